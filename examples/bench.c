@@ -0,0 +1,47 @@
+#include "bench.h"
+#include <time.h>
+
+/*------------------------------------------------------
+ * Creates the drawing context. Returns 0 on failure.
+ *------------------------------------------------------*/
+
+int benchInit(int width, int height)
+{
+  if (!vgCreateContextSH(width, height)) {
+    fprintf(stderr, "Failed creating OpenVG context\n");
+    return 0;
+  }
+
+  return 1;
+}
+
+void benchCleanup(void)
+{
+  vgDestroyContextSH();
+}
+
+/*------------------------------------------------------
+ * Monotonic wall clock time in seconds
+ *------------------------------------------------------*/
+
+double benchTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*------------------------------------------------------
+ * Returns the positional command line argument at the
+ * given index as an integer or the default if missing
+ *------------------------------------------------------*/
+
+int benchArgInt(int argc, char **argv, int index, int def)
+{
+  if (index < argc) {
+    int v = atoi(argv[index]);
+    if (v > 0) return v;
+  }
+
+  return def;
+}
@@ -0,0 +1,19 @@
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <VG/openvg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*------------------------------------------------------
+ * Helpers for the headless benchmark programs. These
+ * run on the software rendering engine and need no
+ * window system.
+ *------------------------------------------------------*/
+
+int    benchInit(int width, int height);
+void   benchCleanup(void);
+double benchTime(void);
+int    benchArgInt(int argc, char **argv, int index, int def);
+
+#endif /* __BENCH_H */
@@ -0,0 +1,57 @@
+#include "bench.h"
+#include <VG/vulcanvg.h>
+
+/*------------------------------------------------------
+ * Places labels along a long curved route with
+ * vgPointAlongPath and reports the time of the first
+ * query, which builds the arc-length index, and of the
+ * following ones.
+ *
+ * Usage: bench_along [route segments] [queries]
+ *------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+  VGubyte segs[2] = { VG_MOVE_TO_ABS, VG_CUBIC_TO_REL };
+  VGfloat coords[6] = { 0.0f, 0.0f };
+  int count = benchArgInt(argc, argv, 1, 2000);
+  int queries = benchArgInt(argc, argv, 2, 100000);
+  VGfloat length, x, y, tx, ty;
+  double start, first, rest;
+  VGPath path;
+  int i;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  path = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                      1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  vgAppendPathData(path, 1, segs, coords);
+
+  for (i=0; i<count; ++i) {
+    coords[0] = 8.0f;  coords[1] = (i & 1) ? 12.0f : -12.0f;
+    coords[2] = 16.0f; coords[3] = (i & 2) ? -4.0f : 4.0f;
+    coords[4] = 24.0f; coords[5] = (i & 4) ? 3.0f : -3.0f;
+    vgAppendPathData(path, 1, &segs[1], coords);
+  }
+
+  start = benchTime();
+  length = vgPathLength(path, 0, count + 1);
+  first = benchTime() - start;
+
+  start = benchTime();
+  for (i=0; i<queries; ++i) {
+    vgPointAlongPath(path, 0, count + 1, length * (VGfloat)i / queries,
+                     &x, &y, &tx, &ty);
+  }
+  rest = benchTime() - start;
+
+  printf("route of %d cubics, length %.1f\n", count, length);
+  printf("%-24s %12.3f ms\n", "first query (index)", first * 1e3);
+  printf("%-24s %12.3f us\n", "point along path", rest * 1e6 / queries);
+
+  vgDestroyPath(path);
+
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include "bench.h"
+#include <VG/vulcanvg.h>
+
+/*------------------------------------------------------
+ * Builds a polyline by appending line segments one at
+ * a time, the way a chart adds its data points, and
+ * reports the time per append.
+ *
+ * Usage: bench_append [segments] [runs]
+ *------------------------------------------------------*/
+
+typedef enum
+{
+  APPEND_DATA,
+  APPEND_DATA_HINTED,
+  APPEND_PATH
+
+} AppendMode;
+
+static const char *modeNames[] = {
+  "vgAppendPathData",
+  "vgAppendPathData + hint",
+  "vgAppendPath"
+};
+
+double appendSegments(AppendMode mode, int count)
+{
+  VGubyte move = VG_MOVE_TO_ABS;
+  VGubyte line = VG_LINE_TO_ABS;
+  VGfloat coords[2] = {0,0};
+  VGPath path, point;
+  double start, end;
+  int i;
+  
+  path = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                      1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  point = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                       1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  
+  vgAppendPathData(path, 1, &move, coords);
+  if (mode == APPEND_PATH)
+    vgAppendPathData(point, 1, &line, coords);
+  
+  start = benchTime();
+  
+  if (mode == APPEND_DATA_HINTED)
+    vgPathCapacityHintEXT(path, count + 1, 2 * (count + 1));
+  
+  for (i=0; i<count; ++i) {
+    if (mode == APPEND_PATH) {
+      vgAppendPath(path, point);
+    }else{
+      coords[0] = (VGfloat)i;
+      coords[1] = (VGfloat)(i % 100);
+      vgAppendPathData(path, 1, &line, coords);
+    }
+  }
+  
+  end = benchTime();
+  
+  if (vgGetParameteri(path, VG_PATH_NUM_SEGMENTS) != count + 1)
+    printf("unexpected segment count\n");
+  
+  vgDestroyPath(point);
+  vgDestroyPath(path);
+  return end - start;
+}
+
+int main(int argc, char **argv)
+{
+  int count = benchArgInt(argc, argv, 1, 100000);
+  int runs = benchArgInt(argc, argv, 2, 5);
+  double sec;
+  int m, r;
+  
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+  
+  printf("%d segments appended one at a time, %d runs\n", count, runs);
+  printf("%-26s %10s %12s\n", "mode", "ms/run", "ns/append");
+  
+  for (m=APPEND_DATA; m<=APPEND_PATH; ++m) {
+    
+    sec = 0.0;
+    for (r=0; r<runs; ++r)
+      sec += appendSegments((AppendMode)m, count);
+    sec /= runs;
+    
+    printf("%-26s %10.2f %12.1f\n", modeNames[m],
+           sec * 1000.0, sec * 1e9 / count);
+  }
+  
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#include "bench.h"
+
+/*------------------------------------------------------
+ * Blurs an RGBA image with vgGaussianBlur at a few
+ * standard deviations, through the exact kernel and the
+ * box approximation, and reports the time per blur and
+ * the throughput in MPix/s.
+ *
+ * Usage: bench_blur [repeats] [width] [height]
+ *------------------------------------------------------*/
+
+static const VGfloat deviations[] = { 2.0f, 8.0f, 32.0f };
+
+#define DEVIATION_COUNT (sizeof(deviations) / sizeof(deviations[0]))
+
+int main(int argc, char **argv)
+{
+  int repeats = benchArgInt(argc, argv, 1, 10);
+  int width = benchArgInt(argc, argv, 2, 1920);
+  int height = benchArgInt(argc, argv, 3, 1080);
+  double start, time;
+  VGubyte *pixels;
+  VGImage src, dst;
+  unsigned d;
+  int i, r;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  pixels = (VGubyte*)malloc((size_t)width * height * 4);
+  for (i=0; i<width*height*4; ++i)
+    pixels[i] = (VGubyte)rand();
+
+  src = vgCreateImage(VG_sRGBA_8888, width, height,
+                      VG_IMAGE_QUALITY_NONANTIALIASED);
+  dst = vgCreateImage(VG_sRGBA_8888, width, height,
+                      VG_IMAGE_QUALITY_NONANTIALIASED);
+  vgImageSubData(src, pixels, width * 4, VG_sRGBA_8888, 0, 0, width, height);
+
+  printf("%dx%d pixels, %d repeats\n", width, height, repeats);
+  printf("%-10s %10s %10s\n", "sigma", "ms", "MPix/s");
+
+  for (d=0; d<DEVIATION_COUNT; ++d) {
+    start = benchTime();
+    for (r=0; r<repeats; ++r)
+      vgGaussianBlur(dst, src, deviations[d], deviations[d], VG_TILE_PAD);
+    vgFinish();
+    time = (benchTime() - start) / repeats;
+
+    printf("%-10.1f %10.2f %10.1f\n", deviations[d], time * 1e3,
+           (double)width * height / 1e6 / time);
+  }
+
+  vgDestroyImage(src);
+  vgDestroyImage(dst);
+  free(pixels);
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
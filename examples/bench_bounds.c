@@ -0,0 +1,71 @@
+#include "bench.h"
+#include <VG/vulcanvg.h>
+
+/*------------------------------------------------------
+ * Queries the bounds and transformed bounds of every
+ * tiger path each frame, as a hit-testing pass would,
+ * while the tiger rotates.
+ *
+ * Usage: bench_bounds [frames]
+ *------------------------------------------------------*/
+
+extern const VGint     pathCount;
+extern const VGint     commandCounts[];
+extern const VGubyte*  commandArrays[];
+extern const VGfloat*  dataArrays[];
+extern const VGfloat*  styleArrays[];
+
+void queryBounds(VGPath *paths, VGfloat angle)
+{
+  VGfloat x, y, w, h;
+  int i;
+
+  vgLoadIdentity();
+  vgRotate(angle);
+
+  for (i=0; i<pathCount; ++i) {
+    vgPathBounds(paths[i], &x, &y, &w, &h);
+    vgPathTransformedBounds(paths[i], &x, &y, &w, &h);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int frames = benchArgInt(argc, argv, 1, 200);
+  double start, first, rest;
+  VGPath *paths;
+  int f, i;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  paths = (VGPath*)malloc(pathCount * sizeof(VGPath));
+  for (i=0; i<pathCount; ++i) {
+    paths[i] = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                            1,0,0,0, VG_PATH_CAPABILITY_ALL);
+    vgAppendPathData(paths[i], commandCounts[i],
+                     commandArrays[i], dataArrays[i]);
+  }
+
+  vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+
+  start = benchTime();
+  queryBounds(paths, 0.0f);
+  first = benchTime() - start;
+
+  start = benchTime();
+  for (f=1; f<=frames; ++f)
+    queryBounds(paths, (VGfloat)f);
+  rest = benchTime() - start;
+
+  printf("tiger, %d paths, %d frames\n", pathCount, frames);
+  printf("%-24s %12.3f ms\n", "first frame", first * 1e3);
+  printf("%-24s %12.3f ms\n", "later frames", rest * 1e3 / frames);
+
+  for (i=0; i<pathCount; ++i)
+    vgDestroyPath(paths[i]);
+  free(paths);
+
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
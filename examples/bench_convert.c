@@ -0,0 +1,108 @@
+#include "bench.h"
+#include "shImage.h"
+
+/*------------------------------------------------------
+ * Uploads pixels into images of a different format with
+ * vgImageSubData for the common pairs of formats and
+ * reports the throughput in MPix/s, compared with the
+ * per pixel conversion through floating point colors.
+ *
+ * Usage: bench_convert [repeats] [size]
+ *------------------------------------------------------*/
+
+typedef struct
+{
+  const char *name;
+  VGImageFormat format;
+
+} Format;
+
+static const Format formats[] = {
+  { "RGBA8", VG_sRGBA_8888 },
+  { "BGRA8", VG_sBGRA_8888 },
+  { "ARGB8", VG_sARGB_8888 },
+  { "RGB565", VG_sRGB_565 },
+  { "RGBA4", VG_sRGBA_4444 },
+  { "L8", VG_sL_8 },
+  { "A8", VG_A_8 },
+};
+
+#define FORMAT_COUNT (sizeof(formats) / sizeof(formats[0]))
+
+/* What every pixel cost before the row converters */
+static void convertPerPixel(SHuint8 *dst, VGImageFormat dstFormat,
+                            const SHuint8 *src, VGImageFormat srcFormat,
+                            int count)
+{
+  SHImageFormatDesc dfd, sfd;
+  SHColor c;
+  int i;
+
+  shSetupImageFormat(dstFormat, &dfd);
+  shSetupImageFormat(srcFormat, &sfd);
+
+  for (i=0; i<count; ++i) {
+    shLoadColor(&c, src + i * sfd.bytes, &sfd);
+    shStoreColor(&c, dst + i * dfd.bytes, &dfd);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int repeats = benchArgInt(argc, argv, 1, 10);
+  int size = benchArgInt(argc, argv, 2, 512);
+  SHuint8 *src, *dst;
+  double start, rows, floats, pixels;
+  SHImageFormatDesc fd;
+  VGImage image;
+  unsigned s, d;
+  int i, r;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  src = (SHuint8*)malloc(size * size * 4);
+  dst = (SHuint8*)malloc(size * size * 4);
+  for (i=0; i<size*size*4; ++i)
+    src[i] = (SHuint8)rand();
+
+  printf("%dx%d pixels, %d repeats\n", size, size, repeats);
+  printf("%-8s %-8s %12s %12s %8s\n",
+         "from", "to", "rows MPix/s", "float MPix/s", "speedup");
+
+  pixels = (double)size * size * repeats / 1e6;
+
+  for (d=0; d<FORMAT_COUNT; ++d) {
+    image = vgCreateImage(formats[d].format, size, size,
+                          VG_IMAGE_QUALITY_NONANTIALIASED);
+
+    for (s=0; s<FORMAT_COUNT; ++s) {
+      if (s == d) continue;
+
+      shSetupImageFormat(formats[s].format, &fd);
+
+      start = benchTime();
+      for (r=0; r<repeats; ++r)
+        vgImageSubData(image, src, size * fd.bytes, formats[s].format,
+                       0, 0, size, size);
+      vgFinish();
+      rows = pixels / (benchTime() - start);
+
+      start = benchTime();
+      for (r=0; r<repeats; ++r)
+        convertPerPixel(dst, formats[d].format, src, formats[s].format,
+                        size * size);
+      floats = pixels / (benchTime() - start);
+
+      printf("%-8s %-8s %12.1f %12.1f %7.1fx\n", formats[s].name,
+             formats[d].name, rows, floats, rows / floats);
+    }
+
+    vgDestroyImage(image);
+  }
+
+  free(src);
+  free(dst);
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
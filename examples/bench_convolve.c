@@ -0,0 +1,152 @@
+#include "bench.h"
+
+/*------------------------------------------------------
+ * Filters an RGBA image with vgConvolve and
+ * vgSeparableConvolve and with a naive reference that
+ * tiles every tap and sums in floating point, reports
+ * the time of each and checks that they agree.
+ *
+ * Usage: bench_convolve [repeats] [width] [height]
+ *------------------------------------------------------*/
+
+typedef struct
+{
+  const char *name;
+  int width;
+  int height;
+  int separable;
+
+} Filter;
+
+static const Filter filters[] = {
+  { "3x3", 3, 3, 0 },
+  { "7x7", 7, 7, 0 },
+  { "15x15", 15, 15, 0 },
+  { "7x7 separable", 7, 7, 1 },
+  { "31x31 separable", 31, 31, 1 },
+};
+
+#define FILTER_COUNT (sizeof(filters) / sizeof(filters[0]))
+
+static int clampCoord(int i, int size)
+{
+  return i < 0 ? 0 : (i >= size ? size - 1 : i);
+}
+
+/* Same sum as the filters with VG_TILE_PAD, kernels given by columns */
+static void convolveNaive(const VGuint *src, VGuint *dst, int width, int height,
+                          const VGshort *kernel, int kw, int kh,
+                          float scale, float bias)
+{
+  int x, y, i, j, c, sx, sy;
+  float sum[4], v;
+  VGuint p, out;
+
+  for (y=0; y<height; ++y) {
+    for (x=0; x<width; ++x) {
+      sum[0] = sum[1] = sum[2] = sum[3] = 0.0f;
+
+      for (i=0; i<kw; ++i) {
+        for (j=0; j<kh; ++j) {
+          sx = clampCoord(x + i - kw/2, width);
+          sy = clampCoord(y + j - kh/2, height);
+          p = src[sy * width + sx];
+          for (c=0; c<4; ++c)
+            sum[c] += kernel[(kw - i - 1) * kh + (kh - j - 1)] *
+                      (float)((p >> (24 - 8*c)) & 0xFF);
+        }
+      }
+
+      for (out=0, c=0; c<4; ++c) {
+        v = sum[c] * scale + bias * 255.0f;
+        v = v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v);
+        out |= (VGuint)(v + 0.5f) << (24 - 8*c);
+      }
+      dst[y * width + x] = out;
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int repeats = benchArgInt(argc, argv, 1, 5);
+  int width = benchArgInt(argc, argv, 2, 1920);
+  int height = benchArgInt(argc, argv, 3, 1080);
+  VGshort kernel[31*31], kx[31], ky[31];
+  VGuint *pixels, *result, *naive;
+  double start, time, naiveTime;
+  VGImage src, dst;
+  int i, j, r, d, maxd;
+  unsigned f;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  pixels = (VGuint*)malloc((size_t)width * height * 4);
+  result = (VGuint*)malloc((size_t)width * height * 4);
+  naive = (VGuint*)malloc((size_t)width * height * 4);
+  for (i=0; i<width*height; ++i)
+    pixels[i] = (VGuint)rand() ^ ((VGuint)rand() << 16);
+
+  src = vgCreateImage(VG_sRGBA_8888, width, height,
+                      VG_IMAGE_QUALITY_NONANTIALIASED);
+  dst = vgCreateImage(VG_sRGBA_8888, width, height,
+                      VG_IMAGE_QUALITY_NONANTIALIASED);
+  vgImageSubData(src, pixels, width * 4, VG_sRGBA_8888, 0, 0, width, height);
+
+  printf("%dx%d pixels, %d repeats\n", width, height, repeats);
+  printf("%-16s %10s %10s %10s %8s %5s\n", "kernel", "ms", "MPix/s",
+         "naive ms", "speedup", "diff");
+
+  for (f=0; f<FILTER_COUNT; ++f) {
+    int kw = filters[f].width, kh = filters[f].height;
+    float scale;
+
+    /* Sharpening weights, positive in the middle */
+    for (i=0; i<kw; ++i) {
+      kx[i] = (VGshort)(i == kw/2 ? 4 * kw : -1 - i % 3);
+      ky[i] = (VGshort)(i == kh/2 ? 4 * kh : -1 - i % 2);
+    }
+    for (i=0; i<kw; ++i)
+      for (j=0; j<kh; ++j)
+        kernel[i * kh + j] = filters[f].separable ? kx[i] * ky[j] :
+                             (VGshort)((i == kw/2 && j == kh/2) ? 2 * kw * kh : -1);
+    scale = 1.0f / (filters[f].separable ? 6.0f * kw * kh : (float)kw * kh);
+
+    start = benchTime();
+    for (r=0; r<repeats; ++r) {
+      if (filters[f].separable)
+        vgSeparableConvolve(dst, src, kw, kh, kw/2, kh/2, kx, ky,
+                            scale, 0.1f, VG_TILE_PAD);
+      else
+        vgConvolve(dst, src, kw, kh, kw/2, kh/2, kernel,
+                   scale, 0.1f, VG_TILE_PAD);
+    }
+    vgFinish();
+    time = (benchTime() - start) / repeats;
+
+    start = benchTime();
+    convolveNaive(pixels, naive, width, height, kernel, kw, kh, scale, 0.1f);
+    naiveTime = benchTime() - start;
+
+    vgGetImageSubData(dst, result, width * 4, VG_sRGBA_8888, 0, 0, width, height);
+    for (maxd=0, i=0; i<width*height; ++i) {
+      for (j=0; j<32; j+=8) {
+        d = abs((int)((result[i] >> j) & 0xFF) - (int)((naive[i] >> j) & 0xFF));
+        if (d > maxd) maxd = d;
+      }
+    }
+
+    printf("%-16s %10.2f %10.1f %10.2f %7.1fx %5d\n", filters[f].name,
+           time * 1e3, (double)width * height / 1e6 / time,
+           naiveTime * 1e3, naiveTime / time, maxd);
+  }
+
+  vgDestroyImage(src);
+  vgDestroyImage(dst);
+  free(pixels);
+  free(result);
+  free(naive);
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#include "bench.h"
+#include <math.h>
+
+/*------------------------------------------------------
+ * Pans the tiger zoomed in past the edges of the surface
+ * and reports the time per frame along with the number
+ * of paths skipped because their bounds fall outside the
+ * surface, and then outside a small scissor rectangle.
+ *
+ * Usage: bench_cull [frames]
+ *------------------------------------------------------*/
+
+extern const VGint     pathCount;
+extern const VGint     commandCounts[];
+extern const VGubyte*  commandArrays[];
+extern const VGfloat*  dataArrays[];
+extern const VGfloat*  styleArrays[];
+
+#define WIDTH  512
+#define HEIGHT 512
+
+VGPath *tigerPaths = NULL;
+VGPaint tigerStroke;
+VGPaint tigerFill;
+
+void loadTiger()
+{
+  int i;
+
+  tigerPaths = (VGPath*)malloc(pathCount * sizeof(VGPath));
+
+  for (i=0; i<pathCount; ++i) {
+    tigerPaths[i] = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                                 1,0,0,0, VG_PATH_CAPABILITY_ALL);
+    vgAppendPathData(tigerPaths[i], commandCounts[i],
+                     commandArrays[i], dataArrays[i]);
+  }
+
+  tigerStroke = vgCreatePaint();
+  tigerFill = vgCreatePaint();
+  vgSetPaint(tigerStroke, VG_STROKE_PATH);
+  vgSetPaint(tigerFill, VG_FILL_PATH);
+}
+
+void drawTiger(VGfloat zoom, VGfloat angle)
+{
+  int i;
+  const VGfloat *style;
+  VGfloat clearColor[] = {1,1,1,1};
+
+  vgSetfv(VG_CLEAR_COLOR, 4, clearColor);
+  vgClear(0,0,WIDTH,HEIGHT);
+
+  /* Circle around the center of the tiger */
+  vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+  vgLoadIdentity();
+  vgTranslate(WIDTH/2, HEIGHT/2);
+  vgScale(zoom, -zoom);
+  vgTranslate(-200 * cosf(angle), -200 * sinf(angle));
+
+  for (i=0; i<pathCount; ++i) {
+
+    style = styleArrays[i];
+    vgSetParameterfv(tigerStroke, VG_PAINT_COLOR, 4, &style[0]);
+    vgSetParameterfv(tigerFill, VG_PAINT_COLOR, 4, &style[4]);
+    vgSetf(VG_STROKE_LINE_WIDTH, style[8]);
+    vgDrawPath(tigerPaths[i], (VGint)style[9]);
+  }
+
+  vgFinish();
+}
+
+static void run(const char *name, VGfloat zoom, int frames)
+{
+  double start, ms;
+  VGint culled;
+  int f;
+
+  /* Warm up path and geometry caches */
+  for (f=0; f<frames; ++f)
+    drawTiger(zoom, f * 2.0f * 3.14159265f / frames);
+
+  culled = vgGeti(VG_CULLED_DRAWS_SH);
+
+  start = benchTime();
+  for (f=0; f<frames; ++f)
+    drawTiger(zoom, f * 2.0f * 3.14159265f / frames);
+  ms = (benchTime() - start) * 1000.0 / frames;
+
+  printf("%-10s %6.0fx %10.2f %8.1f %8d\n", name, zoom, ms,
+         (vgGeti(VG_CULLED_DRAWS_SH) - culled) / (double)frames, pathCount);
+}
+
+int main(int argc, char **argv)
+{
+  int frames = benchArgInt(argc, argv, 1, 16);
+  VGint scissor[] = {WIDTH/2 - 32, HEIGHT/2 - 32, 64, 64};
+  VGfloat zoom;
+
+  if (!benchInit(WIDTH, HEIGHT))
+    return EXIT_FAILURE;
+
+  loadTiger();
+
+  printf("tiger %dx%d, %d frames per zoom\n", WIDTH, HEIGHT, frames);
+  printf("%-10s %7s %10s %8s %8s\n",
+         "clip", "zoom", "ms/frame", "culled", "paths");
+
+  for (zoom=1.0f; zoom<=16.0f; zoom*=4.0f)
+    run("surface", zoom, frames);
+
+  vgSetiv(VG_SCISSOR_RECTS, 4, scissor);
+  vgSeti(VG_SCISSORING, VG_TRUE);
+
+  for (zoom=1.0f; zoom<=16.0f; zoom*=4.0f)
+    run("scissor", zoom, frames);
+
+  for (frames=0; frames<pathCount; ++frames)
+    vgDestroyPath(tigerPaths[frames]);
+  free(tigerPaths);
+  vgDestroyPaint(tigerStroke);
+  vgDestroyPaint(tigerFill);
+
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+#include "bench.h"
+#include <VG/vulcanvg.h>
+
+/*------------------------------------------------------
+ * Prepares a grid of dashed lines and a dashed route
+ * overlay every frame and reports the time spent on the
+ * stroke geometry when the dash pattern stays the same,
+ * compared to animating the dash phase.
+ *
+ * Usage: bench_dash [lines] [frames]
+ *------------------------------------------------------*/
+
+VGPath createGrid(int lines)
+{
+  VGubyte segs[2] = { VG_MOVE_TO_ABS, VG_HLINE_TO_REL };
+  VGfloat coords[3];
+  VGPath path;
+  int i;
+
+  path = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                      1,0,0,0, VG_PATH_CAPABILITY_ALL);
+
+  for (i=0; i<lines; ++i) {
+    coords[0] = 0.0f;
+    coords[1] = (VGfloat)i * 4.0f;
+    coords[2] = 1024.0f;
+    vgAppendPathData(path, 2, segs, coords);
+  }
+
+  return path;
+}
+
+VGPath createRoute(int points)
+{
+  VGubyte segs[2] = { VG_MOVE_TO_ABS, VG_CUBIC_TO_REL };
+  VGfloat coords[6] = { 0.0f, 0.0f };
+  VGPath path;
+  int i;
+
+  path = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                      1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  vgAppendPathData(path, 1, segs, coords);
+
+  for (i=0; i<points; ++i) {
+    coords[0] = 8.0f;  coords[1] = (i & 1) ? 12.0f : -12.0f;
+    coords[2] = 16.0f; coords[3] = (i & 1) ? -4.0f : 4.0f;
+    coords[4] = 24.0f; coords[5] = 0.0f;
+    vgAppendPathData(path, 1, &segs[1], coords);
+  }
+
+  return path;
+}
+
+int main(int argc, char **argv)
+{
+  static const VGfloat dashes[4] = { 6.0f, 3.0f, 1.0f, 3.0f };
+  int lines = benchArgInt(argc, argv, 1, 256);
+  int frames = benchArgInt(argc, argv, 2, 200);
+  VGint hits, misses;
+  VGPath paths[2];
+  double start, ms;
+  int animated, f;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  paths[0] = createGrid(lines);
+  paths[1] = createRoute(lines);
+
+  vgSetf(VG_STROKE_LINE_WIDTH, 1.5f);
+  vgSetfv(VG_STROKE_DASH_PATTERN, 4, dashes);
+
+  printf("%d grid lines, %d route segments, %d frames\n",
+         lines, lines, frames);
+  printf("%-12s %10s %8s %8s\n", "dash phase", "ms/frame", "hits", "misses");
+
+  for (animated=0; animated<=1; ++animated) {
+
+    vgSetf(VG_STROKE_DASH_PHASE, 0.0f);
+    vgPreparePathsEXT(paths, 2, VG_STROKE_PATH);
+
+    hits = vgGeti(VG_STROKE_CACHE_HITS_SH);
+    misses = vgGeti(VG_STROKE_CACHE_MISSES_SH);
+
+    start = benchTime();
+    for (f=0; f<frames; ++f) {
+      if (animated)
+        vgSetf(VG_STROKE_DASH_PHASE, (VGfloat)(f % 13));
+      vgPreparePathsEXT(paths, 2, VG_STROKE_PATH);
+    }
+    ms = (benchTime() - start) * 1000.0 / frames;
+
+    printf("%-12s %10.3f %8d %8d\n", animated ? "animated" : "fixed", ms,
+           vgGeti(VG_STROKE_CACHE_HITS_SH) - hits,
+           vgGeti(VG_STROKE_CACHE_MISSES_SH) - misses);
+  }
+
+  vgDestroyPath(paths[0]);
+  vgDestroyPath(paths[1]);
+
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
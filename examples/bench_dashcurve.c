@@ -0,0 +1,98 @@
+#include "bench.h"
+#include <VG/vulcanvg.h>
+#include "shContext.h"
+#include "shPath.h"
+
+/*------------------------------------------------------
+ * Dashes long quadratic curves with the patterns of the
+ * dash test and with fine dotted patterns, rebuilding
+ * the stroke geometry every frame, and reports the time
+ * per frame and per dash cut into the curves.
+ *
+ * Usage: bench_dashcurve [frames] [curves]
+ *------------------------------------------------------*/
+
+static VGPath createWave(int curves)
+{
+  VGubyte segs[2] = { VG_MOVE_TO_ABS, VG_QUAD_TO_REL };
+  VGfloat coords[4] = { 0.0f, 256.0f };
+  VGPath path;
+  int i;
+
+  path = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                      1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  vgAppendPathData(path, 1, segs, coords);
+
+  /* Alternate gentle arches and sharp turns near a cusp */
+  for (i=0; i<curves; ++i) {
+    coords[0] = (i % 3 == 2) ? 180.0f : 100.0f;
+    coords[1] = (i & 1) ? 200.0f : -200.0f;
+    coords[2] = 40.0f;
+    coords[3] = 0.0f;
+    vgAppendPathData(path, 1, &segs[1], coords);
+  }
+
+  return path;
+}
+
+/* Every curved dash keeps 4 vertices */
+static int curvedDashes(VGPath path)
+{
+  SHPath *p;
+  VG_GETCONTEXT(0);
+  p = shGetPath(context, path);
+  return kv_size(p->stroke_geoms[1].vertices) / 48;
+}
+
+static void run(const char *name, const VGfloat *dashes, int count,
+                VGPath path, int frames)
+{
+  double start, ms;
+  int f, pieces;
+
+  vgSetfv(VG_STROKE_DASH_PATTERN, count, dashes);
+  vgSetf(VG_STROKE_DASH_PHASE, 0.0f);
+  vgPreparePathsEXT(&path, 1, VG_STROKE_PATH);
+  pieces = curvedDashes(path);
+
+  start = benchTime();
+  for (f=0; f<frames; ++f) {
+    /* A new phase rebuilds the stroke every frame */
+    vgSetf(VG_STROKE_DASH_PHASE, (VGfloat)(f % 7) * 0.25f);
+    vgPreparePathsEXT(&path, 1, VG_STROKE_PATH);
+  }
+  ms = (benchTime() - start) * 1000.0 / frames;
+
+  printf("%-12s %10.3f %10d %10.1f\n", name, ms, pieces,
+         ms * 1e6 / (2.0 * pieces));
+}
+
+int main(int argc, char **argv)
+{
+  static const VGfloat test[4] = { 10.0f, 15.0f, 0.0f, 15.0f };
+  static const VGfloat dashed[4] = { 6.0f, 3.0f, 1.0f, 3.0f };
+  static const VGfloat dotted[2] = { 1.0f, 1.0f };
+  static const VGfloat fine[2] = { 0.5f, 0.5f };
+  int frames = benchArgInt(argc, argv, 1, 50);
+  int curves = benchArgInt(argc, argv, 2, 256);
+  VGPath path;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  path = createWave(curves);
+  vgSetf(VG_STROKE_LINE_WIDTH, 1.0f);
+  vgSeti(VG_STROKE_CAP_STYLE, VG_CAP_BUTT);
+
+  printf("%d quadratic curves, %d frames\n", curves, frames);
+  printf("%-12s %10s %10s %10s\n", "pattern", "ms/frame", "dashes", "ns/cut");
+
+  run("test_dash", test, 4, path, frames);
+  run("dash-dot", dashed, 4, path, frames);
+  run("dotted 1px", dotted, 2, path, frames);
+  run("dotted .5px", fine, 2, path, frames);
+
+  vgDestroyPath(path);
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
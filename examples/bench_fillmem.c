@@ -0,0 +1,80 @@
+#include "bench.h"
+
+/*------------------------------------------------------
+ * Fills every tiger path once and reports the size of
+ * the fill geometry built for it, along with the time
+ * taken to build it.
+ *
+ * Usage: bench_fillmem [repeats]
+ *------------------------------------------------------*/
+
+extern const VGint     pathCount;
+extern const VGint     commandCounts[];
+extern const VGubyte*  commandArrays[];
+extern const VGfloat*  dataArrays[];
+extern const VGfloat*  styleArrays[];
+
+#define WIDTH  512
+#define HEIGHT 512
+
+int main(int argc, char **argv)
+{
+  int repeats = benchArgInt(argc, argv, 1, 20);
+  double start, build = 0.0;
+  VGint bytes, total = 0, largest = 0;
+  VGPath *paths;
+  VGPaint fill;
+  int r, i;
+
+  if (!benchInit(WIDTH, HEIGHT))
+    return EXIT_FAILURE;
+
+  paths = (VGPath*)malloc(pathCount * sizeof(VGPath));
+  fill = vgCreatePaint();
+  vgSetPaint(fill, VG_FILL_PATH);
+
+  vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+  vgLoadIdentity();
+  vgTranslate(WIDTH/2, HEIGHT/2);
+  vgScale(0.8f, -0.8f);
+
+  for (r=0; r<repeats; ++r) {
+
+    /* Fresh paths so that every draw builds its fill */
+    for (i=0; i<pathCount; ++i) {
+      paths[i] = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                              1,0,0,0, VG_PATH_CAPABILITY_ALL);
+      vgAppendPathData(paths[i], commandCounts[i],
+                       commandArrays[i], dataArrays[i]);
+    }
+
+    start = benchTime();
+    for (i=0; i<pathCount; ++i) {
+      vgSetParameterfv(fill, VG_PAINT_COLOR, 4, &styleArrays[i][4]);
+      vgDrawPath(paths[i], VG_FILL_PATH);
+    }
+    vgFinish();
+    build += benchTime() - start;
+
+    for (i=0; i<pathCount; ++i) {
+      if (r == 0) {
+        bytes = vgGetParameteri(paths[i], VG_PATH_FILL_GEOMETRY_BYTES_SH);
+        total += bytes;
+        if (bytes > largest) largest = bytes;
+      }
+      vgDestroyPath(paths[i]);
+    }
+  }
+
+  printf("tiger, %d paths, %d repeats\n", pathCount, repeats);
+  printf("%-24s %12d bytes\n", "fill geometry", total);
+  printf("%-24s %12.1f bytes\n", "per path", (double)total / pathCount);
+  printf("%-24s %12d bytes\n", "largest path", largest);
+  printf("%-24s %12.3f ms\n", "build and draw", build * 1e3 / repeats);
+
+  free(paths);
+  vgDestroyPaint(fill);
+
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
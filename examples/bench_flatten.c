@@ -0,0 +1,215 @@
+#include "bench.h"
+#include "shGeometry.h"
+
+/*------------------------------------------------------
+ * Flattens the cubics of the tiger at growing zoom with
+ * the midpoint recursion the OpenGL engine used before
+ * and with the tolerance driven flattener, and reports
+ * the time, the number of points and the largest distance
+ * between a curve and its polyline.
+ *
+ * Usage: bench_flatten [repeats] [tolerance / 100]
+ *------------------------------------------------------*/
+
+extern const VGint     pathCount;
+extern const VGint     commandCounts[];
+extern const VGubyte*  commandArrays[];
+extern const VGfloat*  dataArrays[];
+
+#define MAX_RECURSE_DEPTH 16
+
+static SHCubic *cubics = NULL;
+static int cubicCount = 0;
+
+/* Midpoint recursion with a fixed flatness of one pixel */
+static void recurseCubic(SHVertexArray *out, SHCubic *cubic)
+{
+  SHVertex v;
+  SHfloat dx1, dy1, dx2, dy2;
+  SHVector2 mm, c1, c2, c3, c4, c5;
+  SHCubic stack[MAX_RECURSE_DEPTH];
+  SHCubic *c, *cleft, *cright;
+  SHint cindex = 0;
+  stack[0] = *cubic;
+
+  while (cindex >= 0) {
+
+    c = &stack[cindex];
+
+    dx1 = 3.0f*c->p2.x - 2.0f*c->p1.x - c->p4.x; dx1 *= dx1;
+    dy1 = 3.0f*c->p2.y - 2.0f*c->p1.y - c->p4.y; dy1 *= dy1;
+    dx2 = 3.0f*c->p3.x - 2.0f*c->p4.x - c->p1.x; dx2 *= dx2;
+    dy2 = 3.0f*c->p3.y - 2.0f*c->p4.y - c->p1.y; dy2 *= dy2;
+    if (dx1 < dx2) dx1 = dx2;
+    if (dy1 < dy2) dy1 = dy2;
+
+    if (dx1+dy1 <= 1.0 || cindex == MAX_RECURSE_DEPTH-1) {
+
+      v.point = c->p4; v.flags = 0;
+      if (cindex == 0) return;
+      shVertexArrayPushBackP(out, &v);
+      --cindex;
+
+    }else{
+
+      cright = c; cleft = &stack[++cindex];
+
+      SET2V(c1, c->p1); ADD2V(c1, c->p2); DIV2(c1, 2);
+      SET2V(mm, c->p2); ADD2V(mm, c->p3); DIV2(mm, 2);
+      SET2V(c5, c->p3); ADD2V(c5, c->p4); DIV2(c5, 2);
+      SET2V(c2, c1); ADD2V(c2, mm); DIV2(c2, 2);
+      SET2V(c4, mm); ADD2V(c4, c5); DIV2(c4, 2);
+      SET2V(c3, c2); ADD2V(c3, c4); DIV2(c3, 2);
+
+      cleft->p1 = c->p1; cleft->p2 = c1; cleft->p3 = c2; cleft->p4 = c3;
+      cright->p1 = c3; cright->p2 = c4; cright->p3 = c5; cright->p4 = c->p4;
+    }
+  }
+}
+
+static void flattenCubic(SHVertexArray *out, SHCubic *cubic, SHfloat tolerance)
+{
+  SHQuad quads[SH_MAX_CUBIC_QUADS];
+  SHint n = shCubicToQuads(cubic, SH_CUBIC_QUADS_SHARE * tolerance, quads);
+  shFlattenQuads(out, quads, n, SH_FLATTEN_QUADS_SHARE * tolerance);
+}
+
+static void loadCubics(void)
+{
+  int i, j, k;
+
+  for (i=0; i<pathCount; ++i)
+    for (j=0; j<commandCounts[i]; ++j)
+      if (commandArrays[i][j] == VG_CUBIC_TO_ABS) ++cubicCount;
+
+  cubics = (SHCubic*)malloc(cubicCount * sizeof(SHCubic));
+  cubicCount = 0;
+
+  for (i=0; i<pathCount; ++i) {
+    const VGfloat *d = dataArrays[i];
+    SHVector2 pen = {0,0}, start = {0,0};
+
+    for (j=0, k=0; j<commandCounts[i]; ++j) {
+      switch (commandArrays[i][j]) {
+      case VG_MOVE_TO_ABS:
+        SET2(pen, d[k], d[k+1]); start = pen; k += 2; break;
+      case VG_LINE_TO_ABS:
+        SET2(pen, d[k], d[k+1]); k += 2; break;
+      case VG_CUBIC_TO_ABS:
+        cubics[cubicCount].p1 = pen;
+        SET2(cubics[cubicCount].p2, d[k], d[k+1]);
+        SET2(cubics[cubicCount].p3, d[k+2], d[k+3]);
+        SET2(cubics[cubicCount].p4, d[k+4], d[k+5]);
+        SET2(pen, d[k+4], d[k+5]);
+        ++cubicCount; k += 6; break;
+      case VG_CLOSE_PATH:
+        pen = start; break;
+      }
+    }
+  }
+}
+
+static SHVector2 evalCubic(const SHCubic *c, SHfloat t)
+{
+  SHfloat mt = 1.0f - t;
+  SHVector2 p;
+  p.x = mt*mt*mt*c->p1.x + 3*t*mt*(mt*c->p2.x + t*c->p3.x) + t*t*t*c->p4.x;
+  p.y = mt*mt*mt*c->p1.y + 3*t*mt*(mt*c->p2.y + t*c->p3.y) + t*t*t*c->p4.y;
+  return p;
+}
+
+static SHfloat segmentDistance(SHVector2 p, SHVector2 a, SHVector2 b)
+{
+  SHfloat dx = b.x - a.x, dy = b.y - a.y;
+  SHfloat l = dx*dx + dy*dy, t = 0.0f;
+  if (l > 0.0f) t = ((p.x - a.x)*dx + (p.y - a.y)*dy) / l;
+  if (t < 0.0f) t = 0.0f;
+  if (t > 1.0f) t = 1.0f;
+  dx = a.x + t*dx - p.x; dy = a.y + t*dy - p.y;
+  return SH_SQRT(dx*dx + dy*dy);
+}
+
+/* Largest distance from samples of the curve to the
+   polyline through its start, the points and its end */
+static SHfloat curveError(const SHCubic *c, const SHVertex *points, SHint count)
+{
+  SHfloat worst = 0.0f, best, d;
+  SHVector2 p, a, b;
+  int s, i;
+
+  for (s=1; s<64; ++s) {
+    p = evalCubic(c, s / 64.0f);
+    best = 1e30f;
+    for (i=0; i<=count; ++i) {
+      a = (i == 0 ? c->p1 : points[i-1].point);
+      b = (i == count ? c->p4 : points[i].point);
+      d = segmentDistance(p, a, b);
+      if (d < best) best = d;
+    }
+    if (best > worst) worst = best;
+  }
+
+  return worst;
+}
+
+static void run(const char *name, SHfloat zoom, SHfloat tolerance,
+                int repeats, int recursive)
+{
+  SHVertexArray out;
+  SHCubic c;
+  double start, sec;
+  SHfloat error = 0.0f, e;
+  int r, i, points = 0;
+
+  SH_INITOBJ(SHVertexArray, out);
+
+  start = benchTime();
+  for (r=0; r<repeats; ++r) {
+    for (i=0; i<cubicCount; ++i) {
+      c = cubics[i];
+      MUL2(c.p1, zoom); MUL2(c.p2, zoom); MUL2(c.p3, zoom); MUL2(c.p4, zoom);
+      shVertexArrayClear(&out);
+      if (recursive) recurseCubic(&out, &c);
+      else flattenCubic(&out, &c, tolerance);
+    }
+  }
+  sec = benchTime() - start;
+
+  for (i=0; i<cubicCount; ++i) {
+    c = cubics[i];
+    MUL2(c.p1, zoom); MUL2(c.p2, zoom); MUL2(c.p3, zoom); MUL2(c.p4, zoom);
+    shVertexArrayClear(&out);
+    if (recursive) recurseCubic(&out, &c);
+    else flattenCubic(&out, &c, tolerance);
+    points += out.size;
+    e = curveError(&c, out.items, out.size);
+    if (e > error) error = e;
+  }
+
+  printf("%6.0fx  %-10s %10.3f ms %10d %12.3f\n", zoom, name,
+         sec * 1e3 / repeats, points, error);
+
+  SH_DEINITOBJ(SHVertexArray, out);
+}
+
+int main(int argc, char **argv)
+{
+  int repeats = benchArgInt(argc, argv, 1, 50);
+  SHfloat tolerance = benchArgInt(argc, argv, 2, 25) / 100.0f;
+  SHfloat zoom;
+
+  loadCubics();
+
+  printf("tiger, %d cubics, %d repeats, tolerance %.2f\n",
+         cubicCount, repeats, tolerance);
+  printf("%7s  %-10s %13s %10s %12s\n",
+         "zoom", "flattener", "time", "points", "max error");
+
+  for (zoom=1.0f; zoom<=256.0f; zoom*=4.0f) {
+    run("recursive", zoom, tolerance, repeats, 1);
+    run("parabola", zoom, tolerance, repeats, 0);
+  }
+
+  free(cubics);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include "bench.h"
+#include <VG/vulcanvg.h>
+#include "shContext.h"
+#include "shPath.h"
+
+/*------------------------------------------------------
+ * Strokes a line chart with growing line widths in each
+ * join style and reports the time to build the stroke
+ * geometry and to draw it, along with the vertices kept
+ * per join, which stay the same at any width.
+ *
+ * Usage: bench_joins [repeats] [points]
+ *------------------------------------------------------*/
+
+#define WIDTH  1024
+#define HEIGHT 512
+
+static VGPath chart(int points)
+{
+  VGubyte *cmd = (VGubyte*)malloc(points);
+  VGfloat *xy = (VGfloat*)malloc(2 * points * sizeof(VGfloat));
+  VGfloat y = HEIGHT / 2;
+  VGPath p;
+  int i;
+
+  for (i=0; i<points; ++i) {
+    y += 60.0f * rand() / RAND_MAX - 30.0f;
+    if (y < 32) y = 32;
+    if (y > HEIGHT - 32) y = HEIGHT - 32;
+    cmd[i] = (i == 0 ? VG_MOVE_TO_ABS : VG_LINE_TO_ABS);
+    xy[2*i] = 16 + (WIDTH - 32.0f) * i / (points - 1);
+    xy[2*i+1] = y;
+  }
+
+  p = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                   1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  vgAppendPathData(p, points, cmd, xy);
+  free(cmd); free(xy);
+  return p;
+}
+
+/* Each line segment keeps a quad of 4 vertices, the rest are joins */
+static int strokeVertices(VGPath path)
+{
+  SHPath *p;
+  VG_GETCONTEXT(0);
+  p = shGetPath(context, path);
+  return kv_size(p->stroke_geoms[0].vertices) / 2 +
+         kv_size(p->stroke_geoms[1].vertices) / 12;
+}
+
+static void run(const char *name, VGJoinStyle join, VGPath path,
+                int points, int repeats)
+{
+  double start, build, draw;
+  VGfloat width;
+  int r;
+
+  vgSeti(VG_STROKE_JOIN_STYLE, join);
+
+  for (width=2.0f; width<=64.0f; width*=4.0f) {
+
+    vgSetf(VG_STROKE_LINE_WIDTH, width);
+
+    start = benchTime();
+    for (r=0; r<repeats; ++r) {
+      /* Alternate the width so the geometry is rebuilt */
+      vgSetf(VG_STROKE_LINE_WIDTH, width + (r & 1) * 0.01f);
+      vgPreparePathsEXT(&path, 1, VG_STROKE_PATH);
+    }
+    build = (benchTime() - start) * 1e3 / repeats;
+
+    start = benchTime();
+    for (r=0; r<repeats; ++r)
+      vgDrawPath(path, VG_STROKE_PATH);
+    vgFinish();
+    draw = (benchTime() - start) * 1e3 / repeats;
+
+    printf("%-6s %6.0f %10.3f %10.3f %10.2f\n", name, width, build, draw,
+           (strokeVertices(path) - 4 * (points - 1)) / (double)(points - 2));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int repeats = benchArgInt(argc, argv, 1, 20);
+  int points = benchArgInt(argc, argv, 2, 2000);
+  VGfloat clearColor[] = {1,1,1,1};
+  VGPath path;
+
+  if (!benchInit(WIDTH, HEIGHT))
+    return EXIT_FAILURE;
+
+  srand(1);
+  path = chart(points);
+  vgSetfv(VG_CLEAR_COLOR, 4, clearColor);
+  vgClear(0, 0, WIDTH, HEIGHT);
+  vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+  vgLoadIdentity();
+  vgSetf(VG_STROKE_MITER_LIMIT, 4.0f);
+
+  printf("chart, %d points, %d repeats\n", points, repeats);
+  printf("%-6s %6s %10s %10s %10s\n",
+         "join", "width", "build ms", "draw ms", "verts/join");
+
+  run("bevel", VG_JOIN_BEVEL, path, points, repeats);
+  run("miter", VG_JOIN_MITER, path, points, repeats);
+  run("round", VG_JOIN_ROUND, path, points, repeats);
+
+  vgDestroyPath(path);
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include "bench.h"
+#include <VG/vulcanvg.h>
+#include <string.h>
+
+/*------------------------------------------------------
+ * Animates one marker of a path holding many of them
+ * with vgModifyPathCoords and reports the time to bring
+ * the fill and stroke geometry up to date, compared to
+ * modifying the coordinates of every marker.
+ *
+ * Usage: bench_modify [markers] [frames]
+ *------------------------------------------------------*/
+
+#define MARKER_SEGS   6
+#define MARKER_COORDS 26
+
+static void markerCoords(VGfloat *d, VGfloat x, VGfloat y, VGfloat r)
+{
+  const VGfloat k = 0.5523f * r;
+
+  d[0] = x + r; d[1] = y;
+  d[2] = x + r; d[3] = y + k; d[4] = x + k; d[5] = y + r; d[6] = x; d[7] = y + r;
+  d[8] = x - k; d[9] = y + r; d[10] = x - r; d[11] = y + k; d[12] = x - r; d[13] = y;
+  d[14] = x - r; d[15] = y - k; d[16] = x - k; d[17] = y - r; d[18] = x; d[19] = y - r;
+  d[20] = x + k; d[21] = y - r; d[22] = x + r; d[23] = y - k; d[24] = x + r; d[25] = y;
+}
+
+double animate(VGPath path, VGfloat *coords, int markers, int frames, int all)
+{
+  double start, end;
+  int f, m;
+
+  start = benchTime();
+
+  for (f=0; f<frames; ++f) {
+
+    m = (f * 7919) % markers;
+    markerCoords(&coords[m * MARKER_COORDS],
+                 (VGfloat)(m % 64) * 16.0f + (VGfloat)(f % 8),
+                 (VGfloat)(m / 64) * 16.0f, 6.0f);
+
+    if (all)
+      vgModifyPathCoords(path, 0, markers * MARKER_SEGS, coords);
+    else
+      vgModifyPathCoords(path, m * MARKER_SEGS, MARKER_SEGS,
+                         &coords[m * MARKER_COORDS]);
+
+    vgPreparePathsEXT(&path, 1, VG_FILL_PATH | VG_STROKE_PATH);
+  }
+
+  end = benchTime();
+  return end - start;
+}
+
+int main(int argc, char **argv)
+{
+  static const VGubyte marker[MARKER_SEGS] = {
+    VG_MOVE_TO_ABS, VG_CUBIC_TO_ABS, VG_CUBIC_TO_ABS,
+    VG_CUBIC_TO_ABS, VG_CUBIC_TO_ABS, VG_CLOSE_PATH };
+
+  int markers = benchArgInt(argc, argv, 1, 2000);
+  int frames = benchArgInt(argc, argv, 2, 200);
+  VGubyte *segs;
+  VGfloat *coords;
+  VGPath path;
+  double sec;
+  int m, all;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  segs = (VGubyte*)malloc(markers * MARKER_SEGS);
+  coords = (VGfloat*)malloc(markers * MARKER_COORDS * sizeof(VGfloat));
+
+  for (m=0; m<markers; ++m) {
+    memcpy(&segs[m * MARKER_SEGS], marker, MARKER_SEGS);
+    markerCoords(&coords[m * MARKER_COORDS], (VGfloat)(m % 64) * 16.0f,
+                 (VGfloat)(m / 64) * 16.0f, 6.0f);
+  }
+
+  path = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                      1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  vgAppendPathData(path, markers * MARKER_SEGS, segs, coords);
+  vgSetf(VG_STROKE_LINE_WIDTH, 1.5f);
+  vgPreparePathsEXT(&path, 1, VG_FILL_PATH | VG_STROKE_PATH);
+
+  printf("%d markers, %d frames\n", markers, frames);
+  printf("%-20s %12s\n", "modified", "us/frame");
+
+  for (all=0; all<=1; ++all) {
+    sec = animate(path, coords, markers, frames, all);
+    printf("%-20s %12.1f\n", all ? "all markers" : "one marker",
+           sec * 1e6 / frames);
+  }
+
+  vgDestroyPath(path);
+  free(segs);
+  free(coords);
+
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#include "bench.h"
+#include "shImage.h"
+#include <string.h>
+
+/*------------------------------------------------------
+ * Premultiplies and unpremultiplies rows of 8 bit RGBA
+ * words with the integer kernels and with the floating
+ * point color macros, then reads and writes the surface
+ * and uploads premultiplied images, which go through the
+ * kernels, and reports the throughput in MPix/s.
+ *
+ * Usage: bench_premul [repeats] [size]
+ *------------------------------------------------------*/
+
+static void premultiplyFloat(SHuint32 *rgba, int count)
+{
+  SHColor c;
+  int i;
+
+  for (i=0; i<count; ++i) {
+    SHuint32 in = rgba[i];
+    c.r = (in >> 24) / 255.0f;
+    c.g = ((in >> 16) & 0xFF) / 255.0f;
+    c.b = ((in >> 8) & 0xFF) / 255.0f;
+    c.a = (in & 0xFF) / 255.0f;
+    CPREMUL(c);
+    rgba[i] = ((SHuint32)(c.r * 255.0f + 0.5f) << 24) |
+              ((SHuint32)(c.g * 255.0f + 0.5f) << 16) |
+              ((SHuint32)(c.b * 255.0f + 0.5f) << 8) | (in & 0xFF);
+  }
+}
+
+static void unpremultiplyFloat(SHuint32 *rgba, int count)
+{
+  SHColor c;
+  int i;
+
+  for (i=0; i<count; ++i) {
+    SHuint32 in = rgba[i];
+    c.r = (in >> 24) / 255.0f;
+    c.g = ((in >> 16) & 0xFF) / 255.0f;
+    c.b = ((in >> 8) & 0xFF) / 255.0f;
+    c.a = (in & 0xFF) / 255.0f;
+    if (c.a > 0.0f) CUNPREMUL(c);
+    SH_CLAMP(c.r, 0.0f, 1.0f);
+    SH_CLAMP(c.g, 0.0f, 1.0f);
+    SH_CLAMP(c.b, 0.0f, 1.0f);
+    rgba[i] = ((SHuint32)(c.r * 255.0f + 0.5f) << 24) |
+              ((SHuint32)(c.g * 255.0f + 0.5f) << 16) |
+              ((SHuint32)(c.b * 255.0f + 0.5f) << 8) | (in & 0xFF);
+  }
+}
+
+/* Copies the row back each time so every pass sees the same data */
+static double rowRate(void (*kernel)(SHuint32*, int), SHuint32 *rows,
+                      const SHuint32 *src, int size, int repeats)
+{
+  double start, time = 0.0;
+  int r, y;
+
+  for (r=0; r<repeats; ++r) {
+    memcpy(rows, src, (size_t)size * size * sizeof(SHuint32));
+    start = benchTime();
+    for (y=0; y<size; ++y)
+      kernel(rows + y * size, size);
+    time += benchTime() - start;
+  }
+
+  return (double)size * size * repeats / 1e6 / time;
+}
+
+static void premultiplyRow(SHuint32 *rgba, int count)
+{
+  shPremultiplyRow(rgba, count);
+}
+
+static void unpremultiplyRow(SHuint32 *rgba, int count)
+{
+  shUnpremultiplyRow(rgba, count);
+}
+
+int main(int argc, char **argv)
+{
+  int repeats = benchArgInt(argc, argv, 1, 10);
+  int size = benchArgInt(argc, argv, 2, 512);
+  SHuint32 *src, *rows;
+  double start, pixels, ints, floats;
+  VGImage image;
+  int i, r;
+
+  if (!benchInit(size, size))
+    return EXIT_FAILURE;
+
+  src = (SHuint32*)malloc((size_t)size * size * sizeof(SHuint32));
+  rows = (SHuint32*)malloc((size_t)size * size * sizeof(SHuint32));
+
+  /* Mostly translucent pixels, with their colors below alpha */
+  for (i=0; i<size*size; ++i) {
+    SHuint32 a = rand() & 0xFF;
+    src[i] = ((rand() % (a + 1)) << 24) | ((rand() % (a + 1)) << 16) |
+             ((rand() % (a + 1)) << 8) | a;
+  }
+
+  printf("%dx%d pixels, %d repeats\n", size, size, repeats);
+  printf("%-22s %10s %12s %8s\n", "operation", "MPix/s", "float MPix/s", "speedup");
+
+  shInitColorTables();
+
+  ints = rowRate(premultiplyRow, rows, src, size, repeats);
+  floats = rowRate(premultiplyFloat, rows, src, size, repeats);
+  printf("%-22s %10.1f %12.1f %7.1fx\n", "premultiply rows",
+         ints, floats, ints / floats);
+
+  ints = rowRate(unpremultiplyRow, rows, src, size, repeats);
+  floats = rowRate(unpremultiplyFloat, rows, src, size, repeats);
+  printf("%-22s %10.1f %12.1f %7.1fx\n", "unpremultiply rows",
+         ints, floats, ints / floats);
+
+  pixels = (double)size * size * repeats / 1e6;
+
+  start = benchTime();
+  for (r=0; r<repeats; ++r)
+    vgWritePixels(src, size * 4, VG_sRGBA_8888, 0, 0, size, size);
+  vgFinish();
+  printf("%-22s %10.1f\n", "vgWritePixels", pixels / (benchTime() - start));
+
+  start = benchTime();
+  for (r=0; r<repeats; ++r)
+    vgReadPixels(rows, size * 4, VG_sRGBA_8888, 0, 0, size, size);
+  printf("%-22s %10.1f\n", "vgReadPixels", pixels / (benchTime() - start));
+
+  image = vgCreateImage(VG_sRGBA_8888_PRE, size, size,
+                        VG_IMAGE_QUALITY_NONANTIALIASED);
+
+  start = benchTime();
+  for (r=0; r<repeats; ++r)
+    vgImageSubData(image, src, size * 4, VG_sRGBA_8888, 0, 0, size, size);
+  vgFinish();
+  printf("%-22s %10.1f\n", "RGBA -> RGBA_PRE", pixels / (benchTime() - start));
+
+  start = benchTime();
+  for (r=0; r<repeats; ++r)
+    vgGetImageSubData(image, rows, size * 4, VG_sRGBA_8888, 0, 0, size, size);
+  printf("%-22s %10.1f\n", "RGBA_PRE -> RGBA", pixels / (benchTime() - start));
+
+  vgDestroyImage(image);
+  free(src);
+  free(rows);
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include "bench.h"
+#include <VG/vulcanvg.h>
+
+/*------------------------------------------------------
+ * Builds the fill and stroke geometry of many copies of
+ * the tiger paths with vgPreparePathsEXT, using an
+ * increasing number of threads, and reports the scaling.
+ *
+ * Usage: bench_prepare [max threads] [copies] [runs]
+ *------------------------------------------------------*/
+
+extern const VGint     pathCount;
+extern const VGint     commandCounts[];
+extern const VGubyte*  commandArrays[];
+extern const VGfloat*  dataArrays[];
+extern const VGfloat*  styleArrays[];
+
+VGPath *paths = NULL;
+int count = 0;
+
+void createPaths(int copies)
+{
+  int c, i;
+  
+  count = copies * pathCount;
+  paths = (VGPath*)malloc(count * sizeof(VGPath));
+  
+  for (c=0; c<copies; ++c) {
+    for (i=0; i<pathCount; ++i) {
+      
+      paths[c*pathCount + i] = vgCreatePath(
+        VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+        1,0,0,0, VG_PATH_CAPABILITY_ALL);
+      
+      vgAppendPathData(paths[c*pathCount + i], commandCounts[i],
+                       commandArrays[i], dataArrays[i]);
+    }
+  }
+}
+
+void destroyPaths()
+{
+  int i;
+  
+  for (i=0; i<count; ++i)
+    vgDestroyPath(paths[i]);
+  free(paths);
+}
+
+int main(int argc, char **argv)
+{
+  int maxThreads = benchArgInt(argc, argv, 1, 8);
+  int copies = benchArgInt(argc, argv, 2, 16);
+  int runs = benchArgInt(argc, argv, 3, 5);
+  double start, ms, base = 0.0;
+  int t, r;
+  
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+  
+  vgSetf(VG_STROKE_LINE_WIDTH, 1.0f);
+  
+  printf("tiger x%d, %d paths, %d runs\n",
+         copies, copies * pathCount, runs);
+  printf("threads    ms/run   speedup\n");
+  
+  for (t=1; t<=maxThreads; ++t) {
+    
+    vgSeti(VG_RASTER_THREADS_SH, t);
+    ms = 0.0;
+    
+    /* Fresh paths each run so nothing is cached */
+    for (r=0; r<runs; ++r) {
+      createPaths(copies);
+      start = benchTime();
+      vgPreparePathsEXT(paths, count, VG_FILL_PATH | VG_STROKE_PATH);
+      ms += (benchTime() - start) * 1000.0;
+      destroyPaths();
+    }
+    
+    ms /= runs;
+    if (t == 1) base = ms;
+    printf("%7d %9.2f %9.2fx\n", t, ms, base / ms);
+  }
+  
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
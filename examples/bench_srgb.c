@@ -0,0 +1,76 @@
+#include "bench.h"
+
+/*------------------------------------------------------
+ * Uploads pixels with vgImageSubData between sRGB and
+ * linear formats and reports the throughput in MPix/s
+ * next to a plain reorder of the channels between two
+ * sRGB formats, which needs no color conversion.
+ *
+ * Usage: bench_srgb [repeats] [size]
+ *------------------------------------------------------*/
+
+typedef struct
+{
+  const char *name;
+  VGImageFormat from;
+  VGImageFormat to;
+
+} Upload;
+
+static const Upload uploads[] = {
+  { "sRGBA -> sBGRA (raw)", VG_sRGBA_8888, VG_sBGRA_8888 },
+  { "lRGBA -> sBGRA", VG_lRGBA_8888, VG_sBGRA_8888 },
+  { "sRGBA -> lBGRA", VG_sRGBA_8888, VG_lBGRA_8888 },
+  { "sRGBA -> lRGBX", VG_sRGBA_8888, VG_lRGBX_8888 },
+  { "sRGBA -> sRGB565", VG_sRGBA_8888, VG_sRGB_565 },
+  { "lRGBA -> sRGB565", VG_lRGBA_8888, VG_sRGB_565 },
+  { "sRGBA -> sL8", VG_sRGBA_8888, VG_sL_8 },
+  { "lRGBA -> sL8", VG_lRGBA_8888, VG_sL_8 },
+};
+
+#define UPLOAD_COUNT (sizeof(uploads) / sizeof(uploads[0]))
+
+int main(int argc, char **argv)
+{
+  int repeats = benchArgInt(argc, argv, 1, 10);
+  int size = benchArgInt(argc, argv, 2, 512);
+  double start, mpix, raw = 0.0, pixels;
+  VGubyte *src;
+  VGImage image;
+  unsigned u;
+  int i, r;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  src = (VGubyte*)malloc(size * size * 4);
+  for (i=0; i<size*size*4; ++i)
+    src[i] = (VGubyte)rand();
+
+  printf("%dx%d pixels, %d repeats\n", size, size, repeats);
+  printf("%-20s %10s %8s\n", "upload", "MPix/s", "vs raw");
+
+  pixels = (double)size * size * repeats / 1e6;
+
+  for (u=0; u<UPLOAD_COUNT; ++u) {
+    image = vgCreateImage(uploads[u].to, size, size,
+                          VG_IMAGE_QUALITY_NONANTIALIASED);
+
+    start = benchTime();
+    for (r=0; r<repeats; ++r)
+      vgImageSubData(image, src, size * 4, uploads[u].from,
+                     0, 0, size, size);
+    vgFinish();
+    mpix = pixels / (benchTime() - start);
+    if (u == 0) raw = mpix;
+
+    printf("%-20s %10.1f %7.0f%%\n", uploads[u].name, mpix,
+           100.0 * mpix / raw);
+
+    vgDestroyImage(image);
+  }
+
+  free(src);
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
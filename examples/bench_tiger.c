@@ -0,0 +1,124 @@
+#include "bench.h"
+
+/*------------------------------------------------------
+ * Renders the tiger scene repeatedly with an increasing
+ * number of rasterizer threads and reports the scaling.
+ *
+ * Usage: bench_tiger [max threads] [frames] [tile size]
+ *------------------------------------------------------*/
+
+extern const VGint     pathCount;
+extern const VGint     commandCounts[];
+extern const VGubyte*  commandArrays[];
+extern const VGfloat*  dataArrays[];
+extern const VGfloat*  styleArrays[];
+
+#define WIDTH  1024
+#define HEIGHT 1024
+
+VGPath *tigerPaths = NULL;
+VGPaint tigerStroke;
+VGPaint tigerFill;
+
+void loadTiger()
+{
+  int i;
+  VGPath temp;
+  
+  temp = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                      1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  tigerPaths = (VGPath*)malloc(pathCount * sizeof(VGPath));
+  vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+  vgLoadIdentity();
+  vgTranslate(-100,100);
+  vgScale(1,-1);
+  
+  for (i=0; i<pathCount; ++i) {
+    
+    vgClearPath(temp, VG_PATH_CAPABILITY_ALL);
+    vgAppendPathData(temp, commandCounts[i],
+                     commandArrays[i], dataArrays[i]);
+    
+    tigerPaths[i] = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                                 1,0,0,0, VG_PATH_CAPABILITY_ALL);
+    vgTransformPath(tigerPaths[i], temp);
+  }
+  
+  tigerStroke = vgCreatePaint();
+  tigerFill = vgCreatePaint();
+  vgSetPaint(tigerStroke, VG_STROKE_PATH);
+  vgSetPaint(tigerFill, VG_FILL_PATH);
+  vgLoadIdentity();
+  vgDestroyPath(temp);
+}
+
+void drawTiger()
+{
+  int i;
+  const VGfloat *style;
+  VGfloat clearColor[] = {1,1,1,1};
+  
+  vgSetfv(VG_CLEAR_COLOR, 4, clearColor);
+  vgClear(0,0,WIDTH,HEIGHT);
+  
+  vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+  vgLoadIdentity();
+  vgTranslate(WIDTH/2, HEIGHT/2);
+  vgScale(1.7f, 1.7f);
+  
+  for (i=0; i<pathCount; ++i) {
+    
+    style = styleArrays[i];
+    vgSetParameterfv(tigerStroke, VG_PAINT_COLOR, 4, &style[0]);
+    vgSetParameterfv(tigerFill, VG_PAINT_COLOR, 4, &style[4]);
+    vgSetf(VG_STROKE_LINE_WIDTH, style[8]);
+    vgDrawPath(tigerPaths[i], (VGint)style[9]);
+  }
+  
+  vgFinish();
+}
+
+int main(int argc, char **argv)
+{
+  int maxThreads = benchArgInt(argc, argv, 1, 8);
+  int frames = benchArgInt(argc, argv, 2, 20);
+  int tileSize = benchArgInt(argc, argv, 3, 64);
+  double start, ms, base = 0.0;
+  int t, f;
+  
+  if (!benchInit(WIDTH, HEIGHT))
+    return EXIT_FAILURE;
+  
+  loadTiger();
+  vgSeti(VG_RASTER_TILE_SIZE_SH, tileSize);
+  
+  /* Warm up path and geometry caches */
+  drawTiger();
+  
+  printf("tiger %dx%d, %d paths, %d frames, %dx%d tiles\n",
+         WIDTH, HEIGHT, pathCount, frames, tileSize, tileSize);
+  printf("threads   ms/frame   speedup\n");
+  
+  for (t=1; t<=maxThreads; ++t) {
+    
+    vgSeti(VG_RASTER_THREADS_SH, t);
+    drawTiger();
+    
+    start = benchTime();
+    for (f=0; f<frames; ++f)
+      drawTiger();
+    ms = (benchTime() - start) * 1000.0 / frames;
+    
+    if (t == 1) base = ms;
+    printf("%7d %10.2f %9.2fx\n", t, ms, base / ms);
+  }
+  
+  for (t=0; t<pathCount; ++t)
+    vgDestroyPath(tigerPaths[t]);
+  free(tigerPaths);
+  vgDestroyPaint(tigerStroke);
+  vgDestroyPaint(tigerFill);
+  
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+#include "bench.h"
+#include <VG/vgu.h>
+#include "shGeometry.h"
+#include "shTriangulate.h"
+
+/*------------------------------------------------------
+ * Compares the cost of triangulating fills against the
+ * overdraw it saves, for paths of growing complexity.
+ * The stencil fill touches the pixels of the fan of
+ * every contour and twice the bounding box (cover and
+ * clear); the triangulated fill touches its own area.
+ *
+ * Usage: bench_triangulate [repeats]
+ *------------------------------------------------------*/
+
+extern const VGint     pathCount;
+extern const VGint     commandCounts[];
+extern const VGubyte*  commandArrays[];
+extern const VGfloat*  dataArrays[];
+
+#define MAX_POINTS 1024
+
+static VGPath newPath(void)
+{
+  return vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                      1, 0, 0, 0, VG_PATH_CAPABILITY_ALL);
+}
+
+static void polygon(VGPath p, const VGfloat *xy, int n)
+{
+  VGubyte cmd[MAX_POINTS + 1];
+  int i;
+
+  for (i=0; i<n; ++i)
+    cmd[i] = (i == 0 ? VG_MOVE_TO_ABS : VG_LINE_TO_ABS);
+  cmd[n] = VG_CLOSE_PATH;
+  vgAppendPathData(p, n+1, cmd, xy);
+}
+
+/* Star polygon {n/k} of radius r, which crosses itself */
+static VGPath star(int n, int k, VGfloat r)
+{
+  VGfloat xy[2*MAX_POINTS];
+  VGPath p = newPath();
+  int i;
+
+  for (i=0; i<n; ++i) {
+    VGfloat a = 2.0f * PI * i * k / n;
+    xy[2*i] = 256 + r * SH_COS(a);
+    xy[2*i+1] = 256 + r * SH_SIN(a);
+  }
+
+  polygon(p, xy, n);
+  return p;
+}
+
+/* Random walk around a circle, mostly simple but concave */
+static VGPath blob(int n)
+{
+  VGfloat xy[2*MAX_POINTS];
+  VGPath p = newPath();
+  int i;
+
+  for (i=0; i<n; ++i) {
+    VGfloat a = 2.0f * PI * i / n;
+    VGfloat r = 120 + 100.0f * rand() / RAND_MAX;
+    xy[2*i] = 256 + r * SH_COS(a);
+    xy[2*i+1] = 256 + r * SH_SIN(a);
+  }
+
+  polygon(p, xy, n);
+  return p;
+}
+
+static double fanArea(SHPath *p)
+{
+  double area = 0.0;
+  SHint start, size, i;
+
+  for (start=0; start < p->vertices.size; start += size) {
+    SHVertex *v = &p->vertices.items[start];
+    size = v->flags;
+    for (i=2; i<size; ++i) {
+      double a = (v[i-1].point.x - v[0].point.x) * (v[i].point.y - v[0].point.y) -
+                 (v[i-1].point.y - v[0].point.y) * (v[i].point.x - v[0].point.x);
+      area += (a < 0.0 ? -a : a) * 0.5;
+    }
+  }
+
+  return area;
+}
+
+static double triangleArea(SHVector2Array *t)
+{
+  double area = 0.0;
+  SHint i;
+
+  for (i=0; i+2 < t->size; i+=3) {
+    double a = (t->items[i+1].x - t->items[i].x) * (t->items[i+2].y - t->items[i].y) -
+               (t->items[i+1].y - t->items[i].y) * (t->items[i+2].x - t->items[i].x);
+    area += (a < 0.0 ? -a : a) * 0.5;
+  }
+
+  return area;
+}
+
+static void run(const char *name, VGPath *paths, int count, int repeats)
+{
+  SHVector2Array tris;
+  SHPath *p;
+  double start, sec, stencil = 0.0, exact = 0.0;
+  int i, r, triangles = 0, vertices = 0;
+
+  VG_GETCONTEXT(VG_NO_RETVAL);
+  SH_INITOBJ(SHVector2Array, tris);
+
+  for (i=0; i<count; ++i) {
+    p = shGetPath(context, paths[i]);
+    shFlattenPath(p, 1);
+    shFindBoundbox(p);
+    vertices += p->vertices.size;
+
+    shTriangulatePath(p, VG_EVEN_ODD, &tris);
+    triangles += tris.size / 3;
+    exact += triangleArea(&tris);
+    stencil += fanArea(p) +
+      2.0 * (p->max.x - p->min.x + 2) * (p->max.y - p->min.y + 2);
+  }
+
+  start = benchTime();
+  for (r=0; r<repeats; ++r) {
+    for (i=0; i<count; ++i)
+      shTriangulatePath(shGetPath(context, paths[i]), VG_EVEN_ODD, &tris);
+  }
+  sec = (benchTime() - start) / repeats;
+
+  printf("%-12s %6d %7d %8.1f %12.0f %12.0f %6.2fx %8.0f\n",
+         name, vertices, triangles, sec * 1e6,
+         stencil, exact, stencil / exact, (stencil - exact) / (sec * 1e6));
+
+  SH_DEINITOBJ(SHVector2Array, tris);
+}
+
+int main(int argc, char **argv)
+{
+  int repeats = benchArgInt(argc, argv, 1, 20);
+  VGPath *paths = (VGPath*)malloc(pathCount * sizeof(VGPath));
+  VGPath p;
+  int i, n;
+  char name[32];
+
+  benchInit(512, 512);
+  srand(1);
+
+  printf("%-12s %6s %7s %8s %12s %12s %7s %8s\n", "paths", "verts",
+         "tris", "us", "stencil px", "fill px", "ratio", "px/us");
+
+  p = newPath();
+  vguEllipse(p, 256, 256, 400, 300);
+  run("ellipse", &p, 1, repeats * 100);
+  vgDestroyPath(p);
+
+  for (n=16; n<=MAX_POINTS; n*=4) {
+    p = blob(n);
+    sprintf(name, "blob %d", n);
+    run(name, &p, 1, repeats * 10);
+    vgDestroyPath(p);
+  }
+
+  for (n=5; n<=125; n*=5) {
+    p = star(n, n/2, 250);
+    sprintf(name, "star %d", n);
+    run(name, &p, 1, repeats * 10);
+    vgDestroyPath(p);
+  }
+
+  for (i=0; i<pathCount; ++i) {
+    paths[i] = newPath();
+    vgAppendPathData(paths[i], commandCounts[i], commandArrays[i], dataArrays[i]);
+  }
+  run("tiger", paths, pathCount, repeats);
+  for (i=0; i<pathCount; ++i)
+    vgDestroyPath(paths[i]);
+
+  free(paths);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+#include "bench.h"
+#include <VG/vulcanvg.h>
+#include <math.h>
+
+/*------------------------------------------------------
+ * Zooms the tiger continuously in and out and reports
+ * the time spent bringing the path geometry up to date
+ * per frame, without and with levels of detail kept in
+ * the tessellation cache.
+ *
+ * Usage: bench_zoom [frames] [budget in KiB]
+ *------------------------------------------------------*/
+
+extern const VGint     pathCount;
+extern const VGint     commandCounts[];
+extern const VGubyte*  commandArrays[];
+extern const VGfloat*  dataArrays[];
+extern const VGfloat*  styleArrays[];
+
+VGPath *tigerPaths = NULL;
+
+void loadTiger()
+{
+  int i;
+
+  tigerPaths = (VGPath*)malloc(pathCount * sizeof(VGPath));
+
+  for (i=0; i<pathCount; ++i) {
+    tigerPaths[i] = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                                 1,0,0,0, VG_PATH_CAPABILITY_ALL);
+    vgAppendPathData(tigerPaths[i], commandCounts[i],
+                     commandArrays[i], dataArrays[i]);
+  }
+}
+
+void prepareTiger(VGfloat scale)
+{
+  int i;
+
+  vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+  vgLoadIdentity();
+  vgScale(scale, scale);
+
+  for (i=0; i<pathCount; ++i) {
+    vgSetf(VG_STROKE_LINE_WIDTH, styleArrays[i][8]);
+    vgPreparePathsEXT(&tigerPaths[i], 1, (VGint)styleArrays[i][9]);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int frames = benchArgInt(argc, argv, 1, 400);
+  int budget = benchArgInt(argc, argv, 2, 32 * 1024);
+  double start, ms;
+  int cached, f;
+  VGint hits, misses, evictions;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  loadTiger();
+
+  printf("tiger, %d paths, %d frames zooming 1/8x..8x\n", pathCount, frames);
+  printf("%-12s %10s %8s %8s %10s\n",
+         "cache", "ms/frame", "hits", "misses", "evictions");
+
+  for (cached=0; cached<=1; ++cached) {
+
+    vgSeti(VG_TESS_CACHE_BUDGET_SH, cached ? budget * 1024 : 0);
+    prepareTiger(1.0f);
+
+    hits = vgGeti(VG_TESS_CACHE_HITS_SH);
+    misses = vgGeti(VG_TESS_CACHE_MISSES_SH);
+    evictions = vgGeti(VG_TESS_CACHE_EVICTIONS_SH);
+
+    start = benchTime();
+    for (f=0; f<frames; ++f)
+      prepareTiger((VGfloat)pow(2.0, 3.0 * sin(f * 0.05)));
+    ms = (benchTime() - start) * 1000.0 / frames;
+
+    printf("%-12s %10.3f %8d %8d %10d\n", cached ? "levels" : "none", ms,
+           vgGeti(VG_TESS_CACHE_HITS_SH) - hits,
+           vgGeti(VG_TESS_CACHE_MISSES_SH) - misses,
+           vgGeti(VG_TESS_CACHE_EVICTIONS_SH) - evictions);
+  }
+
+  for (f=0; f<pathCount; ++f)
+    vgDestroyPath(tigerPaths[f]);
+  free(tigerPaths);
+
+  benchCleanup();
+  return EXIT_SUCCESS;
+}
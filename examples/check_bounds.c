@@ -0,0 +1,68 @@
+#include "bench.h"
+#include <math.h>
+
+/*------------------------------------------------------
+ * Checks that smooth curves are bounded like the
+ * explicit curves they stand for: each S or T segment
+ * reflects the previous control point about the
+ * previous end point.
+ *
+ * Usage: check_bounds
+ *------------------------------------------------------*/
+
+static VGPath createPath(VGint count, const VGubyte *cmds,
+                         const VGfloat *data)
+{
+  VGPath p = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                          1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  vgAppendPathData(p, count, cmds, data);
+  return p;
+}
+
+static int sameBounds(const char *name, VGPath a, VGPath b)
+{
+  VGfloat ba[4], bb[4];
+  int i;
+
+  vgPathBounds(a, &ba[0], &ba[1], &ba[2], &ba[3]);
+  vgPathBounds(b, &bb[0], &bb[1], &bb[2], &bb[3]);
+
+  for (i=0; i<4; ++i) {
+    if (fabs(ba[i] - bb[i]) > 1e-3f) {
+      printf("%s: bounds %g,%g %gx%g, expected %g,%g %gx%g\n", name,
+             ba[0], ba[1], ba[2], ba[3], bb[0], bb[1], bb[2], bb[3]);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+int main(void)
+{
+  VGubyte smoothCubic[] = {VG_MOVE_TO_ABS, VG_CUBIC_TO_ABS, VG_SCUBIC_TO_ABS};
+  VGubyte smoothCubicRel[] = {VG_MOVE_TO_ABS, VG_CUBIC_TO_ABS, VG_SCUBIC_TO_REL};
+  VGubyte explicitCubic[] = {VG_MOVE_TO_ABS, VG_CUBIC_TO_ABS, VG_CUBIC_TO_ABS};
+  VGubyte smoothQuad[] = {VG_MOVE_TO_ABS, VG_QUAD_TO_ABS, VG_SQUAD_TO_ABS};
+  VGubyte explicitQuad[] = {VG_MOVE_TO_ABS, VG_QUAD_TO_ABS, VG_QUAD_TO_ABS};
+
+  VGfloat sc[] = {0,0, 10,40, 30,40, 40,0, 70,-40, 80,0};
+  VGfloat scRel[] = {0,0, 10,40, 30,40, 40,0, 30,-40, 40,0};
+  VGfloat ec[] = {0,0, 10,40, 30,40, 40,0, 50,-40, 70,-40, 80,0};
+  VGfloat sq[] = {0,0, 20,40, 40,0, 80,0};
+  VGfloat eq[] = {0,0, 20,40, 40,0, 60,-40, 80,0};
+  int ok = 1;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  ok &= sameBounds("S", createPath(3, smoothCubic, sc),
+                   createPath(3, explicitCubic, ec));
+  ok &= sameBounds("s", createPath(3, smoothCubicRel, scRel),
+                   createPath(3, explicitCubic, ec));
+  ok &= sameBounds("T", createPath(3, smoothQuad, sq),
+                   createPath(3, explicitQuad, eq));
+
+  benchCleanup();
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,71 @@
+#include "bench.h"
+
+/*------------------------------------------------------
+ * Checks that convolution results far out of range
+ * saturate instead of wrapping: a single tap with a
+ * huge scale must give full channels, and with a huge
+ * negative scale empty ones.
+ *
+ * Usage: check_convolve
+ *------------------------------------------------------*/
+
+#define WIDTH  16
+#define HEIGHT 4
+
+static int check(const char *name, VGImage dst, VGImage src,
+                 int separable, VGfloat scale, VGuint expected)
+{
+  static VGuint pixels[WIDTH * HEIGHT];
+  VGshort kernel[] = {1};
+  int i;
+
+  if (separable)
+    vgSeparableConvolve(dst, src, 1, 1, 0, 0, kernel, kernel,
+                        scale, 0.1f, VG_TILE_PAD);
+  else
+    vgConvolve(dst, src, 1, 1, 0, 0, kernel, scale, 0.1f, VG_TILE_PAD);
+  vgFinish();
+
+  vgGetImageSubData(dst, pixels, WIDTH * 4, VG_sRGBA_8888,
+                    0, 0, WIDTH, HEIGHT);
+
+  for (i=0; i<WIDTH * HEIGHT; ++i) {
+    if (pixels[i] != expected) {
+      printf("%s: pixel %d is %08x, expected %08x\n",
+             name, i, pixels[i], expected);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+int main(void)
+{
+  static VGuint pixels[WIDTH * HEIGHT];
+  VGImage src, dst;
+  int i, ok = 1;
+
+  if (!benchInit(64, 64))
+    return EXIT_FAILURE;
+
+  for (i=0; i<WIDTH * HEIGHT; ++i)
+    pixels[i] = 0x808080FF;
+
+  src = vgCreateImage(VG_sRGBA_8888, WIDTH, HEIGHT,
+                      VG_IMAGE_QUALITY_NONANTIALIASED);
+  dst = vgCreateImage(VG_sRGBA_8888, WIDTH, HEIGHT,
+                      VG_IMAGE_QUALITY_NONANTIALIASED);
+  vgImageSubData(src, pixels, WIDTH * 4, VG_sRGBA_8888,
+                 0, 0, WIDTH, HEIGHT);
+
+  ok &= check("convolve high", dst, src, 0, 1e8f, 0xFFFFFFFF);
+  ok &= check("convolve low", dst, src, 0, -1e8f, 0x00000000);
+  ok &= check("separable high", dst, src, 1, 1e8f, 0xFFFFFFFF);
+  ok &= check("separable low", dst, src, 1, -1e8f, 0x00000000);
+
+  vgDestroyImage(src);
+  vgDestroyImage(dst);
+  benchCleanup();
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
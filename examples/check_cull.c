@@ -0,0 +1,89 @@
+#include "bench.h"
+
+/*------------------------------------------------------
+ * Checks that early culling keeps paths that reach into
+ * the surface. Each path lies below the bottom edge
+ * except for a smooth curve bulging into it, so only
+ * bounds that follow the reflected control point keep
+ * it.
+ *
+ * Usage: check_cull
+ *------------------------------------------------------*/
+
+#define WIDTH  64
+#define HEIGHT 64
+
+/* Counts pixels in the bottom rows that are no longer white */
+static int paintedPixels(void)
+{
+  static VGuint pixels[WIDTH * 16];
+  int i, count = 0;
+
+  vgReadPixels(pixels, WIDTH * 4, VG_sRGBA_8888, 0, 0, WIDTH, 16);
+  for (i=0; i<WIDTH * 16; ++i)
+    if (pixels[i] != 0xFFFFFFFF) ++count;
+
+  return count;
+}
+
+static int check(const char *name, VGint count, const VGubyte *cmds,
+                 const VGfloat *data, VGbitfield paintModes)
+{
+  VGfloat white[] = {1,1,1,1};
+  VGPath p;
+  int painted;
+
+  p = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F,
+                   1,0,0,0, VG_PATH_CAPABILITY_ALL);
+  vgAppendPathData(p, count, cmds, data);
+
+  vgSetfv(VG_CLEAR_COLOR, 4, white);
+  vgClear(0, 0, WIDTH, HEIGHT);
+  vgDrawPath(p, paintModes);
+  vgFinish();
+
+  painted = paintedPixels();
+  vgDestroyPath(p);
+
+  if (painted == 0) {
+    printf("%s: nothing drawn\n", name);
+    return 0;
+  }
+
+  return 1;
+}
+
+int main(void)
+{
+  VGubyte smoothCubic[] = {VG_MOVE_TO_ABS, VG_CUBIC_TO_ABS,
+                           VG_SCUBIC_TO_ABS, VG_CLOSE_PATH};
+  VGubyte smoothCubicRel[] = {VG_MOVE_TO_ABS, VG_CUBIC_TO_ABS,
+                              VG_SCUBIC_TO_REL, VG_CLOSE_PATH};
+  VGubyte smoothQuad[] = {VG_MOVE_TO_ABS, VG_QUAD_TO_ABS,
+                          VG_SQUAD_TO_ABS, VG_CLOSE_PATH};
+
+  /* The reflected control points are (40,60) and (40,40) */
+  VGfloat sc[] = {0,-20, 10,-20, 20,-100, 30,-20, 50,-20, 60,-20};
+  VGfloat scRel[] = {0,-20, 10,-20, 20,-100, 30,-20, 20,0, 30,0};
+  VGfloat sq[] = {0,-20, 20,-80, 30,-20, 60,-20};
+  VGPaint paint;
+  VGfloat black[] = {0,0,0,1};
+  int ok = 1;
+
+  if (!benchInit(WIDTH, HEIGHT))
+    return EXIT_FAILURE;
+
+  paint = vgCreatePaint();
+  vgSetParameterfv(paint, VG_PAINT_COLOR, 4, black);
+  vgSetPaint(paint, VG_FILL_PATH | VG_STROKE_PATH);
+  vgSetf(VG_STROKE_LINE_WIDTH, 1.0f);
+
+  ok &= check("S fill", 4, smoothCubic, sc, VG_FILL_PATH);
+  ok &= check("S stroke", 4, smoothCubic, sc, VG_STROKE_PATH);
+  ok &= check("s fill", 4, smoothCubicRel, scRel, VG_FILL_PATH);
+  ok &= check("T fill", 4, smoothQuad, sq, VG_FILL_PATH);
+
+  vgDestroyPaint(paint);
+  benchCleanup();
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -97,7 +97,24 @@ typedef enum {
   VG_MAX_IMAGE_PIXELS                         = 0x1167,
   VG_MAX_IMAGE_BYTES                          = 0x1168,
   VG_MAX_FLOAT                                = 0x1169,
-  VG_MAX_GAUSSIAN_STD_DEVIATION               = 0x116A
+  VG_MAX_GAUSSIAN_STD_DEVIATION               = 0x116A,
+
+  /* Software rasterization (0 threads picks one per CPU) */
+  VG_RASTER_THREADS_SH                        = 0x1180,
+  VG_RASTER_TILE_SIZE_SH                      = 0x1181,
+
+  /* Path geometry cache in bytes and its counters (read-only) */
+  VG_TESS_CACHE_BUDGET_SH                     = 0x1182,
+  VG_TESS_CACHE_HITS_SH                       = 0x1183,
+  VG_TESS_CACHE_MISSES_SH                     = 0x1184,
+  VG_TESS_CACHE_EVICTIONS_SH                  = 0x1185,
+
+  /* Stroke geometry reuse counters (read-only) */
+  VG_STROKE_CACHE_HITS_SH                     = 0x1186,
+  VG_STROKE_CACHE_MISSES_SH                   = 0x1187,
+
+  /* Draws skipped off the surface and scissor (read-only) */
+  VG_CULLED_DRAWS_SH                          = 0x1188
 } VGParamType;
 
 typedef enum {
@@ -211,7 +228,16 @@ typedef enum {
   VG_PATH_SCALE                               = 0x1602,
   VG_PATH_BIAS                                = 0x1603,
   VG_PATH_NUM_SEGMENTS                        = 0x1604,
-  VG_PATH_NUM_COORDS                          = 0x1605
+  VG_PATH_NUM_COORDS                          = 0x1605,
+
+  /* Size of the fill geometry last built for drawing (read-only) */
+  VG_PATH_FILL_GEOMETRY_BYTES_SH              = 0x1606,
+
+  /* Largest distance between a curve and its flattened polyline */
+  VG_PATH_FLATTEN_TOLERANCE_EXT               = 0x1607,
+
+  /* Draw the fill from a triangulation instead of a stencil fan */
+  VG_PATH_TRIANGULATE_FILL_EXT                = 0x1608
 } VGPathParamType;
 
 typedef enum {
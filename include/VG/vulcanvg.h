@@ -17,6 +17,17 @@ VG_API_CALL VGImage vgCreateImageFromVkImageEXT(
    VGbitfield allowedQuality,
    VkImage image);
 
+/* Paths */
+VG_API_CALL void vgPreparePathsEXT(
+   const VGPath *paths,
+   VGint count,
+   VGbitfield paintModes);
+
+VG_API_CALL void vgPathCapacityHintEXT(
+   VGPath path,
+   VGint segmentCapacity,
+   VGint coordCapacity);
+
 #ifdef __cplusplus 
 } /* extern "C" */
 #endif
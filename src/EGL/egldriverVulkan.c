@@ -21,9 +21,11 @@
 #include "eglconfig.h"
 #include "eglcontext.h"
 #include "eglsurface.h"
+#include "eglcurrent.h"
 
 #include <VG/openvg.h>
 #include "shContext.h"
+#include "shTessCache.h"
 
 
 static VkInstance
@@ -368,6 +370,16 @@ static bool _initVGContext(VGContext *c)
   c->surfaceWidth = 0;
   c->surfaceHeight = 0;
   
+  /* Software rasterization settings */
+  c->rasterThreads = 0;
+  c->rasterTileSize = 64;
+  c->threadPool = NULL;
+  c->tessCache = shCreateTessCache();
+  c->geometryScratch = NULL;
+  c->strokeCacheHits = 0;
+  c->strokeCacheMisses = 0;
+  c->culledDraws = 0;
+  
   /* GetString info */
   strncpy(c->vendor, "John doe", sizeof(c->vendor));
   strncpy(c->renderer, "VulcanoVG 0.1.0", sizeof(c->renderer));
@@ -425,9 +437,8 @@ static bool _initVGContext(VGContext *c)
   c->error = VG_NO_ERROR;
   
   /* Resources */
-  SH_INITOBJ(SHPathArray, c->paths);
-  SH_INITOBJ(SHPaintArray, c->paints);
-  SH_INITOBJ(SHImageArray, c->images);
+  SH_INITOBJ(SHHandleSlotArray, c->handles);
+  c->freeHandle = -1;
 
   shLoadExtensions(c);
 
@@ -711,10 +722,21 @@ _EGLSurface* _createPbufferFromClientBuffer(
    _EGLDevice    *dev    = _getPrimaryDevice(disp);
    VuSurface     *vuSurf = malloc(sizeof(VuSurface));
    _EGLSurface   *surf = &vuSurf->base;
-   SHImage       *image  = (SHImage*)buffer;
+   _EGLContext   *ctx    = _eglGetCurrentContext();
+   SHImage       *image  = NULL;
 
-   if(buftype != EGL_OPENVG_IMAGE);
+   if(buftype != EGL_OPENVG_IMAGE){
+      _eglError(EGL_BAD_PARAMETER, "eglCreatePbufferFromClientBuffer");
       goto cleanup;
+   }
+
+   // The buffer is a VGImage handle of the current VG context
+   if(ctx)
+      image = shGetImage(&((VuContext*)ctx)->vg, (VGImage)buffer);
+   if(!image){
+      _eglError(EGL_BAD_ACCESS, "eglCreatePbufferFromClientBuffer");
+      goto cleanup;
+   }
 
    if(!_eglInitSurface(surf, disp, EGL_PBUFFER_BIT, conf, attrib_list, NULL))
       goto cleanup;
@@ -2,6 +2,10 @@
 #define VG_API_EXPORT
 #include <VG/openvg.h>
 #include "shContext.h"
+#include "shRasterizer.h"
+#include "shThreads.h"
+#include "shTessCache.h"
+#include "shGeometry.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -15,6 +19,13 @@
 
 static VGContext *g_context = NULL;
 
+#define _ITEM_T SHHandleSlot
+#define _ARRAY_T SHHandleSlotArray
+#define _FUNC_T shHandleSlotArray
+#define _COMPARE_T(s1,s2) 0
+#define _ARRAY_DEFINE
+#include "shArrayBase.h"
+
 VG_API_CALL VGboolean vgCreateContextSH(VGint width, VGint height)
 {
   /* return if already created */
@@ -24,6 +35,14 @@ VG_API_CALL VGboolean vgCreateContextSH(VGint width, VGint height)
   SH_NEWOBJ(VGContext, g_context);
   if (!g_context) return VG_FALSE;
   
+#if RENDERING_ENGINE == SOFTWARE
+  /* allocate framebuffer */
+  if (!shResizeSurface(g_context, width, height)) {
+    SH_DELETEOBJ(VGContext, g_context);
+    g_context = NULL;
+    return VG_FALSE;
+  }
+#else
   /* init surface info */
   g_context->surfaceWidth = width;
   g_context->surfaceHeight = height;
@@ -38,6 +57,7 @@ VG_API_CALL VGboolean vgCreateContextSH(VGint width, VGint height)
   
   glMatrixMode(GL_MODELVIEW);
   glLoadIdentity();
+#endif
 #endif
   
   return VG_TRUE;
@@ -47,6 +67,11 @@ VG_API_CALL void vgResizeSurfaceSH(VGint width, VGint height)
 {
   VG_GETCONTEXT(VG_NO_RETVAL);
   
+#if RENDERING_ENGINE == SOFTWARE
+  /* reallocate framebuffer */
+  if (!shResizeSurface(context, width, height))
+    shSetError(context, VG_OUT_OF_MEMORY_ERROR);
+#else
   /* update surface info */
   context->surfaceWidth = width;
   context->surfaceHeight = height;
@@ -61,6 +86,7 @@ VG_API_CALL void vgResizeSurfaceSH(VGint width, VGint height)
   
   glMatrixMode(GL_MODELVIEW);
   glLoadIdentity();
+#endif
 #endif
   
   VG_RETURN(VG_NO_RETVAL);
@@ -93,6 +119,20 @@ void VGContext_ctor(VGContext *c)
   /* Surface info */
   c->surfaceWidth = 0;
   c->surfaceHeight = 0;
+#if RENDERING_ENGINE == SOFTWARE
+  c->surfaceData = NULL;
+  c->rasterQueue = NULL;
+#endif
+  
+  /* Software rasterization settings */
+  c->rasterThreads = 0;
+  c->rasterTileSize = 64;
+  c->threadPool = NULL;
+  c->tessCache = shCreateTessCache();
+  c->geometryScratch = NULL;
+  c->strokeCacheHits = 0;
+  c->strokeCacheMisses = 0;
+  c->culledDraws = 0;
   
   /* GetString info */
   strncpy(c->vendor, "John doe", sizeof(c->vendor));
@@ -151,9 +191,8 @@ void VGContext_ctor(VGContext *c)
   c->error = VG_NO_ERROR;
   
   /* Resources */
-  SH_INITOBJ(SHPathArray, c->paths);
-  SH_INITOBJ(SHPaintArray, c->paints);
-  SH_INITOBJ(SHImageArray, c->images);
+  SH_INITOBJ(SHHandleSlotArray, c->handles);
+  c->freeHandle = -1;
 
   shLoadExtensions(c);
 }
@@ -170,14 +209,140 @@ void VGContext_dtor(VGContext *c)
   SH_DEINITOBJ(SHFloatArray, c->strokeDashPattern);
   
   /* Destroy resources */
-  for (i=0; i<c->paths.size; ++i)
-    SH_DELETEOBJ(SHPath, c->paths.items[i]);
+  for (i=0; i<c->handles.size; ++i) {
+    SHHandleSlot *slot = &c->handles.items[i];
+    switch (slot->type) {
+    case SH_RESOURCE_PATH:
+      SH_DELETEOBJ(SHPath, (SHPath*)slot->object); break;
+    case SH_RESOURCE_PAINT:
+      SH_DELETEOBJ(SHPaint, (SHPaint*)slot->object); break;
+    case SH_RESOURCE_IMAGE:
+      SH_DELETEOBJ(SHImage, (SHImage*)slot->object); break;
+    default: break;
+    }
+  }
+  
+  SH_DEINITOBJ(SHHandleSlotArray, c->handles);
+  
+#if RENDERING_ENGINE == SOFTWARE
+  shDeleteSurface(c);
+#endif
+  
+  shDeleteThreadPool(c->threadPool);
+  shDeleteTessCache(c->tessCache);
+  shDeleteGeometryScratch(c->geometryScratch, SH_MAX_THREADS);
+}
+
+/*--------------------------------------------------
+ * Returns the worker pool of the context, creating
+ * it on first use. NULL means running serially.
+ *--------------------------------------------------*/
+
+SHThreadPool* shGetThreadPool(VGContext *c)
+{
+  if (!c->threadPool)
+    c->threadPool = shCreateThreadPool();
+  
+  return c->threadPool;
+}
+
+/*--------------------------------------------------
+ * Returns the geometry build arrays of the context,
+ * one set per worker, creating them on first use.
+ *--------------------------------------------------*/
+
+struct geometry_scratch* shGetGeometryScratch(VGContext *c)
+{
+  if (!c->geometryScratch)
+    c->geometryScratch = shCreateGeometryScratch(SH_MAX_THREADS);
+  
+  return c->geometryScratch;
+}
+
+/*--------------------------------------------------
+ * Handle table. Slot indices are stored off by one
+ * so that no valid handle equals VG_INVALID_HANDLE.
+ *--------------------------------------------------*/
+
+#define SH_HANDLE_VALUE(index, gen) \
+  ((((SHuint32)(gen) & SH_HANDLE_GEN_MASK) << SH_HANDLE_SLOT_BITS) | \
+   ((SHuint32)(index) + 1))
+
+VGHandle shCreateHandle(VGContext *c, void *object, SHResourceType type)
+{
+  SHHandleSlot *slot, empty;
+  SHint index;
   
-  for (i=0; i<c->paints.size; ++i)
-    SH_DELETEOBJ(SHPaint, c->paints.items[i]);
+  if (c->freeHandle != -1) {
+    
+    /* Recycle a free slot */
+    index = c->freeHandle;
+    slot = &c->handles.items[index];
+    c->freeHandle = slot->nextFree;
+    
+  }else{
+    
+    /* Index has to fit into the handle bits */
+    if ((SHuint32)c->handles.size >= SH_HANDLE_SLOT_MASK)
+      return VG_INVALID_HANDLE;
+    
+    empty.generation = 0;
+    if (!shHandleSlotArrayPushBack(&c->handles, empty))
+      return VG_INVALID_HANDLE;
+    
+    index = c->handles.size - 1;
+    slot = &c->handles.items[index];
+  }
+  
+  slot->object = object;
+  slot->type = type;
+  slot->nextFree = -1;
+  
+  return (VGHandle)(size_t)SH_HANDLE_VALUE(index, slot->generation);
+}
+
+/*--------------------------------------------------
+ * Returns the slot of a live handle or NULL
+ *--------------------------------------------------*/
+
+static SHHandleSlot* shFindHandleSlot(VGContext *c, VGHandle h)
+{
+  size_t value = (size_t)h;
+  SHint index = (SHint)(value & SH_HANDLE_SLOT_MASK) - 1;
+  SHHandleSlot *slot;
+  
+  if (index < 0 || index >= c->handles.size)
+    return NULL;
   
-  for (i=0; i<c->images.size; ++i)
-    SH_DELETEOBJ(SHImage, c->images.items[i]);
+  slot = &c->handles.items[index];
+  if (slot->type == SH_RESOURCE_INVALID ||
+      value != SH_HANDLE_VALUE(index, slot->generation))
+    return NULL;
+  
+  return slot;
+}
+
+/*--------------------------------------------------
+ * Releases the slot of the given handle. Bumping
+ * the generation invalidates all copies of it.
+ *--------------------------------------------------*/
+
+void shDestroyHandle(VGContext *c, VGHandle h)
+{
+  SHHandleSlot *slot = shFindHandleSlot(c, h);
+  if (!slot) return;
+  
+  slot->object = NULL;
+  slot->type = SH_RESOURCE_INVALID;
+  slot->generation = (slot->generation + 1) & SH_HANDLE_GEN_MASK;
+  slot->nextFree = c->freeHandle;
+  c->freeHandle = (SHint)(slot - c->handles.items);
+}
+
+void* shGetHandleObject(VGContext *c, VGHandle h, SHResourceType type)
+{
+  SHHandleSlot *slot = shFindHandleSlot(c, h);
+  return (slot && slot->type == type) ? slot->object : NULL;
 }
 
 /*--------------------------------------------------
@@ -186,20 +351,17 @@ void VGContext_dtor(VGContext *c)
 
 SHint shIsValidPath(VGContext *c, VGHandle h)
 {
-  int index = shPathArrayFind(&c->paths, (SHPath*)h);
-  return (index == -1) ? 0 : 1;
+  return shGetHandleObject(c, h, SH_RESOURCE_PATH) != NULL;
 }
 
 SHint shIsValidPaint(VGContext *c, VGHandle h)
 {
-  int index = shPaintArrayFind(&c->paints, (SHPaint*)h);
-  return (index == -1) ? 0 : 1;
+  return shGetHandleObject(c, h, SH_RESOURCE_PAINT) != NULL;
 }
 
 SHint shIsValidImage(VGContext *c, VGHandle h)
 {
-  int index = shImageArrayFind(&c->images, (SHImage*)h);
-  return (index == -1) ? 0 : 1;
+  return shGetHandleObject(c, h, SH_RESOURCE_IMAGE) != NULL;
 }
 
 /*--------------------------------------------------
@@ -209,17 +371,8 @@ SHint shIsValidImage(VGContext *c, VGHandle h)
 
 SHResourceType shGetResourceType(VGContext *c, VGHandle h)
 {
-  if (shIsValidPath(c, h))
-    return SH_RESOURCE_PATH;
-  
-  else if (shIsValidPaint(c, h))
-    return SH_RESOURCE_PAINT;
-  
-  else if (shIsValidImage(c, h))
-    return SH_RESOURCE_IMAGE;
-  
-  else
-    return SH_RESOURCE_INVALID;
+  SHHandleSlot *slot = shFindHandleSlot(c, h);
+  return slot ? slot->type : SH_RESOURCE_INVALID;
 }
 
 /*-----------------------------------------------------
@@ -250,14 +403,22 @@ VG_API_CALL VGErrorCode vgGetError(void)
 VG_API_CALL void vgFlush(void)
 {
   VG_GETCONTEXT(VG_NO_RETVAL);
+#if RENDERING_ENGINE == SOFTWARE
+  shFlushRaster(context);
+#else
   glFlush();
+#endif
   VG_RETURN(VG_NO_RETVAL);
 }
 
 VG_API_CALL void vgFinish(void)
 {
   VG_GETCONTEXT(VG_NO_RETVAL);
+#if RENDERING_ENGINE == SOFTWARE
+  shFlushRaster(context);
+#else
   glFinish();
+#endif
   VG_RETURN(VG_NO_RETVAL);
 }
 
@@ -270,6 +431,10 @@ VG_API_CALL void vgClear(VGint x, VGint y, VGint width, VGint height)
 {
   VG_GETCONTEXT(VG_NO_RETVAL);
   
+#if RENDERING_ENGINE == SOFTWARE
+  /* Clipped to surface and scissor rectangle */
+  shClearSurface(context, x, y, width, height);
+#else
   /* Clip to window */
   if (x < 0) x = 0;
   if (y < 0) y = 0;
@@ -300,6 +465,7 @@ VG_API_CALL void vgClear(VGint x, VGint y, VGint width, VGint height)
           GL_DEPTH_BUFFER_BIT);
   
   glDisable(GL_SCISSOR_TEST);
+#endif
   
   VG_RETURN(VG_NO_RETVAL);
 }
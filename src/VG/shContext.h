@@ -21,12 +21,58 @@ typedef enum
   SH_RESOURCE_IMAGE     = 3
 } SHResourceType;
 
+/*------------------------------------------------
+ * Resource handle table. A handle packs the index
+ * of its slot with the generation of the slot at
+ * creation time, so handles of destroyed objects
+ * stop validating once their slot is recycled.
+ *------------------------------------------------*/
+
+#define SH_HANDLE_SLOT_BITS   20
+#define SH_HANDLE_SLOT_MASK   ((1u << SH_HANDLE_SLOT_BITS) - 1)
+#define SH_HANDLE_GEN_MASK    (0xFFFFFFFFu >> SH_HANDLE_SLOT_BITS)
+
+typedef struct
+{
+  void *object;
+  SHResourceType type;
+  SHuint32 generation;
+  SHint nextFree;
+  
+} SHHandleSlot;
+
+#define _ITEM_T SHHandleSlot
+#define _ARRAY_T SHHandleSlotArray
+#define _FUNC_T shHandleSlotArray
+#define _ARRAY_DECLARE
+#include "shArrayBase.h"
+
 typedef struct
 {
   /* Surface info (since no EGL yet) */
   SHint surfaceWidth;
   SHint surfaceHeight;
   
+  /* Software rasterization settings */
+  SHint rasterThreads;
+  SHint rasterTileSize;
+  
+  /* Worker threads, created on first use */
+  struct SHThreadPool *threadPool;
+  
+  /* Parked levels of detail of the path geometry */
+  struct SHTessCache *tessCache;
+  
+  /* Geometry build arrays per worker, created on first use */
+  struct geometry_scratch *geometryScratch;
+  
+  /* Stroke geometry reused / rebuilt by path draws */
+  SHint strokeCacheHits;
+  SHint strokeCacheMisses;
+  
+  /* Draws skipped off the surface and scissor */
+  SHint culledDraws;
+  
   /* GetString info */
   char vendor[256];
   char renderer[256];
@@ -83,9 +129,8 @@ typedef struct
   VGErrorCode       error;
   
   /* Resources */
-  SHPathArray       paths;
-  SHPaintArray      paints;
-  SHImageArray      images;
+  SHHandleSlotArray handles;
+  SHint             freeHandle;
 
   /* Pointers to extensions */
   SHint isGLAvailable_ClampToEdge;
@@ -96,16 +141,32 @@ typedef struct
   SH_PGLMULTITEXCOORD1F pglMultiTexCoord1f;
   SH_PGLMULTITEXCOORD2F pglMultiTexCoord2f;
   
+#if RENDERING_ENGINE == SOFTWARE
+  /* CPU framebuffer and pending draws */
+  SHuint32 *surfaceData;
+  struct SHRasterQueue *rasterQueue;
+#endif
+  
 } VGContext;
 
 void VGContext_ctor(VGContext *c);
 void VGContext_dtor(VGContext *c);
 void shSetError(VGContext *c, VGErrorCode e);
+struct SHThreadPool* shGetThreadPool(VGContext *c);
+struct geometry_scratch* shGetGeometryScratch(VGContext *c);
+VGHandle shCreateHandle(VGContext *c, void *object, SHResourceType type);
+void shDestroyHandle(VGContext *c, VGHandle h);
+void* shGetHandleObject(VGContext *c, VGHandle h, SHResourceType type);
 SHint shIsValidPath(VGContext *c, VGHandle h);
 SHint shIsValidPaint(VGContext *c, VGHandle h);
 SHint shIsValidImage(VGContext *c, VGHandle h);
 SHResourceType shGetResourceType(VGContext *c, VGHandle h);
+
+#define shGetPath(c, h)  ((SHPath*)shGetHandleObject(c, h, SH_RESOURCE_PATH))
+#define shGetPaint(c, h) ((SHPaint*)shGetHandleObject(c, h, SH_RESOURCE_PAINT))
+#define shGetImage(c, h) ((SHImage*)shGetHandleObject(c, h, SH_RESOURCE_IMAGE))
 VGContext* shGetContext();
+void shUpdateImageTexture(SHImage *i, VGContext *c);
 
 /*----------------------------------------------------
  * TODO: Add mutex locking/unlocking to these macros
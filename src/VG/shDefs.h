@@ -114,6 +114,7 @@ SHfloat getMaxFloat();
 #define SH_NEARZERO(a) (a >= -0.0001 && a < 0.0001)
 #define SH_SWAP(a,b) {SHfloat t=a; a=b; b=t;}
 #define SH_CLAMP(a,min,max) {if (a<min) a=min; if (a>max) a=max; }
+#define SH_IS_ALIGNED(ptr,type) ((((size_t)(ptr)) % sizeof(type)) == 0)
 
 #define SH_NEWOBJ(type,obj) { obj = (type*)malloc(sizeof(type)); if(obj) type ## _ctor(obj); }
 #define SH_INITOBJ(type,obj){ type ## _ctor(&obj); }
@@ -129,9 +130,16 @@ SHfloat getMaxFloat();
 #define SH_MAX_IMAGE_PIXELS              VG_MAXINT
 #define SH_MAX_IMAGE_BYTES               VG_MAXINT
 #define SH_MAX_COLOR_RAMP_STOPS          256
+#define SH_MAX_KERNEL_SIZE               16
+#define SH_MAX_SEPARABLE_KERNEL_SIZE     256
+#define SH_MAX_GAUSSIAN_STD_DEVIATION    128.0f
 
 #define SH_MAX_VERTICES 999999999
-#define SH_MAX_RECURSE_DEPTH 16
+
+/* Curve flattening, in pixels when flattened on the surface */
+#define SH_DEFAULT_FLATTEN_TOLERANCE 0.25f
+#define SH_MAX_FLATTEN_SEGMENTS      65536
+#define SH_MAX_CUBIC_QUADS           32
 
 #define SH_GRADIENT_TEX_SIZE       1024
 #define SH_GRADIENT_TEX_COORDSIZE   4096 /* 1024 * RGBA */
@@ -139,12 +147,26 @@ SHfloat getMaxFloat();
 #define OPENGL_1	0
 #define OPENGL_ES2	1
 #define VULKAN		2
+#define SOFTWARE	3
 
+#ifndef RENDERING_ENGINE
 #define RENDERING_ENGINE	OPENGL_1
+#endif
 
 /* OpenGL headers */
 
-#if defined(__APPLE__)
+#if RENDERING_ENGINE == SOFTWARE
+   /* No GL in the software engine, but keep the object
+      handles and pixel format names of shared structures */
+   typedef unsigned int GLenum;
+   typedef unsigned int GLuint;
+   typedef float GLfloat;
+#  define GL_UNSIGNED_BYTE                 0x1401
+#  define GL_ALPHA                         0x1906
+#  define GL_RGB                           0x1907
+#  define GL_RGBA                          0x1908
+#  define GL_LUMINANCE                     0x1909
+#elif defined(__APPLE__)
 #  include <OpenGL/gl.h>
 #  include <OpenGL/glu.h>
 #elif defined(_WIN32)
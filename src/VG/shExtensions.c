@@ -26,6 +26,7 @@ void fallbackMultiTexCoord2f(GLenum target, GLfloat x, GLfloat y) {
 #endif
 }
 
+#if RENDERING_ENGINE == OPENGL_1
 static int checkExtension(const char *extensions, const char *name)
 {
 	int nlen = (int)strlen(name);
@@ -50,6 +51,7 @@ static int checkExtension(const char *extensions, const char *name)
 
   return 0;
 }
+#endif
 
 typedef void (*PFVOID)();
 
@@ -60,7 +62,7 @@ PFVOID shGetProcAddress(const char *name)
   #elif defined(__APPLE__)
   /* TODO: Mac OS glGetProcAddress implementation */
   return (PFVOID)NULL;
-  #elif RENDERING_ENGINE == OPENGL_ES2
+  #elif RENDERING_ENGINE == OPENGL_ES2 || RENDERING_ENGINE == SOFTWARE
   return (PFVOID)NULL;
   #else
   return (PFVOID)glXGetProcAddress((const unsigned char *)name);
@@ -0,0 +1,1225 @@
+#define VG_API_EXPORT
+#include <VG/openvg.h>
+#include "shImage.h"
+#include "shContext.h"
+#include "shThreads.h"
+#include "shRasterizer.h"
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*-----------------------------------------------------------
+ * Image filters work on 8 bit RGBA words (red in the top
+ * byte) in the processing format picked by the filter format
+ * parameters. The whole source is converted, since filters
+ * read around the pixels they write, and tiling extends it.
+ *
+ * Separable filters run one pass per axis over rows. A pass
+ * writes its rows transposed, a block of rows at a time so
+ * that every column gets a short contiguous run, which lets
+ * both passes read rows and the second one restore the
+ * orientation. Blocks are spread over the worker threads.
+ *-----------------------------------------------------------*/
+
+#define SH_FILTER_BLOCK 8
+
+typedef void (*SHFilterRowFunc) (const SHuint32 *in, SHuint32 *out,
+                                 SHint count, const void *kernel,
+                                 void *scratch);
+
+typedef struct
+{
+  SHFilterRowFunc func;
+  const void *kernel;
+  SHint before, after;      /* pixels read around the filtered ones */
+  SHint scratchBytes;       /* per pixel of the extended row */
+
+} SHFilterAxis;
+
+typedef struct
+{
+  const SHuint32 *in;       /* rows to filter */
+  SHint inLength;           /* pixels per row, tiled beyond */
+  SHint inWords;            /* words per pixel */
+  SHint rows;
+  SHuint32 *out;            /* filtered rows, written transposed */
+  SHint outLength;          /* pixels filtered per row */
+  SHint outWords;
+  const SHFilterAxis *axis;
+  VGTilingMode tiling;
+  const SHuint32 *fill;     /* edge pixel for VG_TILE_FILL */
+  SHuint8 *scratch;         /* per worker */
+  SHint scratchBytes;
+
+} SHFilterPass;
+
+static VGImageFormat shFilterFormat(VGContext *c)
+{
+  if (c->filterFormatLinear)
+    return c->filterFormatPremultiplied ? VG_lRGBA_8888_PRE : VG_lRGBA_8888;
+  else
+    return c->filterFormatPremultiplied ? VG_sRGBA_8888_PRE : VG_sRGBA_8888;
+}
+
+static SHuint32 shFilterFillWord(VGContext *c, VGImageFormat format)
+{
+  SHImageFormatDesc fd;
+  SHColor fill = c->tileFillColor;
+  SHuint32 word;
+
+  SH_CLAMP(fill.r, 0.0f, 1.0f);
+  SH_CLAMP(fill.g, 0.0f, 1.0f);
+  SH_CLAMP(fill.b, 0.0f, 1.0f);
+  SH_CLAMP(fill.a, 0.0f, 1.0f);
+
+  if (shIsLinearImageFormat(format))
+    shLinearizeColor(&fill);
+  if (shIsPremultipliedImageFormat(format))
+    CPREMUL(fill);
+
+  shSetupImageFormat(format, &fd);
+  shStoreColor(&fill, &word, &fd);
+  return word;
+}
+
+static SHuint32* shFilterReadSource(SHImage *s, VGImageFormat format)
+{
+  SHuint32 *words;
+
+  words = (SHuint32*)malloc((size_t)s->width * s->height * sizeof(SHuint32));
+  if (!words) return NULL;
+
+  shCopyPixels((SHuint8*)words, format, s->width * 4,
+               s->data, s->fd.vgformat, s->texwidth * s->fd.bytes,
+               s->width, s->height, s->width, s->height,
+               0, 0, 0, 0, s->width, s->height);
+
+  return words;
+}
+
+/*-----------------------------------------------------------
+ * Writes the filtered words into the lower-left corner of
+ * the destination. Channels left out of the filter channel
+ * mask keep their values, compared in non-premultiplied
+ * colors of the destination color space; luminance targets
+ * ignore the mask.
+ *-----------------------------------------------------------*/
+
+static int shFilterWriteResult(VGContext *c, SHImage *d, SHuint32 *words,
+                               SHint width, SHint height, VGImageFormat format)
+{
+  VGbitfield all = VG_RED | VG_GREEN | VG_BLUE | VG_ALPHA;
+  VGbitfield mask = c->filterChannelMask & all;
+  VGImageFormat merge;
+  SHuint32 *old, keep = 0x0;
+  SHint i, n = width * height;
+
+  if (mask == all || d->fd.vgformat == VG_sL_8 || d->fd.vgformat == VG_lL_8) {
+    shCopyPixels(d->data, d->fd.vgformat, d->texwidth * d->fd.bytes,
+                 (SHuint8*)words, format, width * 4,
+                 d->width, d->height, width, height,
+                 0, 0, 0, 0, width, height);
+    return 1;
+  }
+
+  old = (SHuint32*)malloc((size_t)n * sizeof(SHuint32));
+  if (!old) return 0;
+
+  /* Channel bits of the mask match the bytes of the words */
+  for (i=0; i<4; ++i)
+    if (!(mask & (1 << i))) keep |= 0xFFu << (8 * i);
+
+  merge = shIsLinearImageFormat(d->fd.vgformat) ? VG_lRGBA_8888 : VG_sRGBA_8888;
+
+  shCopyPixels((SHuint8*)old, merge, width * 4,
+               d->data, d->fd.vgformat, d->texwidth * d->fd.bytes,
+               width, height, d->width, d->height,
+               0, 0, 0, 0, width, height);
+
+  /* Converts in place, every pixel is read before written */
+  if (format != merge)
+    shCopyPixels((SHuint8*)words, merge, width * 4,
+                 (SHuint8*)words, format, width * 4,
+                 width, height, width, height,
+                 0, 0, 0, 0, width, height);
+
+  for (i=0; i<n; ++i)
+    words[i] = (words[i] & ~keep) | (old[i] & keep);
+
+  shCopyPixels(d->data, d->fd.vgformat, d->texwidth * d->fd.bytes,
+               (SHuint8*)words, merge, width * 4,
+               d->width, d->height, width, height,
+               0, 0, 0, 0, width, height);
+
+  free(old);
+  return 1;
+}
+
+/*-----------------------------------------------------------
+ * Fills count pixels, of the given number of words each,
+ * with those of a row starting at the given (possibly
+ * negative) offset, tiling outside the row
+ *-----------------------------------------------------------*/
+
+static void shFilterExtendRow(const SHuint32 *row, SHint size, SHint words,
+                              SHint start, SHint count, VGTilingMode tiling,
+                              const SHuint32 *fill, SHuint32 *out)
+{
+  SHint i, j, inside0, inside1;
+
+  inside0 = SH_MIN(SH_MAX(-start, 0), count);
+  inside1 = SH_MAX(SH_MIN(size - start, count), inside0);
+
+  for (i=0; i<inside0; ++i) {
+    j = shTileCoord(start + i, size, tiling);
+    memcpy(out + i * words, (j < 0) ? fill : row + j * words,
+           words * sizeof(SHuint32));
+  }
+
+  memcpy(out + inside0 * words, row + (start + inside0) * words,
+         (inside1 - inside0) * words * sizeof(SHuint32));
+
+  for (i=inside1; i<count; ++i) {
+    j = shTileCoord(start + i, size, tiling);
+    memcpy(out + i * words, (j < 0) ? fill : row + j * words,
+           words * sizeof(SHuint32));
+  }
+}
+
+static void shFilterPassTask(void *data, SHint index, SHint worker)
+{
+  SHFilterPass *p = (SHFilterPass*)data;
+  const SHFilterAxis *a = p->axis;
+  SHint extLength = a->before + p->outLength + a->after;
+  SHint rowWords = p->outLength * p->outWords;
+  SHuint32 *ext = (SHuint32*)(p->scratch + worker * p->scratchBytes);
+  SHuint32 *block = ext + extLength * p->inWords;
+  void *rowScratch = block + SH_FILTER_BLOCK * rowWords;
+  SHint y0 = index * SH_FILTER_BLOCK;
+  SHint n = SH_MIN(SH_FILTER_BLOCK, p->rows - y0);
+  SHuint32 *col;
+  const SHuint32 *pixel;
+  SHint k, x, w;
+
+  for (k=0; k<n; ++k) {
+    shFilterExtendRow(p->in + (size_t)(y0 + k) * p->inLength * p->inWords,
+                      p->inLength, p->inWords, -a->before, extLength,
+                      p->tiling, p->fill, ext);
+    a->func(ext, block + k * rowWords, p->outLength, a->kernel, rowScratch);
+  }
+
+  /* Each column of the block lands as a short contiguous run */
+  if (p->outWords == 1) {
+    for (x=0; x<p->outLength; ++x) {
+      col = p->out + (size_t)x * p->rows + y0;
+      for (k=0; k<n; ++k)
+        col[k] = block[k * rowWords + x];
+    }
+    return;
+  }
+
+  for (x=0; x<p->outLength; ++x) {
+    col = p->out + ((size_t)x * p->rows + y0) * p->outWords;
+    for (k=0; k<n; ++k) {
+      pixel = block + k * rowWords + x * p->outWords;
+      for (w=0; w<p->outWords; ++w)
+        *col++ = pixel[w];
+    }
+  }
+}
+
+static int shRunFilterPass(VGContext *c, SHFilterPass *p)
+{
+  const SHFilterAxis *a = p->axis;
+  SHint threads = shThreadCount(c->rasterThreads);
+  SHint blocks = (p->rows + SH_FILTER_BLOCK - 1) / SH_FILTER_BLOCK;
+  SHint extLength = a->before + p->outLength + a->after;
+
+  threads = SH_MAX(SH_MIN(threads, blocks), 1);
+
+  /* Row scratch stays aligned for any element type */
+  p->scratchBytes = (extLength * p->inWords +
+                     SH_FILTER_BLOCK * p->outLength * p->outWords) *
+                    sizeof(SHuint32);
+  p->scratchBytes = (p->scratchBytes + 15) & ~15;
+  p->scratchBytes += (a->scratchBytes * extLength + 15) & ~15;
+
+  p->scratch = (SHuint8*)malloc((size_t)threads * p->scratchBytes);
+  if (!p->scratch) return 0;
+
+  shParallelFor(shGetThreadPool(c), threads, blocks, shFilterPassTask, p);
+
+  free(p->scratch);
+  return 1;
+}
+
+/*-----------------------------------------------------------
+ * Runs a separable filter over the source and returns the
+ * filtered area of size (width,height), anchored at the
+ * lower-left corner, in a new buffer of words. Rows are
+ * filtered along x into columns of pixels with midWords
+ * words each, then the columns along y back into rows. The
+ * mid fill pixel stands for rows outside the source.
+ *-----------------------------------------------------------*/
+
+static SHuint32* shFilterSeparable(VGContext *c, const SHuint32 *words,
+                                   SHint swidth, SHint sheight,
+                                   SHint width, SHint height,
+                                   VGTilingMode tiling, const SHuint32 *fill,
+                                   SHint midWords, const SHuint32 *midFill,
+                                   const SHFilterAxis *x, const SHFilterAxis *y)
+{
+  SHFilterPass p;
+  SHuint32 *columns, *rows;
+
+  columns = (SHuint32*)malloc((size_t)width * sheight * midWords *
+                              sizeof(SHuint32));
+  rows = (SHuint32*)malloc((size_t)width * height * sizeof(SHuint32));
+  if (!columns || !rows) {
+    free(columns); free(rows);
+    return NULL;
+  }
+
+  p.tiling = tiling;
+
+  p.in = words;
+  p.inLength = swidth;
+  p.inWords = 1;
+  p.rows = sheight;
+  p.out = columns;
+  p.outLength = width;
+  p.outWords = midWords;
+  p.axis = x;
+  p.fill = fill;
+
+  if (!shRunFilterPass(c, &p)) {
+    free(columns); free(rows);
+    return NULL;
+  }
+
+  p.in = columns;
+  p.inLength = sheight;
+  p.inWords = midWords;
+  p.rows = width;
+  p.out = rows;
+  p.outLength = height;
+  p.outWords = 1;
+  p.axis = y;
+  p.fill = midFill;
+
+  if (!shRunFilterPass(c, &p)) {
+    free(columns); free(rows);
+    return NULL;
+  }
+
+  free(columns);
+  return rows;
+}
+
+/*-----------------------------------------------------------
+ * Gaussian kernels. Small deviations use the exact kernel,
+ * truncated at 3 deviations, with 16 bit fixed point weights
+ * summing to one. Larger ones use three successive box
+ * filters with widths picked to match the variance, which
+ * cost the same per pixel at any deviation; values between
+ * the boxes keep 8 fractional bits.
+ *-----------------------------------------------------------*/
+
+#define SH_GAUSSIAN_EXACT_MAX_SIGMA 4.0f
+#define SH_GAUSSIAN_MAX_TAPS (2 * 12 + 1)
+
+typedef struct
+{
+  SHint radius;                           /* pixels read on each side */
+  SHint taps;                             /* 0 when using the boxes */
+  SHuint32 weights[SH_GAUSSIAN_MAX_TAPS];
+  SHint boxes[3];                         /* box radii */
+
+} SHGaussianKernel;
+
+static void shSetupGaussianKernel(SHGaussianKernel *k, SHfloat sigma)
+{
+  SHfloat f[SH_GAUSSIAN_MAX_TAPS], sum, ideal;
+  SHint i, r, total, wl, m;
+
+  if (sigma <= SH_GAUSSIAN_EXACT_MAX_SIGMA) {
+
+    r = (SHint)SH_CEIL(3.0f * sigma);
+    sum = 0.0f;
+    for (i=-r; i<=r; ++i) {
+      f[i+r] = (SHfloat)exp(-(i*i) / (2.0f * sigma * sigma));
+      sum += f[i+r];
+    }
+
+    total = 0;
+    for (i=0; i<2*r+1; ++i) {
+      k->weights[i] = (SHuint32)(f[i] / sum * 65536.0f + 0.5f);
+      total += k->weights[i];
+    }
+
+    /* Rounding leftovers go to the center */
+    k->weights[r] += 65536 - total;
+    k->radius = r;
+    k->taps = 2*r+1;
+
+  }else{
+
+    /* Odd widths wl and wl+2 for the boxes, m of the first */
+    ideal = SH_SQRT(4.0f * sigma * sigma + 1.0f);
+    wl = (SHint)ideal;
+    if (wl % 2 == 0) wl--;
+    m = (SHint)((12.0f * sigma * sigma - 3*wl*wl - 12*wl - 9) /
+                (-4.0f * wl - 4.0f) + 0.5f);
+
+    k->radius = 0;
+    k->taps = 0;
+    for (i=0; i<3; ++i) {
+      k->boxes[i] = (i < m ? wl : wl + 2) / 2;
+      k->radius += k->boxes[i];
+    }
+  }
+}
+
+/* Pairs of channels spread to 32 bit lanes of a 64 bit word */
+#define SH_SPREAD_RB(p) (((uint64_t)((p) >> 24) << 32) | (((p) >> 8) & 0xFF))
+#define SH_SPREAD_GA(p) (((uint64_t)(((p) >> 16) & 0xFF) << 32) | ((p) & 0xFF))
+#define SH_LANE_ROUND(r) (((uint64_t)(r) << 32) | (r))
+
+static void shGaussianExactRow(const SHGaussianKernel *k, SHuint32 *out,
+                               SHint count, const uint64_t *rb,
+                               const uint64_t *ga)
+{
+  const SHuint32 *w = k->weights;
+  const uint64_t *prb, *pga;
+  SHint r = k->radius, i, x;
+  uint64_t srb, sga;
+
+  /* Lanes stay below 2^24, the weights sum to 2^16 */
+  for (x=0; x<count; ++x) {
+    prb = rb + x; pga = ga + x;
+    srb = SH_LANE_ROUND(0x8000) + w[r] * prb[r];
+    sga = SH_LANE_ROUND(0x8000) + w[r] * pga[r];
+
+    for (i=0; i<r; ++i) {
+      srb += w[i] * (prb[i] + prb[2*r - i]);
+      sga += w[i] * (pga[i] + pga[2*r - i]);
+    }
+
+    out[x] = ((SHuint32)(srb >> 48) & 0xFF) << 24 |
+             ((SHuint32)(sga >> 48) & 0xFF) << 16 |
+             ((SHuint32)(srb >> 16) & 0xFF) << 8 |
+             ((SHuint32)(sga >> 16) & 0xFF);
+  }
+}
+
+static void shGaussianBoxRow(const SHGaussianKernel *k, SHuint32 *out,
+                             SHint count, uint64_t *rb, uint64_t *ga,
+                             SHint length)
+{
+  uint64_t srb, sga, vrb, vga, inv;
+  SHint i, n, w, x;
+
+  /* Each box keeps a running sum of its window and writes
+     its averages in place over the values it has passed */
+  for (n=length, i=0; i<3; ++i) {
+    w = 2 * k->boxes[i] + 1;
+    inv = (((uint64_t)1 << 32) + w/2) / w;
+
+    for (srb=0, sga=0, x=0; x<w; ++x) {
+      srb += rb[x];
+      sga += ga[x];
+    }
+
+    for (x=0; ; ++x) {
+      vrb = (((srb >> 32) * inv + 0x80000000u) >> 32) << 32 |
+            (((srb & 0xFFFFFFFF) * inv + 0x80000000u) >> 32);
+      vga = (((sga >> 32) * inv + 0x80000000u) >> 32) << 32 |
+            (((sga & 0xFFFFFFFF) * inv + 0x80000000u) >> 32);
+      if (x + w >= n) {
+        rb[x] = vrb; ga[x] = vga;
+        break;
+      }
+
+      /* Adding first keeps every lane from borrowing */
+      srb = srb + rb[x + w] - rb[x];
+      sga = sga + ga[x + w] - ga[x];
+      rb[x] = vrb; ga[x] = vga;
+    }
+
+    n -= w - 1;
+  }
+
+  for (x=0; x<count; ++x) {
+    vrb = (rb[x] + SH_LANE_ROUND(0x80)) >> 8;
+    vga = (ga[x] + SH_LANE_ROUND(0x80)) >> 8;
+    out[x] = ((SHuint32)(vrb >> 32) & 0xFF) << 24 |
+             ((SHuint32)(vga >> 32) & 0xFF) << 16 |
+             ((SHuint32)vrb & 0xFF) << 8 |
+             ((SHuint32)vga & 0xFF);
+  }
+}
+
+static void shGaussianRow(const SHuint32 *in, SHuint32 *out, SHint count,
+                          const void *kernel, void *scratch)
+{
+  const SHGaussianKernel *k = (const SHGaussianKernel*)kernel;
+  SHint length = count + 2 * k->radius;
+  uint64_t *rb = (uint64_t*)scratch;
+  uint64_t *ga = rb + length;
+  SHint i;
+
+  if (k->taps) {
+
+    for (i=0; i<length; ++i) {
+      rb[i] = SH_SPREAD_RB(in[i]);
+      ga[i] = SH_SPREAD_GA(in[i]);
+    }
+
+    shGaussianExactRow(k, out, count, rb, ga);
+
+  }else{
+
+    /* Box values keep 8 fractional bits */
+    for (i=0; i<length; ++i) {
+      rb[i] = SH_SPREAD_RB(in[i]) << 8;
+      ga[i] = SH_SPREAD_GA(in[i]) << 8;
+    }
+
+    shGaussianBoxRow(k, out, count, rb, ga, length);
+  }
+}
+
+static void shSetupGaussianAxis(SHFilterAxis *a, const SHGaussianKernel *k)
+{
+  a->func = shGaussianRow;
+  a->kernel = k;
+  a->before = k->radius;
+  a->after = k->radius;
+  a->scratchBytes = 2 * sizeof(uint64_t);
+}
+
+/*-----------------------------------------------------------
+ * Convolution kernels. Channels are filtered as planes of
+ * 16 bit samples, a block of pixels at a time through all
+ * the taps, so the inner loops carry no edge tests or
+ * channel shuffles. Kernel weights are stored reversed,
+ * which turns the convolution into a plain weighted sum
+ * over the samples at increasing offsets, and packed in
+ * pairs of adjacent taps for the SSE2 multiply-add.
+ *
+ * With at most 256 taps of 16 bit weights, sums of 8 bit
+ * values fit 32 bits. The second pass of a separable kernel
+ * weights those sums again, as 16 bit samples when the
+ * weights keep them in range, otherwise accumulating in
+ * 64 bits.
+ *-----------------------------------------------------------*/
+
+#define SH_CONVOLVE_TILE_WIDTH  128
+#define SH_CONVOLVE_TILE_HEIGHT 16
+
+typedef struct
+{
+  SHint taps;
+  SHint32 weights[SH_MAX_SEPARABLE_KERNEL_SIZE];
+  SHint pairCount;
+  SHint32 pairs[(SH_MAX_SEPARABLE_KERNEL_SIZE + 1) / 2];
+  SHfloat scale;
+  SHfloat bias;             /* in 8 bit units */
+  SHint clampToAlpha;
+
+} SHConvolveKernel;
+
+typedef struct
+{
+  const SHuint32 *in;
+  SHint swidth, sheight;
+  SHuint32 *out;
+  SHint width, height;
+  SHint kwidth, kheight;
+  SHint shiftX, shiftY;
+  SHint pairCount;          /* per kernel row */
+  SHint32 pairs[SH_MAX_KERNEL_SIZE * ((SH_MAX_KERNEL_SIZE + 1) / 2)];
+  SHfloat scale;
+  SHfloat bias;
+  SHint clampToAlpha;
+  VGTilingMode tiling;
+  SHuint32 fill;
+  SHint tilesX;
+  SHuint8 *scratch;         /* per worker */
+  SHint scratchBytes;
+
+} SHConvolve;
+
+static void shPackWeightPairs(SHint32 *pairs, const SHint32 *weights,
+                              SHint taps)
+{
+  SHint32 w0, w1;
+  SHint q;
+
+  for (q=0; q<(taps + 1) / 2; ++q) {
+    w0 = weights[2*q];
+    w1 = (2*q + 1 < taps) ? weights[2*q + 1] : 0;
+    pairs[q] = (SHint32)(((SHuint32)w1 << 16) | ((SHuint32)w0 & 0xFFFF));
+  }
+}
+
+/*-----------------------------------------------------------
+ * Writes count sums of rows of samples, stride apart,
+ * weighted by the rows of pairs. Samples are read up to one
+ * past the last tap of each row.
+ *-----------------------------------------------------------*/
+
+static void shConvolveSum16(SHint32 *out, const SHint16 *src, SHint stride,
+                            const SHint32 *pairs, SHint pairCount,
+                            SHint rows, SHint count)
+{
+  const SHint16 *s;
+  SHint32 w, sum;
+  SHint x = 0, j, q;
+
+#ifdef __SSE2__
+  __m128i s0, s1, w2, a0, a1;
+
+  /* Every multiply-add covers two taps of four pixels */
+  for (; x + 8 <= count; x += 8) {
+    a0 = _mm_setzero_si128();
+    a1 = _mm_setzero_si128();
+
+    for (j=0; j<rows; ++j) {
+      s = src + j * stride + x;
+      for (q=0; q<pairCount; ++q, s += 2) {
+        w = pairs[j * pairCount + q];
+        if (w == 0) continue;
+        w2 = _mm_set1_epi32(w);
+        s0 = _mm_loadu_si128((const __m128i*)s);
+        s1 = _mm_loadu_si128((const __m128i*)(s + 1));
+        a0 = _mm_add_epi32(a0, _mm_madd_epi16(_mm_unpacklo_epi16(s0, s1), w2));
+        a1 = _mm_add_epi32(a1, _mm_madd_epi16(_mm_unpackhi_epi16(s0, s1), w2));
+      }
+    }
+
+    _mm_storeu_si128((__m128i*)(out + x), a0);
+    _mm_storeu_si128((__m128i*)(out + x + 4), a1);
+  }
+#endif
+
+  for (; x < count; ++x) {
+    sum = 0;
+    for (j=0; j<rows; ++j) {
+      s = src + j * stride + x;
+      for (q=0; q<pairCount; ++q, s += 2) {
+        w = pairs[j * pairCount + q];
+        sum += (SHint16)(w & 0xFFFF) * s[0] +
+               (SHint16)((SHuint32)w >> 16) * s[1];
+      }
+    }
+    out[x] = sum;
+  }
+}
+
+static SHuint32 shConvolveValue(SHfloat v)
+{
+  if (v <= 0.0f) return 0;
+  if (v >= 255.0f) return 255;
+  return (SHuint32)(v + 0.5f);
+}
+
+/* Copies the channel at the given shift of a row into a plane */
+static void shUnpackPlane16(const SHuint32 *rgba, SHint16 *plane,
+                            SHint count, SHint shift)
+{
+  SHint x = 0;
+
+#ifdef __SSE2__
+  __m128i mask = _mm_set1_epi32(0xFF), n = _mm_cvtsi32_si128(shift);
+  __m128i lo, hi;
+
+  for (; x + 8 <= count; x += 8) {
+    lo = _mm_loadu_si128((const __m128i*)(rgba + x));
+    hi = _mm_loadu_si128((const __m128i*)(rgba + x + 4));
+    lo = _mm_and_si128(_mm_srl_epi32(lo, n), mask);
+    hi = _mm_and_si128(_mm_srl_epi32(hi, n), mask);
+    _mm_storeu_si128((__m128i*)(plane + x), _mm_packs_epi32(lo, hi));
+  }
+#endif
+
+  for (; x < count; ++x)
+    plane[x] = (SHint16)((rgba[x] >> shift) & 0xFF);
+}
+
+/* Scales and biases sums into the channel at the given shift
+   of a row, which starts out cleared for the first channel */
+static void shPackPlane32(const SHint32 *acc, SHuint32 *rgba, SHint count,
+                          SHfloat scale, SHfloat bias, SHint shift)
+{
+  SHint x = 0;
+
+#ifdef __SSE2__
+  __m128 s = _mm_set1_ps(scale), b = _mm_set1_ps(bias + 0.5f);
+  __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(255.0f), f;
+  __m128i n = _mm_cvtsi32_si128(shift), v;
+
+  /* Rounds like shConvolveValue. Clamps before converting, since
+     values out of the int range convert to INT_MIN */
+  for (; x + 4 <= count; x += 4) {
+    v = _mm_loadu_si128((const __m128i*)(acc + x));
+    f = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), s), b);
+    v = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(f, lo), hi));
+    v = _mm_sll_epi32(v, n);
+    v = _mm_or_si128(v, _mm_loadu_si128((const __m128i*)(rgba + x)));
+    _mm_storeu_si128((__m128i*)(rgba + x), v);
+  }
+#endif
+
+  for (; x < count; ++x)
+    rgba[x] |= shConvolveValue((SHfloat)acc[x] * scale + bias) << shift;
+}
+
+/* Premultiplied results keep their colors below alpha */
+static void shClampRowToAlpha(SHuint32 *rgba, SHint count)
+{
+  SHuint32 p, a, r, g, b;
+  SHint x;
+
+  for (x=0; x<count; ++x) {
+    p = rgba[x];
+    a = p & 0xFF;
+    r = p >> 24;
+    g = (p >> 16) & 0xFF;
+    b = (p >> 8) & 0xFF;
+    if (r > a) r = a;
+    if (g > a) g = a;
+    if (b > a) b = a;
+    rgba[x] = (r << 24) | (g << 16) | (b << 8) | a;
+  }
+}
+
+static void shConvolveRowX(const SHuint32 *in, SHuint32 *out, SHint count,
+                           const void *kernel, void *scratch)
+{
+  const SHConvolveKernel *k = (const SHConvolveKernel*)kernel;
+  SHint length = count + k->taps - 1;
+  SHint32 *acc = (SHint32*)scratch;
+  SHint16 *plane = (SHint16*)(acc + count);
+  SHint c, x, shift;
+
+  for (c=0; c<4; ++c) {
+    shift = 24 - 8*c;
+
+    shUnpackPlane16(in, plane, length, shift);
+    plane[length] = 0;
+
+    shConvolveSum16(acc, plane, 0, k->pairs, k->pairCount, 1, count);
+
+    for (x=0; x<count; ++x)
+      out[x*4 + c] = (SHuint32)acc[x];
+  }
+}
+
+static void shConvolveRowY(const SHuint32 *in, SHuint32 *out, SHint count,
+                           const void *kernel, void *scratch)
+{
+  const SHConvolveKernel *k = (const SHConvolveKernel*)kernel;
+  SHint length = count + k->taps - 1;
+  int64_t *acc = (int64_t*)scratch;
+  SHint32 *plane = (SHint32*)(acc + length);
+  const SHint32 *src;
+  SHint32 w;
+  SHint c, i, t, x, shift;
+
+  for (c=0; c<4; ++c) {
+    shift = 24 - 8*c;
+
+    for (i=0; i<length; ++i)
+      plane[i] = (SHint32)in[i*4 + c];
+
+    for (x=0; x<count; ++x)
+      acc[x] = 0;
+
+    for (t=0; t<k->taps; ++t) {
+      w = k->weights[t];
+      if (w == 0) continue;
+      src = plane + t;
+      for (x=0; x<count; ++x)
+        acc[x] += (int64_t)w * src[x];
+    }
+
+    if (c == 0) {
+      for (x=0; x<count; ++x)
+        out[x] = shConvolveValue((SHfloat)acc[x] * k->scale + k->bias) << shift;
+    }else{
+      for (x=0; x<count; ++x)
+        out[x] |= shConvolveValue((SHfloat)acc[x] * k->scale + k->bias) << shift;
+    }
+  }
+
+  if (k->clampToAlpha)
+    shClampRowToAlpha(out, count);
+}
+
+/* Horizontal sums kept as 16 bit samples, two per word */
+static void shConvolveRowX16(const SHuint32 *in, SHuint32 *out, SHint count,
+                             const void *kernel, void *scratch)
+{
+  const SHConvolveKernel *k = (const SHConvolveKernel*)kernel;
+  SHint length = count + k->taps - 1;
+  SHint32 *acc = (SHint32*)scratch;
+  SHint16 *plane = (SHint16*)(acc + count);
+  SHint c, x;
+
+  for (c=0; c<4; ++c) {
+    shUnpackPlane16(in, plane, length, 24 - 8*c);
+    plane[length] = 0;
+
+    shConvolveSum16(acc, plane, 0, k->pairs, k->pairCount, 1, count);
+
+    if (c % 2 == 0) {
+      for (x=0; x<count; ++x)
+        out[x*2 + c/2] = (SHuint32)acc[x] & 0xFFFF;
+    }else{
+      for (x=0; x<count; ++x)
+        out[x*2 + c/2] |= (SHuint32)acc[x] << 16;
+    }
+  }
+}
+
+static void shConvolveRowY16(const SHuint32 *in, SHuint32 *out, SHint count,
+                             const void *kernel, void *scratch)
+{
+  const SHConvolveKernel *k = (const SHConvolveKernel*)kernel;
+  SHint length = count + k->taps - 1;
+  SHint32 *acc = (SHint32*)scratch;
+  SHint16 *plane = (SHint16*)(acc + count);
+  SHint c, i, word;
+
+  memset(out, 0, count * sizeof(SHuint32));
+
+  for (c=0; c<4; ++c) {
+    word = c / 2;
+    if (c % 2 == 0) {
+      for (i=0; i<length; ++i)
+        plane[i] = (SHint16)(in[i*2 + word] & 0xFFFF);
+    }else{
+      for (i=0; i<length; ++i)
+        plane[i] = (SHint16)(in[i*2 + word] >> 16);
+    }
+    plane[length] = 0;
+
+    shConvolveSum16(acc, plane, 0, k->pairs, k->pairCount, 1, count);
+    shPackPlane32(acc, out, count, k->scale, k->bias, 24 - 8*c);
+  }
+
+  if (k->clampToAlpha)
+    shClampRowToAlpha(out, count);
+}
+
+/* Whether sums along x fit 16 bits and their sums along y 32 */
+static int shConvolveFitsNarrow(const SHConvolveKernel *kx,
+                                const SHConvolveKernel *ky)
+{
+  SHint32 pos = 0, neg = 0, range, total = 0;
+  SHint i;
+
+  for (i=0; i<kx->taps; ++i) {
+    if (kx->weights[i] > 0) pos += kx->weights[i];
+    else neg -= kx->weights[i];
+  }
+  range = 255 * SH_MAX(pos, neg);
+
+  for (i=0; i<ky->taps; ++i)
+    total += (ky->weights[i] < 0) ? -ky->weights[i] : ky->weights[i];
+
+  return range <= 0x7FFF && (int64_t)range * total <= 0x7FFFFFFF;
+}
+
+/*-----------------------------------------------------------
+ * Non-separable kernels run over tiles of the destination.
+ * Every tile first tiles the source area it reads into
+ * channel planes, which hoists all edge handling out of
+ * the weighted sums and keeps the planes in cache while
+ * each of them is read once per tap.
+ *-----------------------------------------------------------*/
+
+static void shConvolveTask(void *data, SHint index, SHint worker)
+{
+  SHConvolve *p = (SHConvolve*)data;
+  SHint x0 = (index % p->tilesX) * SH_CONVOLVE_TILE_WIDTH;
+  SHint y0 = (index / p->tilesX) * SH_CONVOLVE_TILE_HEIGHT;
+  SHint tw = SH_MIN(SH_CONVOLVE_TILE_WIDTH, p->width - x0);
+  SHint th = SH_MIN(SH_CONVOLVE_TILE_HEIGHT, p->height - y0);
+  SHint ew = tw + p->kwidth - 1;
+  SHint eh = th + p->kheight - 1;
+  SHuint32 *ext = (SHuint32*)(p->scratch + worker * p->scratchBytes);
+  SHint32 *acc = (SHint32*)(ext + ew);
+  SHint16 *planes = (SHint16*)(acc + tw);
+  SHuint32 *dst;
+  SHint c, i, r, y, sy;
+
+  for (r=0; r<eh; ++r) {
+    sy = shTileCoord(y0 - p->shiftY + r, p->sheight, p->tiling);
+    if (sy < 0) {
+      for (i=0; i<ew; ++i)
+        ext[i] = p->fill;
+    }else{
+      shFilterExtendRow(p->in + (size_t)sy * p->swidth, p->swidth, 1,
+                        x0 - p->shiftX, ew, p->tiling, &p->fill, ext);
+    }
+
+    for (c=0; c<4; ++c)
+      shUnpackPlane16(ext, planes + (c * eh + r) * ew, ew, 24 - 8*c);
+  }
+  planes[4 * eh * ew] = 0;
+
+  for (y=0; y<th; ++y) {
+    dst = p->out + (size_t)(y0 + y) * p->width + x0;
+    memset(dst, 0, tw * sizeof(SHuint32));
+
+    for (c=0; c<4; ++c) {
+      shConvolveSum16(acc, planes + (c * eh + y) * ew, ew,
+                      p->pairs, p->pairCount, p->kheight, tw);
+      shPackPlane32(acc, dst, tw, p->scale, p->bias, 24 - 8*c);
+    }
+
+    if (p->clampToAlpha)
+      shClampRowToAlpha(dst, tw);
+  }
+}
+
+static SHuint32* shConvolveImage(VGContext *c, SHConvolve *p)
+{
+  SHint threads = shThreadCount(c->rasterThreads);
+  SHint tilesY = (p->height + SH_CONVOLVE_TILE_HEIGHT - 1) / SH_CONVOLVE_TILE_HEIGHT;
+  SHint ew = SH_CONVOLVE_TILE_WIDTH + p->kwidth - 1;
+  SHint eh = SH_CONVOLVE_TILE_HEIGHT + p->kheight - 1;
+  SHint tiles;
+
+  p->tilesX = (p->width + SH_CONVOLVE_TILE_WIDTH - 1) / SH_CONVOLVE_TILE_WIDTH;
+  tiles = p->tilesX * tilesY;
+  threads = SH_MAX(SH_MIN(threads, tiles), 1);
+
+  p->out = (SHuint32*)malloc((size_t)p->width * p->height * sizeof(SHuint32));
+  if (!p->out) return NULL;
+
+  /* Extended row, sums and planes with spare samples */
+  p->scratchBytes = (ew + SH_CONVOLVE_TILE_WIDTH) * sizeof(SHuint32) +
+                    (4 * eh * ew + 8) * sizeof(SHint16);
+  p->scratchBytes = (p->scratchBytes + 15) & ~15;
+
+  p->scratch = (SHuint8*)malloc((size_t)threads * p->scratchBytes);
+  if (!p->scratch) {
+    free(p->out);
+    return NULL;
+  }
+
+  shParallelFor(shGetThreadPool(c), threads, tiles, shConvolveTask, p);
+
+  free(p->scratch);
+  return p->out;
+}
+
+static void shSetupConvolveKernel(SHConvolveKernel *k, const VGshort *weights,
+                                  SHint taps)
+{
+  SHint i;
+
+  k->taps = taps;
+  for (i=0; i<taps; ++i)
+    k->weights[i] = weights[taps - 1 - i];
+
+  k->pairCount = (taps + 1) / 2;
+  shPackWeightPairs(k->pairs, k->weights, taps);
+}
+
+static void shSetupConvolveAxis(SHFilterAxis *a, const SHConvolveKernel *k,
+                                SHint shift, SHFilterRowFunc func,
+                                SHint scratchBytes)
+{
+  a->func = func;
+  a->kernel = k;
+  a->before = shift;
+  a->after = k->taps - 1 - shift;
+  a->scratchBytes = scratchBytes;
+}
+
+/*-----------------------------------------------------------
+ * Image filter API functions
+ *-----------------------------------------------------------*/
+
+VG_API_CALL void vgColorMatrix(VGImage dst, VGImage src,
+                               const VGfloat * matrix)
+{
+}
+
+VG_API_CALL void vgConvolve(VGImage dst, VGImage src,
+                            VGint kernelWidth, VGint kernelHeight,
+                            VGint shiftX, VGint shiftY,
+                            const VGshort * kernel,
+                            VGfloat scale,
+                            VGfloat bias,
+                            VGTilingMode tilingMode)
+{
+  SHImage *s, *d;
+  SHConvolve *p;
+  SHint32 weights[SH_MAX_KERNEL_SIZE];
+  VGImageFormat format;
+  SHuint32 *words, *out;
+  SHint i, j, ok;
+  VG_GETCONTEXT(VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(!shIsValidImage(context, src) ||
+                   !shIsValidImage(context, dst),
+                   VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+
+  s = shGetImage(context, src); d = shGetImage(context, dst);
+
+  /* Child images are not supported, so only the same image overlaps */
+  VG_RETURN_ERR_IF(s == d, VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(kernelWidth <= 0 || kernelHeight <= 0 ||
+                   kernelWidth > SH_MAX_KERNEL_SIZE ||
+                   kernelHeight > SH_MAX_KERNEL_SIZE,
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(!kernel || ((size_t)kernel & 1),
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(tilingMode < VG_TILE_FILL || tilingMode > VG_TILE_REFLECT,
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+#if RENDERING_ENGINE == SOFTWARE
+  /* Pending draws may still sample the images */
+  shFlushRaster(context);
+#endif
+
+  p = (SHConvolve*)malloc(sizeof(SHConvolve));
+  VG_RETURN_ERR_IF(!p, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+
+  format = shFilterFormat(context);
+  words = shFilterReadSource(s, format);
+  if (!words) {
+    free(p);
+    VG_RETURN_ERR(VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  }
+
+  /* Kernel is given by columns, flip it into reversed rows */
+  p->pairCount = (kernelWidth + 1) / 2;
+  for (j=0; j<kernelHeight; ++j) {
+    for (i=0; i<kernelWidth; ++i)
+      weights[i] = kernel[(kernelWidth - 1 - i) * kernelHeight +
+                          (kernelHeight - 1 - j)];
+    shPackWeightPairs(p->pairs + j * p->pairCount, weights, kernelWidth);
+  }
+
+  p->in = words;
+  p->swidth = s->width;
+  p->sheight = s->height;
+  p->width = SH_MIN(s->width, d->width);
+  p->height = SH_MIN(s->height, d->height);
+  p->kwidth = kernelWidth;
+  p->kheight = kernelHeight;
+  p->shiftX = shiftX;
+  p->shiftY = shiftY;
+  p->scale = scale;
+  p->bias = bias * 255.0f;
+  p->clampToAlpha = shIsPremultipliedImageFormat(format);
+  p->tiling = tilingMode;
+  p->fill = shFilterFillWord(context, format);
+
+  out = shConvolveImage(context, p);
+  free(words);
+  if (!out) {
+    free(p);
+    VG_RETURN_ERR(VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  }
+
+  ok = shFilterWriteResult(context, d, out, p->width, p->height, format);
+  free(out);
+  free(p);
+  VG_RETURN_ERR_IF(!ok, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+
+  shUpdateImageTexture(d, context);
+  VG_RETURN(VG_NO_RETVAL);
+}
+
+VG_API_CALL void vgSeparableConvolve(VGImage dst, VGImage src,
+                                     VGint kernelWidth,
+                                     VGint kernelHeight,
+                                     VGint shiftX, VGint shiftY,
+                                     const VGshort * kernelX,
+                                     const VGshort * kernelY,
+                                     VGfloat scale,
+                                     VGfloat bias,
+                                     VGTilingMode tilingMode)
+{
+  SHImage *s, *d;
+  SHConvolveKernel *kx, *ky;
+  SHFilterAxis ax, ay;
+  VGImageFormat format;
+  SHuint32 *words, *out, fill, midFill[4];
+  SHint width, height, sum, midWords, i, ok;
+  VG_GETCONTEXT(VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(!shIsValidImage(context, src) ||
+                   !shIsValidImage(context, dst),
+                   VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+
+  s = shGetImage(context, src); d = shGetImage(context, dst);
+
+  /* Child images are not supported, so only the same image overlaps */
+  VG_RETURN_ERR_IF(s == d, VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(kernelWidth <= 0 || kernelHeight <= 0 ||
+                   kernelWidth > SH_MAX_SEPARABLE_KERNEL_SIZE ||
+                   kernelHeight > SH_MAX_SEPARABLE_KERNEL_SIZE,
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(!kernelX || ((size_t)kernelX & 1) ||
+                   !kernelY || ((size_t)kernelY & 1),
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(tilingMode < VG_TILE_FILL || tilingMode > VG_TILE_REFLECT,
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+#if RENDERING_ENGINE == SOFTWARE
+  /* Pending draws may still sample the images */
+  shFlushRaster(context);
+#endif
+
+  kx = (SHConvolveKernel*)malloc(2 * sizeof(SHConvolveKernel));
+  VG_RETURN_ERR_IF(!kx, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  ky = kx + 1;
+
+  format = shFilterFormat(context);
+  fill = shFilterFillWord(context, format);
+
+  shSetupConvolveKernel(kx, kernelX, kernelWidth);
+  shSetupConvolveKernel(ky, kernelY, kernelHeight);
+  ky->scale = scale;
+  ky->bias = bias * 255.0f;
+  ky->clampToAlpha = shIsPremultipliedImageFormat(format);
+
+  /* Rows outside the source are the fill color filtered along x */
+  for (sum=0, i=0; i<kernelWidth; ++i)
+    sum += kernelX[i];
+  for (i=0; i<4; ++i)
+    midFill[i] = (SHuint32)(sum * (SHint32)((fill >> (24 - 8*i)) & 0xFF));
+
+  if (shConvolveFitsNarrow(kx, ky)) {
+    shSetupConvolveAxis(&ax, kx, shiftX, shConvolveRowX16,
+                        2 * sizeof(SHint32));
+    shSetupConvolveAxis(&ay, ky, shiftY, shConvolveRowY16,
+                        2 * sizeof(SHint32));
+    midWords = 2;
+    midFill[0] = (midFill[0] & 0xFFFF) | (midFill[1] << 16);
+    midFill[1] = (midFill[2] & 0xFFFF) | (midFill[3] << 16);
+  }else{
+    shSetupConvolveAxis(&ax, kx, shiftX, shConvolveRowX,
+                        2 * sizeof(SHint32));
+    shSetupConvolveAxis(&ay, ky, shiftY, shConvolveRowY,
+                        sizeof(int64_t) + sizeof(SHint32));
+    midWords = 4;
+  }
+
+  width = SH_MIN(s->width, d->width);
+  height = SH_MIN(s->height, d->height);
+
+  words = shFilterReadSource(s, format);
+  if (!words) {
+    free(kx);
+    VG_RETURN_ERR(VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  }
+
+  out = shFilterSeparable(context, words, s->width, s->height, width, height,
+                          tilingMode, &fill, midWords, midFill, &ax, &ay);
+  free(words);
+  free(kx);
+  VG_RETURN_ERR_IF(!out, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+
+  ok = shFilterWriteResult(context, d, out, width, height, format);
+  free(out);
+  VG_RETURN_ERR_IF(!ok, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+
+  shUpdateImageTexture(d, context);
+  VG_RETURN(VG_NO_RETVAL);
+}
+
+VG_API_CALL void vgGaussianBlur(VGImage dst, VGImage src,
+                                VGfloat stdDeviationX,
+                                VGfloat stdDeviationY,
+                                VGTilingMode tilingMode)
+{
+  SHImage *s, *d;
+  SHGaussianKernel kx, ky;
+  SHFilterAxis ax, ay;
+  VGImageFormat format;
+  SHuint32 *words, *out, fill;
+  SHint width, height, ok;
+  VG_GETCONTEXT(VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(!shIsValidImage(context, src) ||
+                   !shIsValidImage(context, dst),
+                   VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+
+  s = shGetImage(context, src); d = shGetImage(context, dst);
+
+  /* Child images are not supported, so only the same image overlaps */
+  VG_RETURN_ERR_IF(s == d, VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(!(stdDeviationX > 0.0f) || !(stdDeviationY > 0.0f) ||
+                   stdDeviationX > SH_MAX_GAUSSIAN_STD_DEVIATION ||
+                   stdDeviationY > SH_MAX_GAUSSIAN_STD_DEVIATION,
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(tilingMode < VG_TILE_FILL || tilingMode > VG_TILE_REFLECT,
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+#if RENDERING_ENGINE == SOFTWARE
+  /* Pending draws may still sample the images */
+  shFlushRaster(context);
+#endif
+
+  shSetupGaussianKernel(&kx, stdDeviationX);
+  shSetupGaussianKernel(&ky, stdDeviationY);
+  shSetupGaussianAxis(&ax, &kx);
+  shSetupGaussianAxis(&ay, &ky);
+
+  width = SH_MIN(s->width, d->width);
+  height = SH_MIN(s->height, d->height);
+  format = shFilterFormat(context);
+  fill = shFilterFillWord(context, format);
+
+  words = shFilterReadSource(s, format);
+  VG_RETURN_ERR_IF(!words, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+
+  out = shFilterSeparable(context, words, s->width, s->height, width, height,
+                          tilingMode, &fill, 1, &fill, &ax, &ay);
+  free(words);
+  VG_RETURN_ERR_IF(!out, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+
+  ok = shFilterWriteResult(context, d, out, width, height, format);
+  free(out);
+  VG_RETURN_ERR_IF(!ok, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+
+  shUpdateImageTexture(d, context);
+  VG_RETURN(VG_NO_RETVAL);
+}
+
+VG_API_CALL void vgLookup(VGImage dst, VGImage src,
+                          const VGubyte * redLUT,
+                          const VGubyte * greenLUT,
+                          const VGubyte * blueLUT,
+                          const VGubyte * alphaLUT,
+                          VGboolean outputLinear,
+                          VGboolean outputPremultiplied)
+{
+}
+
+VG_API_CALL void vgLookupSingle(VGImage dst, VGImage src,
+                                const VGuint * lookupTable,
+                                VGImageChannel sourceChannel,
+                                VGboolean outputLinear,
+                                VGboolean outputPremultiplied)
+{
+}
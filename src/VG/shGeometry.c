@@ -5,6 +5,8 @@
 #include "shGeometry.h"
 #include "kvec.h"
 #include <assert.h>
+#include <limits.h>
+#include <string.h>
 
 
 static int shAddVertex(SHPath *p, SHVertex *v, SHint *contourStart)
@@ -25,181 +27,227 @@ static int shAddVertex(SHPath *p, SHVertex *v, SHint *contourStart)
   return 1;
 }
 
-static void shSubrecurseQuad(SHPath *p, SHQuad *quad, SHint *contourStart)
+/*-----------------------------------------------------------
+ * Curves are flattened into a number of segments computed up
+ * front from the flatten tolerance, the largest distance
+ * allowed between a curve and its polyline. A quad is mapped
+ * onto the parabola y = x^2, and an approximation of the
+ * integral of the square root of its curvature spreads the
+ * points so that every segment deviates about equally.
+ * Cubics are first approximated by quads, arcs are split by
+ * the sagitta of their larger radius.
+ *-----------------------------------------------------------*/
+
+typedef struct
 {
-  SHVertex v;
-  SHVector2 mid, dif, c1, c2, c3;
-  SHQuad quads[SH_MAX_RECURSE_DEPTH];
-  SHQuad *q, *qleft, *qright;
-  SHint qindex=0;
-  quads[0] = *quad;
+  SHfloat a0, a2;     /* parabola integral at the ends */
+  SHfloat u0, uscale; /* maps the integral back to t */
+  SHfloat val;        /* segments needed times sqrt(tolerance) */
+} SHParabola;
+
+static SHfloat shParabolaIntegral(SHfloat x)
+{
+  const SHfloat d = 0.67f;
+  return x / (1.0f - d + SH_SQRT(SH_SQRT(d*d*d*d + 0.25f*x*x)));
+}
+
+static SHfloat shParabolaInvIntegral(SHfloat x)
+{
+  const SHfloat b = 0.39f;
+  return x * (1.0f - b + SH_SQRT(b*b + 0.25f*x*x));
+}
+
+static void shSolveParabola(SHParabola *f, const SHQuad *q, SHfloat sqrtTol)
+{
+  SHfloat ddx = 2.0f*q->p2.x - q->p1.x - q->p3.x;
+  SHfloat ddy = 2.0f*q->p2.y - q->p1.y - q->p3.y;
+  SHfloat u0 = (q->p2.x - q->p1.x)*ddx + (q->p2.y - q->p1.y)*ddy;
+  SHfloat u2 = (q->p3.x - q->p2.x)*ddx + (q->p3.y - q->p2.y)*ddy;
+  SHfloat cross = (q->p3.x - q->p1.x)*ddy - (q->p3.y - q->p1.y)*ddx;
+  SHfloat x0 = u0 / cross;
+  SHfloat x2 = u2 / cross;
+  SHfloat dx = x2 - x0, da, scale, sqrtScale;
   
-  while (qindex >= 0) {
-    
-    q = &quads[qindex];
-    
-    /* Calculate distance of control point from its
-     counterpart on the line between end points */
-    SET2V(mid, q->p1); ADD2V(mid, q->p3); DIV2(mid, 2);
-    SET2V(dif, q->p2); SUB2V(dif, mid); ABS2(dif);
+  if (dx < 0.0f) dx = -dx;
+  if (cross < 0.0f) cross = -cross;
+  scale = cross / (SH_SQRT(ddx*ddx + ddy*ddy) * dx);
+  
+  f->a0 = shParabolaIntegral(x0);
+  f->a2 = shParabolaIntegral(x2);
+  f->val = 0.0f;
+  
+  /* Straight quads need no inner points */
+  if (isfinite(scale) && scale > 0.0f) {
+    da = f->a2 - f->a0;
+    if (da < 0.0f) da = -da;
+    sqrtScale = SH_SQRT(scale);
     
-    /* Cancel if the curve is flat enough */
-    if (dif.x + dif.y <= 1.0f || qindex == SH_MAX_RECURSE_DEPTH-1) {
-
-      /* Add subdivision point */
-      v.point = q->p3; v.flags = 0;
-      if (qindex == 0) return; /* Skip last point */
-      if (!shAddVertex(p, &v, contourStart)) return;
-      --qindex;
-      
+    if ((x0 < 0.0f) == (x2 < 0.0f)) {
+      f->val = da * sqrtScale;
     }else{
-      
-      /* Left recursion goes on top of stack! */
-      qright = q; qleft = &quads[++qindex];
-      
-      /* Subdivide into 2 sub-curves */
-      SET2V(c1, q->p1); ADD2V(c1, q->p2); DIV2(c1, 2);
-      SET2V(c3, q->p2); ADD2V(c3, q->p3); DIV2(c3, 2);
-      SET2V(c2, c1); ADD2V(c2, c3); DIV2(c2, 2);
-  
-      /* Add left recursion onto stack */
-      qleft->p1 = q->p1;
-      qleft->p2 = c1;
-      qleft->p3 = c2;
-      
-      /* Add right recursion onto stack */
-      qright->p1 = c2;
-      qright->p2 = c3;
-      qright->p3 = q->p3;
+      /* The vertex of the parabola lies on the curve */
+      SHfloat xmin = sqrtTol / sqrtScale;
+      f->val = sqrtTol * da / shParabolaIntegral(xmin);
     }
   }
+  
+  f->u0 = shParabolaInvIntegral(f->a0);
+  f->uscale = 1.0f / (shParabolaInvIntegral(f->a2) - f->u0);
 }
 
-static void shSubrecurseCubic(SHPath *p, SHCubic *cubic, SHint *contourStart)
+static SHint shSegmentCount(SHfloat x)
 {
-  SHVertex v;
-  SHfloat dx1, dy1, dx2, dy2;
-  SHVector2 mm, c1, c2, c3, c4, c5;
-  SHCubic cubics[SH_MAX_RECURSE_DEPTH];
-  SHCubic *c, *cleft, *cright;
-  SHint cindex = 0;
-  cubics[0] = *cubic;
-  
-  while (cindex >= 0) {
-    
-    c = &cubics[cindex];
-    
-    /* Calculate distance of control points from their
-     counterparts on the line between end points */
-    dx1 = 3.0f*c->p2.x - 2.0f*c->p1.x - c->p4.x; dx1 *= dx1;
-    dy1 = 3.0f*c->p2.y - 2.0f*c->p1.y - c->p4.y; dy1 *= dy1;
-    dx2 = 3.0f*c->p3.x - 2.0f*c->p4.x - c->p1.x; dx2 *= dx2;
-    dy2 = 3.0f*c->p3.y - 2.0f*c->p4.y - c->p1.y; dy2 *= dy2;
-    if (dx1 < dx2) dx1 = dx2;
-    if (dy1 < dy2) dy1 = dy2;
+  if (!(x > 1.0f)) return 1;
+  if (x >= (SHfloat)SH_MAX_FLATTEN_SEGMENTS) return SH_MAX_FLATTEN_SEGMENTS;
+  return (SHint)SH_CEIL(x);
+}
+
+/* Makes room for count more vertices and returns the first */
+static SHVertex* shReserveVertices(SHVertexArray *out, SHint count)
+{
+  SHint size = out->size + count;
+  
+  if (size > SH_MAX_VERTICES) return NULL;
+  if (size > out->capacity &&
+      !shVertexArrayReserveAndCopy(out, SH_MAX(size, out->capacity*2)))
+    return NULL;
+  
+  return &out->items[out->size];
+}
+
+/*-----------------------------------------------------------
+ * Appends the inner points of the polyline approximating a
+ * chain of quads within the tolerance. Each quad gets its own
+ * segment count and the joints between them are kept, since a
+ * segment across a joint may cut the corner of two bends.
+ * Every point is evaluated independently of the others.
+ *-----------------------------------------------------------*/
+
+void shFlattenQuads(SHVertexArray *out, const SHQuad *quads,
+                    SHint count, SHfloat tolerance)
+{
+  SHParabola f[SH_MAX_CUBIC_QUADS];
+  SHfloat sqrtTol = SH_SQRT(tolerance);
+  SHfloat a, t, mt;
+  SHint segments[SH_MAX_CUBIC_QUADS];
+  SHVertex *v;
+  SHint i, j, n, total = count-1;
+  
+  SH_ASSERT(count <= SH_MAX_CUBIC_QUADS);
+  
+  for (i=0; i<count; ++i) {
+    shSolveParabola(&f[i], &quads[i], sqrtTol);
+    segments[i] = shSegmentCount(0.5f * f[i].val / sqrtTol);
+    total += segments[i]-1;
+  }
+  
+  if (total <= 0) return;
+  
+  v = shReserveVertices(out, total);
+  if (!v) return;
+  
+  for (i=0; i<count; ++i) {
+    const SHQuad *q = &quads[i];
+    n = segments[i];
     
-    /* Cancel if the curve is flat enough */
-    if (dx1+dy1 <= 1.0 || cindex == SH_MAX_RECURSE_DEPTH-1) {
-      
-      /* Add subdivision point */
-      v.point = c->p4; v.flags = 0;
-      if (cindex == 0) return; /* Skip last point */
-      if (!shAddVertex(p, &v, contourStart)) return;
-      --cindex;
-      
-    }else{
-      
-      /* Left recursion goes on top of stack! */
-      cright = c; cleft = &cubics[++cindex];
-      
-      /* Subdivide into 2 sub-curves */
-      SET2V(c1, c->p1); ADD2V(c1, c->p2); DIV2(c1, 2);
-      SET2V(mm, c->p2); ADD2V(mm, c->p3); DIV2(mm, 2);
-      SET2V(c5, c->p3); ADD2V(c5, c->p4); DIV2(c5, 2);
-      
-      SET2V(c2, c1); ADD2V(c2, mm); DIV2(c2, 2);
-      SET2V(c4, mm); ADD2V(c4, c5); DIV2(c4, 2);
-      
-      SET2V(c3, c2); ADD2V(c3, c4); DIV2(c3, 2);
+    for (j=1; j<n; ++j) {
+      a = f[i].a0 + (f[i].a2 - f[i].a0) * j / n;
+      t = (shParabolaInvIntegral(a) - f[i].u0) * f[i].uscale;
+      mt = 1.0f - t;
       
-      /* Add left recursion to stack */
-      cleft->p1 = c->p1;
-      cleft->p2 = c1;
-      cleft->p3 = c2;
-      cleft->p4 = c3;
-      
-      /* Add right recursion to stack */
-      cright->p1 = c3;
-      cright->p2 = c4;
-      cright->p3 = c5;
-      cright->p4 = c->p4;
+      v->point.x = mt*mt*q->p1.x + 2.0f*t*mt*q->p2.x + t*t*q->p3.x;
+      v->point.y = mt*mt*q->p1.y + 2.0f*t*mt*q->p2.y + t*t*q->p3.y;
+      v->flags = 0;
+      ++v;
+    }
+    
+    if (i < count-1) {
+      v->point = q->p3;
+      v->flags = 0;
+      ++v;
     }
   }
+  
+  out->size += total;
 }
 
-static void shSubrecurseArc(SHPath *p, SHArc *arc,
-                            SHVector2 *c,SHVector2 *ux, SHVector2 *uy,
-                            SHint *contourStart)
+/*-----------------------------------------------------------
+ * Splits the cubic into quads that stay within the tolerance
+ * of it and returns their count. The error of the quad
+ * through the endpoints and the crossing of the end tangents
+ * shrinks with the sixth power of the number of pieces.
+ *-----------------------------------------------------------*/
+
+SHint shCubicToQuads(const SHCubic *c, SHfloat tolerance, SHQuad *quads)
 {
-  SHVertex v;
-  SHfloat am, cosa, sina, dx, dy;
-  SHVector2 uux, uuy, c1, m;
-  SHArc arcs[SH_MAX_RECURSE_DEPTH];
-  SHArc *a, *aleft, *aright;
-  SHint aindex=0;
-  arcs[0] = *arc;
-  
-  while (aindex >= 0) {
-    
-    a = &arcs[aindex];
+  /* 432 is the square of 36/sqrt(3) */
+  SHfloat ex = 3.0f*(c->p3.x - c->p2.x) - (c->p4.x - c->p1.x);
+  SHfloat ey = 3.0f*(c->p3.y - c->p2.y) - (c->p4.y - c->p1.y);
+  SHfloat err = (ex*ex + ey*ey) / (432.0f * tolerance * tolerance);
+  SHfloat h, t, mt, sx, sy, dx, dy, px = c->p1.x, py = c->p1.y;
+  SHfloat pdx = 3.0f*(c->p2.x - c->p1.x), pdy = 3.0f*(c->p2.y - c->p1.y);
+  SHint i, n;
+  
+  n = shSegmentCount(SH_SQRT((SHfloat)cbrt(err)));
+  if (n > SH_MAX_CUBIC_QUADS) n = SH_MAX_CUBIC_QUADS;
+  h = 1.0f / n;
+  
+  for (i=1; i<=n; ++i) {
     
-    /* Middle angle and its cos/sin */
-    am = (a->a1 + a->a2)/2;
-    cosa = SH_COS(am);
-    sina = SH_SIN(am);
-  
-    /* New point */
-    SET2V(uux, (*ux)); MUL2(uux, cosa);
-    SET2V(uuy, (*uy)); MUL2(uuy, sina);
-    SET2V(c1, (*c)); ADD2V(c1, uux); ADD2V(c1, uuy);
+    /* Point and derivative at the end of the piece */
+    t = (i == n ? 1.0f : i*h);
+    mt = 1.0f - t;
+    sx = mt*mt*mt*c->p1.x + 3.0f*t*mt*(mt*c->p2.x + t*c->p3.x) + t*t*t*c->p4.x;
+    sy = mt*mt*mt*c->p1.y + 3.0f*t*mt*(mt*c->p2.y + t*c->p3.y) + t*t*t*c->p4.y;
+    dx = 3.0f*(mt*mt*(c->p2.x - c->p1.x) + 2.0f*t*mt*(c->p3.x - c->p2.x) + t*t*(c->p4.x - c->p3.x));
+    dy = 3.0f*(mt*mt*(c->p2.y - c->p1.y) + 2.0f*t*mt*(c->p3.y - c->p2.y) + t*t*(c->p4.y - c->p3.y));
     
-    /* Check distance from linear midpoint */
-    SET2V(m, a->p1); ADD2V(m, a->p2); DIV2(m, 2);
-    dx = c1.x - m.x; dy = c1.y - m.y;
-    if (dx < 0.0f) dx = -dx;
-    if (dy < 0.0f) dy = -dy;
+    SET2(quads[i-1].p1, px, py);
+    SET2(quads[i-1].p2, 0.5f*(px + sx) + 0.25f*h*(pdx - dx),
+                        0.5f*(py + sy) + 0.25f*h*(pdy - dy));
+    SET2(quads[i-1].p3, sx, sy);
     
-    /* Stop if flat enough */
-    if (dx+dy <= 1.0f || aindex == SH_MAX_RECURSE_DEPTH-1) {
-      
-      /* Add middle subdivision point */
-      v.point = c1; v.flags = 0;
-      if (!shAddVertex(p, &v, contourStart)) return;
-      if (aindex == 0) return; /* Skip very last point */
-      
-      /* Add end subdivision point */
-      v.point = a->p2; v.flags = 0;
-      if (!shAddVertex(p, &v, contourStart)) return;
-      --aindex;
-      
-    }else{
-      
-      /* Left subdivision goes on top of stack! */
-      aright = a; aleft = &arcs[++aindex];
-      
-      /* Add left recursion to stack */
-      aleft->p1 = a->p1;
-      aleft->a1 = a->a1;
-      aleft->p2 = c1;
-      aleft->a2 = am;
-      
-      /* Add right recursion to stack */
-      aright->p1 = c1;
-      aright->a1 = am;
-      aright->p2 = a->p2;
-      aright->a2 = a->a2;
-    }
+    px = sx; py = sy;
+    pdx = dx; pdy = dy;
+  }
+  
+  return n;
+}
+
+/*-----------------------------------------------------------
+ * Appends the inner points of the polyline approximating an
+ * elliptical arc around c with axes ux and uy. A chord of
+ * angle a strays at most r*(1 - cos(a/2)) from a circle of
+ * radius r, which bounds the steps of the larger axis.
+ *-----------------------------------------------------------*/
+
+void shFlattenArc(SHVertexArray *out, const SHArc *arc, const SHVector2 *c,
+                  const SHVector2 *ux, const SHVector2 *uy, SHfloat tolerance)
+{
+  SHfloat rx = NORM2((*ux)), ry = NORM2((*uy));
+  SHfloat r = SH_MAX(rx, ry);
+  SHfloat sweep = arc->a2 - arc->a1;
+  SHfloat a, cosa, sina;
+  SHVertex *v;
+  SHint i, n = 1;
+  
+  if (r > tolerance)
+    n = shSegmentCount(SH_ABS(sweep) / (2.0f * SH_ACOS(1.0f - tolerance / r)));
+  if (n <= 1) return;
+  
+  v = shReserveVertices(out, n-1);
+  if (!v) return;
+  
+  for (i=1; i<n; ++i) {
+    a = arc->a1 + sweep * i / n;
+    cosa = SH_COS(a);
+    sina = SH_SIN(a);
+    v[i-1].point.x = c->x + ux->x*cosa + uy->x*sina;
+    v[i-1].point.y = c->y + ux->y*cosa + uy->y*sina;
+    v[i-1].flags = 0;
   }
+  
+  out->size += n-1;
 }
 
 static void shSubdivideSegment(SHPath *p, VGPathSegment segment,
@@ -207,10 +255,13 @@ static void shSubdivideSegment(SHPath *p, VGPathSegment segment,
                                SHfloat *data, void *userData)
 {
   SHVertex v;
-  SHint *contourStart = ((SHint**)userData)[0];
-  SHint *surfaceSpace = ((SHint**)userData)[1];
+  SHint *contourStart = (SHint*)((void**)userData)[0];
+  SHint *surfaceSpace = (SHint*)((void**)userData)[1];
   SHQuad quad; SHCubic cubic; SHArc arc;
+  SHQuad quads[SH_MAX_CUBIC_QUADS];
   SHVector2 c, ux, uy;
+  SHint size = p->vertices.size;
+  SHfloat tol = *(SHfloat*)((void**)userData)[2];
   VG_GETCONTEXT(VG_NO_RETVAL);
   
   switch (segment)
@@ -258,7 +309,7 @@ static void shSubdivideSegment(SHPath *p, VGPathSegment segment,
       TRANSFORM2(quad.p1, context->pathTransform);
       TRANSFORM2(quad.p2, context->pathTransform);
       TRANSFORM2(quad.p3, context->pathTransform); }
-    shSubrecurseQuad(p, &quad, contourStart);
+    shFlattenQuads(&p->vertices, &quad, 1, tol);
     
     /* Last segment vertex */
     v.point.x = data[4];
@@ -280,7 +331,9 @@ static void shSubdivideSegment(SHPath *p, VGPathSegment segment,
       TRANSFORM2(cubic.p2, context->pathTransform);
       TRANSFORM2(cubic.p3, context->pathTransform);
       TRANSFORM2(cubic.p4, context->pathTransform); }
-    shSubrecurseCubic(p, &cubic, contourStart);
+    shFlattenQuads(&p->vertices, quads,
+                   shCubicToQuads(&cubic, SH_CUBIC_QUADS_SHARE*tol, quads),
+                   SH_FLATTEN_QUADS_SHARE*tol);
     
     /* Last segment vertex */
     v.point.x = data[6];
@@ -308,7 +361,7 @@ static void shSubdivideSegment(SHPath *p, VGPathSegment segment,
       TRANSFORM2(c, context->pathTransform);
       TRANSFORM2DIR(ux, context->pathTransform);
       TRANSFORM2DIR(uy, context->pathTransform); }
-    shSubrecurseArc(p, &arc, &c, &ux, &uy, contourStart);
+    shFlattenArc(&p->vertices, &arc, &c, &ux, &uy, tol);
     
     /* Last segment vertex */
     v.point.x = data[10];
@@ -319,6 +372,12 @@ static void shSubdivideSegment(SHPath *p, VGPathSegment segment,
     break;
   }
   
+  /* Count the points of the curve into the contour */
+  if (p->vertices.size > size) {
+    SH_ASSERT((*contourStart) >= 0);
+    p->vertices.items[*contourStart].flags += p->vertices.size - size;
+  }
+  
   /* Add subdivision vertex */
   shAddVertex(p, &v, contourStart);
 }
@@ -326,62 +385,51 @@ static void shSubdivideSegment(SHPath *p, VGPathSegment segment,
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
 #define MAX(x, y) ((x) > (y) ? (x) : (y))
 
-static void subdivide_cubic(const double c[8], double c1[8], double c2[8])
-{
-    double p1x = (c[0] + c[2]) / 2;
-    double p1y = (c[1] + c[3]) / 2;
-    double p2x = (c[2] + c[4]) / 2;
-    double p2y = (c[3] + c[5]) / 2;
-    double p3x = (c[4] + c[6]) / 2;
-    double p3y = (c[5] + c[7]) / 2;
-    double p4x = (p1x + p2x) / 2;
-    double p4y = (p1y + p2y) / 2;
-    double p5x = (p2x + p3x) / 2;
-    double p5y = (p2y + p3y) / 2;
-    double p6x = (p4x + p5x) / 2;
-    double p6y = (p4y + p5y) / 2;
-
-    double p0x = c[0];
-    double p0y = c[1];
-    double p7x = c[6];
-    double p7y = c[7];
+/* Maximum deviation in device pixels when converting
+   cubics to quadratics */
+#define SH_REDUCE_TOLERANCE 0.1f
+#define SH_REDUCE_MAX_QUADS 64
 
-    c1[0] = p0x;
-    c1[1] = p0y;
-    c1[2] = p1x;
-    c1[3] = p1y;
-    c1[4] = p4x;
-    c1[5] = p4y;
-    c1[6] = p6x;
-    c1[7] = p6y;
+/* Control points of the part [t0,t1] of a cubic */
+static void cubic_segment(const double c[8], double t0, double t1, double out[8])
+{
+    int k;
+    double d = (t1 - t0) / 3;
 
-    c2[0] = p6x;
-    c2[1] = p6y;
-    c2[2] = p5x;
-    c2[3] = p5y;
-    c2[4] = p3x;
-    c2[5] = p3y;
-    c2[6] = p7x;
-    c2[7] = p7y;
+    for (k = 0; k < 2; ++k)
+    {
+        double p0 = c[k], p1 = c[2 + k], p2 = c[4 + k], p3 = c[6 + k];
+        double a = p3 - 3 * p2 + 3 * p1 - p0;
+        double b = 3 * (p2 - 2 * p1 + p0);
+        double e = 3 * (p1 - p0);
+
+        double x0 = ((a * t0 + b) * t0 + e) * t0 + p0;
+        double x1 = ((a * t1 + b) * t1 + e) * t1 + p0;
+        double dx0 = (3 * a * t0 + 2 * b) * t0 + e;
+        double dx1 = (3 * a * t1 + 2 * b) * t1 + e;
+
+        out[k] = x0;
+        out[2 + k] = x0 + d * dx0;
+        out[4 + k] = x1 - d * dx1;
+        out[6 + k] = x1;
+    }
 }
 
-static void subdivide_cubic2(const double cin[8], double cout[16])
+/* Number of quadratics approximating the cubic within the
+   tolerance. A single quadratic deviates from the cubic by at
+   most sqrt(3)/36 * |p3 - 3p2 + 3p1 - p0|, and splitting into
+   n equal parameter ranges divides that term by n^3. */
+static int cubic_quad_count(const double c[8], double tolerance)
 {
-    subdivide_cubic(cin, cout, cout + 8);
-}
+    double dx = c[6] - 3 * c[4] + 3 * c[2] - c[0];
+    double dy = c[7] - 3 * c[5] + 3 * c[3] - c[1];
+    double err = sqrt(3.0) / 36 * sqrt(dx * dx + dy * dy);
+    double n;
 
-static void subdivide_cubic4(const double cin[8], double cout[32])
-{
-    subdivide_cubic(cin, cout, cout + 16);
-    subdivide_cubic2(cout, cout);
-    subdivide_cubic2(cout + 16, cout + 16);
-}
+    if (!(err > tolerance)) return 1;
 
-static void subdivide_cubic8(const double cin[8], double cout[64])
-{
-    subdivide_cubic(cin, cout, cout + 32);
-    subdivide_cubic4(cout, cout);
-    subdivide_cubic4(cout + 32, cout + 32);
+    n = ceil(cbrt(err / tolerance));
+    return (int)MIN(n, SH_REDUCE_MAX_QUADS);
 }
 
 static void cubic_to_quadratic(const double c[8], double q[6])
@@ -394,14 +442,11 @@ static void cubic_to_quadratic(const double c[8], double q[6])
     q[5] = c[7];
 }
 
-static void new_path(reduced_path_vec *paths)
-{
-    struct reduced_path rp = {0};
-    kv_push_back(*paths, rp);
-}
-
 static void move_to(struct reduced_path *path, float x, float y)
 {
+    if (!path)
+        return;
+
     if (kv_empty(path->commands))
     {
         kv_push_back(path->commands, VG_MOVE_TO_ABS);
@@ -417,6 +462,9 @@ static void move_to(struct reduced_path *path, float x, float y)
 
 static void line_to(struct reduced_path *path, float x1, float y1, float x2, float y2)
 {
+    if (!path)
+        return;
+
     if (kv_empty(path->commands))
     {
         kv_push_back(path->commands, VG_MOVE_TO_ABS);
@@ -431,6 +479,9 @@ static void line_to(struct reduced_path *path, float x1, float y1, float x2, flo
 
 static void quad_to(struct reduced_path *path, float x1, float y1, float x2, float y2, float x3, float y3)
 {
+    if (!path)
+        return;
+
     if (kv_empty(path->commands))
     {
         kv_push_back(path->commands, VG_MOVE_TO_ABS);
@@ -445,13 +496,15 @@ static void quad_to(struct reduced_path *path, float x1, float y1, float x2, flo
     kv_push_back(path->coords, y3);
 }
 
-static void cubic_to(struct reduced_path *path, float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
+static void cubic_to(struct reduced_path *path, float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, float tolerance)
 {
-    int i;
+    int i, n;
+
+    if (!path)
+        return;
 
     double cin[8] = { x1, y1, x2, y2, x3, y3, x4, y4 };
-    double cout[64];
-    subdivide_cubic8(cin, cout);
+    n = cubic_quad_count(cin, tolerance);
 
     if (kv_empty(path->commands))
     {
@@ -460,10 +513,11 @@ static void cubic_to(struct reduced_path *path, float x1, float y1, float x2, fl
         kv_push_back(path->coords, y1);
     }
 
-    for (i = 0; i < 8; ++i)
+    for (i = 0; i < n; ++i)
     {
-        double q[6];
-        cubic_to_quadratic(cout + i * 8, q);
+        double c[8], q[6];
+        cubic_segment(cin, i / (double)n, (i + 1) / (double)n, c);
+        cubic_to_quadratic(c, q);
         kv_push_back(path->commands, VG_QUAD_TO_ABS);
         kv_push_back(path->coords, q[2]);
         kv_push_back(path->coords, q[3]);
@@ -568,6 +622,9 @@ static void arc_tod(struct reduced_path *path, double x1, double y1, double rh,
 
 static void arc_to(struct reduced_path *path, float x1, float y1, float rh, float rv, float phi, int fA, int fS, float x2, float y2)
 {
+    if (!path)
+        return;
+
     if (kv_empty(path->commands))
     {
         kv_push_back(path->commands, VG_MOVE_TO_ABS);
@@ -580,6 +637,9 @@ static void arc_to(struct reduced_path *path, float x1, float y1, float rh, floa
 
 static void close_path(struct reduced_path *path)
 {
+    if (!path)
+        return;
+
     if (kv_back(path->commands) != VG_CLOSE_PATH)
         kv_push_back(path->commands, VG_CLOSE_PATH);
 }
@@ -595,32 +655,68 @@ static void close_path(struct reduced_path *path)
 #define c4 data[6]
 #define c5 data[7]
 #define c6 data[8]
-#define set(x1, y1, x2, y2) ncpx = x1; ncpy = y1; npepx = x2; npepy = y2;
-#define last_path &kv_back(*reduced_paths)
-static float spx = 0, spy = 0;
-static float cpx = 0, cpy = 0;
-static float pepx = 0, pepy = 0;
-static float ncpx = 0, ncpy = 0;
-static float npepx = 0, npepy = 0;
-static unsigned char prev_command = 2;
+#define set(x1, y1, x2, y2) st->ncpx = x1; st->ncpy = y1; st->npepx = x2; st->npepy = y2;
+#define last_path target_path(st, reduced_paths)
+
+/* Pen state of the reducer. It is carried per call through the
+   userData pointer of shProcessPathData so that several paths can
+   be reduced concurrently. */
+typedef struct
+{
+	float spx, spy;
+	float cpx, cpy;
+	float pepx, pepy;
+	float ncpx, ncpy;
+	float npepx, npepy;
+	unsigned char prev_command;
+	float tolerance;     /* in user units */
+	int segment;         /* index of the segment being reduced */
+	int first, end;      /* segments emitted into the reduced paths */
+	int current;         /* reduced path being written */
+	reduced_path_vec *paths;
+} SHReduceState;
+
+static void shReduceStateInit(SHReduceState *st, reduced_path_vec *paths, float scale){
+	st->spx = 0; st->spy = 0;
+	st->cpx = 0; st->cpy = 0;
+	st->pepx = 0; st->pepy = 0;
+	st->ncpx = 0; st->ncpy = 0;
+	st->npepx = 0; st->npepy = 0;
+	st->prev_command = 2;
+	st->tolerance = SH_REDUCE_TOLERANCE / scale;
+	st->segment = 0;
+	st->first = 0;
+	st->end = INT_MAX;
+	st->current = -1;
+	st->paths = paths;
+}
+
+/* Advances to the next reduced path, appending it when the
+   path is being reduced from scratch */
+static void next_path(SHReduceState *st, reduced_path_vec *paths)
+{
+    st->current++;
+    if ((size_t)st->current == kv_size(*paths))
+    {
+        struct reduced_path rp = {0};
+        rp.first_segment = st->segment;
+        kv_push_back(*paths, rp);
+    }
+}
+
+/* Segments outside [first,end) only advance the pen */
+static struct reduced_path *target_path(SHReduceState *st, reduced_path_vec *paths)
+{
+    if (st->segment < st->first || st->segment >= st->end || st->current < 0)
+        return NULL;
+    return &kv_a(*paths, st->current);
+}
 
 static void shReduceSegmentInit(reduced_path_vec* rpv){
-	spx = 0; spy = 0;
-	cpx = 0; cpy = 0;
-	pepx = 0; pepy = 0;
-	ncpx = 0; ncpy = 0;
-	npepx = 0; npepy = 0;
-	prev_command = 2;
     kv_init(*rpv);
 }
 
 static void shReduceSegmentDeinit(reduced_path_vec* rpv){
-	spx = 0; spy = 0;
-	cpx = 0; cpy = 0;
-	pepx = 0; pepy = 0;
-	ncpx = 0; ncpy = 0;
-	npepx = 0; npepy = 0;
-	prev_command = 2;
 	// reduced path
 	size_t i;
 	for (i = 0; i < kv_size(*rpv); ++i)
@@ -656,113 +752,114 @@ static void shReduceSegment(SHPath *p, VGPathSegment segment,
                                VGPathCommand originalCommand,
                                SHfloat *data, void *userData)
 {
-	reduced_path_vec* reduced_paths = &p->reduced_paths;
+	SHReduceState *st = (SHReduceState*)userData;
+	reduced_path_vec* reduced_paths = st->paths;
 	
 	switch(segment)
 	{
 	case VG_MOVE_TO:
-		if (new_path_table[prev_command][0])
-			new_path(reduced_paths);
-		prev_command = 0;
+		if (new_path_table[st->prev_command][0])
+			next_path(st, reduced_paths);
+		st->prev_command = 0;
 		move_to(last_path, c0, c1);
 		set(c0, c1, c0, c1);
-		spx = ncpx;
-		spy = ncpy;
+		st->spx = st->ncpx;
+		st->spy = st->ncpy;
 		break;
 
 	case VG_CLOSE_PATH:
-		if (new_path_table[prev_command][2])
-			new_path(reduced_paths);
-		prev_command = 2;
+		if (new_path_table[st->prev_command][2])
+			next_path(st, reduced_paths);
+		st->prev_command = 2;
 		close_path(last_path);
-		set(spx, spy, spx, spy);
+		set(st->spx, st->spy, st->spx, st->spy);
 		break;
 
 	case VG_LINE_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		line_to(last_path, cpx, cpy, c0, c1);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		line_to(last_path, st->cpx, st->cpy, c0, c1);
 		set(c0, c1, c0, c1);
 		break;
 		
 	case VG_HLINE_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		line_to(last_path, cpx, cpy, c0, cpy);
-		set(c0, cpy, c0, cpy);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		line_to(last_path, st->cpx, st->cpy, c0, st->cpy);
+		set(c0, st->cpy, c0, st->cpy);
 		break;
 
 	case VG_VLINE_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		line_to(last_path, cpx, cpy, cpx, c0);
-		set(cpx, c0, cpx, c0);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		line_to(last_path, st->cpx, st->cpy, st->cpx, c0);
+		set(st->cpx, c0, st->cpx, c0);
 		break;
 
 	case VG_QUAD_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		quad_to(last_path, cpx, cpy, c0, c1, c2, c3);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		quad_to(last_path, st->cpx, st->cpy, c0, c1, c2, c3);
 		set(c2, c3, c0, c1);
 		break;
 
 	case VG_CUBIC_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		cubic_to(last_path, cpx, cpy, c0, c1, c2, c3, c4, c5);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		cubic_to(last_path, st->cpx, st->cpy, c0, c1, c2, c3, c4, c5, st->tolerance);
 		set(c4, c5, c2, c3);
 		break;
 
 	case VG_SQUAD_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		quad_to(last_path, cpx, cpy, 2 * cpx - pepx, 2 * cpy - pepy, c0, c1);
-		set(c0, c1, 2 * cpx - pepx, 2 * cpy - pepy);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		quad_to(last_path, st->cpx, st->cpy, 2 * st->cpx - st->pepx, 2 * st->cpy - st->pepy, c0, c1);
+		set(c0, c1, 2 * st->cpx - st->pepx, 2 * st->cpy - st->pepy);
 		break;
 
 	case VG_SCUBIC_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		cubic_to(last_path, cpx, cpy, 2 * cpx - pepx, 2 * cpy - pepy, c0, c1, c2, c3);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		cubic_to(last_path, st->cpx, st->cpy, 2 * st->cpx - st->pepx, 2 * st->cpy - st->pepy, c0, c1, c2, c3, st->tolerance);
 		set(c2, c3, c0, c1);
 		break;
 
 	case VG_SCCWARC_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		arc_to(last_path, cpx, cpy, c0, c1, c2, 0, 1, c3, c4);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		arc_to(last_path, st->cpx, st->cpy, c0, c1, c2, 0, 1, c3, c4);
 		set(c3, c4, c3, c4);
 		break;
 
 	case VG_SCWARC_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		arc_to(last_path, cpx, cpy, c0, c1, c2, 0, 0, c3, c4);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		arc_to(last_path, st->cpx, st->cpy, c0, c1, c2, 0, 0, c3, c4);
 		set(c3, c4, c3, c4);
 		break;
 
 	case VG_LCCWARC_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		arc_to(last_path, cpx, cpy, c0, c1, c2, 1, 1, c3, c4);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		arc_to(last_path, st->cpx, st->cpy, c0, c1, c2, 1, 1, c3, c4);
 		set(c3, c4, c3, c4);
 		break;
 
 	case VG_LCWARC_TO:
-		if (new_path_table[prev_command][1])
-			new_path(reduced_paths);
-		prev_command = 1;
-		arc_to(last_path, cpx, cpy, c0, c1, c2, 1, 0, c3, c4);
+		if (new_path_table[st->prev_command][1])
+			next_path(st, reduced_paths);
+		st->prev_command = 1;
+		arc_to(last_path, st->cpx, st->cpy, c0, c1, c2, 1, 0, c3, c4);
 		set(c3, c4, c3, c4);
 		break;
 
@@ -771,10 +868,11 @@ static void shReduceSegment(SHPath *p, VGPathSegment segment,
 		break;
 	}
 
-	cpx = ncpx;
-	cpy = ncpy;
-	pepx = npepx;
-	pepy = npepy;
+	st->cpx = st->ncpx;
+	st->cpy = st->ncpy;
+	st->pepx = st->npepx;
+	st->pepy = st->npepy;
+	st->segment++;
 }
 #undef c0
 #undef c1
@@ -786,6 +884,261 @@ static void shReduceSegment(SHPath *p, VGPathSegment segment,
 #undef set
 #undef last_path
 
+/*--------------------------------------------------
+ * Geometry storage. Indices start out 16-bit and are
+ * widened to 32-bit when a vertex past 65535 gets
+ * referenced, so small paths keep compact indices.
+ *--------------------------------------------------*/
+
+void shInitGeometry(struct geometry *g)
+{
+    kv_init(g->vertices);
+    kv_init(g->indices);
+    kv_init(g->wide_indices);
+    g->wide = 0;
+    g->count = 0;
+    g->block = NULL;
+}
+
+void shFreeGeometry(struct geometry *g)
+{
+    kv_free(g->vertices);
+    kv_free(g->indices);
+    kv_free(g->wide_indices);
+    shInitGeometry(g);
+}
+
+void shFreeGeometrySet(struct geometry *set, int n)
+{
+    int i;
+
+    if (n > 0 && set[0].block)
+    {
+        free(set[0].block);
+        for (i = 0; i < n; ++i)
+            shInitGeometry(&set[i]);
+    }
+    else
+    {
+        for (i = 0; i < n; ++i)
+            shFreeGeometry(&set[i]);
+    }
+}
+
+struct geometry_scratch *shCreateGeometryScratch(int count)
+{
+    struct geometry_scratch *s = malloc(count * sizeof(struct geometry_scratch));
+    int i, k;
+
+    if (!s)
+        return NULL;
+
+    for (i = 0; i < count; ++i)
+    {
+        for (k = 0; k < 4; ++k)
+            shInitGeometry(&s[i].fill[k]);
+        for (k = 0; k < 2; ++k)
+            shInitGeometry(&s[i].stroke[k]);
+    }
+
+    return s;
+}
+
+void shDeleteGeometryScratch(struct geometry_scratch *s, int count)
+{
+    int i;
+
+    if (!s)
+        return;
+
+    for (i = 0; i < count; ++i)
+    {
+        shFreeGeometrySet(s[i].fill, 4);
+        shFreeGeometrySet(s[i].stroke, 2);
+    }
+
+    free(s);
+}
+
+/* Bytes of vertex and index data in use by the fill */
+SHint shFillGeometryBytes(SHPath *p)
+{
+    size_t bytes = 0;
+    int i;
+
+    for (i = 0; i < 4; ++i)
+    {
+        struct geometry *g = &p->fill_geoms[i];
+
+        bytes += kv_size(g->vertices) * sizeof(float);
+        bytes += SH_GEOMETRY_INDEX_COUNT(g) * (g->wide ? sizeof(unsigned int) : sizeof(unsigned short));
+    }
+
+    return (SHint)bytes;
+}
+
+static void clear_geometry(struct geometry *g)
+{
+    kv_clear(g->vertices);
+    kv_clear(g->indices);
+    kv_clear(g->wide_indices);
+    g->wide = 0;
+}
+
+/* Allocates one block holding the arrays of a set of
+   geometries with the given sizes, vertices first so that
+   every slice stays aligned. Returns 0, leaving the set
+   untouched, when out of memory. */
+static int alloc_geometry_set(struct geometry *set, int n, const size_t *num_vertices,
+                              const size_t *num_indices, const int *wide)
+{
+    size_t bytes = 0;
+    char *block, *at;
+    int k;
+
+    for (k = 0; k < n; ++k)
+    {
+        bytes += num_vertices[k] * sizeof(float);
+        bytes += num_indices[k] * (wide[k] ? sizeof(unsigned int) : sizeof(unsigned short));
+    }
+
+    block = at = bytes ? malloc(bytes) : NULL;
+    if (bytes && !block)
+        return 0;
+
+    for (k = 0; k < n; ++k)
+    {
+        shInitGeometry(&set[k]);
+        set[k].wide = wide[k];
+        set[k].block = block;
+    }
+
+    if (!block)
+        return 1;
+
+    for (k = 0; k < n; ++k)
+    {
+        set[k].vertices.a = (float *)at;
+        set[k].vertices.n = set[k].vertices.m = num_vertices[k];
+        at += num_vertices[k] * sizeof(float);
+    }
+
+    for (k = 0; k < n; ++k)
+    {
+        if (!wide[k])
+            continue;
+        set[k].wide_indices.a = (unsigned int *)at;
+        set[k].wide_indices.n = set[k].wide_indices.m = num_indices[k];
+        at += num_indices[k] * sizeof(unsigned int);
+    }
+
+    for (k = 0; k < n; ++k)
+    {
+        if (wide[k])
+            continue;
+        set[k].indices.a = (unsigned short *)at;
+        set[k].indices.n = set[k].indices.m = num_indices[k];
+        at += num_indices[k] * sizeof(unsigned short);
+    }
+
+    return 1;
+}
+
+static void put_index(struct geometry *g, size_t i, unsigned int index)
+{
+    if (g->wide)
+        kv_a(g->wide_indices, i) = index;
+    else
+        kv_a(g->indices, i) = (unsigned short)index;
+}
+
+/* Copies the geometry built in scratch into a new block,
+   leaving the growable arrays in scratch. Returns 0 and
+   keeps the set when out of memory. */
+static int pack_geometry_set(struct geometry *set, const struct geometry *scratch, int n)
+{
+    size_t num_vertices[4], num_indices[4], i;
+    int wide[4], k;
+    struct geometry out[4];
+
+    for (k = 0; k < n; ++k)
+    {
+        num_vertices[k] = kv_size(scratch[k].vertices);
+        num_indices[k] = SH_GEOMETRY_INDEX_COUNT(&scratch[k]);
+        wide[k] = scratch[k].wide;
+    }
+
+    if (!alloc_geometry_set(out, n, num_vertices, num_indices, wide))
+        return 0;
+
+    for (k = 0; k < n; ++k)
+    {
+        if (num_vertices[k])
+            memcpy(kv_data(out[k].vertices), kv_data(scratch[k].vertices), num_vertices[k] * sizeof(float));
+        for (i = 0; i < num_indices[k]; ++i)
+            put_index(&out[k], i, SH_GEOMETRY_INDEX(&scratch[k], i));
+        set[k] = out[k];
+    }
+
+    return 1;
+}
+
+/* Lends the empty scratch arrays to the set for a build */
+static void lend_scratch(struct geometry *set, struct geometry *scratch, int n)
+{
+    int k;
+
+    for (k = 0; k < n; ++k)
+    {
+        clear_geometry(&scratch[k]);
+        set[k] = scratch[k];
+    }
+}
+
+/* Takes the arrays back with what was built into them */
+static void take_scratch(struct geometry *set, struct geometry *scratch, int n)
+{
+    int k;
+
+    for (k = 0; k < n; ++k)
+    {
+        scratch[k] = set[k];
+        shInitGeometry(&set[k]);
+    }
+}
+
+static void widen_geometry(struct geometry *g)
+{
+    size_t i;
+
+    kv_resize(g->wide_indices, kv_size(g->indices));
+    for (i = 0; i < kv_size(g->indices); ++i)
+        kv_a(g->wide_indices, i) = kv_a(g->indices, i);
+
+    kv_free(g->indices);
+    kv_init(g->indices);
+    g->wide = 1;
+}
+
+static void push_triangle(struct geometry *g, unsigned int i0, unsigned int i1, unsigned int i2)
+{
+    if (!g->wide && MAX(i0, MAX(i1, i2)) > 0xFFFF)
+        widen_geometry(g);
+
+    if (g->wide)
+    {
+        kv_push_back(g->wide_indices, i0);
+        kv_push_back(g->wide_indices, i1);
+        kv_push_back(g->wide_indices, i2);
+    }
+    else
+    {
+        kv_push_back(g->indices, (unsigned short)i0);
+        kv_push_back(g->indices, (unsigned short)i1);
+        kv_push_back(g->indices, (unsigned short)i2);
+    }
+}
+
 static void add_stroke_line(SHPath* p, double x0, double y0, double x1, double y1)
 {
     struct geometry *g = &p->stroke_geoms[0];
@@ -815,13 +1168,9 @@ static void add_stroke_line(SHPath* p, double x0, double y0, double x1, double y
     kv_push_back(g->vertices, x0 - (dy * width * 0.5));
     kv_push_back(g->vertices, y0 + (dx * width * 0.5));
 
-    kv_push_back(g->indices, index);
-    kv_push_back(g->indices, index + 1);
-    kv_push_back(g->indices, index + 2);
+    push_triangle(g, index, index + 1, index + 2);
 
-    kv_push_back(g->indices, index);
-    kv_push_back(g->indices, index + 2);
-    kv_push_back(g->indices, index + 3);
+    push_triangle(g, index, index + 2, index + 3);
 }
 
 static void add_stroke_line_dashed(SHPath* path, double x0, double y0, double x1, double y1, double *dash_offset)
@@ -975,96 +1324,36 @@ static void calculatepq(double Ax, double Ay, double Bx, double By, double Cx, d
     *q = (2 * b * b * b - 9 * a * b * c + 27 * a * a * d) / (27 * a * a * a);
 }
 
-static double arc_length_helper(double A, double B, double C, double t)
+static void quad_segment(const double qin[6], double t0, double t1, double qout[6])
 {
-    /* Integrate[Sqrt[A t^2 + B t + C], t] */
-    return (2 * sqrt(A) * (B + 2 * A * t) * sqrt(C + t * (B + A * t)) - (B * B - 4 * A * C) * log(B + 2 * A * t + 2 * sqrt(A) * sqrt(C + t * (B + A * t)))) / (8 * sqrt(A * A * A));
-}
+    double u0 = 1 - t0;
+    double u1 = 1 - t1;
 
-static double arc_length(double Ax, double Ay, double Bx, double By, double Cx, double Cy, double t)
-{
-    double A = 4 * (Ax * Ax + Ay * Ay);
-    double B = 4 * (Ax * Bx + Ay * By);
-    double C = Bx * Bx + By * By;
+    double x0 = qin[0];
+    double y0 = qin[1];
+    double x1 = qin[2];
+    double y1 = qin[3];
+    double x2 = qin[4];
+    double y2 = qin[5];
 
-    return arc_length_helper(A, B, C, t) - arc_length_helper(A, B, C, 0);
+    qout[0] = (u0 * u0) * x0 + (u0 * t0 + u0 * t0) * x1 + (t0 * t0) * x2;
+    qout[1] = (u0 * u0) * y0 + (u0 * t0 + u0 * t0) * y1 + (t0 * t0) * y2;
+    qout[2] = (u0 * u1) * x0 + (u0 * t1 + u1 * t0) * x1 + (t0 * t1) * x2;
+    qout[3] = (u0 * u1) * y0 + (u0 * t1 + u1 * t0) * y1 + (t0 * t1) * y2;
+    qout[4] = (u1 * u1) * x0 + (u1 * t1 + u1 * t1) * x1 + (t1 * t1) * x2;
+    qout[5] = (u1 * u1) * y0 + (u1 * t1 + u1 * t1) * y1 + (t1 * t1) * y2;
 }
 
-static double inverse_arc_length(double Ax, double Ay, double Bx, double By, double Cx, double Cy, double u)
+static void add_stroke_quad(SHPath *path, double x0, double y0, double x1, double y1, double x2, double y2)
 {
     int i;
 
-    double A = 4 * (Ax * Ax + Ay * Ay);
-    double B = 4 * (Ax * Bx + Ay * By);
-    double C = Bx * Bx + By * By;
-
-    if (u <= 0)
-        return 0;
-
-    double length = arc_length_helper(A, B, C, 1) - arc_length_helper(A, B, C, 0);
-
-    if (u >= length)
-        return 1;
-
-    double u0 = arc_length_helper(A, B, C, 0) + u;
-
-    double a = 0;
-    double b = 1;
-    double fa = arc_length_helper(A, B, C, a) - u0;
-    double fb = arc_length_helper(A, B, C, b) - u0;
-
-    for (i = 0; i < 20; ++i)
-    {
-        double c = (a + b) / 2;
-        double fc = arc_length_helper(A, B, C, c) - u0;
-
-        if (fc < 0)
-        {
-            a = c;
-            fa = fc;
-        }
-        else if (fc > 0)
-        {
-            b = c;
-            fb = fc;
-        }
-        else
-            break;
-    }
-
-    return a - fa * (b - a) / (fb - fa);
-}
-
-static void quad_segment(const double qin[6], double t0, double t1, double qout[6])
-{
-    double u0 = 1 - t0;
-    double u1 = 1 - t1;
-
-    double x0 = qin[0];
-    double y0 = qin[1];
-    double x1 = qin[2];
-    double y1 = qin[3];
-    double x2 = qin[4];
-    double y2 = qin[5];
-
-    qout[0] = (u0 * u0) * x0 + (u0 * t0 + u0 * t0) * x1 + (t0 * t0) * x2;
-    qout[1] = (u0 * u0) * y0 + (u0 * t0 + u0 * t0) * y1 + (t0 * t0) * y2;
-    qout[2] = (u0 * u1) * x0 + (u0 * t1 + u1 * t0) * x1 + (t0 * t1) * x2;
-    qout[3] = (u0 * u1) * y0 + (u0 * t1 + u1 * t0) * y1 + (t0 * t1) * y2;
-    qout[4] = (u1 * u1) * x0 + (u1 * t1 + u1 * t1) * x1 + (t1 * t1) * x2;
-    qout[5] = (u1 * u1) * y0 + (u1 * t1 + u1 * t1) * y1 + (t1 * t1) * y2;
-}
-
-static void add_stroke_quad(SHPath *path, double x0, double y0, double x1, double y1, double x2, double y2)
-{
-    int i;
-
-    double Ax = x0 - 2 * x1 + x2;
-    double Ay = y0 - 2 * y1 + y2;
-    double Bx = 2 * (x1 - x0);
-    double By = 2 * (y1 - y0);
-    double Cx = x0;
-    double Cy = y0;
+    double Ax = x0 - 2 * x1 + x2;
+    double Ay = y0 - 2 * y1 + y2;
+    double Bx = 2 * (x1 - x0);
+    double By = 2 * (y1 - y0);
+    double Cx = x0;
+    double Cy = y0;
 
     double cx, cy, ux, uy, vx, vy;
     get_quadratic_bounds_oriented(x0, y0, x1, y1, x2, y2, path->stroke_width + 1, &cx, &cy, &ux, &uy, &vx, &vy);
@@ -1107,13 +1396,111 @@ static void add_stroke_quad(SHPath *path, double x0, double y0, double x1, doubl
         kv_push_back(g->vertices, path->stroke_width * path->stroke_width / 4);
     }
 
-    kv_push_back(g->indices, index);
-    kv_push_back(g->indices, index + 1);
-    kv_push_back(g->indices, index + 2);
+    push_triangle(g, index, index + 1, index + 2);
+
+    push_triangle(g, index, index + 2, index + 3);
+}
+
+/*--------------------------------------------------
+ * Arc length table of a quadratic for dashing and
+ * for vgPathLength / vgPointAlongPath. The length
+ * is tabulated at evenly spaced parameters with 3
+ * point Gauss-Legendre quadrature once per piece;
+ * each cut then interpolates the table and takes a
+ * Newton step on the speed of the curve instead of
+ * solving for the closed form length.
+ *--------------------------------------------------*/
+
+#define SH_DASH_LUT_SIZE 16
+
+struct arc_length_lut
+{
+    double Ax, Ay, Bx, By;
+    double ts[SH_DASH_LUT_SIZE + 2];
+    double lengths[SH_DASH_LUT_SIZE + 2];
+    int count;
+    int cursor;
+};
+
+static double quad_speed(const struct arc_length_lut *lut, double t)
+{
+    double dx = 2 * lut->Ax * t + lut->Bx;
+    double dy = 2 * lut->Ay * t + lut->By;
+    return sqrt(dx * dx + dy * dy);
+}
+
+static double gauss_arc_length(const struct arc_length_lut *lut, double t0, double t1)
+{
+    double h = (t1 - t0) / 2;
+    double m = (t0 + t1) / 2;
+    double k = h * 0.7745966692414834; /* sqrt(3/5) */
+
+    return h * (5 * quad_speed(lut, m - k) + 8 * quad_speed(lut, m) + 5 * quad_speed(lut, m + k)) / 9;
+}
+
+static void init_arc_length_lut(struct arc_length_lut *lut, double x0, double y0, double x1, double y1, double x2, double y2)
+{
+    int i;
+
+    lut->Ax = x0 - 2 * x1 + x2;
+    lut->Ay = y0 - 2 * y1 + y2;
+    lut->Bx = 2 * (x1 - x0);
+    lut->By = 2 * (y1 - y0);
+    lut->cursor = 0;
+
+    /* The speed has a sharp minimum near a cusp, which the
+       quadrature only follows if it falls on a knot */
+    double aa = lut->Ax * lut->Ax + lut->Ay * lut->Ay;
+    double tm = aa > 0 ? -(lut->Ax * lut->Bx + lut->Ay * lut->By) / (2 * aa) : 0;
+
+    lut->count = 0;
+    for (i = 0; i <= SH_DASH_LUT_SIZE; ++i)
+    {
+        double t = (double)i / SH_DASH_LUT_SIZE;
+        if (i > 0 && tm > lut->ts[lut->count - 1] && tm < t)
+            lut->ts[lut->count++] = tm;
+        lut->ts[lut->count++] = t;
+    }
+
+    lut->lengths[0] = 0;
+    for (i = 1; i < lut->count; ++i)
+        lut->lengths[i] = lut->lengths[i - 1] + gauss_arc_length(lut, lut->ts[i - 1], lut->ts[i]);
+}
+
+/* Parameter at distance u, for cuts that mostly come in increasing order */
+static double lut_parameter(struct arc_length_lut *lut, double u)
+{
+    int i, n;
+
+    if (u <= 0)
+        return 0;
+    if (u >= lut->lengths[lut->count - 1])
+        return 1;
+
+    while (lut->cursor > 0 && lut->lengths[lut->cursor] > u)
+        --lut->cursor;
+    while (lut->lengths[lut->cursor + 1] < u)
+        ++lut->cursor;
+
+    i = lut->cursor;
 
-    kv_push_back(g->indices, index);
-    kv_push_back(g->indices, index + 2);
-    kv_push_back(g->indices, index + 3);
+    double l0 = lut->lengths[i];
+    double l1 = lut->lengths[i + 1];
+    double t0 = lut->ts[i];
+    double t1 = lut->ts[i + 1];
+
+    double t = t0 + (l1 > l0 ? (u - l0) / (l1 - l0) : 0) * (t1 - t0);
+
+    for (n = 0; n < 2; ++n)
+    {
+        double speed = quad_speed(lut, t);
+        if (speed <= 0)
+            break;
+        t -= (l0 + gauss_arc_length(lut, t0, t) - u) / speed;
+        t = MIN(MAX(t, t0), t1);
+    }
+
+    return t;
 }
 
 static void add_stroke_quad_dashed(SHPath *path, double x0, double y0, double x1, double y1, double x2, double y2, double *dash_offset)
@@ -1124,16 +1511,12 @@ static void add_stroke_quad_dashed(SHPath *path, double x0, double y0, double x1
         return;
     }
 
-    double Ax = x0 - 2 * x1 + x2;
-    double Ay = y0 - 2 * y1 + y2;
-    double Bx = 2 * (x1 - x0);
-    double By = 2 * (y1 - y0);
-    double Cx = x0;
-    double Cy = y0;
+    struct arc_length_lut lut;
+    init_arc_length_lut(&lut, x0, y0, x1, y1, x2, y2);
 
     double q[6] = { x0, y0, x1, y1, x2, y2 };
 
-    double length = arc_length(Ax, Ay, Bx, By, Cx, Cy, 1);
+    double length = lut.lengths[lut.count - 1];
 
     double offset = -fmod(*dash_offset, path->dash_length);
 
@@ -1145,8 +1528,8 @@ static void add_stroke_quad_dashed(SHPath *path, double x0, double y0, double x1
 
         if (o1 >= 0)
         {
-            double t0 = inverse_arc_length(Ax, Ay, Bx, By, Cx, Cy, o0);
-            double t1 = inverse_arc_length(Ax, Ay, Bx, By, Cx, Cy, o1);
+            double t0 = lut_parameter(&lut, o0);
+            double t1 = lut_parameter(&lut, o1);
 
             double qout[6];
             quad_segment(q, t0, t1, qout);
@@ -1201,9 +1584,7 @@ static void add_join_bevel(SHPath *path, float x0, float y0, float x1, float y1,
         kv_push_back(g->vertices, y1 + v1x * w1);
     }
 
-    kv_push_back(g->indices, index);
-    kv_push_back(g->indices, index + 1);
-    kv_push_back(g->indices, index + 2);
+    push_triangle(g, index, index + 1, index + 2);
 }
 
 static int check_offset(SHPath *path, float of)
@@ -1228,14 +1609,144 @@ static int check_offset(SHPath *path, float of)
     return 0;
 }
 
+/* Unit normals of the incoming and outgoing segments on the outer side of the turn */
+static int join_normals(float x0, float y0, float x1, float y1, float x2, float y2,
+                        float *n0x, float *n0y, float *n1x, float *n1y)
+{
+    float v0x = x0 - x1;
+    float v0y = y0 - y1;
+    float v1x = x2 - x1;
+    float v1y = y2 - y1;
+
+    float len0 = sqrtf(v0x * v0x + v0y * v0y);
+    float len1 = sqrtf(v1x * v1x + v1y * v1y);
+
+    if (len0 == 0 || len1 == 0)
+        return 0;
+
+    if (v0x * v1y - v0y * v1x < 0)
+    {
+        *n0x = -v0y / len0;
+        *n0y = v0x / len0;
+        *n1x = v1y / len1;
+        *n1y = -v1x / len1;
+    }
+    else
+    {
+        *n0x = v0y / len0;
+        *n0y = -v0x / len0;
+        *n1x = -v1y / len1;
+        *n1y = v1x / len1;
+    }
+
+    return 1;
+}
+
 static void add_join_miter_truncate(SHPath *path, float x0, float y0, float x1, float y1, float x2, float y2)
 {
-    //TODO
+    float n0x, n0y, n1x, n1y;
+
+    if (!join_normals(x0, y0, x1, y1, x2, y2, &n0x, &n0y, &n1x, &n1y))
+        return;
+
+    /* The miter length over the stroke width is 1 / cos(turn / 2),
+       and OpenVG falls back to a bevel past the miter limit */
+    float c = 1 + n0x * n1x + n0y * n1y;
+    float limit = MAX(path->miter_limit, 1);
+
+    if (c * limit * limit < 2)
+    {
+        add_join_bevel(path, x0, y0, x1, y1, x2, y2);
+        return;
+    }
+
+    struct geometry *g = &path->stroke_geoms[0];
+
+    float w = path->stroke_width * 0.5f;
+
+    int index = kv_size(g->vertices) / 2;
+
+    kv_push_back(g->vertices, x1);
+    kv_push_back(g->vertices, y1);
+    kv_push_back(g->vertices, x1 + n0x * w);
+    kv_push_back(g->vertices, y1 + n0y * w);
+    kv_push_back(g->vertices, x1 + (n0x + n1x) * w / c);
+    kv_push_back(g->vertices, y1 + (n0y + n1y) * w / c);
+    kv_push_back(g->vertices, x1 + n1x * w);
+    kv_push_back(g->vertices, y1 + n1y * w);
+
+    push_triangle(g, index, index + 1, index + 2);
+
+    push_triangle(g, index, index + 2, index + 3);
 }
 
 static void add_join_round(SHPath *path, float x0, float y0, float x1, float y1, float x2, float y2)
 {
-    //TODO
+    int i;
+    float n0x, n0y, n1x, n1y;
+
+    if (!join_normals(x0, y0, x1, y1, x2, y2, &n0x, &n0y, &n1x, &n1y))
+        return;
+
+    /* Outer bisector, or straight ahead when the path turns back */
+    float mx = n0x + n1x;
+    float my = n0y + n1y;
+    float len = sqrtf(mx * mx + my * my);
+
+    if (len > 1e-4f)
+    {
+        mx /= len;
+        my /= len;
+    }
+    else
+    {
+        mx = x1 - x0;
+        my = y1 - y0;
+        len = sqrtf(mx * mx + my * my);
+        mx /= len;
+        my /= len;
+    }
+
+    /* The wedge lies in the half disk on the outer side of the
+       corner; the segments already cover the rest of the disk */
+    float r = (path->stroke_width + 1) * 0.5f;
+
+    float px[4], py[4];
+
+    px[0] = x1 - my * r;
+    py[0] = y1 + mx * r;
+    px[1] = x1 + my * r;
+    py[1] = y1 - mx * r;
+    px[2] = px[1] + mx * r;
+    py[2] = py[1] + my * r;
+    px[3] = px[0] + mx * r;
+    py[3] = py[0] + my * r;
+
+    /* A curve with A = B = 0 is the corner point itself, which
+       the stroke coverage measures the distance to directly */
+    struct geometry *g = &path->stroke_geoms[1];
+
+    int index = kv_size(g->vertices) / 12;
+
+    for (i = 0; i < 4; ++i)
+    {
+        kv_push_back(g->vertices, px[i]);
+        kv_push_back(g->vertices, py[i]);
+        kv_push_back(g->vertices, 0);
+        kv_push_back(g->vertices, 0);
+        kv_push_back(g->vertices, 0);
+        kv_push_back(g->vertices, 0);
+        kv_push_back(g->vertices, 0);
+        kv_push_back(g->vertices, 0);
+        kv_push_back(g->vertices, x1);
+        kv_push_back(g->vertices, y1);
+        kv_push_back(g->vertices, 0);
+        kv_push_back(g->vertices, path->stroke_width * path->stroke_width / 4);
+    }
+
+    push_triangle(g, index, index + 1, index + 2);
+
+    push_triangle(g, index, index + 2, index + 3);
 }
 
 static void add_join(SHPath *path, float x0, float y0, float x1, float y1, float x2, float y2)
@@ -1320,114 +1831,108 @@ static void update_bounds(float bounds[4], size_t num_vertices, const float *ver
     }
 }
 
-void shCreateStrokeGeometry(SHPath *path)
+static void add_stroke_path(SHPath *path, struct reduced_path *p, double *dash_offset)
 {
 #define c0 coords[icoord]
 #define c1 coords[icoord + 1]
 #define c2 coords[icoord + 2]
 #define c3 coords[icoord + 3]
 
-#define set(x1, y1, x2, y2) ncpx = x1; ncpy = y1; npepx = x2; npepy = y2;
-
-    reduced_path_vec *reduced_paths = &path->reduced_paths;
+#define set(x1, y1, x2, y2) ncpx = x1; ncpy = y1;
 
     size_t i, j;
 
     for (i = 0; i < 2; ++i)
     {
-        kv_init(path->stroke_geoms[i].vertices);
-        kv_init(path->stroke_geoms[i].indices);
+        p->stroke_start[i][0] = kv_size(path->stroke_geoms[i].vertices);
+        p->stroke_start[i][1] = SH_GEOMETRY_INDEX_COUNT(&path->stroke_geoms[i]);
     }
 
-    double offset = 0;
-
-    for (i = 0; i < kv_size(*reduced_paths); ++i)
-    {
-        struct reduced_path *p = &kv_a(*reduced_paths, i);
+    double offset = *dash_offset;
 
-        kvec_float_t corners;
-        kv_init(corners);
+    kvec_float_t corners;
+    kv_init(corners);
 
-        size_t num_commands = kv_size(p->commands);
-        unsigned char *commands = kv_data(p->commands);
-        float *coords = kv_data(p->coords);
+    size_t num_commands = kv_size(p->commands);
+    unsigned char *commands = kv_data(p->commands);
+    float *coords = kv_data(p->coords);
 
-        int closed = 0;
+    int closed = 0;
 
-        int icoord = 0;
+    int icoord = 0;
 
-        float spx = 0, spy = 0;
-        float cpx = 0, cpy = 0;
-        float pepx = 0, pepy = 0;
-        float ncpx = 0, ncpy = 0;
-        float npepx = 0, npepy = 0;
+    float spx = 0, spy = 0;
+    float cpx = 0, cpy = 0;
+    float ncpx = 0, ncpy = 0;
 
-        for (j = 0; j < num_commands; ++j)
+    for (j = 0; j < num_commands; ++j)
+    {
+        switch (commands[j])
         {
-            switch (commands[j])
-            {
-            case VG_MOVE_TO:
-                corner_start(&corners, c0, c1, offset);
-                set(c0, c1, c0, c1);
-                spx = ncpx;
-                spy = ncpy;
-                icoord += 2;
-                break;
-            case VG_LINE_TO:
-                add_stroke_line_dashed(path, cpx, cpy, c0, c1, &offset);
-                corner_continue(&corners, (cpx + c0) / 2, (cpy + c1) / 2, c0, c1, offset);
-                set(c0, c1, c0, c1);
-                icoord += 2;
-                break;
-            case VG_QUAD_TO:
-                add_stroke_quad_dashed(path, cpx, cpy, c0, c1, c2, c3, &offset);
-                corner_continue(&corners, c0, c1, c2, c3, offset);
-                set(c2, c3, c0, c1);
-                icoord += 4;
-                break;
-            case VG_CLOSE_PATH:
-                add_stroke_line_dashed(path, cpx, cpy, spx, spy, &offset);
-                corner_end(&corners, (cpx + spx) / 2, (cpy + spy) / 2);
-                set(spx, spy, spx, spy);
-                closed = 1;
-                break;
-            }
-
-            cpx = ncpx;
-            cpy = ncpy;
-            pepx = npepx;
-            pepy = npepy;
+        case VG_MOVE_TO:
+            corner_start(&corners, c0, c1, offset);
+            set(c0, c1, c0, c1);
+            spx = ncpx;
+            spy = ncpy;
+            icoord += 2;
+            break;
+        case VG_LINE_TO:
+            add_stroke_line_dashed(path, cpx, cpy, c0, c1, &offset);
+            corner_continue(&corners, (cpx + c0) / 2, (cpy + c1) / 2, c0, c1, offset);
+            set(c0, c1, c0, c1);
+            icoord += 2;
+            break;
+        case VG_QUAD_TO:
+            add_stroke_quad_dashed(path, cpx, cpy, c0, c1, c2, c3, &offset);
+            corner_continue(&corners, c0, c1, c2, c3, offset);
+            set(c2, c3, c0, c1);
+            icoord += 4;
+            break;
+        case VG_CLOSE_PATH:
+            add_stroke_line_dashed(path, cpx, cpy, spx, spy, &offset);
+            corner_end(&corners, (cpx + spx) / 2, (cpy + spy) / 2);
+            set(spx, spy, spx, spy);
+            closed = 1;
+            break;
         }
 
-        size_t ncorners = (kv_size(corners) - (closed ? 0 : 7)) / 5;
+        cpx = ncpx;
+        cpy = ncpy;
+    }
 
-        for (j = 0; j < ncorners; j++)
-        {
-            int j0 = j;
-            int j1 = (j + 1) % ncorners;
-
-            float x0 = kv_a(corners, j0 * 5 + 3);
-            float y0 = kv_a(corners, j0 * 5 + 4);
-            float x1 = kv_a(corners, j1 * 5 + 0);
-            float y1 = kv_a(corners, j1 * 5 + 1);
-            float of = kv_a(corners, j1 * 5 + 2);
-            float x2 = kv_a(corners, j1 * 5 + 3);
-            float y2 = kv_a(corners, j1 * 5 + 4);
-
-            if (check_offset(path, of))
-                add_join(path, x0, y0, x1, y1, x2, y2);
-        }
+    size_t ncorners = (kv_size(corners) - (closed ? 0 : 7)) / 5;
 
-        kv_free(corners);
+    for (j = 0; j < ncorners; j++)
+    {
+        int j0 = j;
+        int j1 = (j + 1) % ncorners;
+
+        float x0 = kv_a(corners, j0 * 5 + 3);
+        float y0 = kv_a(corners, j0 * 5 + 4);
+        float x1 = kv_a(corners, j1 * 5 + 0);
+        float y1 = kv_a(corners, j1 * 5 + 1);
+        float of = kv_a(corners, j1 * 5 + 2);
+        float x2 = kv_a(corners, j1 * 5 + 3);
+        float y2 = kv_a(corners, j1 * 5 + 4);
+
+        if (check_offset(path, of))
+            add_join(path, x0, y0, x1, y1, x2, y2);
     }
 
+    kv_free(corners);
+
+    *dash_offset = offset;
+
 #undef c0
 #undef c1
 #undef c2
 #undef c3
 
 #undef set
+}
 
+static void finish_stroke_geometry(SHPath *path)
+{
     path->stroke_bounds[0] = 1e30f;
     path->stroke_bounds[1] = 1e30f;
     path->stroke_bounds[2] = -1e30f;
@@ -1436,321 +1941,1282 @@ void shCreateStrokeGeometry(SHPath *path)
     update_bounds(path->stroke_bounds, kv_size(path->stroke_geoms[0].vertices), kv_data(path->stroke_geoms[0].vertices), 2);
     update_bounds(path->stroke_bounds, kv_size(path->stroke_geoms[1].vertices), kv_data(path->stroke_geoms[1].vertices), 12);
 
-    path->stroke_geoms[0].count = kv_size(path->stroke_geoms[0].indices);
-    path->stroke_geoms[1].count = kv_size(path->stroke_geoms[1].indices);
+    path->stroke_geoms[0].count = SH_GEOMETRY_INDEX_COUNT(&path->stroke_geoms[0]);
+    path->stroke_geoms[1].count = SH_GEOMETRY_INDEX_COUNT(&path->stroke_geoms[1]);
+}
+
+/* Replaces, in each geometry of a packed set, vertices
+   [start[k][0],end[k][0]) and indices [start[k][1],end[k][1])
+   by those of src[k], whose indices count from zero. Indices
+   past the range follow their vertices. The set is rewritten
+   in place when no size changes and repacked otherwise.
+   Returns 0 and keeps the set when out of memory. */
+static int splice_geometry_set(struct geometry *set, int n, size_t start[][2], size_t end[][2],
+                                const struct geometry *src, const int *strides)
+{
+    size_t num_vertices[4], num_indices[4], i;
+    int wide[4], k, in_place = 1;
+    struct geometry out[4];
+
+    for (k = 0; k < n; ++k)
+    {
+        size_t old_vertices = kv_size(set[k].vertices);
+        size_t old_indices = SH_GEOMETRY_INDEX_COUNT(&set[k]);
+
+        num_vertices[k] = old_vertices - (end[k][0] - start[k][0]) + kv_size(src[k].vertices);
+        num_indices[k] = old_indices - (end[k][1] - start[k][1]) + SH_GEOMETRY_INDEX_COUNT(&src[k]);
+
+        /* Widen when the vertices outgrow 16-bit indices */
+        wide[k] = set[k].wide || src[k].wide || num_vertices[k] / strides[k] > 0x10000;
+
+        if (num_vertices[k] != old_vertices || num_indices[k] != old_indices || wide[k] != set[k].wide)
+            in_place = 0;
+    }
+
+    if (in_place)
+    {
+        for (k = 0; k < n; ++k)
+        {
+            size_t base = start[k][0] / strides[k];
+
+            if (kv_size(src[k].vertices))
+                memcpy(kv_data(set[k].vertices) + start[k][0], kv_data(src[k].vertices),
+                       kv_size(src[k].vertices) * sizeof(float));
+            for (i = 0; i < SH_GEOMETRY_INDEX_COUNT(&src[k]); ++i)
+                put_index(&set[k], start[k][1] + i, SH_GEOMETRY_INDEX(&src[k], i) + base);
+        }
+        return 1;
+    }
+
+    if (!alloc_geometry_set(out, n, num_vertices, num_indices, wide))
+        return 0;
+
+    for (k = 0; k < n; ++k)
+    {
+        struct geometry *g = &set[k];
+        size_t old_vertices = kv_size(g->vertices);
+        size_t old_indices = SH_GEOMETRY_INDEX_COUNT(g);
+        size_t new_vertices = kv_size(src[k].vertices);
+        size_t new_indices = SH_GEOMETRY_INDEX_COUNT(&src[k]);
+        size_t base = start[k][0] / strides[k];
+        long shift = ((long)new_vertices - (long)(end[k][0] - start[k][0])) / strides[k];
+        float *v = kv_data(out[k].vertices);
+        size_t at = 0;
+
+        if (start[k][0])
+            memcpy(v, kv_data(g->vertices), start[k][0] * sizeof(float));
+        if (new_vertices)
+            memcpy(v + start[k][0], kv_data(src[k].vertices), new_vertices * sizeof(float));
+        if (old_vertices > end[k][0])
+            memcpy(v + start[k][0] + new_vertices, kv_data(g->vertices) + end[k][0],
+                   (old_vertices - end[k][0]) * sizeof(float));
+
+        for (i = 0; i < start[k][1]; ++i)
+            put_index(&out[k], at++, SH_GEOMETRY_INDEX(g, i));
+        for (i = 0; i < new_indices; ++i)
+            put_index(&out[k], at++, SH_GEOMETRY_INDEX(&src[k], i) + base);
+        for (i = end[k][1]; i < old_indices; ++i)
+            put_index(&out[k], at++, SH_GEOMETRY_INDEX(g, i) + shift);
+    }
+
+    shFreeGeometrySet(set, n);
+    for (k = 0; k < n; ++k)
+        set[k] = out[k];
+
+    return 1;
+}
+
+int shCreateStrokeGeometry(SHPath *path, struct geometry_scratch *scratch)
+{
+    reduced_path_vec *reduced_paths = &path->reduced_paths;
+
+    size_t i;
+
+    shFreeGeometrySet(path->stroke_geoms, 2);
+    lend_scratch(path->stroke_geoms, scratch->stroke, 2);
+
+    double offset = path->dash_phase;
+
+    for (i = 0; i < kv_size(*reduced_paths); ++i)
+        add_stroke_path(path, &kv_a(*reduced_paths, i), &offset);
+
+    take_scratch(path->stroke_geoms, scratch->stroke, 2);
+    if (!pack_geometry_set(path->stroke_geoms, scratch->stroke, 2))
+        return 0;
+
+    finish_stroke_geometry(path);
+    return 1;
+}
+
+/*--------------------------------------------------
+ * Rebuilds the stroke of reduced paths [r0,r1) in
+ * place. The geometry of the following paths is
+ * kept and moved. Dashing carries its phase across
+ * sub-paths, so dashed strokes are not updated here.
+ * Returns 0 when out of memory, leaving a stroke
+ * that has to be rebuilt.
+ *--------------------------------------------------*/
+
+int shUpdateStrokeGeometry(SHPath *path, SHint r0, SHint r1, struct geometry_scratch *scratch)
+{
+    reduced_path_vec *reduced_paths = &path->reduced_paths;
+    SHint n = (SHint)kv_size(*reduced_paths);
+    static const int strides[2] = {2, 12};
+    struct geometry saved[2];
+    size_t start[2][2], end[2][2];
+    SHint i, k;
+    double offset = path->dash_phase;
+
+    assert(path->num_dashes == 0);
+
+    /* Build the sub-paths into scratch and splice it in
+       place of their old geometry */
+    for (k = 0; k < 2; ++k)
+    {
+        struct geometry *g = &path->stroke_geoms[k];
+
+        start[k][0] = kv_a(*reduced_paths, r0).stroke_start[k][0];
+        start[k][1] = kv_a(*reduced_paths, r0).stroke_start[k][1];
+        end[k][0] = (r1 < n ? kv_a(*reduced_paths, r1).stroke_start[k][0] : kv_size(g->vertices));
+        end[k][1] = (r1 < n ? kv_a(*reduced_paths, r1).stroke_start[k][1] : SH_GEOMETRY_INDEX_COUNT(g));
+
+        saved[k] = *g;
+    }
+
+    lend_scratch(path->stroke_geoms, scratch->stroke, 2);
+
+    for (i = r0; i < r1; ++i)
+        add_stroke_path(path, &kv_a(*reduced_paths, i), &offset);
+
+    take_scratch(path->stroke_geoms, scratch->stroke, 2);
+
+    for (k = 0; k < 2; ++k)
+    {
+        struct geometry *built = &scratch->stroke[k];
+        size_t vertex_delta = kv_size(built->vertices) - (end[k][0] - start[k][0]);
+        size_t index_delta = SH_GEOMETRY_INDEX_COUNT(built) - (end[k][1] - start[k][1]);
+
+        /* The rebuilt paths recorded offsets from zero */
+        for (i = r0; i < r1; ++i)
+        {
+            kv_a(*reduced_paths, i).stroke_start[k][0] += start[k][0];
+            kv_a(*reduced_paths, i).stroke_start[k][1] += start[k][1];
+        }
+
+        for (i = r1; i < n; ++i)
+        {
+            kv_a(*reduced_paths, i).stroke_start[k][0] += vertex_delta;
+            kv_a(*reduced_paths, i).stroke_start[k][1] += index_delta;
+        }
+    }
+
+    for (k = 0; k < 2; ++k)
+        path->stroke_geoms[k] = saved[k];
+
+    if (!splice_geometry_set(path->stroke_geoms, 2, start, end, scratch->stroke, strides))
+        return 0;
+
+    finish_stroke_geometry(path);
+    return 1;
+}
+
+/*--------------------------------------------------
+ * Fan triangles only carry positions, so the fan
+ * center and the contour points are shared within
+ * a sub-path: each of the two fan geometries keeps
+ * its center and the last point it emitted.
+ *--------------------------------------------------*/
+
+struct fill_fan
+{
+    int center[2];
+    int last[2];
+    float last_x[2], last_y[2];
+};
+
+static void init_fill_fan(struct fill_fan *fan)
+{
+    fan->center[0] = fan->center[1] = -1;
+    fan->last[0] = fan->last[1] = -1;
+}
+
+static int push_fan_vertex(struct geometry *g, float x, float y)
+{
+    int index = kv_size(g->vertices) / 4;
+
+    kv_push_back(g->vertices, x);
+    kv_push_back(g->vertices, y);
+    kv_push_back(g->vertices, 0);
+    kv_push_back(g->vertices, 0);
+
+    return index;
+}
+
+static int fan_point(struct fill_fan *fan, struct geometry *g, int k, float x, float y)
+{
+    if (fan->last[k] < 0 || fan->last_x[k] != x || fan->last_y[k] != y)
+    {
+        fan->last[k] = push_fan_vertex(g, x, y);
+        fan->last_x[k] = x;
+        fan->last_y[k] = y;
+    }
+
+    return fan->last[k];
+}
+
+static void add_fill_line(SHPath *p, struct fill_fan *fan, float xc, float yc, float x0, float y0, float x1, float y1)
+{
+    float v0x = x0 - xc;
+    float v0y = y0 - yc;
+    float v1x = x1 - xc;
+    float v1y = y1 - yc;
+
+    int k = v0x * v1y - v0y * v1x < 0 ? 1 : 0;
+    struct geometry *g = &p->fill_geoms[k];
+    int i0, i1;
+
+    if (fan->center[k] < 0)
+        fan->center[k] = push_fan_vertex(g, xc, yc);
+
+    i0 = fan_point(fan, g, k, x0, y0);
+    i1 = fan_point(fan, g, k, x1, y1);
+
+    /* Back-facing triangles are flipped to keep one winding per geometry */
+    if (k == 1)
+        push_triangle(g, fan->center[k], i1, i0);
+    else
+        push_triangle(g, fan->center[k], i0, i1);
+}
+
+static void add_fill_quad(SHPath *p, struct fill_fan *fan, float xc, float yc, float x0, float y0, float x1, float y1, float x2, float y2)
+{
+    float v0x, v0y, v1x, v1y;
+
+    add_fill_line(p, fan, xc, yc, x0, y0, x2, y2);
+
+    v0x = x1 - x0;
+    v0y = y1 - y0;
+    v1x = x2 - x0;
+    v1y = y2 - y0;
+
+    if (v0x * v1y - v0y * v1x < 0)
+    {
+        struct geometry *g = &p->fill_geoms[3];
+
+        int index = kv_size(g->vertices) / 4;
+
+        kv_push_back(g->vertices, x0);
+        kv_push_back(g->vertices, y0);
+        kv_push_back(g->vertices, 0);
+        kv_push_back(g->vertices, 0);
+
+        kv_push_back(g->vertices, x2);
+        kv_push_back(g->vertices, y2);
+        kv_push_back(g->vertices, 1);
+        kv_push_back(g->vertices, 1);
+
+        kv_push_back(g->vertices, x1);
+        kv_push_back(g->vertices, y1);
+        kv_push_back(g->vertices, 0.5f);
+        kv_push_back(g->vertices, 0);
+
+        push_triangle(g, index, index + 1, index + 2);
+    }
+    else
+    {
+        struct geometry *g = &p->fill_geoms[2];
+
+        int index = kv_size(g->vertices) / 4;
+
+        kv_push_back(g->vertices, x2);
+        kv_push_back(g->vertices, y2);
+        kv_push_back(g->vertices, 1);
+        kv_push_back(g->vertices, 1);
+
+        kv_push_back(g->vertices, x0);
+        kv_push_back(g->vertices, y0);
+        kv_push_back(g->vertices, 0);
+        kv_push_back(g->vertices, 0);
+
+        kv_push_back(g->vertices, x1);
+        kv_push_back(g->vertices, y1);
+        kv_push_back(g->vertices, 0.5f);
+        kv_push_back(g->vertices, 0);
+
+        push_triangle(g, index, index + 1, index + 2);
+    }
+}
+
+static void add_fill_path(SHPath *path, struct reduced_path *p)
+{
+#define c0 coords[icoord]
+#define c1 coords[icoord + 1]
+#define c2 coords[icoord + 2]
+#define c3 coords[icoord + 3]
+
+#define set(x1, y1, x2, y2) ncpx = x1; ncpy = y1;
+
+    size_t i, j;
+
+    for (i = 0; i < 4; ++i)
+    {
+        p->fill_start[i][0] = kv_size(path->fill_geoms[i].vertices);
+        p->fill_start[i][1] = SH_GEOMETRY_INDEX_COUNT(&path->fill_geoms[i]);
+    }
+
+    size_t num_commands = kv_size(p->commands);
+    unsigned char *commands = kv_data(p->commands);
+    float *coords = kv_data(p->coords);
+
+    int closed = 0;
+
+    int icoord = 0;
+
+    float spx = 0, spy = 0;
+    float cpx = 0, cpy = 0;
+    float ncpx = 0, ncpy = 0;
+
+    float xc = 0, yc = 0;
+
+    struct fill_fan fan;
+
+    init_fill_fan(&fan);
+
+    for (j = 0; j < num_commands; ++j)
+    {
+        switch (commands[j])
+        {
+        case VG_MOVE_TO:
+            set(c0, c1, c0, c1);
+            spx = ncpx;
+            spy = ncpy;
+            xc = spx;
+            yc = spy;
+            init_fill_fan(&fan);
+            icoord += 2;
+            break;
+        case VG_LINE_TO:
+            add_fill_line(path, &fan, xc, yc, cpx, cpy, c0, c1);
+            set(c0, c1, c0, c1);
+            icoord += 2;
+            break;
+        case VG_QUAD_TO:
+            add_fill_quad(path, &fan, xc, yc, cpx, cpy, c0, c1, c2, c3);
+            set(c2, c3, c0, c1);
+            icoord += 4;
+            break;
+        case VG_CLOSE_PATH:
+            add_fill_line(path, &fan, xc, yc, cpx, cpy, spx, spy);
+            set(spx, spy, spx, spy);
+            closed = 1;
+            break;
+        }
+
+        cpx = ncpx;
+        cpy = ncpy;
+    }
+
+    if (closed == 0)
+    {
+        // TODO: close the fill geometry
+    }
+
+#undef c0
+#undef c1
+#undef c2
+#undef c3
+
+#undef set
+}
+
+static void finish_fill_geometry(SHPath *path)
+{
+    path->fill_bounds[0] = 1e30f;
+    path->fill_bounds[1] = 1e30f;
+    path->fill_bounds[2] = -1e30f;
+    path->fill_bounds[3] = -1e30f;
+
+    update_bounds(path->fill_bounds, kv_size(path->fill_geoms[0].vertices), kv_data(path->fill_geoms[0].vertices), 4);
+    update_bounds(path->fill_bounds, kv_size(path->fill_geoms[1].vertices), kv_data(path->fill_geoms[1].vertices), 4);
+    update_bounds(path->fill_bounds, kv_size(path->fill_geoms[2].vertices), kv_data(path->fill_geoms[2].vertices), 4);
+    update_bounds(path->fill_bounds, kv_size(path->fill_geoms[3].vertices), kv_data(path->fill_geoms[3].vertices), 4);
+
+    path->fill_geoms[0].count = SH_GEOMETRY_INDEX_COUNT(&path->fill_geoms[0]);
+    path->fill_geoms[1].count = SH_GEOMETRY_INDEX_COUNT(&path->fill_geoms[1]);
+    path->fill_geoms[2].count = SH_GEOMETRY_INDEX_COUNT(&path->fill_geoms[2]);
+    path->fill_geoms[3].count = SH_GEOMETRY_INDEX_COUNT(&path->fill_geoms[3]);
+}
+
+int shCreateFillGeometry(SHPath *path, struct geometry_scratch *scratch)
+{
+    reduced_path_vec *reduced_paths = &path->reduced_paths;
+
+    size_t i;
+
+    shFreeGeometrySet(path->fill_geoms, 4);
+    lend_scratch(path->fill_geoms, scratch->fill, 4);
+
+    for (i = 0; i < kv_size(*reduced_paths); ++i)
+        add_fill_path(path, &kv_a(*reduced_paths, i));
+
+    take_scratch(path->fill_geoms, scratch->fill, 4);
+    if (!pack_geometry_set(path->fill_geoms, scratch->fill, 4))
+        return 0;
+
+    finish_fill_geometry(path);
+    return 1;
+}
+
+/*--------------------------------------------------
+ * Rebuilds the fill of reduced paths [r0,r1) in
+ * place. Each sub-path is a separate fan, so the
+ * geometry of the following paths is only moved.
+ * Returns 0 when out of memory, leaving a fill that
+ * has to be rebuilt.
+ *--------------------------------------------------*/
+
+int shUpdateFillGeometry(SHPath *path, SHint r0, SHint r1, struct geometry_scratch *scratch)
+{
+    reduced_path_vec *reduced_paths = &path->reduced_paths;
+    SHint n = (SHint)kv_size(*reduced_paths);
+    static const int strides[4] = {4, 4, 4, 4};
+    struct geometry saved[4];
+    size_t start[4][2], end[4][2];
+    SHint i, k;
+
+    /* Build the sub-paths into scratch and splice it in
+       place of their old geometry */
+    for (k = 0; k < 4; ++k)
+    {
+        struct geometry *g = &path->fill_geoms[k];
+
+        start[k][0] = kv_a(*reduced_paths, r0).fill_start[k][0];
+        start[k][1] = kv_a(*reduced_paths, r0).fill_start[k][1];
+        end[k][0] = (r1 < n ? kv_a(*reduced_paths, r1).fill_start[k][0] : kv_size(g->vertices));
+        end[k][1] = (r1 < n ? kv_a(*reduced_paths, r1).fill_start[k][1] : SH_GEOMETRY_INDEX_COUNT(g));
+
+        saved[k] = *g;
+    }
+
+    lend_scratch(path->fill_geoms, scratch->fill, 4);
+
+    for (i = r0; i < r1; ++i)
+        add_fill_path(path, &kv_a(*reduced_paths, i));
+
+    take_scratch(path->fill_geoms, scratch->fill, 4);
+
+    for (k = 0; k < 4; ++k)
+    {
+        struct geometry *built = &scratch->fill[k];
+        size_t vertex_delta = kv_size(built->vertices) - (end[k][0] - start[k][0]);
+        size_t index_delta = SH_GEOMETRY_INDEX_COUNT(built) - (end[k][1] - start[k][1]);
+
+        /* The rebuilt paths recorded offsets from zero */
+        for (i = r0; i < r1; ++i)
+        {
+            kv_a(*reduced_paths, i).fill_start[k][0] += start[k][0];
+            kv_a(*reduced_paths, i).fill_start[k][1] += start[k][1];
+        }
+
+        for (i = r1; i < n; ++i)
+        {
+            kv_a(*reduced_paths, i).fill_start[k][0] += vertex_delta;
+            kv_a(*reduced_paths, i).fill_start[k][1] += index_delta;
+        }
+    }
+
+    for (k = 0; k < 4; ++k)
+        path->fill_geoms[k] = saved[k];
+
+    if (!splice_geometry_set(path->fill_geoms, 4, start, end, scratch->fill, strides))
+        return 0;
+
+    finish_fill_geometry(path);
+    return 1;
+}
+
+/*--------------------------------------------------
+ * Tells whether the flattened contours fill a single
+ * convex polygon, which a triangle fan covers exactly
+ * once. Contours of less than three vertices cover
+ * nothing. Turning always the same way and reversing
+ * direction at most twice along each axis means the
+ * contour winds exactly once, so it is also simple.
+ *--------------------------------------------------*/
+
+static VGboolean shIsConvexFill(SHPath *p)
+{
+  SHVertex *v = NULL;
+  SHint start, size, count = 0, contours = 0;
+  SHint i, turn = 0, flipsX = 0, flipsY = 0;
+  SHfloat dx, dy, pdx = 0.0f, pdy = 0.0f, cross;
+  SHfloat sx = 0.0f, sy = 0.0f;
+  
+  for (start=0; start < p->vertices.size; start += size) {
+    size = p->vertices.items[start].flags;
+    if (size < 3) continue;
+    if (++contours > 1) return VG_FALSE;
+    v = &p->vertices.items[start];
+    count = size;
+  }
+  
+  if (v == NULL) return VG_TRUE;
+  
+  /* Walk the edges twice around so that the first
+     edge is compared with the last one as well */
+  for (i=0; i <= 2*count; ++i) {
+    dx = v[(i+1) % count].point.x - v[i % count].point.x;
+    dy = v[(i+1) % count].point.y - v[i % count].point.y;
+    if (dx == 0.0f && dy == 0.0f) continue;
+    
+    if (pdx != 0.0f || pdy != 0.0f) {
+      cross = pdx*dy - pdy*dx;
+      if (cross > 0.0f) { if (turn < 0) return VG_FALSE; turn = 1; }
+      if (cross < 0.0f) { if (turn > 0) return VG_FALSE; turn = -1; }
+      if (cross == 0.0f && pdx*dx + pdy*dy < 0.0f) return VG_FALSE;
+    }
+    
+    if (i < count) {
+      if (dx != 0.0f) { if (sx != 0.0f && (dx > 0.0f) != (sx > 0.0f)) ++flipsX; sx = dx; }
+      if (dy != 0.0f) { if (sy != 0.0f && (dy > 0.0f) != (sy > 0.0f)) ++flipsY; sy = dy; }
+    }
+    
+    pdx = dx; pdy = dy;
+  }
+  
+  return (flipsX <= 2 && flipsY <= 2) ? VG_TRUE : VG_FALSE;
+}
+
+/*--------------------------------------------------
+ * Processes path data by simplfying it and sending
+ * each segment to subdivision callback function.
+ * In surface space the tolerance holds up to the
+ * top of the power-of-two scale bucket, so that the
+ * vertices can serve other transforms of the bucket
+ * (see shFlattenHeadroom).
+ *--------------------------------------------------*/
+
+void shFlattenPath(SHPath *p, SHint surfaceSpace)
+{
+  SHint contourStart = -1;
+  SHfloat tolerance = p->flattenTolerance;
+  void *userData[3];
+  SHint processFlags =
+    SH_PROCESS_SIMPLIFY_LINES |
+    SH_PROCESS_SIMPLIFY_CURVES |
+    SH_PROCESS_CENTRALIZE_ARCS |
+    SH_PROCESS_REPAIR_ENDS;
+  VG_GETCONTEXT(VG_NO_RETVAL);
+  
+  if (surfaceSpace)
+    tolerance /= shFlattenHeadroom(&context->pathTransform);
+  
+  userData[0] = &contourStart;
+  userData[1] = &surfaceSpace;
+  userData[2] = &tolerance;
+  
+  shVertexArrayClear(&p->vertices);
+  shProcessPathData(p, processFlags, shSubdivideSegment, userData);
+  p->fillConvex = shIsConvexFill(p);
+}
+
+/*--------------------------------------------------
+ * Processes path data by simplfying it and sending
+ * each segment to reducer callback function. Curves
+ * are approximated for the given user-to-surface
+ * scale.
+ *--------------------------------------------------*/
+void shReducePath(SHPath *p, SHfloat scale)
+{
+  SHReduceState st;
+  
+  // Reduce paths
+  shReduceSegmentDeinit(&p->reduced_paths);
+  shReduceSegmentInit(&p->reduced_paths);
+  shReduceStateInit(&st, &p->reduced_paths, scale);
+  shProcessPathData(p, 0, shReduceSegment, &st);
+}
+
+/* Index of the reduced path the given segment went into */
+static SHint shFindReducedPath(SHPath *p, SHint segment)
+{
+  SHint lo = 0, hi = (SHint)kv_size(p->reduced_paths) - 1;
+  
+  while (lo < hi) {
+    SHint mid = (lo + hi + 1) / 2;
+    if (kv_a(p->reduced_paths, mid).first_segment <= segment) lo = mid;
+    else hi = mid - 1;
+  }
+  
+  return lo;
+}
+
+/*--------------------------------------------------
+ * Reduces again the sub-paths affected by a change
+ * of coordinates in segments [first,end), at the
+ * scale the path was last reduced for. Commands are
+ * unchanged so the sub-paths map to the same reduced
+ * paths, whose range [r0,r1) is returned.
+ *--------------------------------------------------*/
+void shReducePathRange(SHPath *p, SHint first, SHint end, SHint *r0, SHint *r1)
+{
+  reduced_path_vec *rpv = &p->reduced_paths;
+  SHint n = (SHint)kv_size(*rpv);
+  SHReduceState st;
+  SHint i, a, b, segCount;
+  
+  *r0 = *r1 = 0;
+  if (n == 0) return;
+  
+  a = shFindReducedPath(p, first);
+  b = shFindReducedPath(p, end - 1) + 1;
+  
+  /* Relative and smooth segments carry the pen over
+     into the following sub-paths up to an absolute move */
+  while (b < n && p->segs[kv_a(*rpv, b).first_segment] != VG_MOVE_TO_ABS)
+    ++b;
+  
+  for (i=a; i<b; ++i) {
+    kv_clear(kv_a(*rpv, i).commands);
+    kv_clear(kv_a(*rpv, i).coords);
+  }
+  
+  shReduceStateInit(&st, rpv, p->cacheReduceScale);
+  st.first = (a == 0 ? 0 : kv_a(*rpv, a).first_segment);
+  st.end = (b == n ? p->segCount : kv_a(*rpv, b).first_segment);
+  
+  /* Segments past the range need not be visited */
+  segCount = p->segCount;
+  p->segCount = st.end;
+  shProcessPathData(p, 0, shReduceSegment, &st);
+  p->segCount = segCount;
+  
+  *r0 = a;
+  *r1 = b;
+}
+
+/*--------------------------------------------------
+ * Returns the scale the path has to be reduced for
+ * under the given transform. It is rounded up to a
+ * power of two so small zoom changes reuse the
+ * reduced path and its geometry. Extreme zooms are
+ * capped at 65536.
+ *--------------------------------------------------*/
+static SHfloat shTransformScale(SHMatrix3x3 *m)
+{
+  SHfloat sx = SH_SQRT(m->m[0][0]*m->m[0][0] + m->m[1][0]*m->m[1][0]);
+  SHfloat sy = SH_SQRT(m->m[0][1]*m->m[0][1] + m->m[1][1]*m->m[1][1]);
+  return SH_MAX(sx, sy);
+}
+
+SHfloat shReduceScale(SHMatrix3x3 *m)
+{
+  SHfloat scale = shTransformScale(m);
+  int e;
+  
+  if (!isfinite(scale) || !(scale > 0.0f)) return 1.0f;
+  if (scale > 65536.0f) scale = 65536.0f;
+  
+  if (frexp(scale, &e) == 0.5) e--;
+  return (SHfloat)ldexp(1.0, e);
+}
+
+/*-------------------------------------------------------
+ * How much further the transform can stretch before it
+ * leaves its scale bucket: the top of the bucket over
+ * the scale, at least 1 (scales beyond the last bucket).
+ *-------------------------------------------------------*/
+
+SHfloat shFlattenHeadroom(SHMatrix3x3 *m)
+{
+  SHfloat headroom = shReduceScale(m) / shTransformScale(m);
+  
+  return (headroom > 1.0f) ? headroom : 1.0f;
+}
+
+/*-------------------------------------------
+ * Releases the reduced paths and geometries
+ *-------------------------------------------*/
+
+void shDeletePathGeometry(SHPath *p)
+{
+  shReduceSegmentDeinit(&p->reduced_paths);
+  kv_init(p->reduced_paths);
+
+  shFreeGeometrySet(p->fill_geoms, 4);
+  shFreeGeometrySet(p->stroke_geoms, 2);
+}
+
+void shDeletePathLengths(SHPath *p)
+{
+  kv_free(p->lengthIndex.seg_pieces);
+  kv_free(p->lengthIndex.pieces);
+  kv_free(p->lengthIndex.lengths);
+  kv_init(p->lengthIndex.seg_pieces);
+  kv_init(p->lengthIndex.pieces);
+  kv_init(p->lengthIndex.lengths);
+  p->cacheLengthValid = VG_FALSE;
+}
+
+/*--------------------------------------------------
+ * Arc lengths of the pieces of the reduced path,
+ * measured on the same Gauss-Legendre table as the
+ * dashes, so both agree on where a distance falls.
+ *--------------------------------------------------*/
+
+/* Curves are measured as finely as if the path spanned
+   this many units, whatever its coordinate range */
+#define SH_LENGTH_RESOLUTION 4096.0f
+
+static double piece_length(const float *q)
+{
+    struct arc_length_lut lut;
+
+    init_arc_length_lut(&lut, q[0], q[1], q[2], q[3], q[4], q[5]);
+    return lut.lengths[lut.count - 1];
+}
+
+/* Parameter of the point at distance u along the piece */
+static double piece_parameter(const float *q, double u, double length)
+{
+    struct arc_length_lut lut;
+
+    if (u <= 0 || length <= 0)
+        return 0;
+    if (u >= length)
+        return 1;
+
+    init_arc_length_lut(&lut, q[0], q[1], q[2], q[3], q[4], q[5]);
+    return lut_parameter(&lut, u);
+}
+
+static void add_length_piece(struct length_index *index, float x0, float y0,
+                             float x1, float y1, float x2, float y2)
+{
+    double length;
+    float *q;
+
+    kv_push_back(index->pieces, x0);
+    kv_push_back(index->pieces, y0);
+    kv_push_back(index->pieces, x1);
+    kv_push_back(index->pieces, y1);
+    kv_push_back(index->pieces, x2);
+    kv_push_back(index->pieces, y2);
+
+    q = &kv_a(index->pieces, kv_size(index->pieces) - 6);
+    length = kv_back(index->lengths) + piece_length(q);
+    kv_push_back(index->lengths, length);
+}
+
+/* The reducer emits into a scratch set of reduced paths
+   whose new elements are turned into pieces after each
+   segment, so pieces are known per segment */
+typedef struct
+{
+    SHReduceState reduce;
+    reduced_path_vec paths;
+    struct length_index *index;
+    int path;            /* reduced path being read */
+    size_t command;      /* next unread command and coord */
+    size_t coord;
+    float x, y;          /* end of the last piece */
+} SHMeasureState;
+
+static void shMeasureSegment(SHPath *p, VGPathSegment segment,
+                             VGPathCommand originalCommand,
+                             SHfloat *data, void *userData)
+{
+    SHMeasureState *st = (SHMeasureState*)userData;
+    struct reduced_path *rp;
+    float *c;
+
+    kv_push_back(st->index->seg_pieces, (int)kv_size(st->index->lengths) - 1);
+    shReduceSegment(p, segment, originalCommand, data, &st->reduce);
+
+    if (st->reduce.current != st->path)
+    {
+        st->path = st->reduce.current;
+        st->command = 0;
+        st->coord = 0;
+    }
+
+    /* Moves only overwrite the start of an empty reduced
+       path, so they get a point piece of their own */
+    if (segment == VG_MOVE_TO)
+    {
+        st->x = st->reduce.cpx;
+        st->y = st->reduce.cpy;
+        add_length_piece(st->index, st->x, st->y, st->x, st->y, st->x, st->y);
+    }
+
+    if (st->path < 0)
+        return;
+
+    rp = &kv_a(st->paths, st->path);
+    while (st->command < kv_size(rp->commands))
+    {
+        c = &kv_a(rp->coords, st->coord);
+        switch (kv_a(rp->commands, st->command++))
+        {
+        case VG_MOVE_TO_ABS:
+            st->coord += 2;
+            break;
+
+        case VG_LINE_TO_ABS:
+            add_length_piece(st->index, st->x, st->y,
+                             (st->x + c[0]) / 2, (st->y + c[1]) / 2, c[0], c[1]);
+            st->x = c[0];
+            st->y = c[1];
+            st->coord += 2;
+            break;
+
+        case VG_QUAD_TO_ABS:
+            add_length_piece(st->index, st->x, st->y, c[0], c[1], c[2], c[3]);
+            st->x = c[2];
+            st->y = c[3];
+            st->coord += 4;
+            break;
+
+        case VG_CLOSE_PATH:
+            add_length_piece(st->index, st->x, st->y,
+                             (st->x + st->reduce.spx) / 2, (st->y + st->reduce.spy) / 2,
+                             st->reduce.spx, st->reduce.spy);
+            st->x = st->reduce.spx;
+            st->y = st->reduce.spy;
+            break;
+        }
+    }
+}
+
+/*--------------------------------------------------
+ * Brings the arc-length index of the path up to
+ * date. Lengths are in path coordinates and the
+ * index is kept until the path data changes.
+ *--------------------------------------------------*/
+
+void shUpdatePathLengths(SHPath *p)
+{
+  SHMeasureState st;
+  SHfloat extent, scale = 1.0f;
+  
+  if (p->cacheLengthValid == VG_TRUE)
+    return;
+  
+  /* The reduce tolerance is relative to the path size */
+  shUpdatePathBounds(p);
+  extent = SH_MAX(p->boundsMax.x - p->boundsMin.x,
+                  p->boundsMax.y - p->boundsMin.y);
+  if (extent > 0.0f && isfinite(SH_LENGTH_RESOLUTION / extent))
+    scale = SH_LENGTH_RESOLUTION / extent;
+  
+  kv_clear(p->lengthIndex.seg_pieces);
+  kv_clear(p->lengthIndex.pieces);
+  kv_clear(p->lengthIndex.lengths);
+  kv_push_back(p->lengthIndex.lengths, 0.0);
+  
+  shReduceSegmentInit(&st.paths);
+  shReduceStateInit(&st.reduce, &st.paths, scale);
+  st.index = &p->lengthIndex;
+  st.path = -1;
+  st.command = 0;
+  st.coord = 0;
+  st.x = 0.0f;
+  st.y = 0.0f;
+  
+  shProcessPathData(p, 0, shMeasureSegment, &st);
+  kv_push_back(p->lengthIndex.seg_pieces,
+               (int)kv_size(p->lengthIndex.lengths) - 1);
+  
+  shReduceSegmentDeinit(&st.paths);
+  p->cacheLengthValid = VG_TRUE;
 }
 
-static void add_fill_line(SHPath *p, float xc, float yc, float x0, float y0, float x1, float y1)
+/* Length of the segments [first,end) */
+SHfloat shPathLength(SHPath *p, SHint first, SHint end)
 {
-    float v0x = x0 - xc;
-    float v0y = y0 - yc;
-    float v1x = x1 - xc;
-    float v1y = y1 - yc;
+  struct length_index *index = &p->lengthIndex;
+  
+  return (SHfloat)(kv_a(index->lengths, kv_a(index->seg_pieces, end)) -
+                   kv_a(index->lengths, kv_a(index->seg_pieces, first)));
+}
 
-    struct geometry *g = NULL;
-    int index;
+/* Tangent of a piece, falling back to its chord where
+   the curve stops (a control point on an end point) */
+static int piece_tangent(const float *q, double t, SHVector2 *tan)
+{
+    double Ax = q[0] - 2 * q[2] + q[4];
+    double Ay = q[1] - 2 * q[3] + q[5];
+    double dx = 2 * Ax * t + 2 * (q[2] - q[0]);
+    double dy = 2 * Ay * t + 2 * (q[3] - q[1]);
+    double len = sqrt(dx * dx + dy * dy);
 
-    if (v0x * v1y - v0y * v1x < 0)
+    if (len <= 0)
     {
-        g = &p->fill_geoms[1];
+        dx = q[4] - q[0];
+        dy = q[5] - q[1];
+        len = sqrt(dx * dx + dy * dy);
+        if (len <= 0)
+            return 0;
+    }
 
-        index = kv_size(g->vertices) / 4;
+    tan->x = (SHfloat)(dx / len);
+    tan->y = (SHfloat)(dy / len);
+    return 1;
+}
 
-        kv_push_back(g->vertices, xc);
-        kv_push_back(g->vertices, yc);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+/*--------------------------------------------------
+ * Point and unit tangent at the given distance along
+ * the segments [first,end). The piece is found by a
+ * binary search on the cumulative lengths and the
+ * point on it by the inverse of its arc length.
+ * Distances are clamped to the ends; without a
+ * length the tangent is (1,0).
+ *--------------------------------------------------*/
 
-        kv_push_back(g->vertices, x1);
-        kv_push_back(g->vertices, y1);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+void shPointAlongPath(SHPath *p, SHint first, SHint end, SHfloat distance,
+                      SHVector2 *point, SHVector2 *tangent)
+{
+  struct length_index *index = &p->lengthIndex;
+  SHint k0 = kv_a(index->seg_pieces, first);
+  SHint k1 = kv_a(index->seg_pieces, end);
+  SHint lo, hi, k;
+  double target, length, t, x, y;
+  const float *q;
+  
+  point->x = 0.0f; point->y = 0.0f;
+  tangent->x = 1.0f; tangent->y = 0.0f;
+  if (k0 == k1) return;
+  
+  /* First piece ending at or past the distance */
+  target = kv_a(index->lengths, k0) + SH_MAX(distance, 0.0f);
+  target = SH_MIN(target, kv_a(index->lengths, k1));
+  lo = k0; hi = k1 - 1;
+  while (lo < hi) {
+    SHint mid = (lo + hi) / 2;
+    if (kv_a(index->lengths, mid + 1) >= target) hi = mid;
+    else lo = mid + 1;
+  }
+  
+  /* At the start, leave the points of leading moves */
+  k = lo;
+  if (distance <= 0.0f)
+    k = k0;
+  
+  q = &kv_a(index->pieces, 6 * k);
+  length = kv_a(index->lengths, k + 1) - kv_a(index->lengths, k);
+  t = piece_parameter(q, target - kv_a(index->lengths, k), length);
+  evaluate_quadratic(q[0], q[1], q[2], q[3], q[4], q[5], t, &x, &y);
+  point->x = (SHfloat)x;
+  point->y = (SHfloat)y;
+  
+  /* Zero-length pieces take the direction of the
+     path that follows them, or else precedes them */
+  if (piece_tangent(q, t, tangent)) return;
+  for (lo=k+1; lo<k1; ++lo)
+    if (piece_tangent(&kv_a(index->pieces, 6 * lo), 0.0, tangent)) return;
+  for (lo=k-1; lo>=k0; --lo)
+    if (piece_tangent(&kv_a(index->pieces, 6 * lo), 1.0, tangent)) return;
+}
 
-        kv_push_back(g->vertices, x0);
-        kv_push_back(g->vertices, y0);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
-    }
-    else
+/*--------------------------------------------------
+ * Exact bounds from the end points and extrema of
+ * each segment, and the convex hull of the control
+ * points for bounds under a transform. A curve lies
+ * within the hull of its control points; arcs add
+ * the corners of their exact bounds instead.
+ *--------------------------------------------------*/
+
+typedef struct
+{
+    double minx, miny, maxx, maxy;
+    int empty;
+    SHVector2Array *hull;
+} SHBoundsState;
+
+static void bounds_add(SHBoundsState *st, double x, double y)
+{
+    if (st->empty)
     {
-        g = &p->fill_geoms[0];
+        st->minx = st->maxx = x;
+        st->miny = st->maxy = y;
+        st->empty = 0;
+        return;
+    }
 
-        index = kv_size(g->vertices) / 4;
+    st->minx = MIN(st->minx, x);
+    st->miny = MIN(st->miny, y);
+    st->maxx = MAX(st->maxx, x);
+    st->maxy = MAX(st->maxy, y);
+}
 
-        kv_push_back(g->vertices, xc);
-        kv_push_back(g->vertices, yc);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+static void hull_add(SHBoundsState *st, double x, double y)
+{
+    SHVector2 v;
+    SET2(v, (SHfloat)x, (SHfloat)y);
+    shVector2ArrayPushBack(st->hull, v);
+}
 
-        kv_push_back(g->vertices, x0);
-        kv_push_back(g->vertices, y0);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+/* Roots in (0,1) of the derivative of one coordinate */
+static int cubic_extrema(double p0, double p1, double p2, double p3, double t[2])
+{
+    double a = -p0 + 3 * p1 - 3 * p2 + p3;
+    double b = 2 * (p0 - 2 * p1 + p2);
+    double c = p1 - p0;
+    double d, r;
+    int n = 0;
 
-        kv_push_back(g->vertices, x1);
-        kv_push_back(g->vertices, y1);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+    if (fabs(a) < 1e-12)
+    {
+        if (fabs(b) > 1e-12)
+        {
+            r = -c / b;
+            if (0 < r && r < 1) t[n++] = r;
+        }
+        return n;
     }
 
-    kv_push_back(g->indices, index);
-    kv_push_back(g->indices, index + 1);
-    kv_push_back(g->indices, index + 2);
+    d = b * b - 4 * a * c;
+    if (d < 0)
+        return 0;
+    d = sqrt(d);
+
+    r = (-b + d) / (2 * a);
+    if (0 < r && r < 1) t[n++] = r;
+    r = (-b - d) / (2 * a);
+    if (0 < r && r < 1) t[n++] = r;
+    return n;
 }
 
-static void add_fill_quad(SHPath *p, float xc, float yc, float x0, float y0, float x1, float y1, float x2, float y2)
+static void cubic_bounds(SHBoundsState *st, const double c[8])
 {
-    float v0x, v0y, v1x, v1y;
+    double t[4], u, x, y;
+    int i, n;
 
-    v0x = x0 - xc;
-    v0y = y0 - yc;
-    v1x = x2 - xc;
-    v1y = y2 - yc;
+    n = cubic_extrema(c[0], c[2], c[4], c[6], t);
+    n += cubic_extrema(c[1], c[3], c[5], c[7], t + n);
 
-    if (v0x * v1y - v0y * v1x < 0)
+    for (i = 0; i < n; ++i)
     {
-        struct geometry *g = &p->fill_geoms[1];
+        u = 1 - t[i];
+        x = u * u * u * c[0] + 3 * u * u * t[i] * c[2] + 3 * u * t[i] * t[i] * c[4] + t[i] * t[i] * t[i] * c[6];
+        y = u * u * u * c[1] + 3 * u * u * t[i] * c[3] + 3 * u * t[i] * t[i] * c[5] + t[i] * t[i] * t[i] * c[7];
+        bounds_add(st, x, y);
+    }
+}
 
-        int index = kv_size(g->vertices) / 4;
+/* Whether angle a lies on the sweep from theta1 */
+static int arc_sweeps(double a, double theta1, double dtheta)
+{
+    double d = (dtheta > 0) ? a - theta1 : theta1 - a;
 
-        kv_push_back(g->vertices, xc);
-        kv_push_back(g->vertices, yc);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+    d = fmod(d, 2 * M_PI);
+    if (d < 0) d += 2 * M_PI;
+    return d <= fabs(dtheta);
+}
 
-        kv_push_back(g->vertices, x2);
-        kv_push_back(g->vertices, y2);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+static void arc_bounds(SHBoundsState *st, double x1, double y1, double rh, double rv,
+                       double phi, int fA, int fS, double x2, double y2)
+{
+    double cx, cy, theta1, dtheta, a[4];
+    double minx, miny, maxx, maxy;
+    int i;
 
-        kv_push_back(g->vertices, x0);
-        kv_push_back(g->vertices, y0);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+    minx = MIN(x1, x2); maxx = MAX(x1, x2);
+    miny = MIN(y1, y2); maxy = MAX(y1, y2);
 
-        kv_push_back(g->indices, index);
-        kv_push_back(g->indices, index + 1);
-        kv_push_back(g->indices, index + 2);
-    }
-    else
+    /* Zero radii make a line */
+    rh = fabs(rh);
+    rv = fabs(rv);
+    if (rh > 0 && rv > 0 && (x1 != x2 || y1 != y2))
     {
-        struct geometry *g = &p->fill_geoms[0];
-
-        int index = kv_size(g->vertices) / 4;
+        phi *= M_PI / 180;
+        endpoint_to_center(x1, y1, x2, y2, fA, fS, &rh, &rv, phi, &cx, &cy, &theta1, &dtheta);
 
-        kv_push_back(g->vertices, xc);
-        kv_push_back(g->vertices, yc);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+        /* Angles of the horizontal and vertical tangents */
+        a[0] = atan2(-sin(phi) * rv, cos(phi) * rh);
+        a[1] = a[0] + M_PI;
+        a[2] = atan2(cos(phi) * rv, sin(phi) * rh);
+        a[3] = a[2] + M_PI;
 
-        kv_push_back(g->vertices, x0);
-        kv_push_back(g->vertices, y0);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+        for (i = 0; i < 4; ++i)
+        {
+            double x, y;
 
-        kv_push_back(g->vertices, x2);
-        kv_push_back(g->vertices, y2);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+            if (!arc_sweeps(a[i], theta1, dtheta))
+                continue;
 
-        kv_push_back(g->indices, index);
-        kv_push_back(g->indices, index + 1);
-        kv_push_back(g->indices, index + 2);
+            x = cos(phi) * rh * cos(a[i]) - sin(phi) * rv * sin(a[i]) + cx;
+            y = sin(phi) * rh * cos(a[i]) + cos(phi) * rv * sin(a[i]) + cy;
+            minx = MIN(minx, x); maxx = MAX(maxx, x);
+            miny = MIN(miny, y); maxy = MAX(maxy, y);
+        }
     }
 
-    v0x = x1 - x0;
-    v0y = y1 - y0;
-    v1x = x2 - x0;
-    v1y = y2 - y0;
+    bounds_add(st, minx, miny);
+    bounds_add(st, maxx, maxy);
+    hull_add(st, minx, miny);
+    hull_add(st, maxx, miny);
+    hull_add(st, maxx, maxy);
+    hull_add(st, minx, maxy);
+}
 
-    if (v0x * v1y - v0y * v1x < 0)
+static void shBoundsSegment(SHPath *p, VGPathSegment segment,
+                            VGPathCommand originalCommand,
+                            SHfloat *data, void *userData)
+{
+    SHBoundsState *st = (SHBoundsState*)userData;
+    double minx, miny, maxx, maxy;
+    double c[8];
+    int i, n;
+
+    switch (segment)
     {
-        struct geometry *g = &p->fill_geoms[3];
+    case VG_MOVE_TO:
+        return;
 
-        int index = kv_size(g->vertices) / 4;
+    case VG_CLOSE_PATH:
+    case VG_LINE_TO:
+        n = 4;
+        break;
 
-        kv_push_back(g->vertices, x0);
-        kv_push_back(g->vertices, y0);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+    case VG_QUAD_TO:
+        get_quadratic_bounds(data[0], data[1], data[2], data[3], data[4], data[5],
+                             0, &minx, &miny, &maxx, &maxy);
+        bounds_add(st, minx, miny);
+        bounds_add(st, maxx, maxy);
+        n = 6;
+        break;
 
-        kv_push_back(g->vertices, x2);
-        kv_push_back(g->vertices, y2);
-        kv_push_back(g->vertices, 1);
-        kv_push_back(g->vertices, 1);
+    case VG_CUBIC_TO:
+        for (i = 0; i < 8; ++i)
+            c[i] = data[i];
+        cubic_bounds(st, c);
+        n = 8;
+        break;
 
-        kv_push_back(g->vertices, x1);
-        kv_push_back(g->vertices, y1);
-        kv_push_back(g->vertices, 0.5f);
-        kv_push_back(g->vertices, 0);
+    case VG_SCCWARC_TO:
+    case VG_SCWARC_TO:
+    case VG_LCCWARC_TO:
+    case VG_LCWARC_TO:
+        arc_bounds(st, data[0], data[1], data[2], data[3], data[4],
+                   segment == VG_LCCWARC_TO || segment == VG_LCWARC_TO,
+                   segment == VG_SCCWARC_TO || segment == VG_LCCWARC_TO,
+                   data[5], data[6]);
+        return;
 
-        kv_push_back(g->indices, index);
-        kv_push_back(g->indices, index + 1);
-        kv_push_back(g->indices, index + 2);
+    default:
+        return;
     }
-    else
-    {
-        struct geometry *g = &p->fill_geoms[2];
 
-        int index = kv_size(g->vertices) / 4;
-
-        kv_push_back(g->vertices, x2);
-        kv_push_back(g->vertices, y2);
-        kv_push_back(g->vertices, 1);
-        kv_push_back(g->vertices, 1);
+    /* End points bound the segment together with the
+       extrema above; all control points go to the hull */
+    bounds_add(st, data[0], data[1]);
+    bounds_add(st, data[n - 2], data[n - 1]);
+    for (i = 0; i < n; i += 2)
+        hull_add(st, data[i], data[i + 1]);
+}
 
-        kv_push_back(g->vertices, x0);
-        kv_push_back(g->vertices, y0);
-        kv_push_back(g->vertices, 0);
-        kv_push_back(g->vertices, 0);
+static int shCompareHullPoints(const void *a, const void *b)
+{
+    const SHVector2 *u = (const SHVector2*)a;
+    const SHVector2 *v = (const SHVector2*)b;
 
-        kv_push_back(g->vertices, x1);
-        kv_push_back(g->vertices, y1);
-        kv_push_back(g->vertices, 0.5f);
-        kv_push_back(g->vertices, 0);
+    if (u->x != v->x) return (u->x < v->x) ? -1 : 1;
+    if (u->y != v->y) return (u->y < v->y) ? -1 : 1;
+    return 0;
+}
 
-        kv_push_back(g->indices, index);
-        kv_push_back(g->indices, index + 1);
-        kv_push_back(g->indices, index + 2);
-    }
+static double hull_cross(const SHVector2 *o, const SHVector2 *a, const SHVector2 *b)
+{
+    return ((double)a->x - o->x) * ((double)b->y - o->y) -
+           ((double)a->y - o->y) * ((double)b->x - o->x);
 }
 
-void shCreateFillGeometry(SHPath *path)
+/* Andrew's monotone chain, in place */
+static void shConvexHull(SHVector2Array *points)
 {
-#define c0 coords[icoord]
-#define c1 coords[icoord + 1]
-#define c2 coords[icoord + 2]
-#define c3 coords[icoord + 3]
+    SHVector2 *v = points->items, *h;
+    SHint n = points->size, i, k = 0, lower;
 
-#define set(x1, y1, x2, y2) ncpx = x1; ncpy = y1; npepx = x2; npepy = y2;
+    if (n < 3)
+        return;
 
-    reduced_path_vec *reduced_paths = &path->reduced_paths;
+    qsort(v, n, sizeof(SHVector2), shCompareHullPoints);
 
-    size_t i, j;
+    h = (SHVector2*)malloc(2 * n * sizeof(SHVector2));
+    if (!h)
+        return;
 
-    for (i = 0; i < 4; ++i)
+    for (i = 0; i < n; ++i)
     {
-        kv_init(path->fill_geoms[i].vertices);
-        kv_init(path->fill_geoms[i].indices);
+        while (k >= 2 && hull_cross(&h[k - 2], &h[k - 1], &v[i]) <= 0) --k;
+        h[k++] = v[i];
     }
 
-    for (i = 0; i < kv_size(*reduced_paths); ++i)
+    for (i = n - 2, lower = k + 1; i >= 0; --i)
     {
-        struct reduced_path *p = &kv_a(*reduced_paths, i);
-
-        size_t num_commands = kv_size(p->commands);
-        unsigned char *commands = kv_data(p->commands);
-        float *coords = kv_data(p->coords);
-
-        int closed = 0;
-
-        int icoord = 0;
-
-        float spx = 0, spy = 0;
-        float cpx = 0, cpy = 0;
-        float pepx = 0, pepy = 0;
-        float ncpx = 0, ncpy = 0;
-        float npepx = 0, npepy = 0;
-
-        float xc, yc;
-
-        for (j = 0; j < num_commands; ++j)
-        {
-            switch (commands[j])
-            {
-            case VG_MOVE_TO:
-                set(c0, c1, c0, c1);
-                spx = ncpx;
-                spy = ncpy;
-                xc = spx;
-                yc = spy;
-                icoord += 2;
-                break;
-            case VG_LINE_TO:
-                add_fill_line(path, xc, yc, cpx, cpy, c0, c1);
-                set(c0, c1, c0, c1);
-                icoord += 2;
-                break;
-            case VG_QUAD_TO:
-                add_fill_quad(path, xc, yc, cpx, cpy, c0, c1, c2, c3);
-                set(c2, c3, c0, c1);
-                icoord += 4;
-                break;
-            case VG_CLOSE_PATH:
-                add_fill_line(path, xc, yc, cpx, cpy, spx, spy);
-                set(spx, spy, spx, spy);
-                closed = 1;
-                break;
-            }
-
-            cpx = ncpx;
-            cpy = ncpy;
-            pepx = npepx;
-            pepy = npepy;
-        }
-
-        if (closed == 0)
-        {
-            // TODO: close the fill geometry
-        }
+        while (k >= lower && hull_cross(&h[k - 2], &h[k - 1], &v[i]) <= 0) --k;
+        h[k++] = v[i];
     }
 
-#undef c0
-#undef c1
-#undef c2
-#undef c3
-
-#undef set
-
-    path->fill_bounds[0] = 1e30f;
-    path->fill_bounds[1] = 1e30f;
-    path->fill_bounds[2] = -1e30f;
-    path->fill_bounds[3] = -1e30f;
-
-    update_bounds(path->fill_bounds, kv_size(path->fill_geoms[0].vertices), kv_data(path->fill_geoms[0].vertices), 4);
-    update_bounds(path->fill_bounds, kv_size(path->fill_geoms[1].vertices), kv_data(path->fill_geoms[1].vertices), 4);
-    update_bounds(path->fill_bounds, kv_size(path->fill_geoms[2].vertices), kv_data(path->fill_geoms[2].vertices), 4);
-    update_bounds(path->fill_bounds, kv_size(path->fill_geoms[3].vertices), kv_data(path->fill_geoms[3].vertices), 4);
-
-    path->fill_geoms[0].count = kv_size(path->fill_geoms[0].indices);
-    path->fill_geoms[1].count = kv_size(path->fill_geoms[1].indices);
-    path->fill_geoms[2].count = kv_size(path->fill_geoms[2].indices);
-    path->fill_geoms[3].count = kv_size(path->fill_geoms[3].indices);
+    /* The last point repeats the first */
+    memcpy(v, h, (k - 1) * sizeof(SHVector2));
+    points->size = k - 1;
+    free(h);
 }
 
 /*--------------------------------------------------
- * Processes path data by simplfying it and sending
- * each segment to subdivision callback function
+ * Brings the bounds and control hull of the path up
+ * to date. They are kept until the path data changes.
+ * An empty path has a width and height of -1.
  *--------------------------------------------------*/
 
-void shFlattenPath(SHPath *p, SHint surfaceSpace)
+void shUpdatePathBounds(SHPath *p)
 {
-  SHint contourStart = -1;
-  SHint surfSpace = surfaceSpace;
-  SHint *userData[2];
-  SHint processFlags =
-    SH_PROCESS_SIMPLIFY_LINES |
-    SH_PROCESS_SIMPLIFY_CURVES |
-    SH_PROCESS_CENTRALIZE_ARCS |
-    SH_PROCESS_REPAIR_ENDS;
+  SHBoundsState st;
   
-  userData[0] = &contourStart;
-  userData[1] = &surfaceSpace;
+  if (p->cacheBoundsValid == VG_TRUE)
+    return;
   
-  shVertexArrayClear(&p->vertices);
-  shProcessPathData(p, processFlags, shSubdivideSegment, userData);
+  shVector2ArrayClear(&p->boundsHull);
+  st.empty = 1;
+  st.hull = &p->boundsHull;
+  
+  shProcessPathData(p, SH_PROCESS_SIMPLIFY_LINES |
+                    SH_PROCESS_SIMPLIFY_CURVES, shBoundsSegment, &st);
+  
+  if (st.empty) {
+    SET2(p->boundsMin, 0.0f, 0.0f);
+    SET2(p->boundsMax, -1.0f, -1.0f);
+  }else{
+    SET2(p->boundsMin, (SHfloat)st.minx, (SHfloat)st.miny);
+    SET2(p->boundsMax, (SHfloat)st.maxx, (SHfloat)st.maxy);
+  }
+  
+  shConvexHull(&p->boundsHull);
+  p->cacheBoundsValid = VG_TRUE;
 }
 
-/*--------------------------------------------------
- * Processes path data by simplfying it and sending
- * each segment to reducer callback function
- *--------------------------------------------------*/
-void shReducePath(SHPath *p)
+/* Bounds of the control hull under the given transform */
+void shTransformedPathBounds(SHPath *p, SHMatrix3x3 *m,
+                             SHVector2 *min, SHVector2 *max)
 {
-  // Reduce paths
-  shReduceSegmentInit(&p->reduced_paths); // for test
-  shProcessPathData(p, 0, shReduceSegment, NULL);
-  //shReduceSegmentDeinit(&p->reduced_paths); // for test
+  SHVector2 v;
+  SHint i;
+  
+  if (p->boundsHull.size == 0) {
+    SET2((*min), 0.0f, 0.0f);
+    SET2((*max), -1.0f, -1.0f);
+    return;
+  }
+  
+  for (i=0; i<p->boundsHull.size; ++i) {
+    TRANSFORM2TO(p->boundsHull.items[i], (*m), v);
+    if (i == 0 || v.x < min->x) min->x = v.x;
+    if (i == 0 || v.y < min->y) min->y = v.y;
+    if (i == 0 || v.x > max->x) max->x = v.x;
+    if (i == 0 || v.y > max->y) max->y = v.y;
+  }
 }
 
 /*-------------------------------------------
@@ -2251,21 +3717,23 @@ VG_API_CALL void vgPathBounds(VGPath path,
                    width == NULL || height == NULL,
                    VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
 
-  /* TODO: check output pointer alignment */
+  VG_RETURN_ERR_IF(!SH_IS_ALIGNED(minX, VGfloat) ||
+                   !SH_IS_ALIGNED(minY, VGfloat) ||
+                   !SH_IS_ALIGNED(width, VGfloat) ||
+                   !SH_IS_ALIGNED(height, VGfloat),
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
 
-  p = (SHPath*)path;
+  p = shGetPath(context, path);
   VG_RETURN_ERR_IF(!(p->caps & VG_PATH_CAPABILITY_PATH_BOUNDS),
                    VG_PATH_CAPABILITY_ERROR, VG_NO_RETVAL);
 
-  /* Update path geometry */
-  shFlattenPath(p, 0);
-  shFindBoundbox(p);
+  shUpdatePathBounds(p);
 
   /* Output bounds */
-  *minX = p->min.x;
-  *minY = p->min.y;
-  *width = p->max.x - p->min.x;
-  *height = p->max.y - p->min.y;
+  *minX = p->boundsMin.x;
+  *minY = p->boundsMin.y;
+  *width = p->boundsMax.x - p->boundsMin.x;
+  *height = p->boundsMax.y - p->boundsMin.y;
   
   VG_RETURN(VG_NO_RETVAL);
 }
@@ -2281,6 +3749,7 @@ VG_API_CALL void vgPathTransformedBounds(VGPath path,
                                          VGfloat * width, VGfloat * height)
 {
   SHPath *p = NULL;
+  SHVector2 min, max;
   VG_GETCONTEXT(VG_NO_RETVAL);
 
   VG_RETURN_ERR_IF(!shIsValidPath(context, path),
@@ -2290,38 +3759,107 @@ VG_API_CALL void vgPathTransformedBounds(VGPath path,
                    width == NULL || height == NULL,
                    VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
 
-  /* TODO: check output pointer alignment */
+  VG_RETURN_ERR_IF(!SH_IS_ALIGNED(minX, VGfloat) ||
+                   !SH_IS_ALIGNED(minY, VGfloat) ||
+                   !SH_IS_ALIGNED(width, VGfloat) ||
+                   !SH_IS_ALIGNED(height, VGfloat),
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
 
-  p = (SHPath*)path;
-  VG_RETURN_ERR_IF(!(p->caps & VG_PATH_CAPABILITY_PATH_BOUNDS),
+  p = shGetPath(context, path);
+  VG_RETURN_ERR_IF(!(p->caps & VG_PATH_CAPABILITY_PATH_TRANSFORMED_BOUNDS),
                    VG_PATH_CAPABILITY_ERROR, VG_NO_RETVAL);
 
-  /* Update path geometry */
-  shFlattenPath(p, 1);
-  shFindBoundbox(p);
+  /* The render tessellation is left alone */
+  shUpdatePathBounds(p);
+  shTransformedPathBounds(p, &context->pathTransform, &min, &max);
 
   /* Output bounds */
-  *minX = p->min.x;
-  *minY = p->min.y;
-  *width = p->max.x - p->min.x;
-  *height = p->max.y - p->min.y;
-
-  /* Invalidate subdivision for rendering */
-  p->cacheDataValid = VG_FALSE;
+  *minX = min.x;
+  *minY = min.y;
+  *width = max.x - min.x;
+  *height = max.y - min.y;
   
   VG_RETURN(VG_NO_RETVAL);
 }
 
+/*------------------------------------------------------------
+ * Outputs the length of the given range of path segments,
+ * measured on the arc-length index of the path
+ *------------------------------------------------------------*/
+
 VG_API_CALL VGfloat vgPathLength(VGPath path,
                                  VGint startSegment, VGint numSegments)
 {
-  return 0.0f;
+  SHPath *p = NULL;
+  VG_GETCONTEXT(-1.0f);
+
+  VG_RETURN_ERR_IF(!shIsValidPath(context, path),
+                   VG_BAD_HANDLE_ERROR, -1.0f);
+
+  p = shGetPath(context, path);
+  VG_RETURN_ERR_IF(!(p->caps & VG_PATH_CAPABILITY_PATH_LENGTH),
+                   VG_PATH_CAPABILITY_ERROR, -1.0f);
+
+  VG_RETURN_ERR_IF(startSegment < 0 || numSegments <= 0 ||
+                   startSegment >= p->segCount ||
+                   numSegments > p->segCount - startSegment,
+                   VG_ILLEGAL_ARGUMENT_ERROR, -1.0f);
+
+  shUpdatePathLengths(p);
+  VG_RETURN(shPathLength(p, startSegment, startSegment + numSegments));
 }
 
+/*------------------------------------------------------------
+ * Outputs the point and unit tangent at the given distance
+ * along a range of path segments. Either pair of outputs
+ * may be NULL.
+ *------------------------------------------------------------*/
+
 VG_API_CALL void vgPointAlongPath(VGPath path,
                                   VGint startSegment, VGint numSegments,
                                   VGfloat distance,
                                   VGfloat * x, VGfloat * y,
                                   VGfloat * tangentX, VGfloat * tangentY)
 {
+  SHPath *p = NULL;
+  SHVector2 point, tangent;
+  VG_GETCONTEXT(VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(!shIsValidPath(context, path),
+                   VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(!SH_IS_ALIGNED(x, VGfloat) ||
+                   !SH_IS_ALIGNED(y, VGfloat) ||
+                   !SH_IS_ALIGNED(tangentX, VGfloat) ||
+                   !SH_IS_ALIGNED(tangentY, VGfloat),
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  p = shGetPath(context, path);
+  VG_RETURN_ERR_IF(x && y && !(p->caps & VG_PATH_CAPABILITY_POINT_ALONG_PATH),
+                   VG_PATH_CAPABILITY_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(tangentX && tangentY &&
+                   !(p->caps & VG_PATH_CAPABILITY_TANGENT_ALONG_PATH),
+                   VG_PATH_CAPABILITY_ERROR, VG_NO_RETVAL);
+
+  VG_RETURN_ERR_IF(startSegment < 0 || numSegments <= 0 ||
+                   startSegment >= p->segCount ||
+                   numSegments > p->segCount - startSegment,
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+
+  shUpdatePathLengths(p);
+  shPointAlongPath(p, startSegment, startSegment + numSegments,
+                   distance, &point, &tangent);
+
+  if (x && y) {
+    *x = point.x;
+    *y = point.y;
+  }
+
+  if (tangentX && tangentY) {
+    *tangentX = tangent.x;
+    *tangentY = tangent.y;
+  }
+
+  VG_RETURN(VG_NO_RETVAL);
 }
@@ -6,12 +6,43 @@
 #include "shVectors.h"
 #include "shPath.h"
 
+/* Shares of the flatten tolerance a cubic spends on its quads
+   and on flattening them. The rest absorbs the error of the
+   approximate parabola integral. */
+#define SH_CUBIC_QUADS_SHARE   0.1f
+#define SH_FLATTEN_QUADS_SHARE 0.85f
+
 void shFlattenPath(SHPath *p, SHint surfaceSpace);
+void shFlattenQuads(SHVertexArray *out, const SHQuad *quads,
+                    SHint count, SHfloat tolerance);
+SHint shCubicToQuads(const SHCubic *c, SHfloat tolerance, SHQuad *quads);
+void shFlattenArc(SHVertexArray *out, const SHArc *arc, const SHVector2 *c,
+                  const SHVector2 *ux, const SHVector2 *uy, SHfloat tolerance);
 void shStrokePath(VGContext* c, SHPath *p);
 void shTransformVertices(SHMatrix3x3 *m, SHPath *p);
-void shReducePath(SHPath *p);
+void shReducePath(SHPath *p, SHfloat scale);
+void shReducePathRange(SHPath *p, SHint first, SHint end, SHint *r0, SHint *r1);
+SHfloat shReduceScale(SHMatrix3x3 *m);
+SHfloat shFlattenHeadroom(SHMatrix3x3 *m);
 void shFindBoundbox(SHPath *p);
-void shCreateFillGeometry(SHPath *path);
-void shCreateStrokeGeometry(SHPath *path);
+int shCreateFillGeometry(SHPath *path, struct geometry_scratch *scratch);
+int shCreateStrokeGeometry(SHPath *path, struct geometry_scratch *scratch);
+int shUpdateFillGeometry(SHPath *path, SHint r0, SHint r1, struct geometry_scratch *scratch);
+int shUpdateStrokeGeometry(SHPath *path, SHint r0, SHint r1, struct geometry_scratch *scratch);
+void shInitGeometry(struct geometry *g);
+void shFreeGeometry(struct geometry *g);
+void shFreeGeometrySet(struct geometry *set, int n);
+struct geometry_scratch *shCreateGeometryScratch(int count);
+void shDeleteGeometryScratch(struct geometry_scratch *s, int count);
+SHint shFillGeometryBytes(SHPath *p);
+void shDeletePathGeometry(SHPath *p);
+void shUpdatePathLengths(SHPath *p);
+SHfloat shPathLength(SHPath *p, SHint first, SHint end);
+void shPointAlongPath(SHPath *p, SHint first, SHint end, SHfloat distance,
+                      SHVector2 *point, SHVector2 *tangent);
+void shDeletePathLengths(SHPath *p);
+void shUpdatePathBounds(SHPath *p);
+void shTransformedPathBounds(SHPath *p, SHMatrix3x3 *m,
+                             SHVector2 *min, SHVector2 *max);
 
 #endif /* __SH_GEOMETRY_H */
@@ -4,8 +4,10 @@
 #include <VG/vulcanvg.h>
 #include "shImage.h"
 #include "shContext.h"
+#include "shRasterizer.h"
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #define _ITEM_T SHColor
 #define _ARRAY_T SHColorArray
@@ -14,12 +16,6 @@
 #define _COMPARE_T(c1,c2) 0
 #include "shArrayBase.h"
 
-#define _ITEM_T SHImage*
-#define _ARRAY_T SHImageArray
-#define _FUNC_T shImageArray
-#define _ARRAY_DEFINE
-#include "shArrayBase.h"
-
 
 /*-----------------------------------------------------------
  * Prepares the proper pixel pack/unpack info for the given
@@ -30,7 +26,7 @@ void shSetupImageFormat(VGImageFormat vg, SHImageFormatDesc *f)
 {
   SHuint8 abits = 0;
   SHuint8 tshift = 0;
-  SHuint8 tmask = 0;
+  SHuint32 tmask = 0;
   SHuint32 amsbBit = 0;
   SHuint32 bgrBit = 0;
 
@@ -343,14 +339,189 @@ int shIsValidImageFormat(VGImageFormat format)
 int shIsSupportedImageFormat(VGImageFormat format)
 {
   SHuint32 baseFormat = (format & 0x1F);
-  if (baseFormat == VG_sRGBA_8888_PRE ||
-      baseFormat == VG_lRGBA_8888_PRE ||
-      baseFormat == VG_BW_1)
+  if (baseFormat == VG_BW_1)
       return 0;
 
   return 1;
 }
 
+/*-----------------------------------------------------------
+ * Maps a pixel coordinate outside an image of the given size
+ * back into it according to the tiling mode. Returns -1 for
+ * VG_TILE_FILL, where the edge fill color is used instead.
+ *-----------------------------------------------------------*/
+
+SHint shTileCoord(SHint i, SHint size, VGTilingMode mode)
+{
+  switch (mode) {
+  case VG_TILE_PAD:
+    return (i < 0) ? 0 : (i >= size ? size-1 : i);
+  case VG_TILE_REPEAT:
+    i %= size;
+    return (i < 0) ? i + size : i;
+  case VG_TILE_REFLECT:
+    i %= 2*size;
+    if (i < 0) i += 2*size;
+    return (i >= size) ? 2*size - 1 - i : i;
+  default:
+    return (i < 0 || i >= size) ? -1 : i;
+  }
+}
+
+/*-----------------------------------------------------------
+ * Tables for the sRGB transfer functions of the OpenVG
+ * specification. 8 bit sRGB values map to linear floats and
+ * to 8 bit linear values; linear values map back to 8 bit
+ * sRGB from 8 bits, or from 12 bits for floats, which is
+ * fine enough for every 8 bit sRGB value to round trip.
+ *-----------------------------------------------------------*/
+
+#define SH_GAMMA_INDEX_MAX 4095
+
+static SHfloat shSRGBToLinearTable[256];
+static SHuint8 shSRGBToLinear8[256];
+static SHuint8 shLinearToSRGB8[256];
+static SHuint8 shLinearToSRGBTable[SH_GAMMA_INDEX_MAX + 1];
+static SHuint32 shUnpremulTable[256];
+static SHuint32 shUnpremulGammaTable[256];
+static pthread_once_t shColorTablesOnce = PTHREAD_ONCE_INIT;
+
+static SHfloat shGammaValue(SHfloat x)
+{
+  return (x <= 0.00304f) ? 12.92f * x :
+    1.0556f * (SHfloat)pow(x, 1.0f / 2.4f) - 0.0556f;
+}
+
+static SHfloat shInverseGammaValue(SHfloat x)
+{
+  return (x <= 0.03928f) ? x / 12.92f :
+    (SHfloat)pow((x + 0.0556f) / 1.0556f, 2.4f);
+}
+
+static void shBuildColorTables(void)
+{
+  SHint i;
+  
+  for (i=0; i<256; ++i) {
+    shSRGBToLinearTable[i] = shInverseGammaValue(i / 255.0f);
+    shSRGBToLinear8[i] = (SHuint8)(shSRGBToLinearTable[i] * 255.0f + 0.5f);
+    shLinearToSRGB8[i] = (SHuint8)(shGammaValue(i / 255.0f) * 255.0f + 0.5f);
+  }
+  
+  for (i=0; i<=SH_GAMMA_INDEX_MAX; ++i)
+    shLinearToSRGBTable[i] = (SHuint8)
+      (shGammaValue((SHfloat)i / SH_GAMMA_INDEX_MAX) * 255.0f + 0.5f);
+  
+  /* 255/a in 16.16 fixed point, rounded up so that the products
+     round like (c*255 + a/2) / a does, ties included */
+  shUnpremulTable[0] = 0;
+  shUnpremulGammaTable[0] = 0;
+  for (i=1; i<256; ++i) {
+    shUnpremulTable[i] = (255u * 65536u + i - 1) / i;
+    shUnpremulGammaTable[i] = (SH_GAMMA_INDEX_MAX * 256u + i / 2) / i;
+  }
+}
+
+void shInitColorTables(void)
+{
+  pthread_once(&shColorTablesOnce, shBuildColorTables);
+}
+
+int shIsPremultipliedImageFormat(VGImageFormat format)
+{
+  SHuint32 baseFormat = (format & 0x1F);
+  return (baseFormat == VG_sRGBA_8888_PRE ||
+          baseFormat == VG_lRGBA_8888_PRE);
+}
+
+int shIsLinearImageFormat(VGImageFormat format)
+{
+  SHuint32 baseFormat = (format & 0x1F);
+  return (baseFormat == VG_lRGBX_8888 ||
+          baseFormat == VG_lRGBA_8888 ||
+          baseFormat == VG_lRGBA_8888_PRE ||
+          baseFormat == VG_lL_8);
+}
+
+/*-----------------------------------------------------------
+ * Converts the color channels of a non-premultiplied color
+ * between sRGB and linear. Results are quantized to 8 bits;
+ * the tables have to be set up by shInitColorTables, which
+ * creating an image or copying pixels does.
+ *-----------------------------------------------------------*/
+
+static SHint shColorIndex(SHfloat x, SHint max)
+{
+  SH_CLAMP(x, 0.0f, 1.0f);
+  return (SHint)(x * max + 0.5f);
+}
+
+void shLinearizeColor(SHColor *c)
+{
+  c->r = shSRGBToLinearTable[shColorIndex(c->r, 255)];
+  c->g = shSRGBToLinearTable[shColorIndex(c->g, 255)];
+  c->b = shSRGBToLinearTable[shColorIndex(c->b, 255)];
+}
+
+void shGammaColor(SHColor *c)
+{
+  c->r = shLinearToSRGBTable[shColorIndex(c->r, SH_GAMMA_INDEX_MAX)] / 255.0f;
+  c->g = shLinearToSRGBTable[shColorIndex(c->g, SH_GAMMA_INDEX_MAX)] / 255.0f;
+  c->b = shLinearToSRGBTable[shColorIndex(c->b, SH_GAMMA_INDEX_MAX)] / 255.0f;
+}
+
+/*-----------------------------------------------------------
+ * Premultiplies a row of 8 bit RGBA words (red in the top
+ * byte, alpha in the bottom one) in place. Red and blue are
+ * multiplied together in the two halves of a word and every
+ * channel rounds c*a/255 without dividing.
+ *-----------------------------------------------------------*/
+
+void shPremultiplyRow(SHuint32 *rgba, SHint count)
+{
+  SHuint32 in, a, rb, g;
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    in = rgba[i];
+    a = in & 0xFF;
+    if (a == 0xFF) continue;
+    
+    rb = ((in >> 8) & 0x00FF00FF) * a + 0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    g = ((in >> 16) & 0xFF) * a + 0x80;
+    g = (g + (g >> 8)) >> 8;
+    
+    rgba[i] = (rb << 8) | (g << 16) | a;
+  }
+}
+
+/*-----------------------------------------------------------
+ * Unpremultiplies a row of 8 bit RGBA words in place with a
+ * table of reciprocals of alpha, set up by shInitColorTables.
+ * Channels round c*255/a and clamp to 255; words of zero
+ * alpha become zero.
+ *-----------------------------------------------------------*/
+
+void shUnpremultiplyRow(SHuint32 *rgba, SHint count)
+{
+  SHuint32 in, k, r, g, b;
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    in = rgba[i];
+    if ((in & 0xFF) == 0xFF) continue;
+    
+    k = shUnpremulTable[in & 0xFF];
+    r = ((in >> 24) * k + 0x8000) >> 16;
+    g = (((in >> 16) & 0xFF) * k + 0x8000) >> 16;
+    b = (((in >> 8) & 0xFF) * k + 0x8000) >> 16;
+    
+    rgba[i] = (SH_MIN(r, 255) << 24) | (SH_MIN(g, 255) << 16) |
+              (SH_MIN(b, 255) << 8) | (in & 0xFF);
+  }
+}
+
 /*--------------------------------------------------------
  * Packs the pixel color components into memory at given
  * address according to given format
@@ -359,20 +530,31 @@ int shIsSupportedImageFormat(VGImageFormat format)
 void shStoreColor(SHColor *c, void *data, SHImageFormatDesc *f)
 {
   /*
+  The color is in the color space of the format, conversions
+  between sRGB and linear are up to the caller.
+
   TODO: unsupported formats:
-  - s and l both behave linearly
   - 1-bit black & white (BW_1)
   */
 
   SHfloat l = 0.0f;
   SHuint32 out = 0x0;
+  SHColor lin;
 
-  if (f->vgformat == VG_lL_8 || f->vgformat == VG_sL_8) {
+  if (f->vgformat == VG_lL_8) {
 
     /* Grayscale (luminosity) conversion as defined by the spec */
-    l = 0.2126f * c->r + 0.7152f * c->g + 0.0722f * c->r;
+    l = 0.2126f * c->r + 0.7152f * c->g + 0.0722f * c->b;
     out = (SHuint32)(l * (SHfloat)f->rmax + 0.5f);
 
+  }else if (f->vgformat == VG_sL_8) {
+
+    /* Luminosity is weighted in linear light */
+    lin = *c;
+    shLinearizeColor(&lin);
+    l = 0.2126f * lin.r + 0.7152f * lin.g + 0.0722f * lin.b;
+    out = shLinearToSRGBTable[shColorIndex(l, SH_GAMMA_INDEX_MAX)];
+
   }else{
 
     /* Pack color components */
@@ -398,8 +580,10 @@ void shStoreColor(SHColor *c, void *data, SHImageFormatDesc *f)
 void shLoadColor(SHColor *c, const void *data, SHImageFormatDesc *f)
 {
   /*
+  The color is in the color space of the format, conversions
+  between sRGB and linear are up to the caller.
+
   TODO: unsupported formats:
-  - s and l both behave linearly
   - 1-bit black & white (BW_1)
   */
 
@@ -444,7 +628,11 @@ void SHImage_ctor(SHImage *i)
   i->data = NULL;
   i->width = 0;
   i->height = 0;
+#if RENDERING_ENGINE == SOFTWARE
+  i->texture = 0;
+#else
   glGenTextures(1, &i->texture);
+#endif
 }
 
 void SHImage_dtor(SHImage *i)
@@ -452,8 +640,10 @@ void SHImage_dtor(SHImage *i)
   if (i->data != NULL)
     free(i->data);
   
+#if RENDERING_ENGINE != SOFTWARE
   if (glIsTexture(i->texture))
     glDeleteTextures(1, &i->texture);
+#endif
 }
 
 /*--------------------------------------------------------
@@ -490,6 +680,7 @@ void shUpdateImageTextureSize(SHImage *i)
 
 void shUpdateImageTexture(SHImage *i, VGContext *c)
 {
+#if RENDERING_ENGINE != SOFTWARE
   SHint potwidth;
   SHint potheight;
   SHint8 *potdata;
@@ -536,6 +727,7 @@ void shUpdateImageTexture(SHImage *i, VGContext *c)
   glTexImage2D(GL_TEXTURE_2D, 0, i->fd.glintformat,
                i->texwidth, i->texheight, 0,
                i->fd.glformat, i->fd.gltype, i->data);
+#endif
 }
 
 /*----------------------------------------------------------
@@ -548,6 +740,7 @@ VG_API_CALL VGImage vgCreateImage(VGImageFormat format,
 {
   SHImage *i = NULL;
   SHImageFormatDesc fd;
+  VGHandle handle;
   VG_GETCONTEXT(VG_INVALID_HANDLE);
   
   /* Reject invalid formats */
@@ -578,6 +771,7 @@ VG_API_CALL VGImage vgCreateImage(VGImageFormat format,
                    VG_ILLEGAL_ARGUMENT_ERROR, VG_INVALID_HANDLE);
   
   /* Create new image object */
+  shInitColorTables();
   SH_NEWOBJ(SHImage, i);
   VG_RETURN_ERR_IF(!i, VG_OUT_OF_MEMORY_ERROR, VG_INVALID_HANDLE);
   i->width = width;
@@ -596,10 +790,13 @@ VG_API_CALL VGImage vgCreateImage(VGImageFormat format,
   memset(i->data, 1, width * height * fd.bytes);
   shUpdateImageTexture(i, context);
   
-  /* Add to resource list */
-  shImageArrayPushBack(&context->images, i);
+  /* Add to resource table */
+  handle = shCreateHandle(context, i, SH_RESOURCE_IMAGE);
+  if (handle == VG_INVALID_HANDLE) {
+    SH_DELETEOBJ(SHImage, i);
+    VG_RETURN_ERR(VG_OUT_OF_MEMORY_ERROR, VG_INVALID_HANDLE); }
   
-  VG_RETURN((VGImage)i);
+  VG_RETURN((VGImage)handle);
 }
 
 VG_API_CALL VGImage vgCreateImageFromVkImageEXT(
@@ -614,16 +811,21 @@ VG_API_CALL VGImage vgCreateImageFromVkImageEXT(
 
 VG_API_CALL void vgDestroyImage(VGImage image)
 {
-  SHint index;
+  SHImage *i;
   VG_GETCONTEXT(VG_NO_RETVAL);
   
   /* Check if valid resource */
-  index = shImageArrayFind(&context->images, (SHImage*)image);
-  VG_RETURN_ERR_IF(index == -1, VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+  i = shGetImage(context, image);
+  VG_RETURN_ERR_IF(!i, VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+  
+#if RENDERING_ENGINE == SOFTWARE
+  /* Pending draws may still sample the image */
+  shFlushRaster(context);
+#endif
   
   /* Delete object and remove resource */
-  SH_DELETEOBJ(SHImage, (SHImage*)image);
-  shImageArrayRemoveAt(&context->images, index);
+  SH_DELETEOBJ(SHImage, i);
+  shDestroyHandle(context, image);
   
   VG_RETURN(VG_NO_RETVAL);
 }
@@ -647,7 +849,12 @@ VG_API_CALL void vgClearImage(VGImage image,
   
   /* TODO: check if image current render target */
   
-  i = (SHImage*)image;
+#if RENDERING_ENGINE == SOFTWARE
+  /* Pending draws may still sample the image */
+  shFlushRaster(context);
+#endif
+  
+  i = shGetImage(context, image);
   VG_RETURN_ERR_IF(width <= 0 || height <= 0,
                    VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
   
@@ -666,6 +873,10 @@ VG_API_CALL void vgClearImage(VGImage image,
   
   /* Walk pixels and clear*/
   clear = context->clearColor;
+  if (shIsLinearImageFormat(i->fd.vgformat))
+    shLinearizeColor(&clear);
+  if (shIsPremultipliedImageFormat(i->fd.vgformat))
+    CPREMUL(clear);
   
   for (Y=iy; Y<iy+height; ++Y) {
     data = i->data + ( Y*stride + ix * i->fd.bytes );
@@ -679,6 +890,403 @@ VG_API_CALL void vgClearImage(VGImage image,
   VG_RETURN(VG_NO_RETVAL);
 }
 
+/*------------------------------------------------------------
+ * Integer row converters for copies between two different
+ * formats. A row is unpacked into 8 bit RGBA words (red in
+ * the top byte) and packed again from them, chunk by chunk.
+ * Channels of other depths go through per-channel tables
+ * that round like shLoadColor and shStoreColor do. Copies
+ * between sRGB and linear formats convert the words with
+ * the 8 bit transfer tables, except into luminance, which
+ * is weighted in linear light from the source colors. Words
+ * of premultiplied formats are unpremultiplied before any
+ * change of color space and whenever the target is not
+ * premultiplied, and premultiplied again for such targets.
+ * Straight 32 bit words into 16 bit or luminance formats skip
+ * the words and index tables pre-shifted into the target.
+ *------------------------------------------------------------*/
+
+#define SH_CONVERT_CHUNK 256
+
+typedef struct
+{
+  SHImageFormatDesc fd;
+  SHuint8 expand[4][256];   /* channel value -> 8 bits */
+  SHuint8 reduce[4][256];   /* 8 bits -> channel value */
+  SHint linear;             /* the format holds linear colors */
+  SHint linearWords;        /* the words packed are linear */
+  SHint premultiplied;      /* the format holds premultiplied colors */
+  
+} SHPixelCodec;
+
+typedef void (*SHUnpackRowFunc)(const SHuint8 *src, SHuint32 *rgba,
+                                SHint count, const SHPixelCodec *pc);
+typedef void (*SHPackRowFunc)(const SHuint32 *rgba, SHuint8 *dst,
+                              SHint count, const SHPixelCodec *pc);
+
+static void shSetupPixelCodec(VGImageFormat format, SHPixelCodec *pc)
+{
+  SHuint32 max[4];
+  SHuint32 mask[4];
+  SHint c, v;
+  
+  shSetupImageFormat(format, &pc->fd);
+  pc->linear = shIsLinearImageFormat(format);
+  pc->linearWords = pc->linear;
+  pc->premultiplied = shIsPremultipliedImageFormat(format);
+  if (pc->fd.bytes == 4) return;
+  
+  max[0] = pc->fd.rmax; mask[0] = pc->fd.rmask;
+  max[1] = pc->fd.gmax; mask[1] = pc->fd.gmask;
+  max[2] = pc->fd.bmax; mask[2] = pc->fd.bmask;
+  max[3] = pc->fd.amax; mask[3] = pc->fd.amask;
+  
+  /* Round to nearest, which never falls on a tie
+     since 255 and the other channel maxima are odd */
+  for (c=0; c<4; ++c) {
+    for (v=0; v<256; ++v) {
+      pc->expand[c][v] = (mask[c] == 0 ? 255 :
+        (SHuint8)((2*SH_MIN((SHuint32)v, max[c])*255 + max[c]) / (2*max[c])));
+      pc->reduce[c][v] = (SHuint8)((2*v*max[c] + 255) / 510);
+    }
+  }
+}
+
+static void shUnpackRow32(const SHuint8 *src, SHuint32 *rgba,
+                          SHint count, const SHPixelCodec *pc)
+{
+  const SHuint32 *s = (const SHuint32*)src;
+  SHuint32 rs = pc->fd.rshift, gs = pc->fd.gshift, bs = pc->fd.bshift;
+  SHuint32 as = pc->fd.ashift, am = pc->fd.amask;
+  SHuint32 a = (am == 0 ? 0xFF : 0x0);
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    SHuint32 in = s[i];
+    rgba[i] = (((in >> rs) & 0xFF) << 24) |
+              (((in >> gs) & 0xFF) << 16) |
+              (((in >> bs) & 0xFF) << 8) |
+              ((in & am) >> as) | a;
+  }
+}
+
+static void shPackRow32(const SHuint32 *rgba, SHuint8 *dst,
+                        SHint count, const SHPixelCodec *pc)
+{
+  SHuint32 *d = (SHuint32*)dst;
+  SHuint32 rs = pc->fd.rshift, gs = pc->fd.gshift, bs = pc->fd.bshift;
+  SHuint32 as = pc->fd.ashift, am = pc->fd.amask;
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    SHuint32 in = rgba[i];
+    d[i] = ((in >> 24) << rs) |
+           (((in >> 16) & 0xFF) << gs) |
+           (((in >> 8) & 0xFF) << bs) |
+           (((in & 0xFF) << as) & am);
+  }
+}
+
+/* Reorders the bytes between two 8 bit formats in one pass */
+static void shConvertRow32(const SHuint8 *src, SHuint8 *dst, SHint count,
+                           const SHPixelCodec *spc, const SHPixelCodec *dpc)
+{
+  const SHuint32 *s = (const SHuint32*)src;
+  SHuint32 *d = (SHuint32*)dst;
+  SHuint32 srs = spc->fd.rshift, sgs = spc->fd.gshift, sbs = spc->fd.bshift;
+  SHuint32 drs = dpc->fd.rshift, dgs = dpc->fd.gshift, dbs = dpc->fd.bshift;
+  SHuint32 sas = spc->fd.ashift, das = dpc->fd.ashift;
+  SHuint32 sam = spc->fd.amask, dam = dpc->fd.amask;
+  SHuint32 a = (sam == 0 ? (0xFFu << das) & dam : 0x0);
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    SHuint32 in = s[i];
+    d[i] = (((in >> srs) & 0xFF) << drs) |
+           (((in >> sgs) & 0xFF) << dgs) |
+           (((in >> sbs) & 0xFF) << dbs) |
+           ((((in & sam) >> sas) << das) & dam) | a;
+  }
+}
+
+/* Unpremultiplies linear words into sRGB through the 12 bit
+   table, as 8 bit linear colors lose too much near black */
+static void shUnpremultiplyGammaRow(SHuint32 *rgba, SHint count)
+{
+  SHuint32 in, k, r, g, b;
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    in = rgba[i];
+    k = shUnpremulGammaTable[in & 0xFF];
+    r = ((in >> 24) * k + 128) >> 8;
+    g = (((in >> 16) & 0xFF) * k + 128) >> 8;
+    b = (((in >> 8) & 0xFF) * k + 128) >> 8;
+    
+    rgba[i] = ((SHuint32)shLinearToSRGBTable[SH_MIN(r, SH_GAMMA_INDEX_MAX)] << 24) |
+              ((SHuint32)shLinearToSRGBTable[SH_MIN(g, SH_GAMMA_INDEX_MAX)] << 16) |
+              ((SHuint32)shLinearToSRGBTable[SH_MIN(b, SH_GAMMA_INDEX_MAX)] << 8) |
+              (in & 0xFF);
+  }
+}
+
+/* Transfer tables with results moved into the destination channels */
+typedef struct
+{
+  SHuint32 r[256];
+  SHuint32 g[256];
+  SHuint32 b[256];
+  
+} SHGammaShifted;
+
+static void shSetupGammaShifted(SHGammaShifted *gs, const SHPixelCodec *dpc,
+                                const SHuint8 *gamma)
+{
+  SHint v;
+  
+  for (v=0; v<256; ++v) {
+    gs->r[v] = (SHuint32)gamma[v] << dpc->fd.rshift;
+    gs->g[v] = (SHuint32)gamma[v] << dpc->fd.gshift;
+    gs->b[v] = (SHuint32)gamma[v] << dpc->fd.bshift;
+  }
+}
+
+static void shConvertRow32Gamma(const SHuint8 *src, SHuint8 *dst, SHint count,
+                                const SHPixelCodec *spc, const SHPixelCodec *dpc,
+                                const SHGammaShifted *gs)
+{
+  const SHuint32 *s = (const SHuint32*)src;
+  SHuint32 *d = (SHuint32*)dst;
+  SHuint32 srs = spc->fd.rshift, sgs = spc->fd.gshift, sbs = spc->fd.bshift;
+  SHuint32 sas = spc->fd.ashift, das = dpc->fd.ashift;
+  SHuint32 sam = spc->fd.amask, dam = dpc->fd.amask;
+  SHuint32 a = (sam == 0 ? (0xFFu << das) & dam : 0x0);
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    SHuint32 in = s[i];
+    d[i] = gs->r[(in >> srs) & 0xFF] |
+           gs->g[(in >> sgs) & 0xFF] |
+           gs->b[(in >> sbs) & 0xFF] |
+           ((((in & sam) >> sas) << das) & dam) | a;
+  }
+}
+
+static void shGammaRow(SHuint32 *rgba, SHint count, const SHuint8 *gamma)
+{
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    SHuint32 in = rgba[i];
+    rgba[i] = ((SHuint32)gamma[in >> 24] << 24) |
+              ((SHuint32)gamma[(in >> 16) & 0xFF] << 16) |
+              ((SHuint32)gamma[(in >> 8) & 0xFF] << 8) |
+              (in & 0xFF);
+  }
+}
+
+static void shUnpackRow16(const SHuint8 *src, SHuint32 *rgba,
+                          SHint count, const SHPixelCodec *pc)
+{
+  const SHuint16 *s = (const SHuint16*)src;
+  const SHImageFormatDesc *f = &pc->fd;
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    SHuint32 in = s[i];
+    rgba[i] = ((SHuint32)pc->expand[0][(in & f->rmask) >> f->rshift] << 24) |
+              ((SHuint32)pc->expand[1][(in & f->gmask) >> f->gshift] << 16) |
+              ((SHuint32)pc->expand[2][(in & f->bmask) >> f->bshift] << 8) |
+              ((SHuint32)pc->expand[3][(in & f->amask) >> f->ashift]);
+  }
+}
+
+static void shPackRow16(const SHuint32 *rgba, SHuint8 *dst,
+                        SHint count, const SHPixelCodec *pc)
+{
+  SHuint16 *d = (SHuint16*)dst;
+  const SHImageFormatDesc *f = &pc->fd;
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    SHuint32 in = rgba[i];
+    d[i] = (SHuint16)((((SHuint32)pc->reduce[0][in >> 24] << f->rshift) & f->rmask) |
+                      (((SHuint32)pc->reduce[1][(in >> 16) & 0xFF] << f->gshift) & f->gmask) |
+                      (((SHuint32)pc->reduce[2][(in >> 8) & 0xFF] << f->bshift) & f->bmask) |
+                      (((SHuint32)pc->reduce[3][in & 0xFF] << f->ashift) & f->amask));
+  }
+}
+
+static void shUnpackRow8(const SHuint8 *src, SHuint32 *rgba,
+                         SHint count, const SHPixelCodec *pc)
+{
+  const SHImageFormatDesc *f = &pc->fd;
+  SHint i;
+  
+  for (i=0; i<count; ++i) {
+    SHuint32 in = src[i];
+    rgba[i] = ((SHuint32)pc->expand[0][(in & f->rmask) >> f->rshift] << 24) |
+              ((SHuint32)pc->expand[1][(in & f->gmask) >> f->gshift] << 16) |
+              ((SHuint32)pc->expand[2][(in & f->bmask) >> f->bshift] << 8) |
+              ((SHuint32)pc->expand[3][(in & f->amask) >> f->ashift]);
+  }
+}
+
+static void shPackRow8(const SHuint32 *rgba, SHuint8 *dst,
+                       SHint count, const SHPixelCodec *pc)
+{
+  const SHuint8 *gamma;
+  SHint i;
+  
+  if (pc->fd.vgformat == VG_A_8) {
+    
+    /* Alpha only */
+    for (i=0; i<count; ++i)
+      dst[i] = (SHuint8)(rgba[i] & 0xFF);
+    
+  }else if (pc->linearWords) {
+    
+    /* Luminance weights of shStoreColor in 16 bit fixed point */
+    gamma = pc->linear ? NULL : shLinearToSRGB8;
+    for (i=0; i<count; ++i) {
+      SHuint32 in = rgba[i];
+      SHuint32 l = (13933 * (in >> 24) +
+                    46871 * ((in >> 16) & 0xFF) +
+                    4732 * ((in >> 8) & 0xFF) + 32768) >> 16;
+      dst[i] = (SHuint8)(gamma ? gamma[l] : l);
+    }
+    
+  }else{
+    
+    /* Luminance of sRGB words is weighted in linear light */
+    for (i=0; i<count; ++i) {
+      SHuint32 in = rgba[i];
+      SHfloat l = 0.2126f * shSRGBToLinearTable[in >> 24] +
+                  0.7152f * shSRGBToLinearTable[(in >> 16) & 0xFF] +
+                  0.0722f * shSRGBToLinearTable[(in >> 8) & 0xFF];
+      dst[i] = (pc->linear ? (SHuint8)(l * 255.0f + 0.5f) :
+                shLinearToSRGBTable[(SHint)(l * SH_GAMMA_INDEX_MAX + 0.5f)]);
+    }
+  }
+}
+
+/* Reduce tables with results moved into the destination channels,
+   indexed by the 8 bit source channel after any transfer function */
+typedef struct
+{
+  SHuint16 r[256];
+  SHuint16 g[256];
+  SHuint16 b[256];
+  SHuint16 a[256];
+
+} SHReduceShifted;
+
+static void shSetupReduceShifted(SHReduceShifted *rs, const SHPixelCodec *dpc,
+                                 const SHuint8 *gamma)
+{
+  const SHImageFormatDesc *f = &dpc->fd;
+  SHint v, g;
+
+  for (v=0; v<256; ++v) {
+    g = gamma ? gamma[v] : v;
+    rs->r[v] = (SHuint16)(((SHuint32)dpc->reduce[0][g] << f->rshift) & f->rmask);
+    rs->g[v] = (SHuint16)(((SHuint32)dpc->reduce[1][g] << f->gshift) & f->gmask);
+    rs->b[v] = (SHuint16)(((SHuint32)dpc->reduce[2][g] << f->bshift) & f->bmask);
+    rs->a[v] = (SHuint16)(((SHuint32)dpc->reduce[3][v] << f->ashift) & f->amask);
+  }
+}
+
+static void shConvertRow32To16(const SHuint8 *src, SHuint8 *dst, SHint count,
+                               const SHPixelCodec *spc, const SHReduceShifted *rs)
+{
+  const SHuint32 *s = (const SHuint32*)src;
+  SHuint16 *d = (SHuint16*)dst;
+  SHuint32 srs = spc->fd.rshift, sgs = spc->fd.gshift, sbs = spc->fd.bshift;
+  SHuint32 sas = spc->fd.ashift, sam = spc->fd.amask;
+  SHuint16 a = (sam == 0 ? rs->a[255] : 0x0);
+  SHint i;
+
+  for (i=0; i<count; ++i) {
+    SHuint32 in = s[i];
+    d[i] = rs->r[(in >> srs) & 0xFF] |
+           rs->g[(in >> sgs) & 0xFF] |
+           rs->b[(in >> sbs) & 0xFF] |
+           rs->a[(in & sam) >> sas] | a;
+  }
+}
+
+/* Luminance weights in 16.16 fixed point, indexed by the source
+   channels, and the table taking their sum to the target value */
+typedef struct
+{
+  SHuint32 r[256];
+  SHuint32 g[256];
+  SHuint32 b[256];
+  const SHuint8 *out;
+
+} SHLuminanceTable;
+
+static void shSetupLuminanceTable(SHLuminanceTable *lt, const SHPixelCodec *spc,
+                                  const SHPixelCodec *dpc)
+{
+  double max;
+  SHint v;
+
+  if (spc->linear) {
+
+    /* Same weights as shPackRow8 uses for linear words */
+    for (v=0; v<256; ++v) {
+      lt->r[v] = 13933 * v;
+      lt->g[v] = 46871 * v;
+      lt->b[v] = 4732 * v;
+    }
+    lt->out = dpc->linear ? NULL : shLinearToSRGB8;
+
+  }else{
+
+    /* Weighted in linear light, into the 12 bit gamma table */
+    max = dpc->linear ? 255.0 : (double)SH_GAMMA_INDEX_MAX;
+    for (v=0; v<256; ++v) {
+      lt->r[v] = (SHuint32)(0.2126 * shSRGBToLinearTable[v] * max * 65536.0 + 0.5);
+      lt->g[v] = (SHuint32)(0.7152 * shSRGBToLinearTable[v] * max * 65536.0 + 0.5);
+      lt->b[v] = (SHuint32)(0.0722 * shSRGBToLinearTable[v] * max * 65536.0 + 0.5);
+    }
+    lt->out = dpc->linear ? NULL : shLinearToSRGBTable;
+  }
+}
+
+static void shConvertRow32ToL8(const SHuint8 *src, SHuint8 *dst, SHint count,
+                               const SHPixelCodec *spc, const SHLuminanceTable *lt)
+{
+  const SHuint32 *s = (const SHuint32*)src;
+  SHuint32 srs = spc->fd.rshift, sgs = spc->fd.gshift, sbs = spc->fd.bshift;
+  const SHuint8 *out = lt->out;
+  SHuint32 in, l;
+  SHint i;
+
+  if (out) {
+    for (i=0; i<count; ++i) {
+      in = s[i];
+      l = (lt->r[(in >> srs) & 0xFF] + lt->g[(in >> sgs) & 0xFF] +
+           lt->b[(in >> sbs) & 0xFF] + 32768) >> 16;
+      dst[i] = out[l];
+    }
+  }else{
+    for (i=0; i<count; ++i) {
+      in = s[i];
+      l = (lt->r[(in >> srs) & 0xFF] + lt->g[(in >> sgs) & 0xFF] +
+           lt->b[(in >> sbs) & 0xFF] + 32768) >> 16;
+      dst[i] = (SHuint8)l;
+    }
+  }
+}
+
+static const SHUnpackRowFunc shUnpackRowFuncs[5] =
+  { NULL, shUnpackRow8, shUnpackRow16, NULL, shUnpackRow32 };
+
+static const SHPackRowFunc shPackRowFuncs[5] =
+  { NULL, shPackRow8, shPackRow16, NULL, shPackRow32 };
+
 /*------------------------------------------------------------
  * Generic function for copying a rectangle area of pixels
  * of size (width,height) among two data buffers. The size of
@@ -698,9 +1306,19 @@ void shCopyPixels(SHuint8 *dst, VGImageFormat dstFormat, SHint dstStride,
   const SHuint8 *SD;
   SHuint8 *DD;
   SHColor c;
+  SHint n;
 
   SHImageFormatDesc dfd;
   SHImageFormatDesc sfd;
+  SHPixelCodec spc, dpc;
+  SHUnpackRowFunc unpack;
+  SHPackRowFunc pack;
+  SHuint32 rgba[SH_CONVERT_CHUNK];
+  const SHuint8 *gamma;
+  SHGammaShifted gs;
+  SHReduceShifted rs;
+  SHLuminanceTable lt;
+  SHint unpremul, premul;
 
   /* Setup image format descriptors */
   SH_ASSERT(shIsSupportedImageFormat(dstFormat));
@@ -774,9 +1392,10 @@ void shCopyPixels(SHuint8 *dst, VGImageFormat dstFormat, SHint dstStride,
       memcpy(DD, SD, width * sfd.bytes);
     }
     
-  }else{
-  
-    /* Walk pixels and copy */
+  }else if (sfd.bytes == 2 && dfd.bytes == 2) {
+    
+    /* Converting between two formats of less than 8 bits per
+       channel through the 8 bit words would round twice */
     for (SY=sy, DY=dy; SY < sy+height; ++SY, ++DY) {
       SD = src + SY * srcStride + sx * sfd.bytes;
       DD = dst + DY * dstStride + dx * dfd.bytes;
@@ -786,6 +1405,91 @@ void shCopyPixels(SHuint8 *dst, VGImageFormat dstFormat, SHint dstStride,
         shStoreColor(&c, DD, &dfd);
         SD += sfd.bytes; DD += dfd.bytes;
       }}
+    
+  }else{
+    
+    shInitColorTables();
+    shSetupPixelCodec(srcFormat, &spc);
+    shSetupPixelCodec(dstFormat, &dpc);
+    
+    /* Luminance is weighted from the source colors, the
+       rest converts the words when the color spaces differ */
+    gamma = NULL;
+    if (dstFormat == VG_sL_8 || dstFormat == VG_lL_8)
+      dpc.linearWords = spc.linear;
+    else if (spc.linear != dpc.linear)
+      gamma = spc.linear ? shLinearToSRGB8 : shSRGBToLinear8;
+    
+    unpremul = spc.premultiplied && (!dpc.premultiplied || gamma);
+    premul = dpc.premultiplied && (!spc.premultiplied || gamma);
+    
+    if (sfd.bytes == 4 && dfd.bytes == 4 && !unpremul && !premul) {
+      
+      if (gamma) shSetupGammaShifted(&gs, &dpc, gamma);
+      
+      for (SY=sy, DY=dy; SY < sy+height; ++SY, ++DY) {
+        SD = src + SY * srcStride + sx * sfd.bytes;
+        DD = dst + DY * dstStride + dx * dfd.bytes;
+        if (gamma) shConvertRow32Gamma(SD, DD, width, &spc, &dpc, &gs);
+        else shConvertRow32(SD, DD, width, &spc, &dpc);
+      }
+
+    }else if (sfd.bytes == 4 && dfd.bytes == 2 && !unpremul && !premul) {
+
+      shSetupReduceShifted(&rs, &dpc, gamma);
+
+      for (SY=sy, DY=dy; SY < sy+height; ++SY, ++DY) {
+        SD = src + SY * srcStride + sx * sfd.bytes;
+        DD = dst + DY * dstStride + dx * dfd.bytes;
+        shConvertRow32To16(SD, DD, width, &spc, &rs);
+      }
+
+    }else if (sfd.bytes == 4 && !unpremul &&
+              (dstFormat == VG_sL_8 || dstFormat == VG_lL_8)) {
+
+      shSetupLuminanceTable(&lt, &spc, &dpc);
+
+      for (SY=sy, DY=dy; SY < sy+height; ++SY, ++DY) {
+        SD = src + SY * srcStride + sx * sfd.bytes;
+        DD = dst + DY * dstStride + dx * dfd.bytes;
+        shConvertRow32ToL8(SD, DD, width, &spc, &lt);
+      }
+
+    }else if (sfd.bytes == 4 && dfd.bytes == 4 && !gamma &&
+              (srcFormat & ~0x1F) == 0 && (dstFormat & ~0x1F) == 0 &&
+              spc.fd.amask != 0 && dpc.fd.amask != 0) {
+
+      /* RGBA words only changing premultiplication convert in place */
+      for (SY=sy, DY=dy; SY < sy+height; ++SY, ++DY) {
+        SD = src + SY * srcStride + sx * sfd.bytes;
+        DD = dst + DY * dstStride + dx * dfd.bytes;
+        memcpy(DD, SD, width * 4);
+        if (premul) shPremultiplyRow((SHuint32*)DD, width);
+        else shUnpremultiplyRow((SHuint32*)DD, width);
+      }
+
+    }else{
+
+      unpack = shUnpackRowFuncs[sfd.bytes];
+      pack = shPackRowFuncs[dfd.bytes];
+      
+      /* Convert rows a chunk at a time through 8 bit words */
+      for (SY=sy, DY=dy; SY < sy+height; ++SY, ++DY) {
+        SD = src + SY * srcStride + sx * sfd.bytes;
+        DD = dst + DY * dstStride + dx * dfd.bytes;
+        for (SX=0; SX < width; SX += n) {
+          n = SH_MIN(width - SX, SH_CONVERT_CHUNK);
+          unpack(SD + SX * sfd.bytes, rgba, n, &spc);
+          if (unpremul && gamma == shLinearToSRGB8)
+            shUnpremultiplyGammaRow(rgba, n);
+          else {
+            if (unpremul) shUnpremultiplyRow(rgba, n);
+            if (gamma) shGammaRow(rgba, n, gamma);
+          }
+          if (premul) shPremultiplyRow(rgba, n);
+          pack(rgba, DD + SX * dfd.bytes, n, &dpc);
+        }}
+    }
   }
 }
 
@@ -807,7 +1511,7 @@ VG_API_CALL void vgImageSubData(VGImage image,
                    VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
   
   /* TODO: check if image current render target */
-  i = (SHImage*)image;
+  i = shGetImage(context, image);
   
   /* Reject invalid formats */
   VG_RETURN_ERR_IF(!shIsValidImageFormat(dataFormat),
@@ -824,6 +1528,11 @@ VG_API_CALL void vgImageSubData(VGImage image,
   
   /* TODO: check data array alignment */
   
+#if RENDERING_ENGINE == SOFTWARE
+  /* Pending draws may still sample the image */
+  shFlushRaster(context);
+#endif
+  
   shCopyPixels(i->data, i->fd.vgformat, i->texwidth * i->fd.bytes,
                data, dataFormat,dataStride,
                i->width, i->height, width, height,
@@ -852,7 +1561,7 @@ VG_API_CALL void vgGetImageSubData(VGImage image,
                    VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
   
   /* TODO: check if image current render target */
-  i = (SHImage*)image;
+  i = shGetImage(context, image);
   
   /* Reject invalid formats */
   VG_RETURN_ERR_IF(!shIsValidImageFormat(dataFormat),
@@ -899,7 +1608,7 @@ VG_API_CALL void vgCopyImage(VGImage dst, VGint dx, VGint dy,
 
   /* TODO: check if images current render target */
 
-  s = (SHImage*)src; d = (SHImage*)dst;
+  s = shGetImage(context, src); d = shGetImage(context, dst);
   VG_RETURN_ERR_IF(width <= 0 || height <= 0,
                    VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
 
@@ -913,6 +1622,11 @@ VG_API_CALL void vgCopyImage(VGImage dst, VGint dx, VGint dy,
 
   pixels = (SHuint8*)malloc(width * height * s->fd.bytes);
   SH_RETURN_ERR_IF(!pixels, VG_OUT_OF_MEMORY_ERROR, SH_NO_RETVAL);
+  
+#if RENDERING_ENGINE == SOFTWARE
+  /* Pending draws may still sample the image */
+  shFlushRaster(context);
+#endif
 
   shCopyPixels(pixels, s->fd.vgformat, s->texwidth * s->fd.bytes,
                s->data, s->fd.vgformat, s->texwidth * s->fd.bytes,
@@ -951,7 +1665,7 @@ VG_API_CALL void vgSetPixels(VGint dx, VGint dy,
   
   /* TODO: check if image current render target (requires EGL) */
 
-  i = (SHImage*)src;
+  i = shGetImage(context, src);
   VG_RETURN_ERR_IF(width <= 0 || height <= 0,
                    VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
 
@@ -972,11 +1686,15 @@ VG_API_CALL void vgSetPixels(VGint dx, VGint dy,
                width, height, i->width, i->height,
                0,0,sx,sy, width, height);
 
+#if RENDERING_ENGINE == SOFTWARE
+  shWriteSurfacePixels(context, pixels, dx, dy, width, height);
+#else
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 #if RENDERING_ENGINE == OPENGL_1
   glRasterPos2i(dx, dy);
   glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
   glRasterPos2i(0,0);
+#endif
 #endif
   
   free(pixels);
@@ -1032,11 +1750,15 @@ VG_API_CALL void vgWritePixels(const void * data, VGint dataStride,
                width, height, width, height,
                0,0,0,0, width, height);
   
+#if RENDERING_ENGINE == SOFTWARE
+  shWriteSurfacePixels(context, pixels, dx, dy, width, height);
+#else
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 #if RENDERING_ENGINE == OPENGL_1
   glRasterPos2i(dx, dy);
   glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
   glRasterPos2i(0,0);
+#endif
 #endif
   
   free(pixels);
@@ -1064,7 +1786,7 @@ VG_API_CALL void vgGetPixels(VGImage dst, VGint dx, VGint dy,
   
    /* TODO: check if image current render target */
 
-  i = (SHImage*)dst;
+  i = shGetImage(context, dst);
   VG_RETURN_ERR_IF(width <= 0 || height <= 0,
                    VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
 
@@ -1077,11 +1799,16 @@ VG_API_CALL void vgGetPixels(VGImage dst, VGint dx, VGint dy,
      coordinates nor using random stride. We have to
      read first and then manually copy to the image data */
 
+#if RENDERING_ENGINE == SOFTWARE
+  pixels = shReadSurfacePixels(context, sx, sy, width, height);
+  SH_RETURN_ERR_IF(!pixels, VG_OUT_OF_MEMORY_ERROR, SH_NO_RETVAL);
+#else
   pixels = (SHuint8*)malloc(width * height * winfd.bytes);
   SH_RETURN_ERR_IF(!pixels, VG_OUT_OF_MEMORY_ERROR, SH_NO_RETVAL);
 
   glPixelStorei(GL_PACK_ALIGNMENT, 1);
   glReadPixels(sx, sy, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+#endif
   
   shCopyPixels(i->data, i->fd.vgformat, i->texwidth * i->fd.bytes,
                pixels, winfd.vgformat, -1,
@@ -1132,11 +1859,16 @@ VG_API_CALL void vgReadPixels(void * data, VGint dataStride,
   /* OpenGL doesn't allow random data stride. We have to
      read first and then manually copy to the output buffer */
 
+#if RENDERING_ENGINE == SOFTWARE
+  pixels = shReadSurfacePixels(context, sx, sy, width, height);
+  SH_RETURN_ERR_IF(!pixels, VG_OUT_OF_MEMORY_ERROR, SH_NO_RETVAL);
+#else
   pixels = (SHuint8*)malloc(width * height * winfd.bytes);
   SH_RETURN_ERR_IF(!pixels, VG_OUT_OF_MEMORY_ERROR, SH_NO_RETVAL);
 
   glPixelStorei(GL_PACK_ALIGNMENT, 1);
   glReadPixels(sx, sy, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+#endif
   
   shCopyPixels(data, dataFormat, dataStride,
                pixels, winfd.vgformat, -1,
@@ -1163,12 +1895,16 @@ VG_API_CALL void vgCopyPixels(VGint dx, VGint dy,
   VG_RETURN_ERR_IF(width <= 0 || height <= 0,
                    VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
   
+#if RENDERING_ENGINE == SOFTWARE
+  shCopySurfacePixels(context, dx, dy, sx, sy, width, height);
+#else
   glPixelStorei(GL_PACK_ALIGNMENT, 1);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 #if RENDERING_ENGINE == OPENGL_1
   glRasterPos2i(dx, dy);
   glCopyPixels(sx, sy, width, height, GL_COLOR);
   glRasterPos2i(0, 0);
+#endif
 #endif
   
   VG_RETURN(VG_NO_RETVAL);
@@ -1184,55 +1920,3 @@ VG_API_CALL VGImage vgGetParent(VGImage image)
 {
   return VG_INVALID_HANDLE;
 }
-
-VG_API_CALL void vgColorMatrix(VGImage dst, VGImage src,
-                               const VGfloat * matrix)
-{
-}
-
-VG_API_CALL void vgConvolve(VGImage dst, VGImage src,
-                            VGint kernelWidth, VGint kernelHeight,
-                            VGint shiftX, VGint shiftY,
-                            const VGshort * kernel,
-                            VGfloat scale,
-                            VGfloat bias,
-                            VGTilingMode tilingMode)
-{
-}
-
-VG_API_CALL void vgSeparableConvolve(VGImage dst, VGImage src,
-                                     VGint kernelWidth,
-                                     VGint kernelHeight,
-                                     VGint shiftX, VGint shiftY,
-                                     const VGshort * kernelX,
-                                     const VGshort * kernelY,
-                                     VGfloat scale,
-                                     VGfloat bias,
-                                     VGTilingMode tilingMode)
-{
-}
-
-VG_API_CALL void vgGaussianBlur(VGImage dst, VGImage src,
-                                VGfloat stdDeviationX,
-                                VGfloat stdDeviationY,
-                                VGTilingMode tilingMode)
-{
-}
-
-VG_API_CALL void vgLookup(VGImage dst, VGImage src,
-                          const VGubyte * redLUT,
-                          const VGubyte * greenLUT,
-                          const VGubyte * blueLUT,
-                          const VGubyte * alphaLUT,
-                          VGboolean outputLinear,
-                          VGboolean outputPremultiplied)
-{
-}
-
-VG_API_CALL void vgLookupSingle(VGImage dst, VGImage src,
-                                const VGuint * lookupTable,
-                                VGImageChannel sourceChannel,
-                                VGboolean outputLinear,
-                                VGboolean outputPremultiplied)
-{
-}
@@ -70,12 +70,6 @@ typedef struct
 void SHImage_ctor(SHImage *i);
 void SHImage_dtor(SHImage *i);
 
-#define _ITEM_T SHImage*
-#define _ARRAY_T SHImageArray
-#define _FUNC_T shImageArray
-#define _ARRAY_DECLARE
-#include "shArrayBase.h"
-
 /*-------------------------------------------------------
  * Color operators
  *-------------------------------------------------------*/
@@ -129,8 +123,23 @@ void SHImage_dtor(SHImage *i);
 #define INT2COLCOORD(i, max) ( (SHfloat)i / (SHfloat)max  )
 #define COL2INTCOORD(c, max) ( (SHuint)SH_FLOOR(c * (SHfloat)max + 0.5f) )
 
+void shSetupImageFormat(VGImageFormat vg, SHImageFormatDesc *f);
+SHint shTileCoord(SHint i, SHint size, VGTilingMode mode);
+void shInitColorTables(void);
+int shIsLinearImageFormat(VGImageFormat format);
+int shIsPremultipliedImageFormat(VGImageFormat format);
+void shLinearizeColor(SHColor *c);
+void shGammaColor(SHColor *c);
+void shPremultiplyRow(SHuint32 *rgba, SHint count);
+void shUnpremultiplyRow(SHuint32 *rgba, SHint count);
 void shStoreColor(SHColor *c, void *data, SHImageFormatDesc *f);
 void shLoadColor(SHColor *c, const void *data, SHImageFormatDesc *f);
 
+void shCopyPixels(SHuint8 *dst, VGImageFormat dstFormat, SHint dstStride,
+                  const SHuint8 *src, VGImageFormat srcFormat, SHint srcStride,
+                  SHint dwidth, SHint dheight, SHint swidth, SHint sheight,
+                  SHint dx, SHint dy, SHint sx, SHint sy,
+                  SHint width, SHint height);
+
 
 #endif /* __SHIMAGE_H */
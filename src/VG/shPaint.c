@@ -12,12 +12,6 @@
 #define _ARRAY_DEFINE
 #include "shArrayBase.h"
 
-#define _ITEM_T SHPaint*
-#define _ARRAY_T SHPaintArray
-#define _FUNC_T shPaintArray
-#define _ARRAY_DEFINE
-#include "shArrayBase.h"
-
 
 void SHPaint_ctor(SHPaint *p)
 {
@@ -34,7 +28,11 @@ void SHPaint_ctor(SHPaint *p)
   for (i=0; i<5; ++i) p->radialGradient[i] = 0.0f;
   p->pattern = VG_INVALID_HANDLE;
   
+#if RENDERING_ENGINE == SOFTWARE
+  p->texture = 0;
+#else
   glGenTextures(1, &p->texture);
+#endif
 #if RENDERING_ENGINE == OPENGL_1
   glBindTexture(GL_TEXTURE_1D, p->texture);
   glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA, SH_GRADIENT_TEX_SIZE, 0,
@@ -47,13 +45,16 @@ void SHPaint_dtor(SHPaint *p)
   SH_DEINITOBJ(SHStopArray, p->instops);
   SH_DEINITOBJ(SHStopArray, p->stops);
   
+#if RENDERING_ENGINE != SOFTWARE
   if (glIsTexture(p->texture))
     glDeleteTextures(1, &p->texture);
+#endif
 }
 
 VG_API_CALL VGPaint vgCreatePaint(void)
 {
   SHPaint *p = NULL;
+  VGHandle handle;
   VG_GETCONTEXT(VG_INVALID_HANDLE);
   
   /* Create new paint object */
@@ -61,24 +62,31 @@ VG_API_CALL VGPaint vgCreatePaint(void)
   VG_RETURN_ERR_IF(!p, VG_OUT_OF_MEMORY_ERROR,
                    VG_INVALID_HANDLE);
   
-  /* Add to resource list */
-  shPaintArrayPushBack(&context->paints, p);
+  /* Add to resource table */
+  handle = shCreateHandle(context, p, SH_RESOURCE_PAINT);
+  if (handle == VG_INVALID_HANDLE) {
+    SH_DELETEOBJ(SHPaint, p);
+    VG_RETURN_ERR(VG_OUT_OF_MEMORY_ERROR, VG_INVALID_HANDLE); }
   
-  VG_RETURN((VGPaint)p);
+  VG_RETURN((VGPaint)handle);
 }
 
 VG_API_CALL void vgDestroyPaint(VGPaint paint)
 {
-  SHint index;
+  SHPaint *p;
   VG_GETCONTEXT(VG_NO_RETVAL);
   
   /* Check if handle valid */
-  index = shPaintArrayFind(&context->paints, (SHPaint*)paint);
-  VG_RETURN_ERR_IF(index == -1, VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+  p = shGetPaint(context, paint);
+  VG_RETURN_ERR_IF(!p, VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+  
+  /* Don't leave the context pointing to it */
+  if (context->fillPaint == p) context->fillPaint = NULL;
+  if (context->strokePaint == p) context->strokePaint = NULL;
   
   /* Delete object and remove resource */
-  SH_DELETEOBJ(SHPaint, (SHPaint*)paint);
-  shPaintArrayRemoveAt(&context->paints, index);
+  SH_DELETEOBJ(SHPaint, p);
+  shDestroyHandle(context, paint);
   
   VG_RETURN(VG_NO_RETVAL);
 }
@@ -98,9 +106,9 @@ VG_API_CALL void vgSetPaint(VGPaint paint, VGbitfield paintModes)
   
   /* Set stroke / fill */
   if (paintModes & VG_STROKE_PATH)
-    context->strokePaint = (SHPaint*)paint;
+    context->strokePaint = shGetPaint(context, paint);
   if (paintModes & VG_FILL_PATH)
-    context->fillPaint = (SHPaint*)paint;
+    context->fillPaint = shGetPaint(context, paint);
   
   VG_RETURN(VG_NO_RETVAL);
 }
@@ -120,13 +128,14 @@ VG_API_CALL void vgPaintPattern(VGPaint paint, VGImage pattern)
   /* TODO: Check if pattern image is current rendering target */
   
   /* Set pattern image */
-  ((SHPaint*)paint)->pattern = pattern;
+  shGetPaint(context, paint)->pattern = pattern;
   
   VG_RETURN(VG_NO_RETVAL);
 }
 
 void shUpdateColorRampTexture(SHPaint *p)
 {
+#if RENDERING_ENGINE == OPENGL_1
   SHint s=0;
   SHStop *stop1, *stop2;
   SHfloat rgba[SH_GRADIENT_TEX_COORDSIZE];
@@ -163,7 +172,6 @@ void shUpdateColorRampTexture(SHPaint *p)
   }
   
   /* Update texture image */
-#if RENDERING_ENGINE == OPENGL_1
   glBindTexture(GL_TEXTURE_1D, p->texture);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
   glTexSubImage1D(GL_TEXTURE_1D, 0, 0, SH_GRADIENT_TEX_SIZE,
@@ -328,6 +336,8 @@ void shGenerateStops(SHPaint *p, SHfloat minOffset, SHfloat maxOffset,
   }
 }
 
+#if RENDERING_ENGINE != SOFTWARE
+
 void shSetGradientTexGLState(SHPaint *p)
 {
 #if RENDERING_ENGINE == OPENGL_1
@@ -353,7 +363,7 @@ void shSetGradientTexGLState(SHPaint *p)
 
 void shSetPatternTexGLState(SHPaint *p, VGContext *c)
 {
-  glBindTexture(GL_TEXTURE_2D, ((SHImage*)p->pattern)->texture);
+  glBindTexture(GL_TEXTURE_2D, shGetImage(c, p->pattern)->texture);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   
@@ -766,7 +776,7 @@ int shDrawPatternMesh(SHPaint *p, SHVector2 *min, SHVector2 *max,
   
   
   /* Setup texture coordinate transform */
-  img = (SHImage*)p->pattern;
+  img = shGetImage(context, p->pattern);
   sx = 1.0f/(VGfloat)img->texwidth;
   sy = 1.0f/(VGfloat)img->texheight;
   
@@ -797,3 +807,5 @@ int shDrawPatternMesh(SHPaint *p, SHVector2 *min, SHVector2 *max,
 #endif
   return 1;
 }
+
+#endif /* RENDERING_ENGINE != SOFTWARE */
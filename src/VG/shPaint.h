@@ -41,12 +41,6 @@ typedef struct
 void SHPaint_ctor(SHPaint *p);
 void SHPaint_dtor(SHPaint *p);
 
-#define _ITEM_T SHPaint*
-#define _ARRAY_T SHPaintArray
-#define _FUNC_T shPaintArray
-#define _ARRAY_DECLARE
-#include "shArrayBase.h"
-
 void shValidateInputStops(SHPaint *p);
 void shSetGradientTexGLState(SHPaint *p);
 
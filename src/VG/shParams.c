@@ -3,6 +3,8 @@
 #include <stdio.h>
 #include <VG/openvg.h>
 #include "shContext.h"
+#include "shTessCache.h"
+#include "shGeometry.h"
 
 /*----------------------------------------------------
  * Returns true (1) if the specified parameter takes
@@ -323,6 +325,24 @@ static void shSet(VGContext *context, VGParamType type, SHint count,
     context->scissoring = bvalue;
     break;
     
+  case VG_RASTER_THREADS_SH:
+    SH_RETURN_ERR_IF(count!=1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    SH_RETURN_ERR_IF(ivalue<0, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    context->rasterThreads = ivalue;
+    break;
+    
+  case VG_RASTER_TILE_SIZE_SH:
+    SH_RETURN_ERR_IF(count!=1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    SH_RETURN_ERR_IF(ivalue<=0, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    context->rasterTileSize = ivalue;
+    break;
+    
+  case VG_TESS_CACHE_BUDGET_SH:
+    SH_RETURN_ERR_IF(count!=1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    SH_RETURN_ERR_IF(ivalue<0, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    shTessCacheSetBudget(context->tessCache, ivalue);
+    break;
+    
   case VG_STROKE_LINE_WIDTH:
     SH_RETURN_ERR_IF(count!=1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
     context->strokeLineWidth = fvalue;
@@ -392,6 +412,12 @@ static void shSet(VGContext *context, VGParamType type, SHint count,
   case VG_MAX_IMAGE_BYTES:
   case VG_MAX_FLOAT:
   case VG_MAX_GAUSSIAN_STD_DEVIATION:
+  case VG_TESS_CACHE_HITS_SH:
+  case VG_TESS_CACHE_MISSES_SH:
+  case VG_TESS_CACHE_EVICTIONS_SH:
+  case VG_STROKE_CACHE_HITS_SH:
+  case VG_STROKE_CACHE_MISSES_SH:
+  case VG_CULLED_DRAWS_SH:
     /* Read-only */ break;
     
   default:
@@ -478,6 +504,7 @@ VG_API_CALL void vgSetiv(VGParamType type, VGint count,
 static void shGet(VGContext *context, VGParamType type, SHint count, void *values, SHint floats)
 {
   int i;
+  SHint stats[3];
   
   /* Check for invalid array / count */
   SH_RETURN_ERR_IF(!values || count<=0, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
@@ -559,6 +586,44 @@ static void shGet(VGContext *context, VGParamType type, SHint count, void *value
     shIntToParam((SHint)context->scissoring, count, values, floats, 0);
     break;
     
+  case VG_RASTER_THREADS_SH:
+    SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    shIntToParam(context->rasterThreads, count, values, floats, 0);
+    break;
+    
+  case VG_RASTER_TILE_SIZE_SH:
+    SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    shIntToParam(context->rasterTileSize, count, values, floats, 0);
+    break;
+    
+  case VG_TESS_CACHE_BUDGET_SH:
+    SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    shIntToParam(shTessCacheGetBudget(context->tessCache), count, values, floats, 0);
+    break;
+    
+  case VG_TESS_CACHE_HITS_SH:
+  case VG_TESS_CACHE_MISSES_SH:
+  case VG_TESS_CACHE_EVICTIONS_SH:
+    SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    shTessCacheGetStats(context->tessCache, &stats[0], &stats[1], &stats[2]);
+    shIntToParam(stats[type - VG_TESS_CACHE_HITS_SH], count, values, floats, 0);
+    break;
+    
+  case VG_STROKE_CACHE_HITS_SH:
+    SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    shIntToParam(context->strokeCacheHits, count, values, floats, 0);
+    break;
+    
+  case VG_STROKE_CACHE_MISSES_SH:
+    SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    shIntToParam(context->strokeCacheMisses, count, values, floats, 0);
+    break;
+    
+  case VG_CULLED_DRAWS_SH:
+    SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+    shIntToParam(context->culledDraws, count, values, floats, 0);
+    break;
+    
   case VG_STROKE_LINE_WIDTH:
     SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
     shFloatToParam(context->strokeLineWidth, count, values, floats, 0);
@@ -656,19 +721,19 @@ static void shGet(VGContext *context, VGParamType type, SHint count, void *value
     shFloatToParam(getMaxFloat(), count, values, floats, 0);
     break;
     
-  case VG_MAX_KERNEL_SIZE: /* TODO: depends on convolution implementation */
+  case VG_MAX_KERNEL_SIZE:
     SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
-    shIntToParam(0, count, values, floats, 0);
+    shIntToParam(SH_MAX_KERNEL_SIZE, count, values, floats, 0);
     break;
     
-  case VG_MAX_SEPARABLE_KERNEL_SIZE: /* TODO: depends on convolution implementation */
+  case VG_MAX_SEPARABLE_KERNEL_SIZE:
     SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
-    shIntToParam(0, count, values, floats, 0);
+    shIntToParam(SH_MAX_SEPARABLE_KERNEL_SIZE, count, values, floats, 0);
     break;
     
-  case VG_MAX_GAUSSIAN_STD_DEVIATION: /* TODO: depends on gaussian blur implementation */
+  case VG_MAX_GAUSSIAN_STD_DEVIATION:
     SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
-    shFloatToParam(0.0f, count, values, floats, 0);
+    shFloatToParam(SH_MAX_GAUSSIAN_STD_DEVIATION, count, values, floats, 0);
     break;
     
   default:
@@ -788,6 +853,15 @@ VG_API_CALL VGint vgGetVectorSize(VGParamType type)
   case VG_MAX_IMAGE_BYTES:
   case VG_MAX_FLOAT:
   case VG_MAX_GAUSSIAN_STD_DEVIATION:
+  case VG_RASTER_THREADS_SH:
+  case VG_RASTER_TILE_SIZE_SH:
+  case VG_TESS_CACHE_BUDGET_SH:
+  case VG_TESS_CACHE_HITS_SH:
+  case VG_TESS_CACHE_MISSES_SH:
+  case VG_TESS_CACHE_EVICTIONS_SH:
+  case VG_STROKE_CACHE_HITS_SH:
+  case VG_STROKE_CACHE_MISSES_SH:
+  case VG_CULLED_DRAWS_SH:
     retval = 1;
     break;
     
@@ -817,10 +891,11 @@ VG_API_CALL VGint vgGetVectorSize(VGParamType type)
  * vector according to the parameter type and input type.
  *-----------------------------------------------------------*/
 
-static void shSetParameter(VGContext *context, VGHandle object,
+static void shSetParameter(VGContext *context, VGHandle handle,
                            SHResourceType rtype, VGint ptype,
                            SHint count, const void *values, SHint floats)
 {
+  void *object = shGetHandleObject(context, handle, rtype);
   SHfloat fvalue = 0.0f;
   SHint ivalue = 0;
   VGboolean bvalue = VG_FALSE;
@@ -849,8 +924,23 @@ static void shSetParameter(VGContext *context, VGHandle object,
     case VG_PATH_BIAS:
     case VG_PATH_NUM_SEGMENTS:
     case VG_PATH_NUM_COORDS:
+    case VG_PATH_FILL_GEOMETRY_BYTES_SH:
       /* Read-only */ break;
       
+    case VG_PATH_FLATTEN_TOLERANCE_EXT:
+      SH_RETURN_ERR_IF(count != 1 || !(fvalue > 0.0f),
+                       VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+      ((SHPath*)object)->flattenTolerance = fvalue;
+      /* Flatten again on next draw */
+      ((SHPath*)object)->cacheTransformInit = VG_FALSE;
+      break;
+      
+    case VG_PATH_TRIANGULATE_FILL_EXT:
+      SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+      ((SHPath*)object)->triangulateFill = bvalue;
+      ((SHPath*)object)->cacheTrianglesValid = VG_FALSE;
+      break;
+      
     default:
       /* Invalid VGParamType */
       SH_RETURN_ERR(VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
@@ -1046,10 +1136,11 @@ VG_API_CALL void vgSetParameteriv(VGHandle object, VGint paramType,
  * vector according to the parameter type and input type.
  *---------------------------------------------------------------*/
 
-static void shGetParameter(VGContext *context, VGHandle object,
+static void shGetParameter(VGContext *context, VGHandle handle,
                            SHResourceType rtype, VGint ptype,
                            SHint count, void *values, SHint floats)
 {
+  void *object = shGetHandleObject(context, handle, rtype);
   int i;
   
   /* Check for invalid array / count */
@@ -1089,6 +1180,21 @@ static void shGetParameter(VGContext *context, VGHandle object,
       shIntToParam(((SHPath*)object)->dataCount, count, values, floats, 0);
       break;
       
+    case VG_PATH_FILL_GEOMETRY_BYTES_SH:
+      SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+      shIntToParam(shFillGeometryBytes((SHPath*)object), count, values, floats, 0);
+      break;
+      
+    case VG_PATH_FLATTEN_TOLERANCE_EXT:
+      SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+      shFloatToParam(((SHPath*)object)->flattenTolerance, count, values, floats, 0);
+      break;
+      
+    case VG_PATH_TRIANGULATE_FILL_EXT:
+      SH_RETURN_ERR_IF(count != 1, VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
+      shIntToParam(((SHPath*)object)->triangulateFill, count, values, floats, 0);
+      break;
+      
     default:
       /* Invalid VGParamType */
       SH_RETURN_ERR(VG_ILLEGAL_ARGUMENT_ERROR, SH_NO_RETVAL);
@@ -1305,6 +1411,9 @@ VG_API_CALL VGint vgGetParameterVectorSize(VGHandle object, VGint ptype)
     case VG_PATH_BIAS:
     case VG_PATH_NUM_SEGMENTS:
     case VG_PATH_NUM_COORDS:
+    case VG_PATH_FILL_GEOMETRY_BYTES_SH:
+    case VG_PATH_FLATTEN_TOLERANCE_EXT:
+    case VG_PATH_TRIANGULATE_FILL_EXT:
       retval = 1; break;
       
     default:
@@ -1327,7 +1436,7 @@ VG_API_CALL VGint vgGetParameterVectorSize(VGHandle object, VGint ptype)
       retval = 1; break;
       
     case VG_PAINT_COLOR_RAMP_STOPS:
-      retval = ((SHPaint*)object)->stops.size*5; break;
+      retval = shGetPaint(context, object)->stops.size*5; break;
       
     case VG_PAINT_LINEAR_GRADIENT:
       retval = 4; break;
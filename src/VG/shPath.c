@@ -1,8 +1,11 @@
 
 #define VG_API_EXPORT
 #include <VG/openvg.h>
+#include <VG/vulcanvg.h>
 #include "shContext.h"
 #include "shPath.h"
+#include "shGeometry.h"
+#include "shTessCache.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -13,12 +16,6 @@
 #define _ARRAY_DEFINE
 #include "shArrayBase.h"
 
-#define _ITEM_T SHPath*
-#define _ARRAY_T SHPathArray
-#define _FUNC_T shPathArray
-#define _ARRAY_DEFINE
-#include "shArrayBase.h"
-
 
 static const SHint shCoordsPerCommand[] = {
   0, /* VG_CLOSE_PATH */
@@ -55,19 +52,62 @@ static const SHint shBytesPerDatatype[] = {
 void shClearSegCallbacks(SHPath *p);
 void SHPath_ctor(SHPath *p)
 {
+  int i;
+  
   p->format = 0;
   p->scale = 0.0f;
   p->bias = 0.0f;
+  p->segHint = 0;
+  p->dataHint = 0;
   p->caps = 0;
   p->datatype = VG_PATH_DATATYPE_F;
+  p->flattenTolerance = SH_DEFAULT_FLATTEN_TOLERANCE;
   
   p->segs = NULL;
   p->data = NULL;
   p->segCount = 0;
   p->dataCount = 0;
+  p->segCapacity = 0;
+  p->dataCapacity = 0;
   
   SH_INITOBJ(SHVertexArray, p->vertices);
+  p->fillConvex = VG_FALSE;
+  p->triangulateFill = VG_FALSE;
+  p->cacheTrianglesValid = VG_FALSE;
+  p->cacheTrianglesRule = VG_EVEN_ODD;
+  SH_INITOBJ(SHVector2Array, p->fillTriangles);
   SH_INITOBJ(SHVector2Array, p->stroke);
+  SH_INITOBJ(SHVector2Array, p->boundsHull);
+  
+  /* Reduced paths and coverage geometry */
+  kv_init(p->reduced_paths);
+  for (i=0; i<4; ++i)
+    shInitGeometry(&p->fill_geoms[i]);
+  for (i=0; i<2; ++i)
+    shInitGeometry(&p->stroke_geoms[i]);
+  
+  p->num_dashes = 0;
+  p->dashes = NULL;
+  p->dash_length = 0.0f;
+  p->dash_phase = 0.0f;
+  
+  p->cacheStrokeDash = NULL;
+  p->cacheStrokeDashCount = 0;
+  
+  p->cacheReducedPaths = VG_FALSE;
+  p->cacheReduceScale = 1.0f;
+  p->dirtySegStart = 0;
+  p->dirtySegEnd = 0;
+  p->lods = NULL;
+  p->lodCache = NULL;
+  p->cacheFillGeometries = VG_FALSE;
+  p->cacheStrokeGeometries = VG_FALSE;
+  
+  kv_init(p->lengthIndex.seg_pieces);
+  kv_init(p->lengthIndex.pieces);
+  kv_init(p->lengthIndex.lengths);
+  p->cacheLengthValid = VG_FALSE;
+  p->cacheBoundsValid = VG_FALSE;
 }
 
 /*-----------------------------------------------------
@@ -80,7 +120,15 @@ void SHPath_dtor(SHPath *p)
   if (p->data) free(p->data);
   
   SH_DEINITOBJ(SHVertexArray, p->vertices);
+  SH_DEINITOBJ(SHVector2Array, p->fillTriangles);
   SH_DEINITOBJ(SHVector2Array, p->stroke);
+  SH_DEINITOBJ(SHVector2Array, p->boundsHull);
+  
+  shTessCacheDropPath(p->lodCache, p);
+  shDeletePathGeometry(p);
+  shDeletePathLengths(p);
+  if (p->dashes) free(p->dashes);
+  if (p->cacheStrokeDash) free(p->cacheStrokeDash);
 }
 
 /*-----------------------------------------------------
@@ -120,6 +168,7 @@ VG_API_CALL VGPath vgCreatePath(VGint pathFormat,
                                 VGbitfield capabilities)
 {
   SHPath *p = NULL;
+  VGHandle handle;
   VG_GETCONTEXT(VG_INVALID_HANDLE);
   
   /* Only standard format supported */
@@ -134,7 +183,12 @@ VG_API_CALL VGPath vgCreatePath(VGint pathFormat,
   /* Allocate new resource */
   SH_NEWOBJ(SHPath, p);
   VG_RETURN_ERR_IF(!p, VG_OUT_OF_MEMORY_ERROR, VG_INVALID_HANDLE);
-  shPathArrayPushBack(&context->paths, p);
+  
+  /* Add to resource table */
+  handle = shCreateHandle(context, p, SH_RESOURCE_PATH);
+  if (handle == VG_INVALID_HANDLE) {
+    SH_DELETEOBJ(SHPath, p);
+    VG_RETURN_ERR(VG_OUT_OF_MEMORY_ERROR, VG_INVALID_HANDLE); }
   
   /* Set parameters */
   p->format = pathFormat;
@@ -150,7 +204,7 @@ VG_API_CALL VGPath vgCreatePath(VGint pathFormat,
   p->cacheTransformInit = VG_FALSE;
   p->cacheStrokeInit = VG_FALSE;
   
-  VG_RETURN((VGPath)p);
+  VG_RETURN((VGPath)handle);
 }
 
 /*-----------------------------------------------------
@@ -167,16 +221,20 @@ VG_API_CALL void vgClearPath(VGPath path, VGbitfield capabilities)
                    VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
   
   /* Clear raw data */
-  p = (SHPath*)path;
+  p = shGetPath(context, path);
   free(p->segs);
   free(p->data);
   p->segs = NULL;
   p->data = NULL;
   p->segCount = 0;
   p->dataCount = 0;
+  p->segCapacity = 0;
+  p->dataCapacity = 0;
 
   /* Mark change */
   p->cacheDataValid = VG_FALSE;
+  p->cacheLengthValid = VG_FALSE;
+  p->cacheBoundsValid = VG_FALSE;
   
   /* Downsize arrays to save memory */
   shVertexArrayRealloc(&p->vertices, 1);
@@ -194,16 +252,16 @@ VG_API_CALL void vgClearPath(VGPath path, VGbitfield capabilities)
 
 VG_API_CALL void vgDestroyPath(VGPath path)
 {
-  int index;
+  SHPath *p;
   VG_GETCONTEXT(VG_NO_RETVAL);
   
   /* Check if handle valid */
-  index = shPathArrayFind(&context->paths, (SHPath*)path);
-  VG_RETURN_ERR_IF(index == -1, VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+  p = shGetPath(context, path);
+  VG_RETURN_ERR_IF(!p, VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
   
   /* Delete object and remove resource */
-  SH_DELETEOBJ(SHPath, (SHPath*)path);
-  shPathArrayRemoveAt(&context->paths, index);
+  SH_DELETEOBJ(SHPath, p);
+  shDestroyHandle(context, path);
   
   VG_RETURN_ERR(VG_NO_ERROR, VG_NO_RETVAL);
 }
@@ -221,7 +279,7 @@ VG_API_CALL void vgRemovePathCapabilities(VGPath path, VGbitfield capabilities)
                    VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
   
   capabilities &= VG_PATH_CAPABILITY_ALL;
-  ((SHPath*)path)->caps &= ~capabilities;
+  shGetPath(context, path)->caps &= ~capabilities;
   
   VG_RETURN(VG_NO_RETVAL);
 }
@@ -237,7 +295,7 @@ VG_API_CALL VGbitfield vgGetPathCapabilities(VGPath path)
   VG_RETURN_ERR_IF(!shIsValidPath(context, path),
                    VG_BAD_HANDLE_ERROR, 0x0);
   
-  VG_RETURN( ((SHPath*)path)->caps );
+  VG_RETURN( shGetPath(context, path)->caps );
 }
 
 /*-----------------------------------------------------
@@ -306,35 +364,79 @@ static void shRealCoordToData(VGPathDatatype type, SHfloat scale, SHfloat bias,
 }
 
 /*-------------------------------------------------
- * Resizes storage for segment and coordinate data
- * of the specified path by given number of items
+ * Makes room for the given number of additional
+ * segments and coordinates in the path storage.
+ * Capacity grows geometrically so that repeated
+ * appends take amortized constant time.
  *-------------------------------------------------*/
 
-static int shResizePathData(SHPath *p, SHint newSegCount, SHint newDataCount,
-                            SHuint8 **newSegs, SHuint8 **newData)
+static int shGrowPathArray(void **items, SHint *capacity, SHint needed,
+                           SHint hint, SHint itemSize)
 {
-  SHint oldDataSize = 0;
-  SHint newDataSize = 0;
+  SHint grown;
+  void *mem;
   
-  /* Allocate memory for new segments */
-  (*newSegs) = (SHuint8*)malloc(p->segCount + newSegCount);
-  if ((*newSegs) == NULL) return 0;
+  if (needed <= *capacity) return 1;
   
-  /* Allocate memory for new data */
-  oldDataSize = p->dataCount * shBytesPerDatatype[p->datatype];
-  newDataSize = newDataCount * shBytesPerDatatype[p->datatype];
-  (*newData) = (SHuint8*)malloc(oldDataSize + newDataSize);
-  if ((*newData) == NULL) {free(*newSegs); return 0;}
+  grown = SH_MAX(*capacity + *capacity / 2, 16);
+  grown = SH_MAX(grown, hint);
+  grown = SH_MAX(grown, needed);
+  
+  /* Retry at the exact size if the headroom doesn't fit */
+  mem = realloc(*items, (size_t)grown * itemSize);
+  if (!mem && grown > needed) {
+    grown = needed;
+    mem = realloc(*items, (size_t)grown * itemSize);
+  }
+  if (!mem) return 0;
   
-  /* Copy old segments */
-  memcpy(*newSegs, p->segs, p->segCount);
+  *items = mem;
+  *capacity = grown;
+  return 1;
+}
+
+static int shReservePathData(SHPath *p, SHint newSegCount, SHint newDataCount)
+{
+  if (!shGrowPathArray((void**)&p->segs, &p->segCapacity,
+                       p->segCount + newSegCount, p->segHint, 1))
+    return 0;
   
-  /* Copy old data */
-  memcpy(*newData, p->data, oldDataSize);
+  if (!shGrowPathArray(&p->data, &p->dataCapacity,
+                       p->dataCount + newDataCount, p->dataHint,
+                       shBytesPerDatatype[p->datatype]))
+    return 0;
   
   return 1;
 }
 
+/*-------------------------------------------------------------
+ * Preallocates storage for the given total number of segments
+ * and coordinates, e.g. before appending them one at a time.
+ * Being a hint, allocation failure is not an error.
+ *-------------------------------------------------------------*/
+
+VG_API_CALL void vgPathCapacityHintEXT(VGPath path, VGint segmentCapacity,
+                                       VGint coordCapacity)
+{
+  SHPath *p;
+  VG_GETCONTEXT(VG_NO_RETVAL);
+  
+  VG_RETURN_ERR_IF(!shIsValidPath(context, path),
+                   VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+  
+  p = shGetPath(context, path);
+  
+  if (segmentCapacity > p->segCapacity)
+    shGrowPathArray((void**)&p->segs, &p->segCapacity,
+                    segmentCapacity, 0, 1);
+  
+  if (coordCapacity > p->dataCapacity)
+    shGrowPathArray(&p->data, &p->dataCapacity, coordCapacity, 0,
+                    shBytesPerDatatype[p->datatype]);
+  
+  VG_RETURN(VG_NO_RETVAL);
+}
+
 /*-------------------------------------------------------------
  * Appends path data from source to destination path resource
  *-------------------------------------------------------------*/
@@ -343,25 +445,23 @@ VG_API_CALL void vgAppendPath(VGPath dstPath, VGPath srcPath)
 {
   int i;
   SHPath *src, *dst;
-  SHuint8 *newSegs = NULL;
-  SHuint8 *newData = NULL;
   VG_GETCONTEXT(VG_NO_RETVAL);
   
   VG_RETURN_ERR_IF(!shIsValidPath(context, srcPath) ||
                    !shIsValidPath(context, dstPath),
                    VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
   
-  src = (SHPath*)srcPath; dst = (SHPath*)dstPath;
+  src = shGetPath(context, srcPath); dst = shGetPath(context, dstPath);
   VG_RETURN_ERR_IF(!(src->caps & VG_PATH_CAPABILITY_APPEND_FROM) ||
                    !(dst->caps & VG_PATH_CAPABILITY_APPEND_TO),
                    VG_PATH_CAPABILITY_ERROR, VG_NO_RETVAL);
   
   /* Resize path storage */
-  shResizePathData(dst, src->segCount, src->dataCount, &newSegs, &newData);
-  VG_RETURN_ERR_IF(!newData, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  VG_RETURN_ERR_IF(!shReservePathData(dst, src->segCount, src->dataCount),
+                   VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
   
   /* Copy new segments */
-  memcpy(newSegs+dst->segCount, src->segs, src->segCount);
+  memcpy(dst->segs+dst->segCount, src->segs, src->segCount);
   
   /* Copy new coordinates */
   for (i=0; i<src->dataCount; ++i) {
@@ -370,21 +470,17 @@ VG_API_CALL void vgAppendPath(VGPath dstPath, VGPath srcPath)
                                         src->bias, src->data, i);
     
     shRealCoordToData(dst->datatype, dst->scale, dst->bias,
-                      newData, dst->dataCount+i, coord);
+                      dst->data, dst->dataCount+i, coord);
   }
   
-  /* Free old arrays */
-  free(dst->segs);
-  free(dst->data);
-  
   /* Adjust new properties */
-  dst->segs = newSegs;
-  dst->data = newData;
   dst->segCount += src->segCount;
   dst->dataCount += src->dataCount;
 
   /* Mark change */
   dst->cacheDataValid = VG_FALSE;
+  dst->cacheLengthValid = VG_FALSE;
+  dst->cacheBoundsValid = VG_FALSE;
   
   VG_RETURN(VG_NO_RETVAL);
 }
@@ -402,14 +498,12 @@ VG_API_CALL void vgAppendPathData(VGPath dstPath, VGint newSegCount,
   SHint newDataCount = 0;
   SHint oldDataSize = 0;
   SHint newDataSize = 0;
-  SHuint8 *newSegs = NULL;
-  SHuint8 *newData = NULL;
   VG_GETCONTEXT(VG_NO_RETVAL);
   
   VG_RETURN_ERR_IF(!shIsValidPath(context, dstPath),
                    VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
   
-  dst = (SHPath*)dstPath;
+  dst = shGetPath(context, dstPath);
   VG_RETURN_ERR_IF(!(dst->caps & VG_PATH_CAPABILITY_APPEND_TO),
                    VG_PATH_CAPABILITY_ERROR, VG_NO_RETVAL);
   
@@ -426,33 +520,29 @@ VG_API_CALL void vgAppendPathData(VGPath dstPath, VGint newSegCount,
                    VG_NO_RETVAL);
   
   /* Resize path storage */
-  shResizePathData(dst, newSegCount, newDataCount, &newSegs, &newData);
-  VG_RETURN_ERR_IF(!newData, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  VG_RETURN_ERR_IF(!shReservePathData(dst, newSegCount, newDataCount),
+                   VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
   
   /* Copy new segments */
-  memcpy(newSegs+dst->segCount, segs, newSegCount);
+  memcpy(dst->segs+dst->segCount, segs, newSegCount);
   
   /* Copy new coordinates */
   if (dst->datatype == VG_PATH_DATATYPE_F) {
     for (i=0; i<newDataCount; ++i)
-      ((SHfloat32*)newData) [dst->dataCount+i] =
+      ((SHfloat32*)dst->data) [dst->dataCount+i] =
         shValidInputFloat( ((VGfloat*)data) [i] );
   }else{
-    memcpy(newData+oldDataSize, data, newDataSize);
+    memcpy((SHuint8*)dst->data+oldDataSize, data, newDataSize);
   }
   
-  /* Free old arrays */
-  free(dst->segs);
-  free(dst->data);
-  
   /* Adjust new properties */
-  dst->segs = newSegs;
-  dst->data = newData;
   dst->segCount += newSegCount;
   dst->dataCount += newDataCount;
 
   /* Mark change */
   dst->cacheDataValid = VG_FALSE;
+  dst->cacheLengthValid = VG_FALSE;
+  dst->cacheBoundsValid = VG_FALSE;
   
   VG_RETURN(VG_NO_RETVAL);
 }
@@ -475,7 +565,7 @@ VG_API_CALL void vgModifyPathCoords(VGPath dstPath, VGint startIndex,
   VG_RETURN_ERR_IF(!shIsValidPath(context, dstPath),
                    VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
   
-  p = (SHPath*)dstPath;
+  p = shGetPath(context, dstPath);
   VG_RETURN_ERR_IF(!(p->caps & VG_PATH_CAPABILITY_MODIFY),
                    VG_PATH_CAPABILITY_ERROR, VG_NO_RETVAL);
   
@@ -503,6 +593,22 @@ VG_API_CALL void vgModifyPathCoords(VGPath dstPath, VGint startIndex,
   }
 
   /* Mark change */
+  p->cacheLengthValid = VG_FALSE;
+  p->cacheBoundsValid = VG_FALSE;
+  
+#if RENDERING_ENGINE == SOFTWARE
+  /* Only the sub-paths of the modified segments get rebuilt
+     as long as the cached geometry is otherwise valid */
+  if (p->cacheDataValid == VG_TRUE && p->cacheReducedPaths == VG_TRUE) {
+    if (p->dirtySegStart < p->dirtySegEnd) {
+      p->dirtySegStart = SH_MIN(p->dirtySegStart, startIndex);
+      p->dirtySegEnd = SH_MAX(p->dirtySegEnd, startIndex + numSegments);
+    }else{
+      p->dirtySegStart = startIndex;
+      p->dirtySegEnd = startIndex + numSegments;
+    }
+  }else
+#endif
   p->cacheDataValid = VG_FALSE;
   
   VG_RETURN(VG_NO_RETVAL);
@@ -668,6 +774,7 @@ void shProcessPathData(SHPath *p,
   SHVector2 start; /* start of the current contour */
   SHVector2 pen; /* current pen position */
   SHVector2 tan; /* backward tangent for smoothing */
+  SHVector2 ctrl; /* reflected control point */
   SHint open = 0; /* contour-open flag */
   
   /* Reset points */
@@ -848,12 +955,14 @@ void shProcessPathData(SHPath *p,
         data[4] += pen.x; data[5] += pen.y;
       }
       
+      /* First control point reflects the previous tangent
+         about the previous pen */
+      SET2(ctrl, 2*pen.x - tan.x, 2*pen.y - tan.y);
       SET2(tan, data[2], data[3]);
       SET2(pen, data[4], data[5]);
       
       if (flags & SH_PROCESS_SIMPLIFY_CURVES) {
-        data[2] = 2*pen.x - tan.x;
-        data[3] = 2*pen.y - tan.y;
+        data[2] = ctrl.x; data[3] = ctrl.y;
         data[4] = tan.x; data[5] = tan.y;
         data[6] = pen.x; data[7] = pen.y;
         (*callback)(p,VG_CUBIC_TO,command,data,userData);
@@ -1100,8 +1209,6 @@ VG_API_CALL void vgTransformPath(VGPath dstPath, VGPath srcPath)
   SHint newSegCount=0;
   SHint newDataCount=0;
   SHPath *src, *dst;
-  SHuint8 *newSegs = NULL;
-  SHuint8 *newData = NULL;
   SHint segCount = 0;
   SHint dataCount = 0;
   void *userData[5];
@@ -1114,36 +1221,32 @@ VG_API_CALL void vgTransformPath(VGPath dstPath, VGPath srcPath)
                    !shIsValidPath(context, srcPath),
                    VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
   
-  src = (SHPath*)srcPath; dst = (SHPath*)dstPath;
+  src = shGetPath(context, srcPath); dst = shGetPath(context, dstPath);
   VG_RETURN_ERR_IF(!(src->caps & VG_PATH_CAPABILITY_TRANSFORM_FROM) ||
                    !(dst->caps & VG_PATH_CAPABILITY_TRANSFORM_TO),
                    VG_PATH_CAPABILITY_ERROR, VG_NO_RETVAL);
   
   /* Resize path storage */
   shProcessedDataCount(src, processFlags, &newSegCount, &newDataCount);
-  shResizePathData(dst, newSegCount, newDataCount, &newSegs, &newData);
-  VG_RETURN_ERR_IF(!newData, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  VG_RETURN_ERR_IF(!shReservePathData(dst, newSegCount, newDataCount),
+                   VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
   
   /* Transform src path into new data */
   segCount = dst->segCount;
   dataCount = dst->dataCount;
-  userData[0] = newSegs; userData[1] = &segCount;
-  userData[2] = newData; userData[3] = &dataCount;
+  userData[0] = dst->segs; userData[1] = &segCount;
+  userData[2] = dst->data; userData[3] = &dataCount;
   userData[4] = dst;
   shProcessPathData(src, processFlags, shTransformSegment, userData);
   
-  /* Free old arrays */
-  free(dst->segs);
-  free(dst->data);
-  
   /* Adjust new properties */
-  dst->segs = newSegs;
-  dst->data = newData;
   dst->segCount = segCount;
   dst->dataCount = dataCount;
 
   /* Mark change */
   dst->cacheDataValid = VG_FALSE;
+  dst->cacheLengthValid = VG_FALSE;
+  dst->cacheBoundsValid = VG_FALSE;
   
   VG_RETURN_ERR(VG_NO_ERROR, VG_NO_RETVAL);
 }
@@ -1175,7 +1278,6 @@ VG_API_CALL VGboolean vgInterpolatePath(VGPath dstPath, VGPath startPath,
   SHfloat *procData1, *procData2;
   SHint procSegCount1=0, procSegCount2=0;
   SHint procDataCount1=0, procDataCount2=0;
-  SHuint8 *newSegs, *newData;
   void *userData[4];
   SHint segment1, segment2;
   SHint segindex, s,d,i;
@@ -1190,7 +1292,7 @@ VG_API_CALL VGboolean vgInterpolatePath(VGPath dstPath, VGPath startPath,
                    !shIsValidPath(context, endPath),
                    VG_BAD_HANDLE_ERROR, VG_FALSE);
   
-  dst = (SHPath*)dstPath; start = (SHPath*)startPath; end = (SHPath*)endPath;
+  dst = shGetPath(context, dstPath); start = shGetPath(context, startPath); end = shGetPath(context, endPath);
   VG_RETURN_ERR_IF(!(start->caps & VG_PATH_CAPABILITY_INTERPOLATE_FROM) ||
                    !(end->caps & VG_PATH_CAPABILITY_INTERPOLATE_FROM) ||
                    !(dst->caps & VG_PATH_CAPABILITY_INTERPOLATE_TO),
@@ -1227,8 +1329,7 @@ VG_API_CALL VGboolean vgInterpolatePath(VGPath dstPath, VGPath startPath,
             procDataCount1 == procDataCount2);
   
   /* Resize dst path storage to include interpolated data */
-  shResizePathData(dst, procSegCount1, procDataCount1, &newSegs, &newData);
-  if (!newData) {
+  if (!shReservePathData(dst, procSegCount1, procDataCount1)) {
     free(procSegs1); free(procData1);
     free(procSegs2); free(procData2);
     VG_RETURN_ERR(VG_OUT_OF_MEMORY_ERROR, VG_FALSE);
@@ -1254,18 +1355,17 @@ VG_API_CALL VGboolean vgInterpolatePath(VGPath dstPath, VGPath startPath,
     if (segment1 != segment2) {
       free(procSegs1); free(procData1);
       free(procSegs2); free(procData2);
-      free(newSegs); free(newData);
       VG_RETURN_ERR(VG_NO_ERROR, VG_FALSE);
     }
     
     /* Interpolate values */
     segindex = (segment1 >> 1);
-    newSegs[s] = segment1 | VG_ABSOLUTE;
+    dst->segs[dst->segCount + s] = segment1 | VG_ABSOLUTE;
     for (i=0; i<shCoordsPerCommand[segindex]; ++i, ++d) {
       SHfloat diff = procData2[d] - procData1[d];
       SHfloat value = procData1[d] + amount * diff;
       shRealCoordToData(dst->datatype, dst->scale, dst->bias,
-                        newData, dst->dataCount + d, value);
+                        dst->data, dst->dataCount + d, value);
     }
   }
   
@@ -1274,13 +1374,13 @@ VG_API_CALL VGboolean vgInterpolatePath(VGPath dstPath, VGPath startPath,
   free(procSegs2); free(procData2);
   
   /* Assign interpolated data */
-  dst->segs = newSegs;
-  dst->data = newData;
   dst->segCount += procSegCount1;
   dst->dataCount += procDataCount1;
 
   /* Mark change */
   dst->cacheDataValid = VG_FALSE;
+  dst->cacheLengthValid = VG_FALSE;
+  dst->cacheBoundsValid = VG_FALSE;
   
   VG_RETURN_ERR(VG_NO_ERROR, VG_TRUE);
 }
@@ -60,12 +60,15 @@ typedef struct SHPath
   SHint dataHint;
   VGbitfield caps;
   VGPathDatatype datatype;
+  SHfloat flattenTolerance;
   
   /* Raw data */
   SHuint8 *segs;
   void *data;
   SHint segCount;
   SHint dataCount;
+  SHint segCapacity;
+  SHint dataCapacity;
 
   /* Reduced data */
   reduced_path_vec reduced_paths;
@@ -93,10 +96,16 @@ typedef struct SHPath
   int    num_dashes;
   float  *dashes;
   float  dash_length;
+  float  dash_phase;
 
   /* Subdivision */
   SHVertexArray vertices;
   SHVector2 min, max;
+  VGboolean fillConvex;  /* one convex contour */
+  
+  /* Triangulated fill, when hinted */
+  VGboolean      triangulateFill;
+  SHVector2Array fillTriangles;
   
   /* Additional stroke geometry (dash vertices if
      path dashed or triangle vertices if width > 1 */
@@ -114,13 +123,35 @@ typedef struct SHPath
   VGCapStyle     cacheStrokeCapStyle;
   VGJoinStyle    cacheStrokeJoinStyle;
   SHfloat        cacheStrokeMiterLimit;
-  SHfloat        cacheStrokeDashPhase;
+  SHuint         cacheStrokeDashHash;  /* 0 when not dashed */
+  SHfloat       *cacheStrokeDash;      /* dash the stroke was */
+  SHint          cacheStrokeDashCount; /* built with, checked */
+  SHfloat        cacheStrokeDashPhase; /* when hashes match */
   VGboolean      cacheStrokeDashPhaseReset;
 
+  VGboolean      cacheTrianglesValid;
+  VGFillRule     cacheTrianglesRule;
+
   VGboolean      cacheReducedPaths;
+  SHfloat        cacheReduceScale;
+  SHint          dirtySegStart;  /* segments with modified */
+  SHint          dirtySegEnd;    /* coords since last prepare */
+  struct SHPathLOD   *lods;      /* levels parked in lodCache */
+  struct SHTessCache *lodCache;
   VGboolean      cacheFillGeometries;
   VGboolean      cacheStrokeGeometries;
   
+  /* Arc lengths for vgPathLength / vgPointAlongPath,
+     built on first query after a data change */
+  struct length_index lengthIndex;
+  VGboolean      cacheLengthValid;
+  
+  /* Bounds for vgPathBounds / vgPathTransformedBounds */
+  VGboolean      cacheBoundsValid;
+  SHVector2      boundsMin;
+  SHVector2      boundsMax;
+  SHVector2Array boundsHull;     /* hull of the control points */
+  
 } SHPath;
 
 void SHPath_ctor(SHPath *p);
@@ -144,11 +175,4 @@ void shProcessPathData(SHPath *p, int flags,
                        void *userData);
 
 
-/* Pointer-to-path array */
-#define _ITEM_T SHPath*
-#define _ARRAY_T SHPathArray
-#define _FUNC_T shPathArray
-#define _ARRAY_DECLARE
-#include "shArrayBase.h"
-
 #endif /* __SHPATH_H */
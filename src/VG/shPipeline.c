@@ -1,6 +1,7 @@
 
 #define VG_API_EXPORT
 #include <VG/openvg.h>
+#include <VG/vulcanvg.h>
 #include "shDefs.h"
 #include "shExtensions.h"
 #include "shContext.h"
@@ -8,6 +9,13 @@
 #include "shImage.h"
 #include "shGeometry.h"
 #include "shPaint.h"
+#include "shRasterizer.h"
+#include "shThreads.h"
+#include "shTessCache.h"
+#include "shTriangulate.h"
+#include <string.h>
+
+#if RENDERING_ENGINE != SOFTWARE
 
 void shPremultiplyFramebuffer()
 {
@@ -83,6 +91,22 @@ static void shDrawStroke(SHPath *p)
 #endif
 }
 
+/*-----------------------------------------------------------
+ * Draws the triangles covering the fill of a path.
+ *-----------------------------------------------------------*/
+
+static void shDrawFillTriangles(SHPath *p)
+{
+#if RENDERING_ENGINE == OPENGL_1
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(2, GL_FLOAT, 0, p->fillTriangles.items);
+#endif
+  glDrawArrays(GL_TRIANGLES, 0, p->fillTriangles.size);
+#if RENDERING_ENGINE == OPENGL_1
+  glDisableClientState(GL_VERTEX_ARRAY);
+#endif
+}
+
 /*-----------------------------------------------------------
  * Draws the subdivided vertices in the OpenGL mode given
  * (this could be VG_TRIANGLE_FAN or VG_LINE_STRIP).
@@ -170,7 +194,7 @@ static void shDrawPaintMesh(VGContext *c, SHVector2 *min, SHVector2 *max,
     break;
     
   case VG_PAINT_TYPE_PATTERN:
-    if (p->pattern != VG_INVALID_HANDLE) {
+    if (shGetImage(c, p->pattern)) {
       shDrawPatternMesh(p, min, max, mode, texUnit);
       break;
     }/* else behave as a color paint */
@@ -189,11 +213,37 @@ static void shDrawPaintMesh(VGContext *c, SHVector2 *min, SHVector2 *max,
   }
 }
 
+#endif /* RENDERING_ENGINE != SOFTWARE */
+
+/*-----------------------------------------------------------
+ * Squared largest stretch (spectral norm) of the linear part
+ * of a matrix, which bounds how much it lengthens any chord
+ * error of vertices it moves.
+ *-----------------------------------------------------------*/
+
+static SHfloat shMatrixStretch2(SHMatrix3x3 *m)
+{
+  SHfloat a = m->m[0][0], b = m->m[0][1];
+  SHfloat d = m->m[1][0], e = m->m[1][1];
+  SHfloat sum = a*a + b*b + d*d + e*e;
+  SHfloat det = a*e - b*d;
+  SHfloat disc = sum*sum - 4.0f*det*det;
+  
+  return 0.5f * (sum + SH_SQRT(SH_MAX(disc, 0.0f)));
+}
+
+/*-----------------------------------------------------------
+ * Vertices flattened at the cached transform hold the
+ * tolerance up to the top of its scale bucket. They serve
+ * the current transform while it stays in the bucket and
+ * the change from the cached one stretches no further than
+ * that headroom, whatever rotation or shear it adds.
+ *-----------------------------------------------------------*/
+
 VGboolean shIsTessCacheValid (VGContext *c, SHPath *p)
 {
-  SHfloat nX, nY;
-  SHVector2 X, Y;
   SHMatrix3x3 mi, mchange;
+  SHfloat headroom;
   VGboolean valid = VG_TRUE;
 
   if (p->cacheDataValid == VG_FALSE) {
@@ -207,13 +257,13 @@ VGboolean shIsTessCacheValid (VGContext *c, SHPath *p)
   }
   else
   {
-    /* TODO: Compare change matrix for any scale or shear  */
     MULMATMAT( c->pathTransform, mi, mchange );
-    SET2( X, mi.m[0][0], mi.m[1][0] );
-    SET2( Y, mi.m[0][1], mi.m[1][1] );
-    nX = NORM2( X ); nY = NORM2( Y );
-    if (nX > 1.01f || nX < 0.99 ||
-        nY > 1.01f || nY < 0.99)
+    headroom = shFlattenHeadroom( &p->cacheTransform );
+    
+    /* The slack absorbs the rounding of an unchanged transform */
+    if (shReduceScale(&c->pathTransform) !=
+        shReduceScale(&p->cacheTransform) ||
+        shMatrixStretch2(&mchange) > headroom * headroom * 1.0001f)
       valid = VG_FALSE;
   }
 
@@ -229,9 +279,78 @@ VGboolean shIsTessCacheValid (VGContext *c, SHPath *p)
   return valid;
 }
 
+/*-----------------------------------------------------------
+ * Hashes the dash pattern, phase and phase reset (FNV-1a).
+ * Zero stands for an undashed stroke; an odd last entry and
+ * the phase of an undashed stroke don't affect the outline.
+ *-----------------------------------------------------------*/
+
+static SHuint shHashMix(SHuint hash, const void *data, size_t size)
+{
+  const SHuint8 *bytes = (const SHuint8*)data;
+  size_t i;
+
+  for (i=0; i<size; ++i) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static SHuint shHashStrokeDash(VGContext *c)
+{
+  SHint count = c->strokeDashPattern.size & ~1;
+  SHuint hash = 2166136261u;
+
+  if (count == 0) return 0;
+
+  hash = shHashMix(hash, &count, sizeof(count));
+  hash = shHashMix(hash, c->strokeDashPattern.items, count * sizeof(SHfloat));
+  hash = shHashMix(hash, &c->strokeDashPhase, sizeof(SHfloat));
+  hash = shHashMix(hash, &c->strokeDashPhaseReset, sizeof(VGboolean));
+  return hash ? hash : 1;
+}
+
+/*-----------------------------------------------------------
+ * Compares the dash the stroke was built with against the
+ * context one, to rule out hash collisions.
+ *-----------------------------------------------------------*/
+
+static VGboolean shIsStrokeDashEqual(VGContext *c, SHPath *p)
+{
+  SHint count = c->strokeDashPattern.size & ~1;
+
+  if (count != p->cacheStrokeDashCount) return VG_FALSE;
+  if (count == 0) return VG_TRUE;
+
+  return (p->cacheStrokeDashPhase == c->strokeDashPhase &&
+          p->cacheStrokeDashPhaseReset == c->strokeDashPhaseReset &&
+          memcmp(p->cacheStrokeDash, c->strokeDashPattern.items,
+                 count * sizeof(SHfloat)) == 0) ? VG_TRUE : VG_FALSE;
+}
+
+static int shStoreStrokeDash(VGContext *c, SHPath *p)
+{
+  SHint count = c->strokeDashPattern.size & ~1;
+  SHfloat *dash = p->cacheStrokeDash;
+
+  if (count > 0) {
+    dash = (SHfloat*)realloc(dash, count * sizeof(SHfloat));
+    if (!dash) return 0;
+    memcpy(dash, c->strokeDashPattern.items, count * sizeof(SHfloat));
+    p->cacheStrokeDash = dash;
+  }
+
+  p->cacheStrokeDashCount = count;
+  p->cacheStrokeDashPhase = c->strokeDashPhase;
+  p->cacheStrokeDashPhaseReset = c->strokeDashPhaseReset;
+  return 1;
+}
+
 VGboolean shIsStrokeCacheValid (VGContext *c, SHPath *p)
 {
   VGboolean valid = VG_TRUE;
+  SHuint dashHash = shHashStrokeDash(c);
 
   if (p->cacheStrokeInit == VG_FALSE) {
     valid = VG_FALSE;
@@ -239,13 +358,12 @@ VGboolean shIsStrokeCacheValid (VGContext *c, SHPath *p)
   else if (p->cacheStrokeTessValid == VG_FALSE) {
     valid = VG_FALSE;
   }
-  else if (c->strokeDashPattern.size > 0) {
-    valid = VG_FALSE;
-  }
   else if (p->cacheStrokeLineWidth  != c->strokeLineWidth  ||
            p->cacheStrokeCapStyle   != c->strokeCapStyle   ||
            p->cacheStrokeJoinStyle  != c->strokeJoinStyle  ||
-           p->cacheStrokeMiterLimit != c->strokeMiterLimit) {
+           p->cacheStrokeMiterLimit != c->strokeMiterLimit ||
+           p->cacheStrokeDashHash   != dashHash ||
+           shIsStrokeDashEqual(c, p) == VG_FALSE) {
     valid = VG_FALSE;
   }
 
@@ -258,11 +376,105 @@ VGboolean shIsStrokeCacheValid (VGContext *c, SHPath *p)
     p->cacheStrokeCapStyle   = c->strokeCapStyle;
     p->cacheStrokeJoinStyle  = c->strokeJoinStyle;
     p->cacheStrokeMiterLimit = c->strokeMiterLimit;
+    p->cacheStrokeDashHash   = dashHash;
+
+    /* Without the dash to compare, never match again */
+    if (!shStoreStrokeDash(c, p))
+      p->cacheStrokeInit = VG_FALSE;
   }
 
   return valid;
 }
 
+/*-----------------------------------------------------------
+ * Conservative early culling. A draw whose surface-space
+ * bounds miss the surface or the scissor rectangle is
+ * skipped before any geometry is built for it.
+ *-----------------------------------------------------------*/
+
+static VGboolean shIsRectCulled(VGContext *c, SHVector2 *min, SHVector2 *max)
+{
+  SHRectangle *s;
+  
+  /* One pixel of margin for antialiasing */
+  SHfloat x0 = min->x - 1.0f, y0 = min->y - 1.0f;
+  SHfloat x1 = max->x + 1.0f, y1 = max->y + 1.0f;
+  
+  /* Surface size is unknown until one is bound */
+  if (c->surfaceWidth > 0 && c->surfaceHeight > 0 &&
+      (x1 <= 0.0f || y1 <= 0.0f ||
+       x0 >= (SHfloat)c->surfaceWidth ||
+       y0 >= (SHfloat)c->surfaceHeight))
+    return VG_TRUE;
+  
+  if (c->scissoring == VG_TRUE) {
+    if (c->scissor.size == 0) return VG_TRUE;
+    s = &c->scissor.items[0];
+    if (x1 <= s->x || y1 <= s->y ||
+        x0 >= s->x + s->w || y0 >= s->y + s->h)
+      return VG_TRUE;
+  }
+  
+  return VG_FALSE;
+}
+
+static VGboolean shIsPathCulled(VGContext *c, SHPath *p, VGbitfield paintModes)
+{
+  SHMatrix3x3 *m = &c->pathTransform;
+  SHVector2 min, max;
+  SHfloat k;
+  
+  shUpdatePathBounds(p);
+  shTransformedPathBounds(p, m, &min, &max);
+  
+  /* Empty path */
+  if (min.x > max.x || min.y > max.y)
+    return VG_TRUE;
+  
+  /* The stroke reaches out by half its width, times the
+     miter limit at miter joins and sqrt(2) at square caps */
+  if ((paintModes & VG_STROKE_PATH) && c->strokeLineWidth > 0.0f) {
+    k = 0.5f * c->strokeLineWidth * 1.5f;
+    if (c->strokeJoinStyle == VG_JOIN_MITER && c->strokeMiterLimit > 1.5f)
+      k = 0.5f * c->strokeLineWidth * c->strokeMiterLimit;
+    min.x -= k * (SH_ABS(m->m[0][0]) + SH_ABS(m->m[0][1]));
+    max.x += k * (SH_ABS(m->m[0][0]) + SH_ABS(m->m[0][1]));
+    min.y -= k * (SH_ABS(m->m[1][0]) + SH_ABS(m->m[1][1]));
+    max.y += k * (SH_ABS(m->m[1][0]) + SH_ABS(m->m[1][1]));
+  }
+  
+  return shIsRectCulled(c, &min, &max);
+}
+
+static VGboolean shIsImageCulled(VGContext *c, SHImage *i)
+{
+  SHMatrix3x3 *m = &c->imageTransform;
+  SHVector2 min, max, v;
+  SHfloat x, y, w;
+  SHint k;
+  
+  for (k=0; k<4; ++k) {
+    x = (SHfloat)((k == 1 || k == 2) ? i->width : 0);
+    y = (SHfloat)((k >= 2) ? i->height : 0);
+    
+    /* Corners behind the projection have no bounds */
+    w = x*m->m[2][0] + y*m->m[2][1] + m->m[2][2];
+    if (!(w > 0.0f)) return VG_FALSE;
+    
+    v.x = (x*m->m[0][0] + y*m->m[0][1] + m->m[0][2]) / w;
+    v.y = (x*m->m[1][0] + y*m->m[1][1] + m->m[1][2]) / w;
+    
+    if (k == 0 || v.x < min.x) min.x = v.x;
+    if (k == 0 || v.y < min.y) min.y = v.y;
+    if (k == 0 || v.x > max.x) max.x = v.x;
+    if (k == 0 || v.y > max.y) max.y = v.y;
+  }
+  
+  return shIsRectCulled(c, &min, &max);
+}
+
+#if RENDERING_ENGINE != SOFTWARE
+
 /*-----------------------------------------------------------
  * Tessellates / strokes the path and draws it according to
  * VGContext state.
@@ -275,6 +487,7 @@ VG_API_CALL void vgDrawPath(VGPath path, VGbitfield paintModes)
   SHfloat mgl[16];
   SHPaint *fill, *stroke;
   SHRectangle *rect;
+  VGboolean triangulated = VG_FALSE;
   
   VG_GETCONTEXT(VG_NO_RETVAL);
   
@@ -283,6 +496,14 @@ VG_API_CALL void vgDrawPath(VGPath path, VGbitfield paintModes)
   
   VG_RETURN_ERR_IF(paintModes & (~(VG_STROKE_PATH | VG_FILL_PATH)),
                    VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+  
+  p = shGetPath(context, path);
+  
+  /* Skip draws off the surface and scissor */
+  if (shIsPathCulled(context, p, paintModes)) {
+    context->culledDraws++;
+    VG_RETURN(VG_NO_RETVAL);
+  }
 
   /* Check whether scissoring is enabled and scissor
      rectangle is valid */
@@ -294,8 +515,6 @@ VG_API_CALL void vgDrawPath(VGPath path, VGbitfield paintModes)
     glEnable( GL_SCISSOR_TEST );
   }
   
-  p = (SHPath*)path;
-  
   /* If user-to-surface matrix invertible tessellate in
      surface space for better path resolution */
   if (shIsTessCacheValid( context, p ) == VG_FALSE)
@@ -307,26 +526,7 @@ VG_API_CALL void vgDrawPath(VGPath path, VGbitfield paintModes)
       shTransformVertices(&mi, p);
 
     shFindBoundbox(p);
-
-#if 0 // test for bake path
-  shReducePath(p);
-  p->stroke_width = context->strokeLineWidth;
-  p->join_style = context->strokeJoinStyle;
-  p->initial_end_cap = context->strokeCapStyle;
-  p->terminal_end_cap = context->strokeCapStyle;
-  p->miter_limit = context->strokeMiterLimit;
-  p->num_dashes = 0;
-  p->dashes = NULL;
-  p->dash_length = 0;
-  p->fill_geoms[0].count = 0;
-  p->fill_geoms[1].count = 0;
-  p->fill_geoms[2].count = 0;
-  p->fill_geoms[3].count = 0;
-  p->stroke_geoms[0].count = 0;
-  p->stroke_geoms[1].count = 0;
-  shCreateFillGeometry(p);
-  shCreateStrokeGeometry(p);
-#endif
+    p->cacheTrianglesValid = VG_FALSE;
   }
 
 #if RENDERING_ENGINE == OPENGL_1
@@ -336,6 +536,17 @@ VG_API_CALL void vgDrawPath(VGPath path, VGbitfield paintModes)
   glEnable(GL_MULTISAMPLE);
 #endif
   
+  /* Triangulate hinted fills for the current fill rule.
+     Out of memory falls back to the stencil fan */
+  if ((paintModes & VG_FILL_PATH) && p->triangulateFill && !p->fillConvex) {
+    if (!p->cacheTrianglesValid || p->cacheTrianglesRule != context->fillRule) {
+      p->cacheTrianglesValid =
+        shTriangulatePath(p, context->fillRule, &p->fillTriangles) ? VG_TRUE : VG_FALSE;
+      p->cacheTrianglesRule = context->fillRule;
+    }
+    triangulated = p->cacheTrianglesValid;
+  }
+  
   /* Pick paint if available or default*/
   fill = (context->fillPaint ? context->fillPaint : &context->defaultPaint);
   stroke = (context->strokePaint ? context->strokePaint : &context->defaultPaint);
@@ -348,14 +559,43 @@ VG_API_CALL void vgDrawPath(VGPath path, VGbitfield paintModes)
   glMultMatrixf(mgl);
 #endif
   
-  if (paintModes & VG_FILL_PATH) {
+  if ((paintModes & VG_FILL_PATH) && p->fillConvex &&
+      fill->type == VG_PAINT_TYPE_COLOR) {
+    
+    /* A convex contour is covered once by its fan,
+       so draw it with the paint straight away */
+    updateBlendingStateGL(context, fill->color.a == 1.0f);
+#if RENDERING_ENGINE == OPENGL_1
+    glColor4fv((GLfloat*)&fill->color);
+#endif
+    shDrawVertices(p, GL_TRIANGLE_FAN);
+    glDisable(GL_BLEND);
+    
+  }else if ((paintModes & VG_FILL_PATH) && triangulated &&
+            fill->type == VG_PAINT_TYPE_COLOR) {
+    
+    /* The triangles cover the fill once */
+    updateBlendingStateGL(context, fill->color.a == 1.0f);
+#if RENDERING_ENGINE == OPENGL_1
+    glColor4fv((GLfloat*)&fill->color);
+#endif
+    shDrawFillTriangles(p);
+    glDisable(GL_BLEND);
+    
+  }else if (paintModes & VG_FILL_PATH) {
     
     /* Tesselate into stencil */
     glEnable(GL_STENCIL_TEST);
-    glStencilFunc(GL_ALWAYS, 0, 0);
-    glStencilOp(GL_INVERT, GL_INVERT, GL_INVERT);
     glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-    shDrawVertices(p, GL_TRIANGLE_FAN);
+    if (triangulated) {
+      glStencilFunc(GL_ALWAYS, 1, 1);
+      glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);
+      shDrawFillTriangles(p);
+    }else{
+      glStencilFunc(GL_ALWAYS, 0, 0);
+      glStencilOp(GL_INVERT, GL_INVERT, GL_INVERT);
+      shDrawVertices(p, GL_TRIANGLE_FAN);
+    }
     
     /* Setup blending */
     updateBlendingStateGL(context,
@@ -399,7 +639,9 @@ VG_API_CALL void vgDrawPath(VGPath path, VGbitfield paintModes)
         /* Generate stroke triangles in user space */
         shVector2ArrayClear(&p->stroke);
         shStrokePath(context, p);
+        context->strokeCacheMisses++;
       }
+      else context->strokeCacheHits++;
 
       /* Stroke into stencil */
       glEnable(GL_STENCIL_TEST);
@@ -482,6 +724,14 @@ VG_API_CALL void vgDrawImage(VGImage image)
 
   /* TODO: check if image is current render target */
   
+  i = shGetImage(context, image);
+  
+  /* Skip draws off the surface and scissor */
+  if (shIsImageCulled(context, i)) {
+    context->culledDraws++;
+    VG_RETURN(VG_NO_RETVAL);
+  }
+  
   /* Check whether scissoring is enabled and scissor
      rectangle is valid */
   if (context->scissoring == VG_TRUE) {
@@ -493,7 +743,6 @@ VG_API_CALL void vgDrawImage(VGImage image)
   }
   
   /* Apply image-user-to-surface transformation */
-  i = (SHImage*)image;
   shMatrixToGL(&context->imageTransform, mgl);
 #if RENDERING_ENGINE == OPENGL_1
   glMatrixMode(GL_MODELVIEW);
@@ -623,3 +872,314 @@ VG_API_CALL void vgDrawImage(VGImage image)
   
   VG_RETURN(VG_NO_RETVAL);
 }
+
+#else /* RENDERING_ENGINE == SOFTWARE */
+
+/*-----------------------------------------------------------
+ * Copies the context stroke parameters and dash pattern
+ * into the path prior to building its stroke geometry
+ *-----------------------------------------------------------*/
+
+static int shSetupPathStroke(VGContext *c, SHPath *p)
+{
+  SHint i, count;
+  SHfloat *dashes;
+
+  p->stroke_width = c->strokeLineWidth;
+  p->join_style = c->strokeJoinStyle;
+  p->initial_end_cap = c->strokeCapStyle;
+  p->terminal_end_cap = c->strokeCapStyle;
+  p->miter_limit = c->strokeMiterLimit;
+  p->num_dashes = 0;
+  p->dash_length = 0.0f;
+  p->dash_phase = 0.0f;
+
+  /* Odd dash count ignores the last entry */
+  count = c->strokeDashPattern.size & ~1;
+  if (count == 0) return 1;
+
+  dashes = (SHfloat*)realloc(p->dashes, count * sizeof(SHfloat));
+  if (!dashes) return 0;
+  p->dashes = dashes;
+
+  for (i=0; i<count; ++i) {
+    dashes[i] = SH_MAX(c->strokeDashPattern.items[i], 0.0f);
+    p->dash_length += dashes[i];
+  }
+
+  if (p->dash_length > 0.0f) {
+    p->num_dashes = count;
+    p->dash_phase = (SHfloat)fmod(c->strokeDashPhase, p->dash_length);
+    if (p->dash_phase < 0.0f) p->dash_phase += p->dash_length;
+  }
+
+  return 1;
+}
+
+/*-----------------------------------------------------------
+ * Brings the cached geometry of the path up to date for the
+ * given paint modes. Only the path itself is written, so
+ * distinct paths may be prepared concurrently, each with its
+ * own build arrays; stroke cache hits and misses are counted
+ * into the caller's counters.
+ *-----------------------------------------------------------*/
+
+static int shPreparePath(VGContext *c, SHPath *p, VGbitfield paintModes,
+                         struct geometry_scratch *scratch,
+                         SHint *strokeHits, SHint *strokeMisses)
+{
+  SHfloat scale = shReduceScale(&c->pathTransform);
+  
+  /* Geometry is kept in user space and only rebuilt
+     when the path data changes */
+  if (p->cacheDataValid == VG_FALSE) {
+    p->cacheDataValid = VG_TRUE;
+    p->cacheReducedPaths = VG_FALSE;
+    p->cacheFillGeometries = VG_FALSE;
+    p->cacheStrokeTessValid = VG_FALSE;
+    p->dirtySegStart = p->dirtySegEnd = 0;
+    shTessCacheDropPath(c->tessCache, p);
+  }
+  
+  /* Coordinate edits rebuild the touched sub-paths and
+     splice them into the cached geometry */
+  if (p->dirtySegStart < p->dirtySegEnd) {
+    shTessCacheDropPath(c->tessCache, p);
+    if (p->cacheReducedPaths == VG_TRUE &&
+        SH_TESS_SCALE_USABLE(p->cacheReduceScale, scale)) {
+      SHint r0, r1;
+      shReducePathRange(p, p->dirtySegStart, p->dirtySegEnd, &r0, &r1);
+      if (r0 < r1) {
+        /* Failed updates fall back to a full build below */
+        if (p->cacheFillGeometries == VG_TRUE &&
+            !shUpdateFillGeometry(p, r0, r1, scratch))
+          p->cacheFillGeometries = VG_FALSE;
+        if (p->cacheStrokeTessValid == VG_TRUE && p->num_dashes == 0) {
+          if (!shUpdateStrokeGeometry(p, r0, r1, scratch))
+            p->cacheStrokeTessValid = VG_FALSE;
+        }else{
+          p->cacheStrokeTessValid = VG_FALSE;
+        }
+      }
+    }else{
+      p->cacheReducedPaths = VG_FALSE;
+    }
+    p->dirtySegStart = p->dirtySegEnd = 0;
+  }
+  
+  /* Curves are approximated for the current zoom. Other
+     levels of detail are parked in the context cache. */
+  if (p->cacheReducedPaths == VG_TRUE &&
+      !SH_TESS_SCALE_USABLE(p->cacheReduceScale, scale))
+    shTessCacheSwap(c->tessCache, p, scale);
+  
+  if (p->cacheReducedPaths == VG_FALSE) {
+    shReducePath(p, scale);
+    p->cacheReducedPaths = VG_TRUE;
+    p->cacheReduceScale = scale;
+    p->cacheFillGeometries = VG_FALSE;
+    p->cacheStrokeTessValid = VG_FALSE;
+  }
+  
+  if ((paintModes & VG_FILL_PATH) &&
+      p->cacheFillGeometries == VG_FALSE) {
+    if (!shCreateFillGeometry(p, scratch))
+      return 0;
+    p->cacheFillGeometries = VG_TRUE;
+  }
+  
+  if ((paintModes & VG_STROKE_PATH) &&
+      c->strokeLineWidth > 0.0f) {
+    if (shIsStrokeCacheValid(c, p) == VG_TRUE) {
+      (*strokeHits)++;
+    }else{
+      (*strokeMisses)++;
+      if (!shSetupPathStroke(c, p) ||
+          !shCreateStrokeGeometry(p, scratch)) {
+        p->cacheStrokeTessValid = VG_FALSE;
+        return 0;
+      }
+    }
+  }
+  
+  return 1;
+}
+
+typedef struct
+{
+  VGContext *context;
+  SHPath **paths;
+  VGbitfield paintModes;
+  struct geometry_scratch *scratch;
+  SHint failed;
+  
+  /* Stroke cache counters per worker */
+  SHint strokeHits[SH_MAX_THREADS];
+  SHint strokeMisses[SH_MAX_THREADS];
+  
+} SHPrepareJob;
+
+static void shPreparePathTask(void *data, SHint index, SHint worker)
+{
+  SHPrepareJob *job = (SHPrepareJob*)data;
+  
+  if (!shPreparePath(job->context, job->paths[index], job->paintModes,
+                     &job->scratch[worker],
+                     &job->strokeHits[worker], &job->strokeMisses[worker]))
+    job->failed = 1;
+}
+
+static int shComparePathPointers(const void *a, const void *b)
+{
+  const SHPath *pa = *(SHPath* const*)a;
+  const SHPath *pb = *(SHPath* const*)b;
+  return (pa < pb ? -1 : (pa > pb ? 1 : 0));
+}
+
+/*-----------------------------------------------------------
+ * Builds the coverage geometry of the path as needed and
+ * rasterizes it into the context framebuffer
+ *-----------------------------------------------------------*/
+
+VG_API_CALL void vgDrawPath(VGPath path, VGbitfield paintModes)
+{
+  SHPath *p;
+  SHPaint *fill, *stroke;
+  struct geometry_scratch *scratch;
+  
+  VG_GETCONTEXT(VG_NO_RETVAL);
+  
+  VG_RETURN_ERR_IF(!shIsValidPath(context, path),
+                   VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+  
+  VG_RETURN_ERR_IF(paintModes & (~(VG_STROKE_PATH | VG_FILL_PATH)),
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+  
+  p = shGetPath(context, path);
+  
+  /* Skip draws off the surface and scissor */
+  if (shIsPathCulled(context, p, paintModes)) {
+    context->culledDraws++;
+    VG_RETURN(VG_NO_RETVAL);
+  }
+  
+  scratch = shGetGeometryScratch(context);
+  
+  VG_RETURN_ERR_IF(!scratch, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  
+  VG_RETURN_ERR_IF(!shPreparePath(context, p, paintModes, &scratch[0],
+                                  &context->strokeCacheHits,
+                                  &context->strokeCacheMisses),
+                   VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  
+  /* Pick paint if available or default*/
+  fill = (context->fillPaint ? context->fillPaint : &context->defaultPaint);
+  stroke = (context->strokePaint ? context->strokePaint : &context->defaultPaint);
+  
+  if (paintModes & VG_FILL_PATH)
+    shRasterizeFill(context, p, fill);
+  
+  if ((paintModes & VG_STROKE_PATH) &&
+      context->strokeLineWidth > 0.0f)
+    shRasterizeStroke(context, p, stroke);
+  
+  VG_RETURN(VG_NO_RETVAL);
+}
+
+VG_API_CALL void vgDrawImage(VGImage image)
+{
+  SHImage *i;
+  
+  VG_GETCONTEXT(VG_NO_RETVAL);
+  
+  VG_RETURN_ERR_IF(!shIsValidImage(context, image),
+                   VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+  
+  /* TODO: check if image is current render target */
+  
+  i = shGetImage(context, image);
+  
+  /* Skip draws off the surface and scissor */
+  if (shIsImageCulled(context, i)) {
+    context->culledDraws++;
+    VG_RETURN(VG_NO_RETVAL);
+  }
+  
+  shRasterizeImage(context, i);
+  
+  VG_RETURN(VG_NO_RETVAL);
+}
+
+#endif /* RENDERING_ENGINE == SOFTWARE */
+
+/*-----------------------------------------------------------
+ * Builds the geometry of many paths ahead of drawing them,
+ * spreading the paths over the worker threads. Curves are
+ * approximated for the current path-user-to-surface zoom
+ * and the stroke follows the current stroke parameters.
+ *-----------------------------------------------------------*/
+
+VG_API_CALL void vgPreparePathsEXT(const VGPath *paths, VGint count,
+                                   VGbitfield paintModes)
+{
+#if RENDERING_ENGINE == SOFTWARE
+  SHPrepareJob job;
+  SHPath **list;
+  SHint i, n;
+#else
+  SHint i;
+#endif
+  
+  VG_GETCONTEXT(VG_NO_RETVAL);
+  
+  VG_RETURN_ERR_IF(count < 0 || (count > 0 && !paths),
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+  
+  VG_RETURN_ERR_IF(paintModes & (~(VG_STROKE_PATH | VG_FILL_PATH)),
+                   VG_ILLEGAL_ARGUMENT_ERROR, VG_NO_RETVAL);
+  
+  for (i=0; i<count; ++i)
+    VG_RETURN_ERR_IF(!shIsValidPath(context, paths[i]),
+                     VG_BAD_HANDLE_ERROR, VG_NO_RETVAL);
+  
+#if RENDERING_ENGINE == SOFTWARE
+  if (count == 0 || paintModes == 0)
+    VG_RETURN(VG_NO_RETVAL);
+  
+  job.scratch = shGetGeometryScratch(context);
+  VG_RETURN_ERR_IF(!job.scratch, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  
+  list = (SHPath**)malloc(count * sizeof(SHPath*));
+  VG_RETURN_ERR_IF(!list, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+  
+  /* A path listed twice must not be built by two threads */
+  for (i=0; i<count; ++i)
+    list[i] = shGetPath(context, paths[i]);
+  qsort(list, count, sizeof(SHPath*), shComparePathPointers);
+  
+  for (i=1, n=1; i<count; ++i)
+    if (list[i] != list[n-1]) list[n++] = list[i];
+  
+  job.context = context;
+  job.paths = list;
+  job.paintModes = paintModes;
+  job.failed = 0;
+  memset(job.strokeHits, 0, sizeof(job.strokeHits));
+  memset(job.strokeMisses, 0, sizeof(job.strokeMisses));
+  
+  shParallelFor(shGetThreadPool(context),
+                shThreadCount(context->rasterThreads),
+                n, shPreparePathTask, &job);
+  
+  for (i=0; i<SH_MAX_THREADS; ++i) {
+    context->strokeCacheHits += job.strokeHits[i];
+    context->strokeCacheMisses += job.strokeMisses[i];
+  }
+  
+  free(list);
+  VG_RETURN_ERR_IF(job.failed, VG_OUT_OF_MEMORY_ERROR, VG_NO_RETVAL);
+#endif
+  
+  /* Other engines tessellate with the draw-time transform */
+  VG_RETURN(VG_NO_RETVAL);
+}
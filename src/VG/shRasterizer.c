@@ -0,0 +1,1641 @@
+#define VG_API_EXPORT
+#include <VG/openvg.h>
+#include "shDefs.h"
+#include "shContext.h"
+#include "shRasterizer.h"
+#include "shThreads.h"
+#include "kvec.h"
+#include <string.h>
+
+#if RENDERING_ENGINE == SOFTWARE
+
+/* Coverage below this doesn't change an 8-bit pixel */
+#define SH_MIN_COVERAGE (1.0f / 512.0f)
+
+/* Maximum chord deviation in device pixels when
+   flattening curves of the fill geometry */
+#define SH_RASTER_TOLERANCE 0.1f
+#define SH_RASTER_MAX_SEGMENTS 256
+
+/* Number of samples in the gradient color ramp */
+#define SH_RAMP_SIZE 256
+
+/* Limits of the rasterization knobs */
+#define SH_MIN_RASTER_TILE_SIZE 8
+#define SH_MAX_RASTER_TILE_SIZE 1024
+
+/*-----------------------------------------------------------
+ * Coverage of a device rectangle. The accumulation buffer
+ * receives signed area deltas of the edges which are then
+ * prefix-summed along each row to obtain winding coverage.
+ *-----------------------------------------------------------*/
+
+typedef struct
+{
+  SHint x, y;
+  SHint w, h;
+  SHfloat *acc;   /* h rows of (w+2) area deltas */
+  SHfloat *cov;   /* h rows of w resolved coverage */
+
+} SHCoverage;
+
+/*-----------------------------------------------------------
+ * Paint evaluation state, captured when a draw is recorded
+ *-----------------------------------------------------------*/
+
+typedef struct
+{
+  VGPaintType type;
+  SHMatrix3x3 inv;      /* surface to paint space */
+  SHColor color;        /* premultiplied color paint */
+  SHfloat linear[4];
+  SHfloat radial[5];
+  VGColorRampSpreadMode spreadMode;
+  SHColor *ramp;        /* premultiplied gradient samples */
+  SHImage *pattern;
+  VGTilingMode tilingMode;
+  SHColor tileFill;
+
+} SHPaintState;
+
+/*-----------------------------------------------------------
+ * Draw commands are recorded into a queue and binned by the
+ * screen tiles they touch. Tiles are then rasterized by a
+ * pool of worker threads, each tile walking its commands in
+ * submission order so blending stays correct.
+ *-----------------------------------------------------------*/
+
+typedef enum
+{
+  SH_RASTER_CLEAR,
+  SH_RASTER_PATH,
+  SH_RASTER_IMAGE
+
+} SHRasterCommandType;
+
+/* Device-space edge with its winding direction */
+typedef struct
+{
+  SHfloat x0, y0, x1, y1;
+  SHfloat dir;
+
+} SHEdge;
+
+/* Curved stroke piece A*t^2 + B*t + C in user space */
+typedef struct
+{
+  SHfloat A[2], B[2], C[2];
+  SHint rect[4];
+
+} SHStrokeQuad;
+
+typedef struct
+{
+  SHRasterCommandType type;
+  SHint rect[4];                /* clipped device rectangle */
+  VGBlendMode blend;
+  VGFillRule rule;
+  VGRenderingQuality quality;
+  SHPaintState paint;
+
+  /* Paths */
+  size_t firstEdge, edgeCount;
+  size_t firstQuad, quadCount;
+  SHMatrix3x3 inv;              /* surface to path user space */
+  SHfloat halfWidth;
+  SHfloat scale;
+
+  /* Images */
+  SHImage *image;
+  SHint usePaint;
+  SHint stencil;
+
+  /* Clear */
+  SHuint32 pixel;
+
+} SHRasterCommand;
+
+typedef struct
+{
+  SHfloat *acc;
+  SHfloat *cov;
+  SHint size;
+  SHint failed;                 /* tiles skipped for lack of memory */
+
+} SHRasterScratch;
+
+typedef kvec_t(SHuint32) SHTileBin;
+
+typedef struct SHRasterQueue
+{
+  VGContext *context;
+
+  kvec_t(SHRasterCommand) commands;
+  kvec_t(SHEdge) edges;
+  kvec_t(SHStrokeQuad) quads;
+  kvec_t(SHColor*) ramps;
+
+  /* Tile bins */
+  SHTileBin *bins;
+  SHint tilesX, tilesY;
+  SHint tileSize;
+
+  /* Coverage buffers of each worker thread */
+  SHRasterScratch scratch[SH_MAX_THREADS];
+
+} SHRasterQueue;
+
+/*-----------------------------------------------------------
+ * Framebuffer management
+ *-----------------------------------------------------------*/
+
+static void shDeleteRasterQueue(VGContext *c);
+
+int shResizeSurface(VGContext *c, SHint width, SHint height)
+{
+  SHuint32 *data = NULL;
+  SHint y, w, h;
+
+  /* Pending draws target the old framebuffer */
+  shFlushRaster(c);
+
+  if (width > 0 && height > 0) {
+    data = (SHuint32*)calloc((size_t)width * height, sizeof(SHuint32));
+    if (!data) return 0;
+  }
+
+  /* Keep the overlapping part of the old content */
+  if (c->surfaceData && data) {
+    w = SH_MIN(width, c->surfaceWidth);
+    h = SH_MIN(height, c->surfaceHeight);
+    for (y=0; y<h; ++y)
+      memcpy(data + y*width, c->surfaceData + y*c->surfaceWidth,
+             w * sizeof(SHuint32));
+  }
+
+  free(c->surfaceData);
+  c->surfaceData = data;
+  c->surfaceWidth = width;
+  c->surfaceHeight = height;
+  return 1;
+}
+
+void shDeleteSurface(VGContext *c)
+{
+  /* Pending draws are dropped with the surface */
+  shDeleteRasterQueue(c);
+  free(c->surfaceData);
+  c->surfaceData = NULL;
+}
+
+/*-----------------------------------------------------------
+ * Clips the given device rectangle [x0,x1)x[y0,y1) to the
+ * surface and the scissor rectangle. Returns 0 if empty.
+ *-----------------------------------------------------------*/
+
+static int shClipRect(VGContext *c, SHint r[4])
+{
+  SHRectangle *s;
+
+  r[0] = SH_MAX(r[0], 0);
+  r[1] = SH_MAX(r[1], 0);
+  r[2] = SH_MIN(r[2], c->surfaceWidth);
+  r[3] = SH_MIN(r[3], c->surfaceHeight);
+
+  if (c->scissoring == VG_TRUE) {
+    if (c->scissor.size == 0) return 0;
+    s = &c->scissor.items[0];
+    r[0] = SH_MAX(r[0], (SHint)SH_FLOOR(s->x));
+    r[1] = SH_MAX(r[1], (SHint)SH_FLOOR(s->y));
+    r[2] = SH_MIN(r[2], (SHint)SH_FLOOR(s->x + s->w));
+    r[3] = SH_MIN(r[3], (SHint)SH_FLOOR(s->y + s->h));
+  }
+
+  return (c->surfaceData != NULL && r[0] < r[2] && r[1] < r[3]);
+}
+
+/*-----------------------------------------------------------
+ * Finds the clipped device rectangle covering the given
+ * user-space bounds under an affine transformation
+ *-----------------------------------------------------------*/
+
+static int shDeviceRect(VGContext *c, const float bounds[4],
+                        SHMatrix3x3 *m, SHint r[4])
+{
+  SHVector2 corners[4], v;
+  SHfloat minx, miny, maxx, maxy;
+  int i;
+
+  if (bounds[0] > bounds[2] || bounds[1] > bounds[3])
+    return 0;
+
+  SET2(corners[0], bounds[0], bounds[1]);
+  SET2(corners[1], bounds[2], bounds[1]);
+  SET2(corners[2], bounds[2], bounds[3]);
+  SET2(corners[3], bounds[0], bounds[3]);
+
+  TRANSFORM2TO(corners[0], (*m), v);
+  minx = maxx = v.x; miny = maxy = v.y;
+  for (i=1; i<4; ++i) {
+    TRANSFORM2TO(corners[i], (*m), v);
+    minx = SH_MIN(minx, v.x); maxx = SH_MAX(maxx, v.x);
+    miny = SH_MIN(miny, v.y); maxy = SH_MAX(maxy, v.y);
+  }
+
+  /* One pixel of margin for antialiasing */
+  r[0] = (SHint)SH_FLOOR(minx) - 1;
+  r[1] = (SHint)SH_FLOOR(miny) - 1;
+  r[2] = (SHint)SH_CEIL(maxx) + 1;
+  r[3] = (SHint)SH_CEIL(maxy) + 1;
+
+  return shClipRect(c, r);
+}
+/*-----------------------------------------------------------
+ * Accumulates the signed area of an edge lying inside the
+ * horizontal range [0,w] of the coverage rectangle
+ *-----------------------------------------------------------*/
+
+static void shAccumulateSegment(SHCoverage *cv, SHfloat x0, SHfloat y0,
+                                SHfloat x1, SHfloat y1, SHfloat dir)
+{
+  SHfloat *row;
+  SHfloat dxdy, x, xnext, dy, d, xa, xb;
+  SHfloat xaf, xbc, xmf, s, a0, a1, a2, am, fa, fb;
+  SHint y, ystart, yend, xai, xbi, xi;
+  SHint stride = cv->w + 2;
+  SHfloat maxx = (SHfloat)cv->w;
+
+  if (y0 == y1) return;
+
+  /* Walk from bottom to top */
+  if (y0 > y1) {
+    SH_SWAP(x0, x1); SH_SWAP(y0, y1);
+    dir = -dir;
+  }
+
+  if (y1 <= 0.0f || y0 >= (SHfloat)cv->h)
+    return;
+
+  dxdy = (x1 - x0) / (y1 - y0);
+  x = x0;
+  if (y0 < 0.0f) x -= y0 * dxdy;
+
+  ystart = (y0 < 0.0f) ? 0 : (SHint)y0;
+  yend = (SHint)SH_CEIL(y1);
+  if (yend > cv->h) yend = cv->h;
+
+  for (y=ystart; y<yend; ++y) {
+
+    row = cv->acc + y * stride;
+    dy = SH_MIN((SHfloat)(y+1), y1) - SH_MAX((SHfloat)y, y0);
+    xnext = x + dxdy * dy;
+    d = dy * dir;
+
+    xa = SH_MIN(x, xnext); xb = SH_MAX(x, xnext);
+    SH_CLAMP(xa, 0.0f, maxx);
+    SH_CLAMP(xb, 0.0f, maxx);
+
+    xaf = SH_FLOOR(xa); xai = (SHint)xaf;
+    xbc = SH_CEIL(xb);  xbi = (SHint)xbc;
+
+    if (xbi <= xai + 1) {
+
+      /* Edge within a single pixel */
+      xmf = 0.5f * (xa + xb) - xaf;
+      row[xai]     += d - d * xmf;
+      row[xai + 1] += d * xmf;
+
+    }else{
+
+      /* Edge spans several pixels, distribute the
+         trapezoid area along them */
+      s = 1.0f / (xb - xa);
+      fa = xa - xaf;
+      a0 = 0.5f * s * (1.0f - fa) * (1.0f - fa);
+      fb = xb - xbc + 1.0f;
+      am = 0.5f * s * fb * fb;
+
+      row[xai] += d * a0;
+      if (xbi == xai + 2) {
+        row[xai + 1] += d * (1.0f - a0 - am);
+      }else{
+        a1 = s * (1.5f - fa);
+        row[xai + 1] += d * (a1 - a0);
+        for (xi = xai + 2; xi < xbi - 1; ++xi)
+          row[xi] += d * s;
+        a2 = a1 + (SHfloat)(xbi - xai - 3) * s;
+        row[xbi - 1] += d * (1.0f - a2 - am);
+      }
+      row[xbi] += d * am;
+    }
+
+    x = xnext;
+  }
+}
+
+/*-----------------------------------------------------------
+ * Accumulates a device-space edge. Parts of the edge lying
+ * left or right of the coverage rectangle are projected
+ * onto its borders which keeps the winding intact.
+ *-----------------------------------------------------------*/
+
+static void shAccumulateLine(SHCoverage *cv, SHfloat x0, SHfloat y0,
+                             SHfloat x1, SHfloat y1, SHfloat dir)
+{
+  SHfloat t[4], tl, tr, dx, dy, xa, ya, xb, yb;
+  SHfloat maxx = (SHfloat)cv->w;
+  SHint n = 0, k;
+
+  x0 -= (SHfloat)cv->x; x1 -= (SHfloat)cv->x;
+  y0 -= (SHfloat)cv->y; y1 -= (SHfloat)cv->y;
+
+  if (y0 == y1) return;
+  if (y0 <= 0.0f && y1 <= 0.0f) return;
+  if (y0 >= (SHfloat)cv->h && y1 >= (SHfloat)cv->h) return;
+
+  dx = x1 - x0;
+  dy = y1 - y0;
+
+  /* Split where crossing the left and right borders */
+  t[n++] = 0.0f;
+  if (dx != 0.0f) {
+    tl = (0.0f - x0) / dx;
+    tr = (maxx - x0) / dx;
+    if (tl > tr) SH_SWAP(tl, tr);
+    if (tl > 0.0f && tl < 1.0f) t[n++] = tl;
+    if (tr > 0.0f && tr < 1.0f) t[n++] = tr;
+  }
+  t[n++] = 1.0f;
+
+  for (k=0; k<n-1; ++k) {
+    xa = x0 + dx * t[k];   ya = y0 + dy * t[k];
+    xb = x0 + dx * t[k+1]; yb = y0 + dy * t[k+1];
+    SH_CLAMP(xa, 0.0f, maxx);
+    SH_CLAMP(xb, 0.0f, maxx);
+    shAccumulateSegment(cv, xa, ya, xb, yb, dir);
+  }
+}
+/*-----------------------------------------------------------
+ * Turns accumulated area deltas into coverage according to
+ * the fill rule and resets the accumulation buffer.
+ *-----------------------------------------------------------*/
+
+static void shResolveCoverage(SHCoverage *cv, VGFillRule rule,
+                              VGRenderingQuality quality)
+{
+  SHint x, y;
+  SHint stride = cv->w + 2;
+  SHfloat s, v;
+
+  for (y=0; y<cv->h; ++y) {
+
+    SHfloat *acc = cv->acc + y * stride;
+    SHfloat *cov = cv->cov + y * cv->w;
+
+    for (x=0, s=0.0f; x<cv->w; ++x) {
+      s += acc[x]; acc[x] = 0.0f;
+      v = (s < 0.0f) ? -s : s;
+
+      if (rule == VG_EVEN_ODD) {
+        v = v - 2.0f * SH_FLOOR(v * 0.5f);
+        if (v > 1.0f) v = 2.0f - v;
+      }else if (v > 1.0f) v = 1.0f;
+
+      if (quality == VG_RENDERING_QUALITY_NONANTIALIASED)
+        v = (v >= 0.5f) ? 1.0f : 0.0f;
+
+      cov[x] = v;
+    }
+
+    acc[cv->w] = 0.0f;
+    acc[cv->w + 1] = 0.0f;
+  }
+}
+
+/*-----------------------------------------------------------
+ * Solves a*t^3 + b*t^2 + c*t + d = 0 for real roots
+ *-----------------------------------------------------------*/
+
+static int shSolveCubic(double a, double b, double c, double d, double r[3])
+{
+  double p, q, off, disc, s, u, v, m, k, th;
+  double scale = fabs(b) + fabs(c) + fabs(d);
+
+  if (fabs(a) <= 1e-9 * scale) {
+
+    /* Quadratic or linear */
+    if (fabs(b) <= 1e-9 * scale) {
+      if (c == 0.0) return 0;
+      r[0] = -d / c;
+      return 1;
+    }
+
+    disc = c*c - 4*b*d;
+    if (disc < 0.0) return 0;
+    s = sqrt(disc);
+    r[0] = (-c + s) / (2*b);
+    r[1] = (-c - s) / (2*b);
+    return 2;
+  }
+
+  b /= a; c /= a; d /= a;
+  p = c - b*b/3;
+  q = 2*b*b*b/27 - b*c/3 + d;
+  off = -b/3;
+  disc = q*q/4 + p*p*p/27;
+
+  if (disc > 0.0) {
+    s = sqrt(disc);
+    u = cbrt(-q/2 + s);
+    v = cbrt(-q/2 - s);
+    r[0] = u + v + off;
+    return 1;
+  }
+
+  if (p == 0.0) {
+    r[0] = off;
+    return 1;
+  }
+
+  /* Three real roots */
+  m = 2 * sqrt(-p/3);
+  k = 3*q / (p*m);
+  if (k < -1.0) k = -1.0;
+  if (k > 1.0) k = 1.0;
+  th = acos(k) / 3;
+  r[0] = m * cos(th) + off;
+  r[1] = m * cos(th - 2*PI/3) + off;
+  r[2] = m * cos(th - 4*PI/3) + off;
+  return 3;
+}
+
+/*-----------------------------------------------------------
+ * Returns the distance from point (px,py) to the quadratic
+ * curve A*t^2 + B*t + C measured along a normal of the curve
+ * with t in [0,1], or a negative value if there is none.
+ *-----------------------------------------------------------*/
+
+static double shQuadDistance(double Ax, double Ay, double Bx, double By,
+                             double Cx, double Cy, double px, double py)
+{
+  double r[3], best = -1.0, dx, dy, t, ex, ey, d2;
+  int n, i;
+
+  dx = Cx - px; dy = Cy - py;
+
+  /* Round joins are stored as a curve that is a single point */
+  if (Ax == 0.0 && Ay == 0.0 && Bx == 0.0 && By == 0.0)
+    return sqrt(dx*dx + dy*dy);
+
+  n = shSolveCubic(2 * (Ax*Ax + Ay*Ay),
+                   3 * (Ax*Bx + Ay*By),
+                   Bx*Bx + By*By + 2 * (Ax*dx + Ay*dy),
+                   Bx*dx + By*dy, r);
+
+  for (i=0; i<n; ++i) {
+    t = r[i];
+    if (t < 0.0 || t > 1.0) continue;
+    ex = (Ax*t + Bx)*t + dx;
+    ey = (Ay*t + By)*t + dy;
+    d2 = ex*ex + ey*ey;
+    if (best < 0.0 || d2 < best) best = d2;
+  }
+
+  return (best < 0.0) ? -1.0 : sqrt(best);
+}
+
+/*-----------------------------------------------------------
+ * Merges the coverage of the curved stroke pieces by their
+ * distance to the curve in user space
+ *-----------------------------------------------------------*/
+
+static void shCoverQuadStrokes(SHCoverage *cv, const SHRasterCommand *cmd,
+                               const SHStrokeQuad *quads)
+{
+  const SHMatrix3x3 *mi = &cmd->inv;
+  SHfloat X, Y, ux, uy, a;
+  SHint x, y, x0, y0, x1, y1;
+  double d;
+  size_t i;
+
+  for (i=0; i<cmd->quadCount; ++i) {
+
+    const SHStrokeQuad *q = &quads[i];
+
+    x0 = SH_MAX(q->rect[0], cv->x) - cv->x;
+    y0 = SH_MAX(q->rect[1], cv->y) - cv->y;
+    x1 = SH_MIN(q->rect[2], cv->x + cv->w) - cv->x;
+    y1 = SH_MIN(q->rect[3], cv->y + cv->h) - cv->y;
+
+    for (y=y0; y<y1; ++y) {
+      SHfloat *cov = cv->cov + y * cv->w;
+
+      for (x=x0; x<x1; ++x) {
+
+        X = cv->x + x + 0.5f;
+        Y = cv->y + y + 0.5f;
+        ux = mi->m[0][0]*X + mi->m[0][1]*Y + mi->m[0][2];
+        uy = mi->m[1][0]*X + mi->m[1][1]*Y + mi->m[1][2];
+
+        d = shQuadDistance(q->A[0], q->A[1], q->B[0], q->B[1],
+                           q->C[0], q->C[1], ux, uy);
+        if (d < 0.0) continue;
+
+        /* Antialiasing ramp is one device pixel wide */
+        a = (cmd->halfWidth - (SHfloat)d) * cmd->scale + 0.5f;
+        SH_CLAMP(a, 0.0f, 1.0f);
+        if (a > cov[x]) cov[x] = a;
+      }
+    }
+  }
+}
+
+/*-----------------------------------------------------------
+ * Paint evaluation
+ *-----------------------------------------------------------*/
+
+static void shClampColor(SHColor *c)
+{
+  SH_CLAMP(c->r, 0.0f, 1.0f);
+  SH_CLAMP(c->g, 0.0f, 1.0f);
+  SH_CLAMP(c->b, 0.0f, 1.0f);
+  SH_CLAMP(c->a, 0.0f, 1.0f);
+}
+
+static void shBuildColorRamp(SHPaint *p, SHColor ramp[SH_RAMP_SIZE])
+{
+  SHStop defaultStops[2];
+  SHStop *stops = p->stops.items;
+  SHint count = p->stops.size;
+  SHint i, s = 0;
+  SHfloat t, k;
+  SHColor c1, c2;
+
+  /* Default ramp if no valid stops were given */
+  if (count == 0) {
+    defaultStops[0].offset = 0.0f;
+    CSET(defaultStops[0].color, 0,0,0,1);
+    defaultStops[1].offset = 1.0f;
+    CSET(defaultStops[1].color, 1,1,1,1);
+    stops = defaultStops;
+    count = 2;
+  }
+
+  for (i=0; i<SH_RAMP_SIZE; ++i) {
+
+    t = (SHfloat)i / (SH_RAMP_SIZE - 1);
+    while (s < count - 2 && t > stops[s+1].offset) ++s;
+
+    c1 = stops[s].color;
+    c2 = stops[SH_MIN(s+1, count-1)].color;
+    if (p->premultiplied == VG_TRUE) { CPREMUL(c1); CPREMUL(c2); }
+
+    if (count == 1 || stops[s+1].offset <= stops[s].offset) k = 1.0f;
+    else k = (t - stops[s].offset) / (stops[s+1].offset - stops[s].offset);
+    SH_CLAMP(k, 0.0f, 1.0f);
+
+    CSUBC(c2, c1);
+    CADDCK(c1, c2, k);
+    shClampColor(&c1);
+    if (p->premultiplied != VG_TRUE) CPREMUL(c1);
+    ramp[i] = c1;
+  }
+}
+
+static int shSetupPaintState(SHPaintState *ps, SHRasterQueue *q,
+                             VGContext *c, SHPaint *p,
+                             SHMatrix3x3 *userToSurface,
+                             SHMatrix3x3 *paintToUser)
+{
+  SHMatrix3x3 m;
+
+  MULMATMAT((*userToSurface), (*paintToUser), m);
+  if (!shInvertMatrix(&m, &ps->inv))
+    return 0;
+
+  ps->type = p->type;
+  ps->color = p->color;
+  shClampColor(&ps->color);
+  CPREMUL(ps->color);
+  ps->spreadMode = p->spreadMode;
+  ps->tilingMode = p->tilingMode;
+  ps->pattern = shGetImage(c, p->pattern);
+  ps->tileFill = c->tileFillColor;
+  shClampColor(&ps->tileFill);
+  CPREMUL(ps->tileFill);
+  memcpy(ps->linear, p->linearGradient, sizeof(ps->linear));
+  memcpy(ps->radial, p->radialGradient, sizeof(ps->radial));
+
+  if (ps->type == VG_PAINT_TYPE_PATTERN && ps->pattern == NULL)
+    ps->type = VG_PAINT_TYPE_COLOR;
+
+  if (ps->type == VG_PAINT_TYPE_LINEAR_GRADIENT ||
+      ps->type == VG_PAINT_TYPE_RADIAL_GRADIENT) {
+    /* Ramp lives until the queue is executed */
+    ps->ramp = (SHColor*)malloc(SH_RAMP_SIZE * sizeof(SHColor));
+    if (!ps->ramp) return 0;
+    kv_push_back(q->ramps, ps->ramp);
+    shBuildColorRamp(p, ps->ramp);
+  }
+
+  return 1;
+}
+
+static void shRampColor(const SHPaintState *ps, SHfloat t, SHColor *out)
+{
+  switch (ps->spreadMode) {
+  case VG_COLOR_RAMP_SPREAD_REPEAT:
+    t = t - SH_FLOOR(t);
+    break;
+  case VG_COLOR_RAMP_SPREAD_REFLECT:
+    t = t - 2.0f * SH_FLOOR(t * 0.5f);
+    if (t > 1.0f) t = 2.0f - t;
+    break;
+  default:
+    SH_CLAMP(t, 0.0f, 1.0f);
+    break;
+  }
+
+  *out = ps->ramp[(SHint)(t * (SH_RAMP_SIZE - 1) + 0.5f)];
+}
+
+static void shImageColor(SHImage *img, SHint x, SHint y, SHColor *out)
+{
+  const SHuint8 *data = img->data +
+    y * img->texwidth * img->fd.bytes + x * img->fd.bytes;
+
+  shLoadColor(out, data, &img->fd);
+
+  /* The surface holds premultiplied sRGB colors */
+  if (!shIsLinearImageFormat(img->fd.vgformat)) {
+    if (!shIsPremultipliedImageFormat(img->fd.vgformat))
+      CPREMUL((*out));
+    return;
+  }
+
+  if (shIsPremultipliedImageFormat(img->fd.vgformat) && out->a > 0.0f)
+    CUNPREMUL((*out));
+
+  shGammaColor(out);
+  CPREMUL((*out));
+}
+
+static void shPaintColor(const SHPaintState *ps, SHfloat x, SHfloat y, SHColor *out)
+{
+  SHfloat u, v, dx, dy, fx, fy, r, den, dd, t;
+  SHint ix, iy;
+
+  if (ps->type == VG_PAINT_TYPE_COLOR) {
+    *out = ps->color;
+    return;
+  }
+
+  u = ps->inv.m[0][0]*x + ps->inv.m[0][1]*y + ps->inv.m[0][2];
+  v = ps->inv.m[1][0]*x + ps->inv.m[1][1]*y + ps->inv.m[1][2];
+
+  switch (ps->type) {
+  case VG_PAINT_TYPE_LINEAR_GRADIENT:
+
+    dx = ps->linear[2] - ps->linear[0];
+    dy = ps->linear[3] - ps->linear[1];
+    dd = dx*dx + dy*dy;
+    t = (dd == 0.0f) ? 1.0f :
+      ((u - ps->linear[0]) * dx + (v - ps->linear[1]) * dy) / dd;
+    shRampColor(ps, t, out);
+    break;
+
+  case VG_PAINT_TYPE_RADIAL_GRADIENT:
+
+    r = ps->radial[4];
+    if (r <= 0.0f) { shRampColor(ps, 1.0f, out); break; }
+
+    /* Focal point relative to center, pulled inside the circle */
+    fx = ps->radial[2] - ps->radial[0];
+    fy = ps->radial[3] - ps->radial[1];
+    dd = fx*fx + fy*fy;
+    if (dd > 0.99f * 0.99f * r*r) {
+      SHfloat k = 0.99f * r / SH_SQRT(dd);
+      fx *= k; fy *= k;
+    }
+
+    dx = u - (ps->radial[0] + fx);
+    dy = v - (ps->radial[1] + fy);
+    den = r*r - (fx*fx + fy*fy);
+    t = r*r * (dx*dx + dy*dy) - (dx*fy - dy*fx) * (dx*fy - dy*fx);
+    t = ((dx*fx + dy*fy) + SH_SQRT(SH_MAX(t, 0.0f))) / den;
+    shRampColor(ps, t, out);
+    break;
+
+  default:
+
+    ix = shTileCoord((SHint)SH_FLOOR(u), ps->pattern->width, ps->tilingMode);
+    iy = shTileCoord((SHint)SH_FLOOR(v), ps->pattern->height, ps->tilingMode);
+    if (ix < 0 || iy < 0) *out = ps->tileFill;
+    else shImageColor(ps->pattern, ix, iy, out);
+    break;
+  }
+}
+
+/*-----------------------------------------------------------
+ * Blends premultiplied source color into a framebuffer pixel
+ * with the given coverage
+ *-----------------------------------------------------------*/
+
+static void shBlendPixel(VGBlendMode mode, const SHColor *s,
+                         SHfloat cov, SHuint32 *pixel)
+{
+  SHColor d, r;
+  SHuint32 in = *pixel;
+
+  /* Opaque source over with full coverage */
+  if (cov >= 1.0f && s->a >= 1.0f &&
+      (mode == VG_BLEND_SRC_OVER || mode == VG_BLEND_SRC)) {
+    *pixel = SH_PACK_RGBA((SHuint32)(s->r * 255.0f + 0.5f),
+                          (SHuint32)(s->g * 255.0f + 0.5f),
+                          (SHuint32)(s->b * 255.0f + 0.5f), 255);
+    return;
+  }
+
+  d.r = (SHfloat)((in >> 24) & 0xFF) / 255.0f;
+  d.g = (SHfloat)((in >> 16) & 0xFF) / 255.0f;
+  d.b = (SHfloat)((in >> 8)  & 0xFF) / 255.0f;
+  d.a = (SHfloat)( in        & 0xFF) / 255.0f;
+
+  switch (mode) {
+  case VG_BLEND_SRC:
+    r = *s; break;
+
+  case VG_BLEND_DST_OVER:
+    CSET(r, s->r*(1-d.a) + d.r, s->g*(1-d.a) + d.g,
+            s->b*(1-d.a) + d.b, s->a*(1-d.a) + d.a); break;
+
+  case VG_BLEND_SRC_IN:
+    CSET(r, s->r*d.a, s->g*d.a, s->b*d.a, s->a*d.a); break;
+
+  case VG_BLEND_DST_IN:
+    CSET(r, d.r*s->a, d.g*s->a, d.b*s->a, d.a*s->a); break;
+
+  case VG_BLEND_MULTIPLY:
+    CSET(r, s->r*(1-d.a) + d.r*(1-s->a) + s->r*d.r,
+            s->g*(1-d.a) + d.g*(1-s->a) + s->g*d.g,
+            s->b*(1-d.a) + d.b*(1-s->a) + s->b*d.b,
+            s->a + d.a*(1-s->a)); break;
+
+  case VG_BLEND_SCREEN:
+    CSET(r, s->r + d.r - s->r*d.r, s->g + d.g - s->g*d.g,
+            s->b + d.b - s->b*d.b, s->a + d.a - s->a*d.a); break;
+
+  case VG_BLEND_DARKEN:
+    CSET(r, SH_MIN(s->r + d.r*(1-s->a), d.r + s->r*(1-d.a)),
+            SH_MIN(s->g + d.g*(1-s->a), d.g + s->g*(1-d.a)),
+            SH_MIN(s->b + d.b*(1-s->a), d.b + s->b*(1-d.a)),
+            s->a + d.a*(1-s->a)); break;
+
+  case VG_BLEND_LIGHTEN:
+    CSET(r, SH_MAX(s->r + d.r*(1-s->a), d.r + s->r*(1-d.a)),
+            SH_MAX(s->g + d.g*(1-s->a), d.g + s->g*(1-d.a)),
+            SH_MAX(s->b + d.b*(1-s->a), d.b + s->b*(1-d.a)),
+            s->a + d.a*(1-s->a)); break;
+
+  case VG_BLEND_ADDITIVE:
+    CSET(r, s->r + d.r, s->g + d.g, s->b + d.b, s->a + d.a); break;
+
+  case VG_BLEND_SRC_OUT_SH:
+    CSET(r, s->r*(1-d.a), s->g*(1-d.a), s->b*(1-d.a), s->a*(1-d.a)); break;
+
+  case VG_BLEND_DST_OUT_SH:
+    CSET(r, d.r*(1-s->a), d.g*(1-s->a), d.b*(1-s->a), d.a*(1-s->a)); break;
+
+  case VG_BLEND_SRC_ATOP_SH:
+    CSET(r, s->r*d.a + d.r*(1-s->a), s->g*d.a + d.g*(1-s->a),
+            s->b*d.a + d.b*(1-s->a), d.a); break;
+
+  case VG_BLEND_DST_ATOP_SH:
+    CSET(r, s->r*(1-d.a) + d.r*s->a, s->g*(1-d.a) + d.g*s->a,
+            s->b*(1-d.a) + d.b*s->a, s->a); break;
+
+  case VG_BLEND_SRC_OVER: default:
+    CSET(r, s->r + d.r*(1-s->a), s->g + d.g*(1-s->a),
+            s->b + d.b*(1-s->a), s->a + d.a*(1-s->a)); break;
+  }
+
+  /* Interpolate with coverage */
+  CSUBC(r, d);
+  CADDCK(d, r, cov);
+  shClampColor(&d);
+
+  *pixel = SH_PACK_RGBA((SHuint32)(d.r * 255.0f + 0.5f),
+                        (SHuint32)(d.g * 255.0f + 0.5f),
+                        (SHuint32)(d.b * 255.0f + 0.5f),
+                        (SHuint32)(d.a * 255.0f + 0.5f));
+}
+
+/*-----------------------------------------------------------
+ * Blends paint through an image used as a per-channel alpha
+ * mask (VG_DRAW_IMAGE_STENCIL). Each color channel blends
+ * with its own alpha, the image channel times paint alpha,
+ * while the destination alpha uses image times paint alpha.
+ *-----------------------------------------------------------*/
+
+static void shBlendStencilPixel(VGBlendMode mode, const SHColor *img,
+                                const SHColor *paint, SHuint32 *pixel)
+{
+  SHColor s;
+  SHuint32 in = *pixel, out = *pixel;
+
+  CSET(s, paint->r * img->r, paint->g * img->g, paint->b * img->b, 0.0f);
+
+  s.a = paint->a * img->r;
+  shBlendPixel(mode, &s, 1.0f, &out);
+  *pixel = (out & 0xFF000000);
+
+  s.a = paint->a * img->g; out = in;
+  shBlendPixel(mode, &s, 1.0f, &out);
+  *pixel |= (out & 0x00FF0000);
+
+  s.a = paint->a * img->b; out = in;
+  shBlendPixel(mode, &s, 1.0f, &out);
+  *pixel |= (out & 0x0000FF00);
+
+  s.a = paint->a * img->a; out = in;
+  shBlendPixel(mode, &s, 1.0f, &out);
+  *pixel |= (out & 0x000000FF);
+}
+
+/*-----------------------------------------------------------
+ * Shades the covered pixels with paint and blends them
+ * into the framebuffer
+ *-----------------------------------------------------------*/
+
+static void shCompositeCoverage(VGContext *c, SHCoverage *cv,
+                                const SHRasterCommand *cmd)
+{
+  SHint x, y;
+  SHColor s;
+
+  for (y=0; y<cv->h; ++y) {
+
+    const SHfloat *cov = cv->cov + y * cv->w;
+    SHuint32 *dst = c->surfaceData + (cv->y + y) * c->surfaceWidth + cv->x;
+
+    for (x=0; x<cv->w; ++x) {
+      if (cov[x] < SH_MIN_COVERAGE) continue;
+      shPaintColor(&cmd->paint, cv->x + x + 0.5f, cv->y + y + 0.5f, &s);
+      shBlendPixel(cmd->blend, &s, cov[x], &dst[x]);
+    }
+  }
+}
+
+/*-----------------------------------------------------------
+ * Command recording
+ *-----------------------------------------------------------*/
+
+static SHRasterQueue* shGetRasterQueue(VGContext *c)
+{
+  SHRasterQueue *q = c->rasterQueue;
+
+  if (q) return q;
+
+  q = (SHRasterQueue*)calloc(1, sizeof(SHRasterQueue));
+  if (!q) return NULL;
+
+  q->context = c;
+  kv_init(q->commands);
+  kv_init(q->edges);
+  kv_init(q->quads);
+  kv_init(q->ramps);
+
+  c->rasterQueue = q;
+  return q;
+}
+
+/*-----------------------------------------------------------
+ * Lays out the tile bins for the current surface size. Only
+ * done while the queue is empty.
+ *-----------------------------------------------------------*/
+
+static int shSetupBins(SHRasterQueue *q, VGContext *c)
+{
+  SHint size = c->rasterTileSize;
+  SHint tilesX, tilesY, i;
+
+  SH_CLAMP(size, SH_MIN_RASTER_TILE_SIZE, SH_MAX_RASTER_TILE_SIZE);
+  tilesX = (c->surfaceWidth + size - 1) / size;
+  tilesY = (c->surfaceHeight + size - 1) / size;
+
+  if (q->bins && size == q->tileSize &&
+      tilesX == q->tilesX && tilesY == q->tilesY)
+    return 1;
+
+  for (i=0; i<q->tilesX * q->tilesY; ++i)
+    kv_free(q->bins[i]);
+  free(q->bins);
+
+  q->bins = (SHTileBin*)malloc(tilesX * tilesY * sizeof(SHTileBin));
+  if (!q->bins) { q->tilesX = q->tilesY = 0; return 0; }
+  for (i=0; i<tilesX * tilesY; ++i)
+    kv_init(q->bins[i]);
+
+  q->tileSize = size;
+  q->tilesX = tilesX;
+  q->tilesY = tilesY;
+  return 1;
+}
+
+static SHRasterCommand* shBeginCommand(VGContext *c, SHRasterCommandType type,
+                                       SHint r[4])
+{
+  SHRasterQueue *q = shGetRasterQueue(c);
+  SHRasterCommand cmd;
+
+  if (!q) return NULL;
+  if (kv_empty(q->commands) && !shSetupBins(q, c))
+    return NULL;
+
+  memset(&cmd, 0, sizeof(SHRasterCommand));
+  cmd.type = type;
+  memcpy(cmd.rect, r, sizeof(cmd.rect));
+  cmd.blend = c->blendMode;
+  cmd.rule = VG_NON_ZERO;
+  cmd.quality = c->renderingQuality;
+  cmd.firstEdge = kv_size(q->edges);
+  cmd.firstQuad = kv_size(q->quads);
+
+  kv_push_back(q->commands, cmd);
+  return &kv_back(q->commands);
+}
+
+static void shCancelCommand(VGContext *c)
+{
+  SHRasterQueue *q = c->rasterQueue;
+  kv_pop_back(q->commands);
+}
+
+/*-----------------------------------------------------------
+ * Adds the last recorded command to the bins of all the
+ * tiles its rectangle overlaps
+ *-----------------------------------------------------------*/
+
+static void shEndCommand(VGContext *c)
+{
+  SHRasterQueue *q = c->rasterQueue;
+  SHRasterCommand *cmd = &kv_back(q->commands);
+  SHuint32 index = (SHuint32)(kv_size(q->commands) - 1);
+  SHint tx, ty;
+
+  cmd->edgeCount = kv_size(q->edges) - cmd->firstEdge;
+  cmd->quadCount = kv_size(q->quads) - cmd->firstQuad;
+
+  for (ty = cmd->rect[1] / q->tileSize;
+       ty <= (cmd->rect[3] - 1) / q->tileSize; ++ty)
+    for (tx = cmd->rect[0] / q->tileSize;
+         tx <= (cmd->rect[2] - 1) / q->tileSize; ++tx)
+      kv_push_back(q->bins[ty * q->tilesX + tx], index);
+}
+
+static void shRecordLine(SHRasterQueue *q, SHVector2 *a, SHVector2 *b,
+                         SHfloat dir)
+{
+  SHEdge e;
+
+  if (a->y == b->y) return;
+  e.x0 = a->x; e.y0 = a->y;
+  e.x1 = b->x; e.y1 = b->y;
+  e.dir = dir;
+  kv_push_back(q->edges, e);
+}
+
+/*-----------------------------------------------------------
+ * Records a quadratic curve flattened in device space
+ *-----------------------------------------------------------*/
+
+static void shRecordQuad(SHRasterQueue *q, SHVector2 *p0, SHVector2 *p1,
+                         SHVector2 *p2, SHfloat dir)
+{
+  SHVector2 dd, prev, cur;
+  SHfloat t, u;
+  SHint i, n;
+
+  SET2(dd, p0->x - 2*p1->x + p2->x, p0->y - 2*p1->y + p2->y);
+  n = (SHint)SH_CEIL(SH_SQRT(NORM2(dd) / (4.0f * SH_RASTER_TOLERANCE)));
+  if (n < 1) n = 1;
+  if (n > SH_RASTER_MAX_SEGMENTS) n = SH_RASTER_MAX_SEGMENTS;
+
+  prev = *p0;
+  for (i=1; i<=n; ++i) {
+    t = (SHfloat)i / n; u = 1.0f - t;
+    cur.x = u*u*p0->x + 2*u*t*p1->x + t*t*p2->x;
+    cur.y = u*u*p0->y + 2*u*t*p1->y + t*t*p2->y;
+    shRecordLine(q, &prev, &cur, dir);
+    prev = cur;
+  }
+}
+
+/*-----------------------------------------------------------
+ * Records the edges of indexed triangles of the given
+ * geometry. If normalize is set every triangle is counted
+ * positively so that overlapping triangles form a union.
+ *-----------------------------------------------------------*/
+
+static void shRecordTriangles(SHRasterQueue *q, SHMatrix3x3 *m,
+                              struct geometry *g, SHint stride,
+                              SHfloat dir, SHint normalize)
+{
+  const float *vertices = kv_data(g->vertices);
+  SHVector2 v[3];
+  SHfloat d, area;
+  size_t i;
+  int k;
+
+  for (i=0; i+2<g->count; i+=3) {
+
+    for (k=0; k<3; ++k) {
+      const float *s = vertices + SH_GEOMETRY_INDEX(g, i+k) * stride;
+      v[k].x = m->m[0][0]*s[0] + m->m[0][1]*s[1] + m->m[0][2];
+      v[k].y = m->m[1][0]*s[0] + m->m[1][1]*s[1] + m->m[1][2];
+    }
+
+    d = dir;
+    if (normalize) {
+      area = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+             (v[2].x - v[0].x) * (v[1].y - v[0].y);
+      if (area < 0.0f) d = -d;
+    }
+
+    shRecordLine(q, &v[0], &v[1], d);
+    shRecordLine(q, &v[1], &v[2], d);
+    shRecordLine(q, &v[2], &v[0], d);
+  }
+}
+
+/*-----------------------------------------------------------
+ * Records the area between each quadratic curve and its
+ * chord. Vertices carry (u,v) = (0,0) at the start point,
+ * (1,1) at the end point and (0.5,0) at the control point.
+ *-----------------------------------------------------------*/
+
+static void shRecordQuadHulls(SHRasterQueue *q, SHMatrix3x3 *m,
+                              struct geometry *g)
+{
+  const float *vertices = kv_data(g->vertices);
+  SHVector2 v[3];
+  size_t i;
+  int k, k0, k1, k2;
+
+  for (i=0; i+2<g->count; i+=3) {
+
+    k0 = 0; k1 = 1; k2 = 2;
+    for (k=0; k<3; ++k) {
+      const float *s = vertices + SH_GEOMETRY_INDEX(g, i+k) * 4;
+      v[k].x = m->m[0][0]*s[0] + m->m[0][1]*s[1] + m->m[0][2];
+      v[k].y = m->m[1][0]*s[0] + m->m[1][1]*s[1] + m->m[1][2];
+      if (s[2] == 0.0f) k0 = k;
+      else if (s[2] == 1.0f) k2 = k;
+      else k1 = k;
+    }
+
+    shRecordQuad(q, &v[k0], &v[k1], &v[k2], 1.0f);
+    shRecordLine(q, &v[k2], &v[k0], 1.0f);
+  }
+}
+
+/*-----------------------------------------------------------
+ * Records the curved stroke pieces. Each one holds the curve
+ * coefficients A, B, C in its vertex data and an oriented
+ * bounding box in the vertex positions.
+ *-----------------------------------------------------------*/
+
+static void shRecordStrokeQuads(SHRasterQueue *q, SHMatrix3x3 *m,
+                                struct geometry *g)
+{
+  const float *vertices = kv_data(g->vertices);
+  SHStrokeQuad sq;
+  SHfloat minx, miny, maxx, maxy;
+  SHVector2 v, dv;
+  size_t i;
+  int k;
+
+  for (i=0; i+5<g->count; i+=6) {
+
+    const float *s = vertices + SH_GEOMETRY_INDEX(g, i) * 12;
+
+    for (k=0; k<4; ++k) {
+      SET2(v, s[k*12], s[k*12+1]);
+      TRANSFORM2TO(v, (*m), dv);
+      if (k == 0) { minx = maxx = dv.x; miny = maxy = dv.y; }
+      minx = SH_MIN(minx, dv.x); maxx = SH_MAX(maxx, dv.x);
+      miny = SH_MIN(miny, dv.y); maxy = SH_MAX(maxy, dv.y);
+    }
+
+    sq.rect[0] = (SHint)SH_FLOOR(minx);
+    sq.rect[1] = (SHint)SH_FLOOR(miny);
+    sq.rect[2] = (SHint)SH_CEIL(maxx);
+    sq.rect[3] = (SHint)SH_CEIL(maxy);
+    sq.A[0] = s[4]; sq.A[1] = s[5];
+    sq.B[0] = s[6]; sq.B[1] = s[7];
+    sq.C[0] = s[8]; sq.C[1] = s[9];
+    kv_push_back(q->quads, sq);
+  }
+}
+
+/*-----------------------------------------------------------
+ * Records the fill geometry of the path
+ *-----------------------------------------------------------*/
+
+void shRasterizeFill(VGContext *c, SHPath *p, SHPaint *paint)
+{
+  SHRasterCommand *cmd;
+  SHMatrix3x3 *m = &c->pathTransform;
+  SHRasterQueue *q;
+  SHint r[4];
+
+  if (!shDeviceRect(c, p->fill_bounds, m, r)) return;
+  if (!(cmd = shBeginCommand(c, SH_RASTER_PATH, r))) {
+    shSetError(c, VG_OUT_OF_MEMORY_ERROR);
+    return;
+  }
+
+  q = c->rasterQueue;
+  cmd->rule = c->fillRule;
+  if (!shSetupPaintState(&cmd->paint, q, c, paint, m, &c->fillTransform)) {
+    shCancelCommand(c);
+    return;
+  }
+
+  /* Fan triangles, the back-facing ones are stored reversed */
+  shRecordTriangles(q, m, &p->fill_geoms[0], 4, 1.0f, 0);
+  shRecordTriangles(q, m, &p->fill_geoms[1], 4, -1.0f, 0);
+
+  /* Curved parts between the fan and the outline */
+  shRecordQuadHulls(q, m, &p->fill_geoms[2]);
+  shRecordQuadHulls(q, m, &p->fill_geoms[3]);
+
+  shEndCommand(c);
+}
+
+/*-----------------------------------------------------------
+ * Records the stroke geometry of the path
+ *-----------------------------------------------------------*/
+
+void shRasterizeStroke(VGContext *c, SHPath *p, SHPaint *paint)
+{
+  SHRasterCommand *cmd;
+  SHMatrix3x3 *m = &c->pathTransform;
+  SHRasterQueue *q;
+  SHint r[4];
+
+  if (!shDeviceRect(c, p->stroke_bounds, m, r)) return;
+  if (!(cmd = shBeginCommand(c, SH_RASTER_PATH, r))) {
+    shSetError(c, VG_OUT_OF_MEMORY_ERROR);
+    return;
+  }
+
+  q = c->rasterQueue;
+  if (!shSetupPaintState(&cmd->paint, q, c, paint, m, &c->strokeTransform) ||
+      !shInvertMatrix(m, &cmd->inv)) {
+    shCancelCommand(c);
+    return;
+  }
+
+  cmd->halfWidth = p->stroke_width * 0.5f;
+  cmd->scale = SH_SQRT(SH_ABS((m->m[0][0]*m->m[1][1] - m->m[0][1]*m->m[1][0])));
+
+  /* Union of the straight pieces and joins */
+  shRecordTriangles(q, m, &p->stroke_geoms[0], 2, 1.0f, 1);
+
+  /* Curved pieces are covered by their distance to the curve */
+  shRecordStrokeQuads(q, m, &p->stroke_geoms[1]);
+
+  shEndCommand(c);
+}
+
+/*-----------------------------------------------------------
+ * Records an image draw through the (possibly projective)
+ * image transformation
+ *-----------------------------------------------------------*/
+
+void shRasterizeImage(VGContext *c, SHImage *img)
+{
+  SHMatrix3x3 *m = &c->imageTransform, mi, affine;
+  SHRasterCommand *cmd;
+  SHPaint *fill;
+  SHfloat corners[4][2], w, minx, miny, maxx, maxy, X, Y;
+  SHint r[4], k, projective = 0;
+
+  if (!shInvertMatrix(m, &mi)) return;
+
+  /* Device bounds of the image corners */
+  corners[0][0] = 0.0f;               corners[0][1] = 0.0f;
+  corners[1][0] = (SHfloat)img->width; corners[1][1] = 0.0f;
+  corners[2][0] = (SHfloat)img->width; corners[2][1] = (SHfloat)img->height;
+  corners[3][0] = 0.0f;               corners[3][1] = (SHfloat)img->height;
+
+  minx = miny = 1e30f; maxx = maxy = -1e30f;
+  for (k=0; k<4; ++k) {
+    w = m->m[2][0]*corners[k][0] + m->m[2][1]*corners[k][1] + m->m[2][2];
+    if (w <= 0.0f) { projective = 1; break; }
+    X = (m->m[0][0]*corners[k][0] + m->m[0][1]*corners[k][1] + m->m[0][2]) / w;
+    Y = (m->m[1][0]*corners[k][0] + m->m[1][1]*corners[k][1] + m->m[1][2]) / w;
+    minx = SH_MIN(minx, X); maxx = SH_MAX(maxx, X);
+    miny = SH_MIN(miny, Y); maxy = SH_MAX(maxy, Y);
+  }
+
+  if (projective) {
+    /* Image crosses the horizon, walk the whole surface */
+    r[0] = 0; r[1] = 0;
+    r[2] = c->surfaceWidth; r[3] = c->surfaceHeight;
+  }else{
+    r[0] = (SHint)SH_FLOOR(minx); r[1] = (SHint)SH_FLOOR(miny);
+    r[2] = (SHint)SH_CEIL(maxx);  r[3] = (SHint)SH_CEIL(maxy);
+  }
+  if (!shClipRect(c, r)) return;
+
+  if (!(cmd = shBeginCommand(c, SH_RASTER_IMAGE, r))) {
+    shSetError(c, VG_OUT_OF_MEMORY_ERROR);
+    return;
+  }
+
+  cmd->image = img;
+  cmd->inv = mi;
+
+  /* Paint is evaluated in image user space when multiplying
+     or stenciling */
+  fill = (c->fillPaint ? c->fillPaint : &c->defaultPaint);
+  cmd->usePaint = (c->imageMode != VG_DRAW_IMAGE_NORMAL);
+  cmd->stencil = (c->imageMode == VG_DRAW_IMAGE_STENCIL);
+  if (cmd->usePaint) {
+    SETMAT(affine, m->m[0][0], m->m[0][1], m->m[0][2],
+                   m->m[1][0], m->m[1][1], m->m[1][2],
+                   0.0f, 0.0f, 1.0f);
+    if (!shSetupPaintState(&cmd->paint, c->rasterQueue, c, fill,
+                           &affine, &c->fillTransform)) {
+      shCancelCommand(c);
+      return;
+    }
+  }
+
+  shEndCommand(c);
+}
+
+/*-----------------------------------------------------------
+ * Records filling a rectangle with the clear color
+ *-----------------------------------------------------------*/
+
+void shClearSurface(VGContext *c, SHint x, SHint y,
+                    SHint width, SHint height)
+{
+  SHRasterCommand *cmd;
+  SHColor col = c->clearColor;
+  SHint r[4];
+
+  r[0] = x; r[1] = y;
+  r[2] = x + width; r[3] = y + height;
+  if (!shClipRect(c, r)) return;
+
+  if (!(cmd = shBeginCommand(c, SH_RASTER_CLEAR, r))) {
+    shSetError(c, VG_OUT_OF_MEMORY_ERROR);
+    return;
+  }
+
+  shClampColor(&col);
+  CPREMUL(col);
+  cmd->pixel = SH_PACK_RGBA((SHuint32)(col.r * 255.0f + 0.5f),
+                            (SHuint32)(col.g * 255.0f + 0.5f),
+                            (SHuint32)(col.b * 255.0f + 0.5f),
+                            (SHuint32)(col.a * 255.0f + 0.5f));
+  shEndCommand(c);
+}
+
+/*-----------------------------------------------------------
+ * Command execution on a rectangle inside a single tile
+ *-----------------------------------------------------------*/
+
+static void shRunPath(SHRasterQueue *q, const SHRasterCommand *cmd,
+                      SHint r[4], SHRasterScratch *scratch)
+{
+  const SHEdge *e = kv_data(q->edges) + cmd->firstEdge;
+  SHCoverage cv;
+  size_t i;
+
+  cv.x = r[0]; cv.w = r[2] - r[0];
+  cv.y = r[1]; cv.h = r[3] - r[1];
+  cv.acc = scratch->acc;
+  cv.cov = scratch->cov;
+
+  for (i=0; i<cmd->edgeCount; ++i, ++e) {
+
+    /* Edges left of the tile still carry winding */
+    if (e->x0 >= r[2] && e->x1 >= r[2]) continue;
+    if (e->y0 <= r[1] && e->y1 <= r[1]) continue;
+    if (e->y0 >= r[3] && e->y1 >= r[3]) continue;
+
+    shAccumulateLine(&cv, e->x0, e->y0, e->x1, e->y1, e->dir);
+  }
+
+  shResolveCoverage(&cv, cmd->rule, cmd->quality);
+
+  if (cmd->quadCount > 0)
+    shCoverQuadStrokes(&cv, cmd, kv_data(q->quads) + cmd->firstQuad);
+
+  shCompositeCoverage(q->context, &cv, cmd);
+}
+
+static void shRunImage(SHRasterQueue *q, const SHRasterCommand *cmd,
+                       SHint r[4])
+{
+  VGContext *c = q->context;
+  const SHMatrix3x3 *mi = &cmd->inv;
+  SHImage *img = cmd->image;
+  SHfloat X, Y, w, u, v;
+  SHColor s, pc;
+  SHint x, y, ix, iy;
+  SHuint32 *dst;
+
+  for (y=r[1]; y<r[3]; ++y) {
+
+    dst = c->surfaceData + y * c->surfaceWidth;
+
+    for (x=r[0]; x<r[2]; ++x) {
+
+      X = x + 0.5f; Y = y + 0.5f;
+      w = mi->m[2][0]*X + mi->m[2][1]*Y + mi->m[2][2];
+      if (w <= 0.0f) continue;
+      u = (mi->m[0][0]*X + mi->m[0][1]*Y + mi->m[0][2]) / w;
+      v = (mi->m[1][0]*X + mi->m[1][1]*Y + mi->m[1][2]) / w;
+
+      if (u < 0.0f || v < 0.0f) continue;
+      ix = (SHint)u; iy = (SHint)v;
+      if (ix >= img->width || iy >= img->height) continue;
+
+      shImageColor(img, ix, iy, &s);
+
+      if (cmd->stencil) {
+        shPaintColor(&cmd->paint, X, Y, &pc);
+        shBlendStencilPixel(cmd->blend, &s, &pc, &dst[x]);
+        continue;
+      }
+
+      if (cmd->usePaint) {
+        shPaintColor(&cmd->paint, X, Y, &pc);
+        s.r *= pc.r; s.g *= pc.g; s.b *= pc.b; s.a *= pc.a;
+      }
+
+      shBlendPixel(cmd->blend, &s, 1.0f, &dst[x]);
+    }
+  }
+}
+
+static void shRunClear(SHRasterQueue *q, const SHRasterCommand *cmd,
+                       SHint r[4])
+{
+  VGContext *c = q->context;
+  SHuint32 *dst;
+  SHint x, y;
+
+  for (y=r[1]; y<r[3]; ++y) {
+    dst = c->surfaceData + y * c->surfaceWidth;
+    for (x=r[0]; x<r[2]; ++x)
+      dst[x] = cmd->pixel;
+  }
+}
+
+/*-----------------------------------------------------------
+ * Runs all the commands binned to the given tile in order
+ *-----------------------------------------------------------*/
+
+static void shRunTile(SHRasterQueue *q, SHint tile, SHRasterScratch *scratch)
+{
+  VGContext *c = q->context;
+  SHTileBin *bin = &q->bins[tile];
+  const SHRasterCommand *cmd;
+  SHint tr[4], r[4];
+  size_t i;
+
+  tr[0] = (tile % q->tilesX) * q->tileSize;
+  tr[1] = (tile / q->tilesX) * q->tileSize;
+  tr[2] = SH_MIN(tr[0] + q->tileSize, c->surfaceWidth);
+  tr[3] = SH_MIN(tr[1] + q->tileSize, c->surfaceHeight);
+
+  for (i=0; i<kv_size(*bin); ++i) {
+
+    cmd = &kv_a(q->commands, kv_a(*bin, i));
+    r[0] = SH_MAX(tr[0], cmd->rect[0]);
+    r[1] = SH_MAX(tr[1], cmd->rect[1]);
+    r[2] = SH_MIN(tr[2], cmd->rect[2]);
+    r[3] = SH_MIN(tr[3], cmd->rect[3]);
+
+    switch (cmd->type) {
+    case SH_RASTER_PATH:
+      shRunPath(q, cmd, r, scratch); break;
+    case SH_RASTER_IMAGE:
+      shRunImage(q, cmd, r); break;
+    default:
+      shRunClear(q, cmd, r); break;
+    }
+  }
+}
+
+/*-----------------------------------------------------------
+ * Rasterizes one tile on the given worker thread
+ *-----------------------------------------------------------*/
+
+static void shRunTileTask(void *data, SHint tile, SHint worker)
+{
+  SHRasterQueue *q = (SHRasterQueue*)data;
+  SHRasterScratch *scratch = &q->scratch[worker];
+  SHint size = q->tileSize;
+
+  /* Coverage buffers for the largest tile */
+  if (scratch->size != size) {
+    free(scratch->acc); free(scratch->cov);
+    scratch->acc = (SHfloat*)calloc((size + 2) * size, sizeof(SHfloat));
+    scratch->cov = (SHfloat*)malloc(size * size * sizeof(SHfloat));
+    if (!scratch->acc || !scratch->cov) {
+      free(scratch->acc); free(scratch->cov);
+      scratch->acc = NULL; scratch->cov = NULL;
+      scratch->size = 0;
+      scratch->failed = 1;
+      return;
+    }
+    scratch->size = size;
+  }
+
+  shRunTile(q, tile, scratch);
+}
+
+static void shResetQueue(SHRasterQueue *q)
+{
+  SHint i;
+
+  for (i=0; i<(SHint)kv_size(q->ramps); ++i)
+    free(kv_a(q->ramps, i));
+
+  for (i=0; i<q->tilesX * q->tilesY; ++i)
+    kv_clear(q->bins[i]);
+
+  kv_clear(q->commands);
+  kv_clear(q->edges);
+  kv_clear(q->quads);
+  kv_clear(q->ramps);
+}
+
+/*-----------------------------------------------------------
+ * Executes all the recorded commands on the framebuffer
+ *-----------------------------------------------------------*/
+
+void shFlushRaster(VGContext *c)
+{
+  SHRasterQueue *q = c->rasterQueue;
+  SHint i, failed = 0;
+
+  if (!q || kv_empty(q->commands)) return;
+
+  shParallelFor(shGetThreadPool(c), shThreadCount(c->rasterThreads),
+                q->tilesX * q->tilesY, shRunTileTask, q);
+
+  /* Workers only flag their own scratch, report once here */
+  for (i=0; i<SH_MAX_THREADS; ++i) {
+    if (q->scratch[i].failed) {
+      q->scratch[i].failed = 0;
+      failed = 1;
+    }
+  }
+  if (failed) shSetError(c, VG_OUT_OF_MEMORY_ERROR);
+
+  shResetQueue(q);
+}
+
+static void shDeleteRasterQueue(VGContext *c)
+{
+  SHRasterQueue *q = c->rasterQueue;
+  SHint i;
+
+  if (!q) return;
+
+  shResetQueue(q);
+
+  for (i=0; i<q->tilesX * q->tilesY; ++i)
+    kv_free(q->bins[i]);
+  free(q->bins);
+
+  kv_free(q->commands);
+  kv_free(q->edges);
+  kv_free(q->quads);
+  kv_free(q->ramps);
+
+  for (i=0; i<SH_MAX_THREADS; ++i) {
+    free(q->scratch[i].acc);
+    free(q->scratch[i].cov);
+  }
+
+  free(q);
+
+  c->rasterQueue = NULL;
+}
+
+/*-----------------------------------------------------------
+ * Reads a rectangle of the framebuffer into a new buffer of
+ * non-premultiplied VG_sRGBA_8888 pixels. Pixels outside the
+ * surface are returned as zero.
+ *-----------------------------------------------------------*/
+
+SHuint8* shReadSurfacePixels(VGContext *c, SHint sx, SHint sy,
+                             SHint width, SHint height)
+{
+  SHuint32 *out, *row;
+  SHint x0, x1, Y, y;
+
+  shFlushRaster(c);
+
+  out = (SHuint32*)calloc((size_t)width * height, sizeof(SHuint32));
+  if (!out) return NULL;
+  if (!c->surfaceData) return (SHuint8*)out;
+
+  /* Span of the rows inside the surface */
+  x0 = SH_MAX(sx, 0);
+  x1 = SH_MIN(sx + width, c->surfaceWidth);
+  if (x0 >= x1) return (SHuint8*)out;
+
+  shInitColorTables();
+
+  for (Y=0; Y<height; ++Y) {
+    y = sy + Y;
+    if (y < 0 || y >= c->surfaceHeight) continue;
+
+    row = out + Y * width + (x0 - sx);
+    memcpy(row, c->surfaceData + y * c->surfaceWidth + x0,
+           (x1 - x0) * sizeof(SHuint32));
+    shUnpremultiplyRow(row, x1 - x0);
+  }
+
+  return (SHuint8*)out;
+}
+
+/*-----------------------------------------------------------
+ * Writes a rectangle of non-premultiplied VG_sRGBA_8888
+ * pixels into the framebuffer
+ *-----------------------------------------------------------*/
+
+void shWriteSurfacePixels(VGContext *c, const SHuint8 *pixels,
+                          SHint dx, SHint dy, SHint width, SHint height)
+{
+  const SHuint32 *src = (const SHuint32*)pixels;
+  SHuint32 *row;
+  SHint x0, x1, Y, y;
+
+  shFlushRaster(c);
+  if (!c->surfaceData) return;
+
+  /* Span of the rows inside the surface */
+  x0 = SH_MAX(dx, 0);
+  x1 = SH_MIN(dx + width, c->surfaceWidth);
+  if (x0 >= x1) return;
+
+  for (Y=0; Y<height; ++Y) {
+    y = dy + Y;
+    if (y < 0 || y >= c->surfaceHeight) continue;
+
+    row = c->surfaceData + y * c->surfaceWidth + x0;
+    memcpy(row, src + Y * width + (x0 - dx), (x1 - x0) * sizeof(SHuint32));
+    shPremultiplyRow(row, x1 - x0);
+  }
+}
+
+/*-----------------------------------------------------------
+ * Copies a rectangle of the framebuffer onto itself. Only
+ * pixels whose source and destination are both inside the
+ * surface get copied.
+ *-----------------------------------------------------------*/
+
+void shCopySurfacePixels(VGContext *c, SHint dx, SHint dy,
+                         SHint sx, SHint sy, SHint width, SHint height)
+{
+  SHint k, Y;
+
+  shFlushRaster(c);
+  if (!c->surfaceData) return;
+
+  /* Clip source and destination against the surface */
+  if (sx < 0) { k = -sx; sx += k; dx += k; width -= k; }
+  if (dx < 0) { k = -dx; sx += k; dx += k; width -= k; }
+  if (sy < 0) { k = -sy; sy += k; dy += k; height -= k; }
+  if (dy < 0) { k = -dy; sy += k; dy += k; height -= k; }
+  width = SH_MIN(width, c->surfaceWidth - SH_MAX(sx, dx));
+  height = SH_MIN(height, c->surfaceHeight - SH_MAX(sy, dy));
+  if (width <= 0 || height <= 0) return;
+
+  /* Walk rows away from the overlap */
+  if (dy <= sy) {
+    for (Y=0; Y<height; ++Y)
+      memmove(c->surfaceData + (dy+Y) * c->surfaceWidth + dx,
+              c->surfaceData + (sy+Y) * c->surfaceWidth + sx,
+              width * sizeof(SHuint32));
+  }else{
+    for (Y=height-1; Y>=0; --Y)
+      memmove(c->surfaceData + (dy+Y) * c->surfaceWidth + dx,
+              c->surfaceData + (sy+Y) * c->surfaceWidth + sx,
+              width * sizeof(SHuint32));
+  }
+}
+
+#endif /* RENDERING_ENGINE == SOFTWARE */
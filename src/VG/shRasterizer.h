@@ -0,0 +1,47 @@
+#ifndef __SHRASTERIZER_H
+#define __SHRASTERIZER_H
+
+#include "shDefs.h"
+#include "shContext.h"
+
+#if RENDERING_ENGINE == SOFTWARE
+
+/*-----------------------------------------------------------
+ * The software engine renders into a CPU framebuffer held
+ * by the context. Pixels are premultiplied and packed like
+ * VG_sRGBA_8888 (red in the most significant byte), rows
+ * are stored bottom-up to match the OpenVG surface origin.
+ *
+ * Drawing only records commands binned by screen tiles. They
+ * are executed by shFlushRaster on a pool of threads, which
+ * is done implicitly before the framebuffer is accessed.
+ *-----------------------------------------------------------*/
+
+#define SH_PACK_RGBA(r,g,b,a) \
+  (((SHuint32)(r) << 24) | ((SHuint32)(g) << 16) | \
+   ((SHuint32)(b) << 8)  |  (SHuint32)(a))
+
+int  shResizeSurface(VGContext *c, SHint width, SHint height);
+void shDeleteSurface(VGContext *c);
+
+void shClearSurface(VGContext *c, SHint x, SHint y,
+                    SHint width, SHint height);
+
+SHuint8* shReadSurfacePixels(VGContext *c, SHint sx, SHint sy,
+                             SHint width, SHint height);
+
+void shWriteSurfacePixels(VGContext *c, const SHuint8 *pixels,
+                          SHint dx, SHint dy, SHint width, SHint height);
+
+void shCopySurfacePixels(VGContext *c, SHint dx, SHint dy,
+                         SHint sx, SHint sy, SHint width, SHint height);
+
+void shRasterizeFill(VGContext *c, SHPath *p, SHPaint *paint);
+void shRasterizeStroke(VGContext *c, SHPath *p, SHPaint *paint);
+void shRasterizeImage(VGContext *c, SHImage *i);
+
+void shFlushRaster(VGContext *c);
+
+#endif /* RENDERING_ENGINE == SOFTWARE */
+
+#endif /* __SHRASTERIZER_H */
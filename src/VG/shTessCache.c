@@ -0,0 +1,333 @@
+#include <VG/openvg.h>
+#include "shTessCache.h"
+#include "shGeometry.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+struct SHTessCache
+{
+  pthread_mutex_t lock;
+  SHPathLOD *head;
+  SHPathLOD *tail;
+  SHint bytes;
+  SHint budget;
+
+  /* Statistics */
+  SHint hits;
+  SHint misses;
+  SHint evictions;
+};
+
+SHTessCache* shCreateTessCache(void)
+{
+  SHTessCache *cache;
+
+  cache = (SHTessCache*)calloc(1, sizeof(SHTessCache));
+  if (!cache) return NULL;
+
+  pthread_mutex_init(&cache->lock, NULL);
+  cache->budget = SH_TESS_CACHE_BUDGET;
+  return cache;
+}
+
+static SHint shGeometryBytes(struct geometry *g)
+{
+  return (SHint)(g->vertices.m * sizeof(float) +
+                 g->indices.m * sizeof(unsigned short) +
+                 g->wide_indices.m * sizeof(unsigned int));
+}
+
+static SHint shLODBytes(SHPathLOD *lod)
+{
+  SHint bytes = sizeof(SHPathLOD);
+  size_t i;
+
+  bytes += (SHint)(lod->reduced_paths.m * sizeof(struct reduced_path));
+  for (i=0; i<kv_size(lod->reduced_paths); ++i) {
+    bytes += (SHint)kv_a(lod->reduced_paths, i).commands.m;
+    bytes += (SHint)(kv_a(lod->reduced_paths, i).coords.m * sizeof(float));
+  }
+
+  for (i=0; i<4; ++i) bytes += shGeometryBytes(&lod->fill_geoms[i]);
+  for (i=0; i<2; ++i) bytes += shGeometryBytes(&lod->stroke_geoms[i]);
+  return bytes;
+}
+
+static void shFreeLOD(SHPathLOD *lod)
+{
+  size_t i;
+
+  for (i=0; i<kv_size(lod->reduced_paths); ++i) {
+    kv_free(kv_a(lod->reduced_paths, i).commands);
+    kv_free(kv_a(lod->reduced_paths, i).coords);
+  }
+  kv_free(lod->reduced_paths);
+
+  shFreeGeometrySet(lod->fill_geoms, 4);
+  shFreeGeometrySet(lod->stroke_geoms, 2);
+
+  free(lod->strokeDash);
+  free(lod);
+}
+
+/*-----------------------------------------------------------
+ * List maintenance. Called with the cache locked.
+ *-----------------------------------------------------------*/
+
+static void shLinkLOD(SHTessCache *cache, SHPathLOD *lod)
+{
+  lod->lruPrev = NULL;
+  lod->lruNext = cache->head;
+  if (cache->head) cache->head->lruPrev = lod;
+  else cache->tail = lod;
+  cache->head = lod;
+
+  lod->pathNext = lod->path->lods;
+  lod->path->lods = lod;
+
+  cache->bytes += lod->bytes;
+}
+
+static void shUnlinkLOD(SHTessCache *cache, SHPathLOD *lod)
+{
+  SHPathLOD **link = &lod->path->lods;
+
+  if (lod->lruPrev) lod->lruPrev->lruNext = lod->lruNext;
+  else cache->head = lod->lruNext;
+  if (lod->lruNext) lod->lruNext->lruPrev = lod->lruPrev;
+  else cache->tail = lod->lruPrev;
+
+  while (*link != lod) link = &(*link)->pathNext;
+  *link = lod->pathNext;
+
+  cache->bytes -= lod->bytes;
+}
+
+static void shEvictLODs(SHTessCache *cache)
+{
+  SHPathLOD *lod;
+
+  while (cache->bytes > cache->budget && cache->tail) {
+    lod = cache->tail;
+    shUnlinkLOD(cache, lod);
+    shFreeLOD(lod);
+    cache->evictions++;
+  }
+}
+
+/*-----------------------------------------------------------
+ * Moving the current level of detail of a path in and out
+ *-----------------------------------------------------------*/
+
+static void shTakePathLOD(SHPathLOD *lod, SHPath *p)
+{
+  int i;
+
+  lod->path = p;
+  lod->scale = p->cacheReduceScale;
+
+  lod->reduced_paths = p->reduced_paths;
+  kv_init(p->reduced_paths);
+
+  for (i=0; i<4; ++i) {
+    lod->fill_geoms[i] = p->fill_geoms[i];
+    lod->fill_bounds[i] = p->fill_bounds[i];
+    shInitGeometry(&p->fill_geoms[i]);
+  }
+  lod->fillValid = p->cacheFillGeometries;
+
+  for (i=0; i<2; ++i) {
+    lod->stroke_geoms[i] = p->stroke_geoms[i];
+    shInitGeometry(&p->stroke_geoms[i]);
+  }
+  for (i=0; i<4; ++i)
+    lod->stroke_bounds[i] = p->stroke_bounds[i];
+
+  lod->strokeValid = (p->cacheStrokeInit == VG_TRUE &&
+                      p->cacheStrokeTessValid == VG_TRUE);
+  lod->strokeLineWidth = p->cacheStrokeLineWidth;
+  lod->strokeCapStyle = p->cacheStrokeCapStyle;
+  lod->strokeJoinStyle = p->cacheStrokeJoinStyle;
+  lod->strokeMiterLimit = p->cacheStrokeMiterLimit;
+  lod->strokeDashHash = p->cacheStrokeDashHash;
+  lod->strokeDashCount = p->cacheStrokeDashCount;
+  lod->strokeDashPhase = p->cacheStrokeDashPhase;
+  lod->strokeDashPhaseReset = p->cacheStrokeDashPhaseReset;
+  lod->strokeDash = NULL;
+  if (lod->strokeValid && lod->strokeDashCount > 0) {
+    lod->strokeDash = (SHfloat*)malloc(lod->strokeDashCount * sizeof(SHfloat));
+    if (lod->strokeDash)
+      memcpy(lod->strokeDash, p->cacheStrokeDash,
+             lod->strokeDashCount * sizeof(SHfloat));
+    else
+      lod->strokeValid = VG_FALSE;
+  }
+
+  lod->bytes = shLODBytes(lod);
+
+  p->cacheReducedPaths = VG_FALSE;
+  p->cacheFillGeometries = VG_FALSE;
+  p->cacheStrokeTessValid = VG_FALSE;
+}
+
+static int shIsLODDashEqual(SHPathLOD *lod, SHPath *p)
+{
+  if (lod->strokeDashCount != p->cacheStrokeDashCount) return 0;
+  if (lod->strokeDashCount == 0) return 1;
+
+  return (lod->strokeDashPhase == p->cacheStrokeDashPhase &&
+          lod->strokeDashPhaseReset == p->cacheStrokeDashPhaseReset &&
+          memcmp(lod->strokeDash, p->cacheStrokeDash,
+                 lod->strokeDashCount * sizeof(SHfloat)) == 0);
+}
+
+static void shGivePathLOD(SHPathLOD *lod, SHPath *p)
+{
+  int i;
+
+  p->cacheReduceScale = lod->scale;
+  p->cacheReducedPaths = VG_TRUE;
+
+  shDeletePathGeometry(p);
+  p->reduced_paths = lod->reduced_paths;
+
+  for (i=0; i<4; ++i) {
+    p->fill_geoms[i] = lod->fill_geoms[i];
+    p->fill_bounds[i] = lod->fill_bounds[i];
+  }
+  p->cacheFillGeometries = lod->fillValid;
+
+  /* The stroke only holds while the path is stroked the
+     same way as when it was parked */
+  for (i=0; i<2; ++i)
+    p->stroke_geoms[i] = lod->stroke_geoms[i];
+  for (i=0; i<4; ++i)
+    p->stroke_bounds[i] = lod->stroke_bounds[i];
+
+  p->cacheStrokeTessValid =
+    (lod->strokeValid == VG_TRUE &&
+     p->cacheStrokeInit == VG_TRUE &&
+     p->cacheStrokeLineWidth == lod->strokeLineWidth &&
+     p->cacheStrokeCapStyle == lod->strokeCapStyle &&
+     p->cacheStrokeJoinStyle == lod->strokeJoinStyle &&
+     p->cacheStrokeMiterLimit == lod->strokeMiterLimit &&
+     p->cacheStrokeDashHash == lod->strokeDashHash &&
+     shIsLODDashEqual(lod, p)) ? VG_TRUE : VG_FALSE;
+
+  free(lod->strokeDash);
+  lod->strokeDash = NULL;
+}
+
+/*-----------------------------------------------------------
+ * Parks the current level of detail of the path and brings
+ * in the coarsest cached one usable at the given scale.
+ * Returns 1 on a hit; on a miss the path is left without
+ * reduced data to be built for the scale.
+ *-----------------------------------------------------------*/
+
+int shTessCacheSwap(SHTessCache *cache, SHPath *p, SHfloat scale)
+{
+  SHPathLOD *lod, *best = NULL;
+
+  if (!cache) {
+    shDeletePathGeometry(p);
+    p->cacheReducedPaths = VG_FALSE;
+    p->cacheFillGeometries = VG_FALSE;
+    p->cacheStrokeTessValid = VG_FALSE;
+    return 0;
+  }
+
+  pthread_mutex_lock(&cache->lock);
+
+  for (lod = p->lods; lod; lod = lod->pathNext)
+    if (SH_TESS_SCALE_USABLE(lod->scale, scale) &&
+        (!best || lod->scale < best->scale))
+      best = lod;
+
+  if (best) {
+    shUnlinkLOD(cache, best);
+    cache->hits++;
+  }else{
+    cache->misses++;
+  }
+
+  lod = (SHPathLOD*)malloc(sizeof(SHPathLOD));
+  if (lod) {
+    shTakePathLOD(lod, p);
+    shLinkLOD(cache, lod);
+    p->lodCache = cache;
+  }else{
+    shDeletePathGeometry(p);
+    p->cacheReducedPaths = VG_FALSE;
+    p->cacheFillGeometries = VG_FALSE;
+    p->cacheStrokeTessValid = VG_FALSE;
+  }
+
+  if (best) {
+    shGivePathLOD(best, p);
+    free(best);
+  }
+
+  shEvictLODs(cache);
+  pthread_mutex_unlock(&cache->lock);
+
+  return best != NULL;
+}
+
+/*-----------------------------------------------------------
+ * Releases the parked levels of a path, when its data
+ * changes or it is destroyed.
+ *-----------------------------------------------------------*/
+
+void shTessCacheDropPath(SHTessCache *cache, SHPath *p)
+{
+  SHPathLOD *lod;
+
+  if (!cache) return;
+
+  pthread_mutex_lock(&cache->lock);
+  while ((lod = p->lods) != NULL) {
+    shUnlinkLOD(cache, lod);
+    shFreeLOD(lod);
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
+
+void shTessCacheSetBudget(SHTessCache *cache, SHint bytes)
+{
+  if (!cache) return;
+
+  pthread_mutex_lock(&cache->lock);
+  cache->budget = bytes;
+  shEvictLODs(cache);
+  pthread_mutex_unlock(&cache->lock);
+}
+
+SHint shTessCacheGetBudget(SHTessCache *cache)
+{
+  return cache ? cache->budget : 0;
+}
+
+void shTessCacheGetStats(SHTessCache *cache, SHint *hits,
+                         SHint *misses, SHint *evictions)
+{
+  *hits = cache ? cache->hits : 0;
+  *misses = cache ? cache->misses : 0;
+  *evictions = cache ? cache->evictions : 0;
+}
+
+void shDeleteTessCache(SHTessCache *cache)
+{
+  SHPathLOD *lod;
+
+  if (!cache) return;
+
+  while ((lod = cache->head) != NULL) {
+    shUnlinkLOD(cache, lod);
+    shFreeLOD(lod);
+  }
+
+  pthread_mutex_destroy(&cache->lock);
+  free(cache);
+}
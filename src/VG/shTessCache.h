@@ -0,0 +1,72 @@
+#ifndef __SHTESSCACHE_H
+#define __SHTESSCACHE_H
+
+#include "shDefs.h"
+#include "shVectors.h"
+
+/*-----------------------------------------------------------
+ * Levels of detail of the path geometry built by the
+ * software engine. A path keeps the level of its current
+ * power-of-two reduce scale in place. Levels built for other
+ * scales are parked in a cache shared by all the paths of a
+ * context, which evicts the least recently used ones when
+ * they exceed the memory budget.
+ *
+ * A level serves any scale up to SH_TESS_CACHE_OVERSAMPLE
+ * times coarser than its own, so zooming is served from the
+ * nearest finer level before building a new one.
+ *-----------------------------------------------------------*/
+
+#define SH_TESS_CACHE_OVERSAMPLE 4.0f
+#define SH_TESS_CACHE_BUDGET     (32 * 1024 * 1024)
+
+#define SH_TESS_SCALE_USABLE(lodScale, scale) \
+  ((lodScale) >= (scale) && (lodScale) <= (scale) * SH_TESS_CACHE_OVERSAMPLE)
+
+struct SHPath;
+
+typedef struct SHPathLOD
+{
+  struct SHPath *path;
+  SHfloat scale;
+  SHint bytes;
+
+  reduced_path_vec reduced_paths;
+  struct geometry fill_geoms[4];
+  float fill_bounds[4];
+  VGboolean fillValid;
+
+  /* Stroke and the parameters it was built with */
+  struct geometry stroke_geoms[2];
+  float stroke_bounds[4];
+  VGboolean strokeValid;
+  SHfloat strokeLineWidth;
+  VGCapStyle strokeCapStyle;
+  VGJoinStyle strokeJoinStyle;
+  SHfloat strokeMiterLimit;
+  SHuint strokeDashHash;
+  SHfloat *strokeDash;
+  SHint strokeDashCount;
+  SHfloat strokeDashPhase;
+  VGboolean strokeDashPhaseReset;
+
+  struct SHPathLOD *lruPrev;   /* most recently used first */
+  struct SHPathLOD *lruNext;
+  struct SHPathLOD *pathNext;  /* levels of the same path */
+
+} SHPathLOD;
+
+typedef struct SHTessCache SHTessCache;
+
+SHTessCache* shCreateTessCache(void);
+void shDeleteTessCache(SHTessCache *cache);
+
+void shTessCacheSetBudget(SHTessCache *cache, SHint bytes);
+SHint shTessCacheGetBudget(SHTessCache *cache);
+void shTessCacheGetStats(SHTessCache *cache, SHint *hits,
+                         SHint *misses, SHint *evictions);
+
+int shTessCacheSwap(SHTessCache *cache, struct SHPath *p, SHfloat scale);
+void shTessCacheDropPath(SHTessCache *cache, struct SHPath *p);
+
+#endif /* __SHTESSCACHE_H */
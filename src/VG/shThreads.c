@@ -0,0 +1,204 @@
+#include "shThreads.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct
+{
+  struct SHThreadPool *pool;
+  pthread_t thread;
+  SHint index;
+  SHint generation;
+
+} SHWorker;
+
+struct SHThreadPool
+{
+  SHWorker *workers;
+  SHint workerCount;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t idle;
+  SHint generation;
+  SHint busy;
+  SHint quit;
+
+  /* Current job */
+  SHParallelFunc func;
+  void *data;
+  SHint count;
+  SHint next;
+  SHint running;
+};
+
+/*-----------------------------------------------------------
+ * Resolves a requested thread count. Zero or less picks one
+ * thread per processor. The processor count is queried once
+ * since sysconf reads it from the file system on every call.
+ *-----------------------------------------------------------*/
+
+static long shProcessorCount = 0;
+
+SHint shThreadCount(SHint requested)
+{
+  long n = requested;
+
+  if (n <= 0) {
+    if (shProcessorCount <= 0)
+      shProcessorCount = sysconf(_SC_NPROCESSORS_ONLN);
+    n = shProcessorCount;
+  }
+  if (n < 1) n = 1;
+  if (n > SH_MAX_THREADS) n = SH_MAX_THREADS;
+  return (SHint)n;
+}
+
+SHThreadPool* shCreateThreadPool(void)
+{
+  SHThreadPool *pool;
+
+  pool = (SHThreadPool*)calloc(1, sizeof(SHThreadPool));
+  if (!pool) return NULL;
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pthread_cond_init(&pool->idle, NULL);
+  return pool;
+}
+
+/*-----------------------------------------------------------
+ * Takes indices of the current job until all of them are
+ * taken. Called by the workers and the calling thread alike.
+ *-----------------------------------------------------------*/
+
+static void shRunJob(SHThreadPool *pool, SHint worker)
+{
+  SHint index;
+
+  for (;;) {
+    pthread_mutex_lock(&pool->lock);
+    index = pool->next++;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (index >= pool->count) break;
+    pool->func(pool->data, index, worker);
+  }
+}
+
+static void* shWorkerMain(void *arg)
+{
+  SHWorker *w = (SHWorker*)arg;
+  SHThreadPool *pool = w->pool;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+
+    while (w->generation == pool->generation && !pool->quit)
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    if (pool->quit) break;
+    w->generation = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    shRunJob(pool, w->index);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->busy == 0)
+      pthread_cond_signal(&pool->idle);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+static void shStopWorkers(SHThreadPool *pool)
+{
+  SHint i;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->quit = 1;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (i=0; i<pool->workerCount; ++i)
+    pthread_join(pool->workers[i].thread, NULL);
+
+  free(pool->workers);
+  pool->workers = NULL;
+  pool->workerCount = 0;
+  pool->quit = 0;
+}
+
+/*-----------------------------------------------------------
+ * Starts the given number of worker threads in addition to
+ * the calling thread. Fewer are used if creation fails.
+ *-----------------------------------------------------------*/
+
+static void shStartWorkers(SHThreadPool *pool, SHint count)
+{
+  SHint i;
+
+  if (count == pool->workerCount) return;
+  shStopWorkers(pool);
+  if (count == 0) return;
+
+  pool->workers = (SHWorker*)calloc(count, sizeof(SHWorker));
+  if (!pool->workers) return;
+
+  for (i=0; i<count; ++i) {
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i + 1;
+    pool->workers[i].generation = pool->generation;
+    if (pthread_create(&pool->workers[i].thread, NULL,
+                       shWorkerMain, &pool->workers[i]) != 0)
+      break;
+  }
+
+  pool->workerCount = i;
+}
+
+void shParallelFor(SHThreadPool *pool, SHint threads, SHint count,
+                   SHParallelFunc func, void *data)
+{
+  SHint i;
+
+  if (count <= 0) return;
+
+  /* Single-threaded, nested or without a pool */
+  if (!pool || pool->running || threads <= 1 || count == 1) {
+    for (i=0; i<count; ++i)
+      func(data, i, 0);
+    return;
+  }
+
+  shStartWorkers(pool, threads - 1);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->func = func;
+  pool->data = data;
+  pool->count = count;
+  pool->next = 0;
+  pool->running = 1;
+  pool->busy = pool->workerCount;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  shRunJob(pool, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->busy > 0)
+    pthread_cond_wait(&pool->idle, &pool->lock);
+  pool->running = 0;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void shDeleteThreadPool(SHThreadPool *pool)
+{
+  if (!pool) return;
+
+  shStopWorkers(pool);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->wake);
+  pthread_cond_destroy(&pool->idle);
+  free(pool);
+}
@@ -0,0 +1,32 @@
+#ifndef __SHTHREADS_H
+#define __SHTHREADS_H
+
+#include "shDefs.h"
+
+/*-----------------------------------------------------------
+ * Pool of worker threads shared by the CPU side of the
+ * implementation (software rasterization, path preparation).
+ *
+ * shParallelFor runs func once for every index in [0,count)
+ * on the calling thread plus up to threads-1 workers, and
+ * returns when all of them are done. Indices are handed out
+ * one at a time so uneven work balances itself. The worker
+ * argument is in [0,threads) and unique among the threads
+ * running concurrently, which allows per-thread scratch.
+ *-----------------------------------------------------------*/
+
+#define SH_MAX_THREADS 64
+
+typedef void (*SHParallelFunc) (void *data, SHint index, SHint worker);
+
+typedef struct SHThreadPool SHThreadPool;
+
+SHThreadPool* shCreateThreadPool(void);
+void shDeleteThreadPool(SHThreadPool *pool);
+
+SHint shThreadCount(SHint requested);
+
+void shParallelFor(SHThreadPool *pool, SHint threads, SHint count,
+                   SHParallelFunc func, void *data);
+
+#endif /* __SHTHREADS_H */
@@ -0,0 +1,252 @@
+#include <VG/openvg.h>
+#include "shTriangulate.h"
+#include <stdlib.h>
+
+typedef struct SHSweepEdge
+{
+  SHfloat x0, y0;   /* upper end */
+  SHfloat x1, y1;   /* lower end */
+  SHfloat dxdy;
+  SHint winding;    /* +1 when the contour runs down */
+  SHfloat x;        /* where the edges were last sorted */
+
+  /* Trapezoid open on the right of the edge */
+  struct SHSweepEdge *right;
+  SHfloat top;
+  SHint slab;
+} SHSweepEdge;
+
+static int shCompareEdgeTops(const void *a, const void *b)
+{
+  const SHSweepEdge *ea = (const SHSweepEdge*)a;
+  const SHSweepEdge *eb = (const SHSweepEdge*)b;
+  if (ea->y0 < eb->y0) return -1;
+  if (ea->y0 > eb->y0) return 1;
+  return 0;
+}
+
+/* Ends exactly on the end points keep shared vertices shared */
+static SHfloat shEdgeX(SHSweepEdge *e, SHfloat y)
+{
+  if (y <= e->y0) return e->x0;
+  if (y >= e->y1) return e->x1;
+  return e->x0 + (y - e->y0) * e->dxdy;
+}
+
+static int shAddTriangle(SHVector2Array *out, SHfloat ax, SHfloat ay,
+                         SHfloat bx, SHfloat by, SHfloat cx, SHfloat cy)
+{
+  SHVector2 *v;
+
+  if (out->size + 3 > out->capacity &&
+      !shVector2ArrayReserveAndCopy(out, out->capacity*2 + 48))
+    return 0;
+
+  v = &out->items[out->size];
+  SET2(v[0], ax, ay);
+  SET2(v[1], bx, by);
+  SET2(v[2], cx, cy);
+  out->size += 3;
+  return 1;
+}
+
+/* Closes the trapezoid open on the right of the edge at bottom */
+static int shCloseTrapezoid(SHVector2Array *out, SHSweepEdge *a, SHfloat bottom)
+{
+  SHSweepEdge *b = a->right;
+  SHfloat y = a->top;
+  SHfloat ax0 = shEdgeX(a, y), bx0 = shEdgeX(b, y);
+  SHfloat ax1 = shEdgeX(a, bottom), bx1 = shEdgeX(b, bottom);
+
+  a->right = NULL;
+
+  if (bx0 > ax0 &&
+      !shAddTriangle(out, ax0, y, bx0, y, bx1, bottom))
+    return 0;
+
+  if (bx1 > ax1 &&
+      !shAddTriangle(out, ax0, y, bx1, bottom, ax1, bottom))
+    return 0;
+
+  return 1;
+}
+
+static SHint shCollectEdges(SHPath *p, SHSweepEdge *edges)
+{
+  SHVertex *v;
+  SHSweepEdge *e;
+  SHint start, size, i, count = 0;
+  SHVector2 a, b;
+
+  for (start=0; start < p->vertices.size; start += size) {
+    size = p->vertices.items[start].flags;
+    if (size < 3) continue;
+    v = &p->vertices.items[start];
+
+    for (i=0; i<size; ++i) {
+      a = v[i].point;
+      b = v[i+1 < size ? i+1 : 0].point;
+
+      /* Horizontal edges do not change the winding */
+      if (!(a.y < b.y) && !(a.y > b.y)) continue;
+
+      e = &edges[count++];
+      e->winding = (a.y < b.y ? 1 : -1);
+      if (a.y > b.y) { SHVector2 t = a; a = b; b = t; }
+
+      e->x0 = a.x; e->y0 = a.y;
+      e->x1 = b.x; e->y1 = b.y;
+      e->dxdy = (b.x - a.x) / (b.y - a.y);
+      e->right = NULL;
+    }
+  }
+
+  return count;
+}
+
+/* Sorts the active edges by their x at y, then by slope,
+   and tells whether the order changed */
+static int shSortEdges(SHSweepEdge **active, SHint act, SHfloat y)
+{
+  SHSweepEdge *e;
+  SHint i, j, moved = 0;
+
+  for (i=0; i<act; ++i)
+    active[i]->x = shEdgeX(active[i], y);
+
+  /* The order barely changes between slabs */
+  for (i=1; i<act; ++i) {
+    e = active[i];
+    for (j=i; j>0 && (active[j-1]->x > e->x ||
+                      (active[j-1]->x == e->x &&
+                       active[j-1]->dxdy > e->dxdy)); --j)
+      active[j] = active[j-1];
+    if (j != i) { active[j] = e; moved = 1; }
+  }
+
+  return moved;
+}
+
+/* First crossing of neighbouring edges below y, sorted at ys */
+static SHfloat shFirstCrossing(SHSweepEdge **active, SHint act,
+                               SHfloat y, SHfloat ys, SHfloat bottom)
+{
+  SHSweepEdge *a, *b;
+  SHfloat cy;
+  SHint i;
+
+  for (i=1; i<act; ++i) {
+    a = active[i-1]; b = active[i];
+    if (a->dxdy == b->dxdy) continue;
+    cy = ys - (a->x - b->x) / (a->dxdy - b->dxdy);
+    if (cy > y && cy < bottom) bottom = cy;
+  }
+
+  return bottom;
+}
+
+/* Orders the active edges and returns where the slab has to
+   end for no two of them to cross within it. The first
+   crossing is always between neighbours. Edges meeting at y
+   may be ordered by rounding there, so the order is checked
+   again in the middle of the slab */
+static SHfloat shSortSlab(SHSweepEdge **active, SHint act,
+                          SHfloat y, SHfloat bottom)
+{
+  SHfloat mid, limit;
+  SHint pass;
+
+  shSortEdges(active, act, y);
+  bottom = shFirstCrossing(active, act, y, y, bottom);
+
+  for (pass=0; pass<16; ++pass) {
+    mid = 0.5f * (y + bottom);
+    if (!shSortEdges(active, act, mid)) break;
+    limit = shFirstCrossing(active, act, y, mid, bottom);
+    if (limit == bottom) break;
+    bottom = limit;
+  }
+
+  return bottom;
+}
+
+int shTriangulatePath(SHPath *p, VGFillRule rule, SHVector2Array *out)
+{
+  SHSweepEdge *edges, **active, *e, *spanStart;
+  SHint count, next = 0, act = 0, slab = 0;
+  SHint i, j, w, inside, ok = 1;
+  SHfloat y = 0.0f, bottom;
+
+  shVector2ArrayClear(out);
+  if (p->vertices.size < 3) return 1;
+
+  edges = (SHSweepEdge*)malloc(p->vertices.size * sizeof(SHSweepEdge));
+  active = (SHSweepEdge**)malloc(p->vertices.size * sizeof(SHSweepEdge*));
+  if (!edges || !active) {
+    free(edges); free(active);
+    return 0;
+  }
+
+  count = shCollectEdges(p, edges);
+  qsort(edges, count, sizeof(SHSweepEdge), shCompareEdgeTops);
+
+  while (ok && (next < count || act > 0)) {
+
+    if (act == 0) y = edges[next].y0;
+
+    /* Drop the edges above the slab, take in the new ones */
+    for (i=0, j=0; i<act; ++i) {
+      e = active[i];
+      if (e->y1 > y) active[j++] = e;
+      else if (e->right) ok &= shCloseTrapezoid(out, e, y);
+    }
+    act = j;
+
+    while (next < count && edges[next].y0 <= y)
+      active[act++] = &edges[next++];
+
+    if (act == 0) continue;
+
+    /* The slab ends at the next vertex or crossing */
+    bottom = (next < count ? edges[next].y0 : active[0]->y1);
+    for (i=0; i<act; ++i)
+      if (active[i]->y1 < bottom) bottom = active[i]->y1;
+
+    bottom = shSortSlab(active, act, y, bottom);
+
+    /* Spans inside the fill extend the trapezoids open
+       between the same two edges, or open new ones */
+    ++slab;
+    spanStart = NULL;
+
+    for (i=0, w=0; i<act && ok; ++i) {
+      e = active[i];
+      w += e->winding;
+      inside = (rule == VG_EVEN_ODD ? (w & 1) : w != 0);
+
+      if (inside && !spanStart) {
+        spanStart = e;
+      }else if (!inside && spanStart) {
+        if (spanStart->right != e) {
+          if (spanStart->right) ok &= shCloseTrapezoid(out, spanStart, y);
+          spanStart->right = e;
+          spanStart->top = y;
+        }
+        spanStart->slab = slab;
+        spanStart = NULL;
+      }
+    }
+
+    for (i=0; i<act && ok; ++i) {
+      e = active[i];
+      if (e->right && e->slab != slab)
+        ok &= shCloseTrapezoid(out, e, y);
+    }
+
+    y = bottom;
+  }
+
+  free(edges);
+  free(active);
+  return ok;
+}
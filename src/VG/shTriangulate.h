@@ -0,0 +1,20 @@
+#ifndef __SHTRIANGULATE_H
+#define __SHTRIANGULATE_H
+
+#include "shDefs.h"
+#include "shVectors.h"
+#include "shPath.h"
+
+/*-----------------------------------------------------------
+ * Triangulates the flattened contours of a path into
+ * triangles that cover its fill exactly once, for either
+ * fill rule, so that the fill can be drawn without stencil
+ * overdraw. The contours are cut into horizontal slabs at
+ * every vertex and every crossing of two edges; the spans
+ * inside the fill become trapezoids, which are extended
+ * down the slabs as long as the same two edges bound them.
+ *-----------------------------------------------------------*/
+
+int shTriangulatePath(SHPath *p, VGFillRule rule, SHVector2Array *out);
+
+#endif /* __SHTRIANGULATE_H */
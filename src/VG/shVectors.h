@@ -56,15 +56,48 @@ struct reduced_path
 {
     kvec_t(unsigned char) commands;
     kvec_t(float) coords;
+    int first_segment;          /* path segment that started it */
+    size_t fill_start[4][2];    /* vertex and index offsets of its */
+    size_t stroke_start[2][2];  /* geometry in fill_geoms/stroke_geoms */
 };
 
 typedef kvec_t(struct reduced_path) reduced_path_vec;
 
+// indices are 16-bit until a vertex past 65535 is
+// referenced, then the geometry switches to 32-bit ones.
+// the fill and stroke sets of a path are packed: their
+// arrays are slices of one block, freed with the set
 struct geometry
 {
     kvec_t(float) vertices;
     kvec_t(unsigned short) indices;
+    kvec_t(unsigned int) wide_indices;
+    int wide;
     size_t count;
+    void *block;                /* block of a packed set */
+};
+
+// growable geometry that builds write into before it is
+// packed, kept between builds to avoid regrowing it
+struct geometry_scratch
+{
+    struct geometry fill[4];
+    struct geometry stroke[2];
+};
+
+#define SH_GEOMETRY_INDEX_COUNT(g) \
+  ((g)->wide ? kv_size((g)->wide_indices) : kv_size((g)->indices))
+
+#define SH_GEOMETRY_INDEX(g, i) \
+  ((g)->wide ? kv_a((g)->wide_indices, i) : (unsigned int)kv_a((g)->indices, i))
+
+// lines and quadratics of the path with their cumulative
+// length, a line having its control point halfway
+struct length_index
+{
+    kvec_t(int) seg_pieces;     /* first piece of each segment */
+    kvec_t(float) pieces;       /* x0 y0 x1 y1 x2 y2 per piece */
+    kvec_t(double) lengths;     /* length up to each piece end */
 };
 
 /*------------------------------------------------------------